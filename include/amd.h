@@ -0,0 +1,73 @@
+//==============================================================================
+//     File: amd.h
+//  Created: 2025-03-10 10:12
+//   Author: Bernie Roesler
+//
+//  Description: Declarations for the approximate minimum degree (AMD)
+//      fill-reducing ordering.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_AMD_H_
+#define _CSPARSE_AMD_H_
+
+#include <vector>
+
+#include "csc.h"
+#include "types.h"
+
+
+namespace cs {
+
+/*------------------------------------------------------------------------------
+ *          Fill-Reducing Orderings
+ *----------------------------------------------------------------------------*/
+/** Build the symmetric matrix to be ordered by AMD.
+ *
+ * The matrix is chosen by the ordering method:
+ * - `APlusAT`:        \f$ C = A + A^T \f$ (Cholesky, square `A` only)
+ * - `ATANoDenseRows`: \f$ C = A^T A \f$, with dense rows of `A` removed (LU)
+ * - `ATA`:            \f$ C = A^T A \f$ (QR)
+ *
+ * The diagonal of `C` is removed, and only the pattern is meaningful.
+ *
+ * @param A  the matrix to order
+ * @param order  the ordering method to use. Must not be `Natural`.
+ *
+ * @return C  the symmetric `N`-by-`N` matrix to order, without its diagonal
+ */
+CSCMatrix build_graph(const CSCMatrix& A, const AMDOrder order);
+
+
+/** Compute the approximate minimum degree ordering of a matrix.
+ *
+ * This function computes the ordering of the graph of \f$ C = A + A^T \f$ or
+ * \f$ C = A^T A \f$, depending on the `order` argument (see `build_graph`).
+ * The graph is represented as a quotient graph of nodes and elements, so that
+ * elimination takes place in the space of the original matrix. Nodes are
+ * eliminated in order of their approximate external degree, and
+ * element absorption, mass elimination, aggressive absorption and
+ * indistinguishable node (supernode) detection are used to reduce the work.
+ * Dense nodes, with degree greater than \f$ \max(16, 10 \sqrt{N}) \f$, are
+ * removed from the graph and ordered last.
+ *
+ * See: Davis, Section 7.1 and `cs_amd`.
+ *
+ * @param A  the matrix to order
+ * @param order  the ordering method to use. If `order` is `Natural`, the
+ *        identity permutation is returned. If it is `NestedDissection`, the
+ *        graph of `APlusAT` is ordered by `nested_dissection`.
+ *
+ * @return p  the fill-reducing permutation vector of length `N`, such that
+ *        `A[p, p]` (Cholesky) or `A[:, p]` (LU and QR) has less fill-in
+ *        than `A`.
+ */
+std::vector<csint> amd(const CSCMatrix& A, const AMDOrder order=AMDOrder::APlusAT);
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_AMD_H_
+
+//==============================================================================
+//==============================================================================
@@ -0,0 +1,156 @@
+//==============================================================================
+//     File: assembly.h
+//  Created: 2025-03-24 09:05
+//   Author: Bernie Roesler
+//
+//  Description: Repeated assembly of a matrix into a frozen sparsity pattern,
+//      e.g. for finite-element stiffness matrices.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_ASSEMBLY_H_
+#define _CSPARSE_ASSEMBLY_H_
+
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "types.h"
+#include "csc.h"
+
+
+namespace cs {
+
+/** A function that computes the matrix of one element.
+ *
+ * The function is called with the index of the element, and the dense
+ * element matrix `Ke` of size `m x m` in column-major order, where `m` is the
+ * number of nodes of the element. `Ke` is zeroed before each call.
+ */
+using ElementKernel = std::function<void(csint e, std::span<double> Ke)>;
+
+
+/** A frozen sparsity pattern, and the map from each contribution to its entry.
+ *
+ * The pattern is built once by `cs::assembly_pattern()`, from a list of
+ * contributions, which are either the entries of a COO matrix, or the entries
+ * of the element matrices. Each contribution `k` is added to the entry
+ * `A.data()[slots[k]]`, so the values can then be reassembled in O(1) per
+ * contribution, without searching or inserting into `A`.
+ *
+ * The contributions of element `e` are numbered from `map_ptr[e]`, with the
+ * entry `(a, b)` of the element matrix at `map_ptr[e] + a + b * m`.
+ *
+ * The elements are also grouped by color, such that no two elements of a color
+ * share a node, and so no two elements of a color add to the same entry.
+ */
+struct AssemblyPattern
+{
+    CSCMatrix A;                         ///< the matrix, in canonical format
+    std::vector<csint> slots;            ///< the entry of each contribution
+    std::vector<csint> slot_ptr,         ///< the contributions to entry `p` are
+                       slot_contribs;    ///< `slot_contribs[slot_ptr[p] ...]`
+    std::vector<csint> elem_ptr,         ///< the nodes of element `e` are
+                       elem_nodes;       ///< `elem_nodes[elem_ptr[e] ...]`
+    std::vector<csint> map_ptr;          ///< the first contribution of each element
+    std::vector<csint> color_ptr,        ///< the elements of color `c` are
+                       color_elems;      ///< `color_elems[color_ptr[c] ...]`
+
+    /// The number of elements, or 0 if the pattern was built from a COO matrix.
+    csint num_elements() const {
+        return elem_ptr.empty() ? 0 : static_cast<csint>(elem_ptr.size()) - 1;
+    }
+
+    /// The number of colors of the elements.
+    csint num_colors() const {
+        return color_ptr.empty() ? 0 : static_cast<csint>(color_ptr.size()) - 1;
+    }
+
+    /** Set all of the values of `A` to zero, keeping the pattern. */
+    void zero();
+
+    /** Add all of the contributions to the values of `A`.
+     *
+     * Each entry of `A` gathers its own contributions, so the entries are
+     * split among the threads without any synchronization.
+     *
+     * @param values  the value of each contribution, in the order of the
+     *        entries of the COO matrix, or of the element matrices
+     * @param threads  the number of threads to use. If `threads <= 0`, use
+     *        the default from `get_num_threads()`.
+     *
+     * @throws std::runtime_error if the size of `values` is not the number of
+     *         contributions.
+     */
+    void add(const std::vector<double>& values, int threads=0);
+
+    /** Add one element matrix to the values of `A`.
+     *
+     * @param e  the index of the element
+     * @param Ke  the element matrix, of size `m x m` in column-major order
+     *
+     * @throws std::runtime_error if `e` is not an element, or `Ke` is not the
+     *         size of the element matrix.
+     */
+    void add_element(csint e, std::span<const double> Ke);
+
+    /** Compute and add the matrices of all of the elements.
+     *
+     * The colors are assembled in turn. The elements of each color are split
+     * among the threads, which each compute their elements with `kernel` into
+     * a private workspace, and add them to `A` without any synchronization.
+     *
+     * @param kernel  the function that computes each element matrix. It must
+     *        be safe to call concurrently for different elements.
+     * @param threads  the number of threads to use. If `threads <= 0`, use
+     *        the default from `get_num_threads()`.
+     *
+     * @throws std::runtime_error if the pattern has no elements. Any exception
+     *         thrown by `kernel` is rethrown, and `A` is then incomplete.
+     */
+    void assemble(const ElementKernel& kernel, int threads=0);
+};
+
+
+/** Build a frozen pattern from the entries of a COO matrix.
+ *
+ * Duplicate entries of `T` map to the same entry of `A`, and the values of
+ * `A` are the sum of the values of `T`. Entries of `T` with value zero are
+ * kept in the pattern.
+ *
+ * @param T  the matrix, whose entries are the contributions
+ *
+ * @return P  the pattern, with the values of `T`, if any, assembled into
+ *         `P.A`
+ */
+AssemblyPattern assembly_pattern(const COOMatrix& T);
+
+
+/** Build a frozen pattern from the connectivity of the elements of a mesh.
+ *
+ * Each element `e` with nodes `n_0 ... n_{m-1}` contributes all of the entries
+ * `(n_a, n_b)`. The values of `A` are initialized to zero.
+ *
+ * @param N  the number of nodes, which is the size of `A`
+ * @param elem_ptr  the offsets of the nodes of each element, of size
+ *        `num_elements + 1`
+ * @param elem_nodes  the nodes of each element, each in `[0, N)`
+ *
+ * @return P  the pattern
+ *
+ * @throws std::runtime_error if the offsets are not non-decreasing and
+ *         consistent with `elem_nodes`, or a node is out of range.
+ */
+AssemblyPattern assembly_pattern(
+    csint N,
+    const std::vector<csint>& elem_ptr,
+    const std::vector<csint>& elem_nodes
+);
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_ASSEMBLY_H_
+
+//==============================================================================
+//==============================================================================
@@ -0,0 +1,178 @@
+//==============================================================================
+//     File: batch.h
+//  Created: 2025-03-22 09:40
+//   Author: Bernie Roesler
+//
+//  Description: Batched factorizations and solves of many matrices with the
+//      same sparsity pattern.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_BATCH_H_
+#define _CSPARSE_BATCH_H_
+
+#include <vector>
+
+#include "types.h"
+#include "csc.h"
+#include "qr.h"
+
+
+namespace cs {
+
+/** Number of matrices factored together by `chol_batch`.
+ *
+ * The matrices of a group are stored interleaved in the workspace, so each
+ * scalar operation of the factorization becomes a loop over the lanes, which
+ * the compiler vectorizes.
+ */
+constexpr csint BATCH_LANES = 8;
+
+
+/** A batch of Cholesky factors with the same pattern.
+ *
+ * The values of factor `b` are stored in `values` in the given layout, in the
+ * order of the entries of `L`.
+ */
+struct CholBatch
+{
+    CSCMatrix L;                  ///< the pattern of each factor
+    std::vector<csint> p_inv;     ///< fill-reducing permutation
+    std::vector<double> values;   ///< the values of the factors, size lnz * batch
+    csint batch = 0;              ///< the number of factors
+    BatchLayout layout = BatchLayout::Strided;  ///< the storage of `values`
+
+    /** Get one factor of the batch.
+     *
+     * @param b  the index of the factor
+     *
+     * @return L  a copy of the `b`th factor
+     */
+    CSCMatrix factor(csint b) const;
+};
+
+
+/** A batch of QR factors with the same pattern.
+ *
+ * The values of factor `b` are stored in `V_values`, `R_values` and `beta` in
+ * the given layout.
+ */
+struct QRBatch
+{
+    CSCMatrix V, R;                   ///< the patterns of each factor
+    std::vector<csint> p_inv, q;      ///< row and column permutations
+    csint M = 0;                      ///< the number of rows of each matrix
+    std::vector<double> V_values,     ///< the Householder vectors, vnz * batch
+                        R_values,     ///< the values of R, rnz * batch
+                        beta;         ///< the scaling factors, N * batch
+    csint batch = 0;                  ///< the number of factors
+    BatchLayout layout = BatchLayout::Strided;  ///< the storage of the values
+
+    /** Get one factor of the batch.
+     *
+     * @param b  the index of the factor
+     *
+     * @return res  a copy of the `b`th factor
+     */
+    QRResult factor(csint b) const;
+};
+
+
+/** Compute the Cholesky factors of a batch of matrices with the same pattern.
+ *
+ * The symmetric permutation of the values and the elimination schedule are
+ * computed once for the batch. The matrices are then factored in groups of
+ * `BATCH_LANES`, with the groups split among the threads, and one workspace
+ * per thread.
+ *
+ * @param A  the common pattern of the matrices. Only the upper triangular
+ *        part is used, and the values of `A` are ignored.
+ * @param S  the symbolic factorization of `A`, from `cs::schol()`
+ * @param values  the values of each matrix, in the order of the entries of
+ *        `A`, of size `A.nnz() * batch`
+ * @param layout  the storage of `values`, which is also used for the factors
+ * @param threads  the number of threads to use. If `threads <= 0`, use the
+ *        default from `get_num_threads()`.
+ *
+ * @return F  the batch of factors
+ *
+ * @throws std::runtime_error if the size of `values` is not a multiple of
+ *         `A.nnz()`, or if any matrix is not positive definite.
+ */
+CholBatch chol_batch(
+    const CSCMatrix& A,
+    const SymbolicChol& S,
+    const std::vector<double>& values,
+    BatchLayout layout=BatchLayout::Strided,
+    int threads=0
+);
+
+
+/** Solve \f$ A_b x_b = b_b \f$ for each matrix of a batch of Cholesky factors.
+ *
+ * @param F  the batch of factors, from `cs::chol_batch()`
+ * @param B  the right-hand sides, of size `N * batch`, in the layout of `F`
+ * @param threads  the number of threads to use. If `threads <= 0`, use the
+ *        default from `get_num_threads()`.
+ *
+ * @return X  the solutions, in the layout of `F`
+ */
+std::vector<double> chol_solve_batch(
+    const CholBatch& F,
+    const std::vector<double>& B,
+    int threads=0
+);
+
+
+/** Compute the QR factors of a batch of matrices with the same pattern.
+ *
+ * The patterns of `V` and `R` are computed once for the batch. Each matrix is
+ * then factored as in `cs::reqr()`, with the matrices split among the threads,
+ * and one workspace per thread.
+ *
+ * @param A  the common pattern of the matrices, of size `M x N` with
+ *        `M >= N`. The values of `A` are ignored.
+ * @param S  the symbolic factorization of `A`, from `cs::sqr()`
+ * @param values  the values of each matrix, in the order of the entries of
+ *        `A`, of size `A.nnz() * batch`
+ * @param layout  the storage of `values`, which is also used for the factors
+ * @param threads  the number of threads to use. If `threads <= 0`, use the
+ *        default from `get_num_threads()`.
+ *
+ * @return F  the batch of factors
+ *
+ * @throws std::runtime_error if `M < N`, or the size of `values` is not a
+ *         multiple of `A.nnz()`.
+ */
+QRBatch qr_batch(
+    const CSCMatrix& A,
+    const SymbolicQR& S,
+    const std::vector<double>& values,
+    BatchLayout layout=BatchLayout::Strided,
+    int threads=0
+);
+
+
+/** Solve the least-squares problems \f$ \min \|A_b x_b - b_b\| \f$ for each
+ * matrix of a batch of QR factors.
+ *
+ * @param F  the batch of factors, from `cs::qr_batch()`
+ * @param B  the right-hand sides, of size `M * batch`, in the layout of `F`
+ * @param threads  the number of threads to use. If `threads <= 0`, use the
+ *        default from `get_num_threads()`.
+ *
+ * @return X  the solutions, of size `N * batch`, in the layout of `F`
+ */
+std::vector<double> qr_solve_batch(
+    const QRBatch& F,
+    const std::vector<double>& B,
+    int threads=0
+);
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_BATCH_H_
+
+//==============================================================================
+//==============================================================================
@@ -10,9 +10,11 @@
 #ifndef _CSPARSE_DECOMPOSITION_H_
 #define _CSPARSE_DECOMPOSITION_H_
 
+#include <cstdint>
 #include <vector>
 
 #include "types.h"
+#include "csc.h"
 
 namespace cs {
 
@@ -47,7 +49,12 @@ struct CholCounts {
 };
 
 
-/** SymbolicChol Cholesky decomposition return struct (see cs_symbolic aka css) */
+/** SymbolicChol Cholesky decomposition return struct (see cs_symbolic aka css)
+ *
+ * The symmetric permutation of the analyzed matrix is cached as a pattern and
+ * a map into its values, so the numeric factorizations of any matrix with the
+ * same pattern read `C = triu(A(p, p))` directly from `A`, without a copy.
+ */
 struct SymbolicChol
 {
     std::vector<csint> p_inv,   ///< fill-reducing permutation
@@ -55,6 +62,86 @@ struct SymbolicChol
                        cp;      ///< column pointers
 
     csint lnz;  ///< # entries in L
+
+    CSCMatrix C;                ///< the pattern of `triu(A(p, p))`
+    std::vector<csint> C_map;   ///< entry `q` of `C` is `A.data()[C_map[q]]`
+    csint anz = 0;              ///< # entries in the analyzed `A`
+
+    std::uint64_t pattern_hash = 0;  ///< `pattern_hash` of the analyzed `A`
+};
+
+
+/** Check if the cached pattern of `S` applies to `A`.
+ *
+ * @param A  a square matrix
+ * @param S  the symbolic analysis
+ *
+ * @return true if `S` holds the pattern `S.C` and map `S.C_map` of
+ *         `triu(A(p, p))`, i.e., if `S` was analyzed from the pattern of `A`.
+ */
+bool has_symperm_map(const CSCMatrix& A, const SymbolicChol& S);
+
+
+/** The upper triangular part of a symmetrically permuted matrix,
+ * \f$ C = \text{triu}(A(p, p)) \f$, as a pattern and a map into the values of
+ * `A`.
+ *
+ * The pattern cached in the `SymbolicChol` is used if it was analyzed from the
+ * pattern of `A`. Otherwise, a local pattern is computed.
+ *
+ * Only the upper triangular part of `A` is used, so `A` may store only its
+ * upper triangle, e.g. `A.band(0, N)`.
+ */
+class SymPermView
+{
+    std::vector<csint> local_map_;
+    CSCMatrix local_C_;
+
+    SymPermView(const CSCMatrix& A, const SymbolicChol& S, bool cached);
+
+    public:
+        const CSCMatrix& C;              ///< the pattern of `C`
+        const std::vector<csint>& map;   ///< entry `q` of `C` is `A.data()[map[q]]`
+
+        SymPermView(const CSCMatrix& A, const SymbolicChol& S);
+
+        SymPermView(const SymPermView&) = delete;
+        SymPermView& operator=(const SymPermView&) = delete;
+};
+
+
+/** Supernodal Cholesky factor.
+ *
+ * The columns of `L` are partitioned into supernodes, contiguous sets of
+ * columns `super[s] ... super[s+1]-1` that share the same sub-diagonal pattern.
+ * Each supernode is stored as a dense, column-major block of size
+ * `nrows x ncols`, where `nrows = rp[s+1] - rp[s]`. The first `ncols` row
+ * indices of each supernode are the columns of the supernode itself, so the
+ * top of each block is the (lower triangular) diagonal block.
+ */
+struct SupernodalChol
+{
+    std::vector<csint> p_inv,  ///< fill-reducing permutation
+                       super,  ///< first column of each supernode, size ns+1
+                       rp,     ///< start of row pattern of each supernode in ri
+                       ri,     ///< row indices of each supernode
+                       xp;     ///< start of dense block of each supernode in x
+    std::vector<double> x;     ///< dense column-major blocks of L
+};
+
+
+/** The workspace of a multiple-rank update or downdate (see `chol_updown`).
+ *
+ * The workspace grows to fit the largest update, and is left clean after each
+ * call, so one workspace can be reused by a sequence of updates without any
+ * further allocation.
+ */
+struct UpdownWorkspace
+{
+    std::vector<double> W;      ///< the update columns, N x k in row-major order
+    std::vector<double> beta;   ///< the scaling factor of each column, size k
+    std::vector<csint> path;    ///< the union of the paths in the etree
+    std::vector<char> marked;   ///< marks the nodes of the path, size N
 };
 
 
@@ -283,6 +370,7 @@ std::vector<csint> chol_colcounts(const CSCMatrix& A, bool ata=false);
  *       - 1: amd(A + A.T)
  *       - 2: amd(A.T * A) with no dense rows
  *       - 3: amd(A.T * A)
+ *       - 4: nested_dissection(A + A.T)
  * @param postorder  if True, postorder the matrix in addition to the AMD
  *        (or natural) ordering. See: Davis, Exercise 4.9.
  *
@@ -321,16 +409,32 @@ CSCMatrix symbolic_cholesky(const CSCMatrix& A, const SymbolicChol& S);
 
 
 /** Compute the up-looking Cholesky factorization of a sparse matrix.
+ *
+ * Row `k` of `L` depends only on the rows in the subtree of `k` in the
+ * elimination tree, so disjoint subtrees are independent. With more than one
+ * thread, the rows are scheduled over the postordered elimination tree, and
+ * independent subtrees are factored concurrently. Each row is computed by the
+ * same operations in any schedule, so `L` is identical for any number of
+ * threads.
  *
  * @note This function assumes that `A` is symmetric and positive definite.
  *
  * @param A the matrix to factorize
  * @param S the SymbolicChol factorization of `A`
  * @param drop_tol  the drop tolerance for the factorization
+ * @param threads  the number of threads to use. If `threads <= 0`, use the
+ *        default from `get_num_threads()`.
  *
  * @return the numeric Cholesky factorization of `A`
+ *
+ * @throws std::runtime_error if `A` is not positive definite
  */
-CSCMatrix chol(const CSCMatrix& A, const SymbolicChol& S, double drop_tol=0.0);
+CSCMatrix chol(
+    const CSCMatrix& A,
+    const SymbolicChol& S,
+    double drop_tol=0.0,
+    int threads=0
+);
 
 
 /** Compute the left-looking Cholesky factorization of a sparse matrix, given
@@ -388,6 +492,51 @@ CSCMatrix& chol_update(
 );
 
 
+/** Update the Cholesky factor for \f$ A = A + σ C C^T \f$, for a matrix `C`
+ * with `k` columns.
+ *
+ * The paths in the elimination tree from the first non-zero of each column of
+ * `C` are merged, and the union is traversed once. At each column of `L` on the
+ * path, the `k` rotations are applied in turn, so the result is the same as
+ * `k` calls to `chol_update`, but each column of `L` is loaded only once.
+ *
+ * See: Davis & Hager (2001), *Multiple-rank modifications of a sparse Cholesky
+ * factorization*, and CHOLMOD's `cholmod_updown`.
+ *
+ * @note As with `chol_update`, the pattern of `L` is not changed, so the
+ * pattern of each column of `C` must be contained in the pattern of column `f`
+ * of `L`, where `f` is its first non-zero row.
+ *
+ * @param[in,out] L  the Cholesky factor of A, with sorted columns and the
+ *        diagonal first in each column. It is modified in place.
+ * @param update  true for update, false for downdate
+ * @param C  the N x k update matrix
+ * @param parent  the elimination tree of A
+ * @param[in,out] ws  a workspace, which may be reused across calls
+ *
+ * @return L  the updated Cholesky factor of A
+ *
+ * @throws std::runtime_error if the downdated matrix is not positive definite.
+ *         `L` is then left partially modified.
+ */
+CSCMatrix& chol_updown(
+    CSCMatrix& L,
+    bool update,
+    const CSCMatrix& C,
+    const std::vector<csint>& parent,
+    UpdownWorkspace& ws
+);
+
+
+/** Update the Cholesky factor with a temporary workspace (see above). */
+CSCMatrix& chol_updown(
+    CSCMatrix& L,
+    bool update,
+    const CSCMatrix& C,
+    const std::vector<csint>& parent
+);
+
+
 /** Compute the elimination tree of L and row and column counts using ereach.
  *
  * This function takes O(|L|) time and O(N) space.
@@ -419,8 +568,9 @@ CholCounts chol_etree_counts(const CSCMatrix& A);
  *
  * @param A  the matrix to factorize. Only the upper triangle is used.
  * @param method the method to use: NoFill or ICT
- *        * NoFill: no fill-in. The factor will have the same non-zero pattern
- *           as the input `A`.
+ *        * NoFill: no fill-in, IC(0). The factor will have the same non-zero
+ *          pattern as `triu(A).T`. A zero or negative pivot throws a
+ *          `std::runtime_error`.
  *        * ICT: incomplete Cholesky with threshold drop tolerance. Any
  *          element that is smaller than `drop_tol` will not be included in `L`.
  * @param drop_tol  the drop tolerance, default is 1e-4
@@ -438,6 +588,92 @@ CSCMatrix ichol(
 );
 
 
+/*------------------------------------------------------------------------------
+ *          Supernodal Cholesky
+ *----------------------------------------------------------------------------*/
+/** Find the supernodes of the Cholesky factor.
+ *
+ * Column `j+1` is added to the supernode containing column `j` if
+ * `parent[j] == j+1` and `L(:, j)` has exactly one more non-zero than
+ * `L(:, j+1)`, so that the pattern of `L(j+1:, j)` is the pattern of
+ * `L(:, j+1)`.
+ *
+ * See: Davis, p 61.
+ *
+ * @param parent  the elimination tree of `A`
+ * @param cp  the column pointers of `L`, from `cs::schol()`
+ *
+ * @return super  the first column of each supernode, with `super.back() == N`.
+ */
+std::vector<csint> find_supernodes(
+    const std::vector<csint>& parent,
+    const std::vector<csint>& cp
+);
+
+
+/** Compute the symbolic supernodal Cholesky factorization of a sparse matrix.
+ *
+ * The row pattern of each supernode is the union of the patterns of
+ * `A(:, f:l)` and the patterns of its children in the supernodal elimination
+ * tree. It is computed in time proportional to the size of the supernodal
+ * row structure.
+ *
+ * @param A  the matrix to factorize. Only the upper triangle is used.
+ * @param S  the SymbolicChol factorization of `A`, from `cs::schol()`
+ *
+ * @return L  the supernodal factor with the values zeroed out.
+ */
+SupernodalChol symbolic_super(const CSCMatrix& A, const SymbolicChol& S);
+
+
+/** Compute the left-looking supernodal Cholesky factorization of a sparse
+ * matrix, given the supernodal structure.
+ *
+ * Each supernode is updated by the descendant supernodes that have rows in its
+ * column range with a dense matrix product, followed by a dense Cholesky
+ * factorization of the diagonal block and a dense triangular solve for the
+ * sub-diagonal rows.
+ *
+ * @note This function assumes that `A` is symmetric and positive definite.
+ *
+ * @param A  the matrix to factorize. Only the upper triangle is used.
+ * @param S  the SymbolicChol factorization of `A`, from `cs::schol()`
+ * @param[in, out] L  the symbolic supernodal factor of `A` from
+ *        `cs::symbolic_super()`. The values are computed in place.
+ *
+ * @return L  the numeric supernodal Cholesky factor of `A`
+ *
+ * @see 'python/csparse/_cholesky.py::chol_super()'
+ */
+SupernodalChol& rechol_super(
+    const CSCMatrix& A,
+    const SymbolicChol& S,
+    SupernodalChol& L
+);
+
+
+/** Compute the supernodal Cholesky factorization of a sparse matrix.
+ *
+ * @note This function assumes that `A` is symmetric and positive definite.
+ *
+ * @param A  the matrix to factorize. Only the upper triangle is used.
+ * @param S  the SymbolicChol factorization of `A`, from `cs::schol()`
+ *
+ * @return L  the supernodal Cholesky factor of `A`
+ */
+SupernodalChol chol_super(const CSCMatrix& A, const SymbolicChol& S);
+
+
+/** Convert a supernodal Cholesky factor to a sparse matrix.
+ *
+ * @param L  the supernodal Cholesky factor
+ *
+ * @return C  the lower triangular factor in canonical format. Numerically zero
+ *         entries within each supernode are retained.
+ */
+CSCMatrix super_to_csc(const SupernodalChol& L);
+
+
 }  // namespace cs
 
 #endif // _DECOMPOSITION_H_
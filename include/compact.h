@@ -0,0 +1,201 @@
+//==============================================================================
+//     File: compact.h
+//  Created: 2025-03-19 10:12
+//   Author: Bernie Roesler
+//
+//  Description: A compressed sparse column matrix with templated index and
+//      value types, for the bandwidth-bound kernels.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_COMPACT_H_
+#define _CSPARSE_COMPACT_H_
+
+#include <complex>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "types.h"
+
+
+namespace cs {
+
+/** A CSC matrix with compact index and value types.
+ *
+ * Matrix-vector multiplies and triangular solves read each index and value
+ * once, so their speed is limited by memory bandwidth. With 32-bit row
+ * indices, `i_` is half the size of a 64-bit `CSCMatrix`, and `float` values
+ * halve `v_` again. The column pointers are always `csint`, since they are
+ * only `N + 1` entries, and may exceed the range of `Index` when `nnz` is
+ * large.
+ *
+ * The matrix is built from a `CSCMatrix`, which does the assembly, ordering
+ * and factorization. The compact copy is then used in the inner loops, e.g.
+ * the preconditioner solves of an iterative method.
+ *
+ * The member and solve definitions are in `compact.cpp`, which explicitly
+ * instantiates them for `Index` in `{std::int32_t, std::int64_t}` and `Value`
+ * in `{float, double, std::complex<double>}`.
+ *
+ * @tparam Index  the signed integer type of the row indices
+ * @tparam Value  the type of the values
+ */
+template <typename Index, typename Value>
+class CompactCSC
+{
+    static_assert(std::is_signed_v<Index> && std::is_integral_v<Index>);
+
+    std::vector<Value> v_;  // numerical values, size nnz
+    std::vector<Index> i_;  // row indices, size nnz
+    std::vector<csint> p_;  // column pointers (CSC size N + 1)
+    csint M_ = 0;           // number of rows
+    csint N_ = 0;           // number of columns
+
+    public:
+        using index_type = Index;
+        using value_type = Value;
+
+        CompactCSC() = default;
+
+        /** Convert a CSCMatrix to the compact types.
+         *
+         * @param A  the matrix to convert
+         *
+         * @throws std::runtime_error if either dimension of `A` does not fit
+         *         in `Index`.
+         */
+        explicit CompactCSC(const CSCMatrix& A);
+
+        /** Construct a matrix by taking ownership of existing arrays.
+         *
+         * @param data  the values of the entries, size nnz
+         * @param indices  the row indices of the entries, size nnz
+         * @param indptr  the column pointers, size N + 1
+         * @param shape  the dimensions of the matrix
+         *
+         * @throws std::runtime_error if either dimension does not fit in
+         *         `Index`, or the array sizes are inconsistent.
+         */
+        CompactCSC(
+            std::vector<Value>&& data,
+            std::vector<Index>&& indices,
+            std::vector<csint>&& indptr,
+            const Shape& shape
+        );
+
+        //----------------------------------------------------------------------
+        //        Accessors
+        //----------------------------------------------------------------------
+        csint nnz() const { return static_cast<csint>(i_.size()); }
+        Shape shape() const { return {M_, N_}; }
+
+        const std::vector<Index>& indices() const { return i_; }
+        const std::vector<csint>& indptr() const { return p_; }
+        const std::vector<Value>& data() const { return v_; }
+
+        /** Convert back to a CSCMatrix. Only for real values.
+         *
+         * @return A  a copy of the matrix with 64-bit indices and `double`
+         *         values
+         */
+        CSCMatrix tocsc() const requires (!std::is_same_v<Value, std::complex<double>>);
+
+        //----------------------------------------------------------------------
+        //        Math Operations
+        //----------------------------------------------------------------------
+        /** Matrix-vector multiply `y = Ax + y`.
+         *
+         * See `CSCMatrix::gaxpy`.
+         *
+         * @param x  the dense vector to multiply
+         * @param y  the dense vector to add
+         * @param threads  the number of threads to use. If `threads <= 0`,
+         *        use the default from `get_num_threads()`.
+         *
+         * @return y  the result
+         */
+        std::vector<Value> gaxpy(
+            const std::vector<Value>& x,
+            const std::vector<Value>& y,
+            int threads=0
+        ) const;
+
+        /** Matrix transpose-vector multiply `y = A.T x + y`.
+         *
+         * See `CSCMatrix::gatxpy`.
+         *
+         * @param x  the dense vector to multiply
+         * @param y  the dense vector to add
+         * @param threads  the number of threads to use. If `threads <= 0`,
+         *        use the default from `get_num_threads()`.
+         *
+         * @return y  the result
+         */
+        std::vector<Value> gatxpy(
+            const std::vector<Value>& x,
+            const std::vector<Value>& y,
+            int threads=0
+        ) const;
+};
+
+
+// 32-bit row indices, which cover any matrix with fewer than 2^31 rows
+using CSCMatrix32 = CompactCSC<std::int32_t, double>;
+using CSCMatrix32F = CompactCSC<std::int32_t, float>;
+using CSCMatrix32Z = CompactCSC<std::int32_t, std::complex<double>>;
+
+
+//------------------------------------------------------------------------------
+//        Triangular Matrix Solutions
+//------------------------------------------------------------------------------
+/** Forward solve a lower-triangular system \f$ Lx = b \f$.
+ *
+ * See `lsolve(const CSCMatrix&, const std::vector<double>&)`.
+ */
+template <typename Index, typename Value>
+std::vector<Value> lsolve(
+    const CompactCSC<Index, Value>& L,
+    const std::vector<Value>& b
+);
+
+
+/** Backsolve a lower-triangular system \f$ L^T x = b \f$.
+ *
+ * See `ltsolve(const CSCMatrix&, const std::vector<double>&)`.
+ */
+template <typename Index, typename Value>
+std::vector<Value> ltsolve(
+    const CompactCSC<Index, Value>& L,
+    const std::vector<Value>& b
+);
+
+
+/** Backsolve an upper-triangular system \f$ Ux = b \f$.
+ *
+ * See `usolve(const CSCMatrix&, const std::vector<double>&)`.
+ */
+template <typename Index, typename Value>
+std::vector<Value> usolve(
+    const CompactCSC<Index, Value>& U,
+    const std::vector<Value>& b
+);
+
+
+/** Forward solve an upper-triangular system \f$ U^T x = b \f$.
+ *
+ * See `utsolve(const CSCMatrix&, const std::vector<double>&)`.
+ */
+template <typename Index, typename Value>
+std::vector<Value> utsolve(
+    const CompactCSC<Index, Value>& U,
+    const std::vector<Value>& b
+);
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_COMPACT_H_
+
+//==============================================================================
+//==============================================================================
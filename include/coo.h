@@ -76,6 +76,25 @@ class COOMatrix
             const Shape shape=Shape{0, 0}
         );
 
+        /** Construct a COOMatrix by taking ownership of existing arrays.
+         *
+         * This constructor moves the arrays into the matrix without copying.
+         * The shape must be given explicitly.
+         *
+         * @param vals  the values of the entries in the matrix
+         * @param rows, cols  the non-negative integer row and column indices of
+         *        the values
+         * @param shape  the dimensions of the matrix
+         *
+         * @return a new COOMatrix object
+         */
+        COOMatrix(
+            std::vector<double>&& vals,
+            std::vector<csint>&& rows,
+            std::vector<csint>&& cols,
+            const Shape& shape
+        );
+
         /** Allocate a COOMatrix for a given shape and number of non-zeros.
          *
          * @param shape  the dimensions of the matrix
@@ -168,16 +187,34 @@ class COOMatrix
         /** Convert a coordinate format matrix to a compressed sparse column matrix.
          *
          * The columns are not guaranteed to be sorted, and duplicates are allowed.
+         * Within each column, the entries are in the same order as in the
+         * `COOMatrix`, independent of the number of threads.
+         *
+         * Large matrices are compressed in parallel, with a column histogram
+         * per thread and a parallel scatter.
+         *
+         * @param threads  the number of threads to use. If `threads <= 0`, use
+         *        the default from `get_num_threads()`.
          *
          * @return a copy of the `COOMatrix` in CSC format.
          */
-        CSCMatrix compress() const;
+        CSCMatrix compress(int threads=0) const;
 
         /** Create a canonical format CSCMatrix from a COOMatrix.
+         *
+         * The conversion is a single pipeline of a stable bucket sort by
+         * row, a stable bucket sort by column, and one pass to sum duplicates
+         * and drop zeros. The result is identical to
+         * `compress().to_canonical()`, but takes fewer passes over the data.
          *
          * See: Davis, Exercise 2.9
+         *
+         * @param threads  the number of threads to use. If `threads <= 0`, use
+         *        the default from `get_num_threads()`.
+         *
+         * @return a copy of the `COOMatrix` in canonical CSC format.
          */
-        CSCMatrix tocsc() const;
+        CSCMatrix tocsc(int threads=0) const;
 
         /** Convert the matrix to a dense array.
          *
@@ -11,11 +11,15 @@
 #define _CSPARSE_CSC_H_
 
 #include <cassert>
+#include <concepts>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <string_view>
+#include <span>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 
 #include "types.h"
@@ -42,8 +46,36 @@ class CSCMatrix
      */
     void write_elems_(std::stringstream& ss, csint start, csint end) const;
 
+    /** The lazily built CSR mirror of the matrix.
+     *
+     * The mirror itself is immutable, so copies of the matrix share it until
+     * either is modified. All access to the pointer is serialized, so that
+     * const member functions may build it concurrently.
+     */
+    struct CSRCache
+    {
+        std::shared_ptr<const CSRMatrix> ptr;
+
+        CSRCache() = default;
+        CSRCache(const CSRCache& other);
+        CSRCache(CSRCache&& other) noexcept = default;
+        CSRCache& operator=(const CSRCache& other);
+        CSRCache& operator=(CSRCache&& other) noexcept = default;
+    };
+
+    mutable CSRCache csr_;
+
+    /** Return the CSR mirror if it has been built, or `nullptr`. */
+    const CSRMatrix *cached_csr_() const;
+
+    /** Discard the CSR mirror. Called by every function that modifies the
+     * matrix in place. */
+    void invalidate_csr_();
+
     public:
         friend class COOMatrix;
+        friend class CSRMatrix;
+        friend class LinearCombination;
 
         /** 
          * @typedef KeepFunc
@@ -88,6 +120,25 @@ class CSCMatrix
             const Shape& shape
         );
 
+        /** Construct a CSCMatrix by taking ownership of existing arrays.
+         *
+         * This constructor moves the arrays into the matrix without copying.
+         * See the `const` reference version for details.
+         *
+         * @param data the values of the entries in the matrix
+         * @param indices row indices of each element.
+         * @param indptr array indices of the start of each column in `indices`.
+         * @param shape the dimensions of the matrix
+         *
+         * @return a new CSCMatrix object
+         */
+        CSCMatrix(
+            std::vector<double>&& data,
+            std::vector<csint>&& indices,
+            std::vector<csint>&& indptr,
+            const Shape& shape
+        );
+
         /** Allocate a CSCMatrix for a given shape and number of non-zeros.
          *
          * @param shape  the dimensions of the matrix
@@ -274,6 +325,31 @@ class CSCMatrix
          */
         std::vector<double> to_dense_vector(const char order='F') const;
 
+        /** Return the CSR mirror of the matrix, building it on first use.
+         *
+         * The mirror is one transpose of the matrix. Once it is built, the
+         * row-oriented operations `transpose`, `slice`, `index`, `sum_rows`,
+         * `lsolve_rows` and `usolve_rows` traverse the rows of the mirror
+         * instead of all of the columns of the matrix. The mirror is discarded
+         * by any function that modifies the matrix.
+         *
+         * @return R  a reference to the mirror, which is valid until the matrix
+         *         is modified or destroyed.
+         */
+        const CSRMatrix& csr() const;
+
+        /** Return true if the CSR mirror has been built. */
+        bool has_csr() const;
+
+        /** Discard the CSR mirror to free its memory. */
+        void clear_csr() { invalidate_csr_(); }
+
+        /** Convert a CSCMatrix to a CSRMatrix, using the mirror if it exists.
+         *
+         * @return R  a copy of the matrix in CSR format.
+         */
+        CSRMatrix tocsr() const;
+
         /** Convert a CSCMatrix to a double if it is a 1x1 matrix.
          *
          * @return the value of the matrix if it is a 1x1 matrix.
@@ -293,6 +369,9 @@ class CSCMatrix
         *   - O(M + N + nnz) time
         *       == nnz column counts + N columns * M potential non-zeros per column
         *
+        * If the CSR mirror has been built (see `csr()`), it is copied instead,
+        * which takes O(M + nnz) time.
+        *
         * @param values if `true`, allocate space for the values array.
         *
         * @return new CSCMatrix object with transposed rows and columns.
@@ -411,11 +490,31 @@ class CSCMatrix
          * @param x  a dense multiplying vector
          * @param y  a dense adding vector which will be used for the output
          *
+         * @param threads  the number of threads to use. If `threads <= 0`, use
+         *        the default from `cs::get_num_threads()`. Columns are split
+         *        into blocks with an equal number of non-zeros per thread.
+         *
          * @return y a copy of the updated vector
          */
         std::vector<double> gaxpy(
             const std::vector<double>& x,
-            const std::vector<double>& y
+            const std::vector<double>& y,
+            int threads=0
+        ) const;
+
+        /** Matrix-vector multiply `y += Ax` in place.
+         *
+         * The output is not allocated. With more than one thread, each thread
+         * but the first accumulates into a private partial vector.
+         *
+         * @param x  a dense multiplying vector of size N
+         * @param[in,out] y  a dense adding vector of size M, which is updated
+         * @param threads  the number of threads to use (see above)
+         */
+        void gaxpy(
+            std::span<const double> x,
+            std::span<double> y,
+            int threads=0
         ) const;
 
         /** Matrix transpose-vector multiply `y = A.T x + y`.
@@ -426,11 +525,32 @@ class CSCMatrix
          * @param x  a dense multiplying vector
          * @param y[in,out]  a dense adding vector which will be used for the output
          *
+         * @param threads  the number of threads to use. If `threads <= 0`, use
+         *        the default from `cs::get_num_threads()`. Columns are split
+         *        into blocks with an equal number of non-zeros per thread.
+         *
          * @return y a copy of the updated vector
          */
         std::vector<double> gatxpy(
             const std::vector<double>& x,
-            const std::vector<double>& y
+            const std::vector<double>& y,
+            int threads=0
+        ) const;
+
+        /** Matrix transpose-vector multiply `y += A.T x` in place.
+         *
+         * Use this function instead of `A.T().gaxpy()`, which copies `A`.
+         * The output is not allocated, and each thread writes its own block of
+         * `y`.
+         *
+         * @param x  a dense multiplying vector of size M
+         * @param[in,out] y  a dense adding vector of size N, which is updated
+         * @param threads  the number of threads to use (see above)
+         */
+        void gatxpy(
+            std::span<const double> x,
+            std::span<double> y,
+            int threads=0
         ) const;
 
         /** Matrix-vector multiply `y = Ax + y` symmetric A (\f$ A = A^T \f$).
@@ -440,11 +560,28 @@ class CSCMatrix
          * @param x  a dense multiplying vector
          * @param y  a dense adding vector which will be used for the output
          *
+         * @param threads  the number of threads to use. If `threads <= 0`, use
+         *        the default from `cs::get_num_threads()`. Columns are split
+         *        into blocks with an equal number of non-zeros per thread.
+         *
          * @return y a copy of the updated vector
          */
         std::vector<double> sym_gaxpy(
             const std::vector<double>& x,
-            const std::vector<double>& y
+            const std::vector<double>& y,
+            int threads=0
+        ) const;
+
+        /** Matrix-vector multiply `y += Ax` in place for symmetric A.
+         *
+         * @param x  a dense multiplying vector
+         * @param[in,out] y  a dense adding vector, which is updated
+         * @param threads  the number of threads to use (see above)
+         */
+        void sym_gaxpy(
+            std::span<const double> x,
+            std::span<double> y,
+            int threads=0
         ) const;
 
         /** Matrix multiply `Y = AX + Y` column-major dense matrices `X` and `Y`.
@@ -533,6 +670,40 @@ class CSCMatrix
             const std::vector<double>& Y
         ) const;
 
+        /** Matrix multiply `Y = AX + Y` for row-major dense matrices `X` and `Y`,
+         * using SIMD instructions.
+         *
+         * Each non-zero `A(i, j)` is loaded once and applied to the entire row
+         * `Y(i, :)` with vectorized fused multiply-adds. The vector width is
+         * chosen at compile time (see `simd.h`), and is 1 (scalar) unless the
+         * library is built for the host instruction set.
+         *
+         * @param X  a dense multiplying matrix in row-major order
+         * @param[in,out] Y  a dense adding matrix which will be used for the output
+         *
+         * @return Y a copy of the updated matrix
+         */
+        std::vector<double> gaxpy_simd(
+            const std::vector<double>& X,
+            const std::vector<double>& Y
+        ) const;
+
+        /** Matrix multiply `Y = A.T X + Y` for row-major dense matrices `X`
+         * and `Y`, using SIMD instructions.
+         *
+         * Each row `Y(j, :)` is accumulated in a tile of vector registers
+         * while traversing column `j` of `A`.
+         *
+         * @param X  a dense multiplying matrix in row-major order
+         * @param[in,out] Y  a dense adding matrix which will be used for the output
+         *
+         * @return Y a copy of the updated matrix
+         */
+        std::vector<double> gatxpy_simd(
+            const std::vector<double>& X,
+            const std::vector<double>& Y
+        ) const;
+
         /** Scale the rows and columns of a matrix by \f$ A = RAC \f$, where *R* and *C*
          * are diagonal matrices.
          *
@@ -543,15 +714,34 @@ class CSCMatrix
          *
          * @return RAC the scaled matrix
          */
-        CSCMatrix scale(const std::vector<double>& r, const std::vector<double> c) const;
+        CSCMatrix scale(const std::vector<double>& r, const std::vector<double>& c) const;
+
+        /** Scale the rows and columns of this matrix in place by \f$ A = RAC \f$.
+         *
+         * @param r, c  the diagonals of R and C (see `scale`)
+         *
+         * @return A  a reference to this matrix
+         */
+        CSCMatrix& scale_inplace(std::span<const double> r, std::span<const double> c);
 
         /** Matrix-vector right-multiply (see cs_multiply) */
         std::vector<double> dot(const std::vector<double>& x) const;
 
+        /** Matrix-vector right-multiply `y = Ax` into an existing vector.
+         *
+         * @param x  a dense multiplying vector of size N
+         * @param[out] y  the product, of size M, which is overwritten
+         * @param threads  the number of threads to use (see `gaxpy`)
+         */
+        void dot(std::span<const double> x, std::span<double> y, int threads=0) const;
+
         /** Scale a matrix by a scalar */
         CSCMatrix dot(const double c) const;
 
         /** Matrix-matrix multiplication
+         *
+         * The product is computed by `dot_2x`, so the output is allocated
+         * exactly once, with the default number of threads.
          *
          * @note This function may *not* return a matrix with sorted columns!
          *
@@ -559,11 +749,24 @@ class CSCMatrix
          *        A is size M x K, B is size K x N.
          *
          * @return C    a CSC-format matrix of size M x N.
-         *         C.nnz() <= A.nnz() + B.nnz().
          */
         CSCMatrix dot(const CSCMatrix& B) const;
 
         /** Matrix-matrix multiplication with two passes
+         *
+         * The first (symbolic) pass computes the exact number of non-zeros in
+         * each column of `C`, so that `C` is allocated once with no unused
+         * space. The second (numeric) pass computes the columns of `C`.
+         * Both passes split the columns of `C` into blocks with about equal
+         * work, and each thread has its own accumulator.
+         *
+         * The dense accumulator takes O(M) space and time per thread. The hash
+         * accumulator takes space proportional to the work in the largest
+         * column of the thread, so it is faster for products with short
+         * columns, where `M` is large compared to the work.
+         *
+         * The entries of each column are in the same order, with the same
+         * values, for any accumulator and number of threads.
          *
          * See: Davis, Exercise 2.20.
          *
@@ -571,11 +774,19 @@ class CSCMatrix
          *
          * @param A, B  the CSC-format matrices to multiply.
          *        A is size M x K, B is size K x N.
+         * @param threads  the number of threads to use. If `threads <= 0`, use
+         *        the default from `get_num_threads()`.
+         * @param acc  the accumulator to use. `Auto` chooses `Hash` when the
+         *        dense workspaces of all threads would be larger than the
+         *        number of multiplications, and `Dense` otherwise.
          *
          * @return C    a CSC-format matrix of size M x N.
-         *         C.nnz() <= A.nnz() + B.nnz().
          */
-        CSCMatrix dot_2x(const CSCMatrix& B) const;  // Exercise 2.20
+        CSCMatrix dot_2x(
+            const CSCMatrix& B,
+            int threads=0,
+            SpGEMMAccumulator acc=SpGEMMAccumulator::Auto
+        ) const;  // Exercise 2.20
 
         /** Multiply two sparse column vectors \f$ c = x^T y \f$.
          *
@@ -601,6 +812,8 @@ class CSCMatrix
          * @param alpha, beta  scalar multipliers
          *
          * @return out a CSC matrix
+         *
+         * @throws std::invalid_argument if the shapes of `A` and `B` differ
          */
         friend CSCMatrix add_scaled(
             const CSCMatrix& A,
@@ -690,6 +903,23 @@ class CSCMatrix
          */
         CSCMatrix symperm(const std::vector<csint> p_inv, bool values=true) const;
 
+        /** Permute the pattern of a symmetric matrix, and map each entry of the
+         * result to its entry in this matrix.
+         *
+         * Only the upper triangular part is used, as in `symperm`. The values
+         * of `C = triu(A(p, p))` are `A.data()[map[q]]`, so any matrix with
+         * the same pattern can be permuted without copying its values.
+         *
+         * @param p_inv  *inverse* permutation vector
+         * @param[out] map  the position in `data()` of each entry of `C`
+         *
+         * @return C  the permuted pattern, without values
+         */
+        CSCMatrix symperm_map(
+            const std::vector<csint>& p_inv,
+            std::vector<csint>& map
+        ) const;
+
         /** Permute and transpose a matrix \f$ C = PA^TQ \f$.
          *
          * See: Davis, Exercise 2.26.
@@ -903,19 +1133,91 @@ class CSCMatrix
 
         friend TriPerm find_tri_permutation(const CSCMatrix& A);
 
+        friend LevelSchedule level_schedule(
+            const CSCMatrix& A,
+            bool lower,
+            bool trans
+        );
+
+        friend std::vector<double> level_solve(
+            const LevelSchedule& S,
+            const std::vector<double>& b,
+            int threads
+        );
+
         friend SparseSolution spsolve(
             const CSCMatrix& A,
             const CSCMatrix& B,
             csint k,
-            bool lo
+            bool lo,
+            const std::vector<csint>& p_inv
+        );
+
+        friend std::vector<csint>& spsolve(
+            const CSCMatrix& A,
+            const CSCMatrix& B,
+            csint k,
+            std::vector<bool>& marked,
+            std::vector<csint>& xi,
+            std::vector<double>& x,
+            bool lo,
+            const std::vector<csint>& p_inv
+        );
+
+        friend std::vector<csint> reach(
+            const CSCMatrix& A,
+            const CSCMatrix& B,
+            csint k,
+            const std::vector<csint>& p_inv
+        );
+
+        friend std::vector<csint>& reach(
+            const CSCMatrix& A,
+            const CSCMatrix& B,
+            csint k,
+            std::vector<bool>& marked,
+            std::vector<csint>& xi,
+            const std::vector<csint>& p_inv
         );
 
-        friend std::vector<csint> reach(const CSCMatrix& A, const CSCMatrix& B, csint k);
         friend std::vector<csint>& dfs(
             const CSCMatrix& A,
             csint j,
             std::vector<bool>& marked,
-            std::vector<csint>& xi
+            std::vector<csint>& xi,
+            const std::vector<csint>& p_inv
+        );
+
+        friend std::vector<csint>& spsolve(
+            const CSCMatrix& A,
+            const CSCMatrix& B,
+            csint k,
+            SpsolveWorkspace& ws,
+            bool lo,
+            const std::vector<csint>& p_inv
+        );
+
+        friend CSCMatrix spsolve_block(
+            const CSCMatrix& A,
+            const CSCMatrix& B,
+            bool lo,
+            const std::vector<csint>& p_inv,
+            int threads
+        );
+
+        friend std::vector<csint>& reach(
+            const CSCMatrix& A,
+            const CSCMatrix& B,
+            csint k,
+            SpsolveWorkspace& ws,
+            const std::vector<csint>& p_inv
+        );
+
+        friend std::vector<csint>& dfs(
+            const CSCMatrix& A,
+            csint j,
+            SpsolveWorkspace& ws,
+            const std::vector<csint>& p_inv
         );
 
         //----------------------------------------------------------------------
@@ -966,7 +1268,13 @@ class CSCMatrix
 
         friend CSCMatrix symbolic_cholesky(const CSCMatrix& A, const SymbolicChol& S);
 
-        friend CSCMatrix chol(const CSCMatrix& A, const SymbolicChol& S, double drop_tol);
+        friend CSCMatrix chol(
+            const CSCMatrix& A,
+            const SymbolicChol& S,
+            double drop_tol,
+            int threads
+        );
+
         friend CSCMatrix& leftchol(const CSCMatrix& A, const SymbolicChol& S, CSCMatrix& L);
         friend CSCMatrix& rechol(const CSCMatrix& A, const SymbolicChol& S, CSCMatrix& L);
 
@@ -983,8 +1291,24 @@ class CSCMatrix
 	        const std::vector<csint>& parent
         );
 
+        friend CSCMatrix& chol_updown(
+            CSCMatrix& L,
+            bool update,
+            const CSCMatrix& C,
+            const std::vector<csint>& parent,
+            UpdownWorkspace& ws
+        );
+
         friend CholCounts chol_etree_counts(const CSCMatrix& A);
 
+        friend SupernodalChol symbolic_super(const CSCMatrix& A, const SymbolicChol& S);
+        friend SupernodalChol& rechol_super(
+            const CSCMatrix& A,
+            const SymbolicChol& S,
+            SupernodalChol& L
+        );
+        friend CSCMatrix super_to_csc(const SupernodalChol& L);
+
         friend SparseSolution chol_lsolve(
             const CSCMatrix& L,
             const CSCMatrix& b,
@@ -1013,6 +1337,13 @@ class CSCMatrix
             const std::vector<double>& x
         );
 
+        friend void happly_inplace(
+            const CSCMatrix& V,
+            csint j,
+            double beta,
+            std::span<double> x
+        );
+
         friend std::vector<csint> find_leftmost(const CSCMatrix& A);
         friend void vcount(const CSCMatrix& A, SymbolicQR& S);
 
@@ -1020,6 +1351,36 @@ class CSCMatrix
         friend QRResult qr(const CSCMatrix& A, const SymbolicQR& S);
         friend void reqr(const CSCMatrix& A, const SymbolicQR& S, QRResult& res);
 
+        //----------------------------------------------------------------------
+        //        LU Decomposition
+        //----------------------------------------------------------------------
+        friend SymbolicLU slu(const CSCMatrix& A, AMDOrder order);
+        friend LUResult lu(const CSCMatrix& A, const SymbolicLU& S, double tol);
+
+        //----------------------------------------------------------------------
+        //        Fill-Reducing Orderings
+        //----------------------------------------------------------------------
+        friend CSCMatrix build_graph(const CSCMatrix& A, const AMDOrder order);
+        friend std::vector<csint> amd(const CSCMatrix& A, const AMDOrder order);
+
+        //----------------------------------------------------------------------
+        //        File I/O
+        //----------------------------------------------------------------------
+        friend CachedChol read_chol_cache(const std::string& filename, const CSCMatrix& A);
+        friend CachedQR read_qr_cache(const std::string& filename, const CSCMatrix& A);
+
+        //----------------------------------------------------------------------
+        //        Assembly
+        //----------------------------------------------------------------------
+        friend struct AssemblyPattern;
+
+        friend AssemblyPattern assembly_pattern(const COOMatrix& T);
+        friend AssemblyPattern assembly_pattern(
+            csint N,
+            const std::vector<csint>& elem_ptr,
+            const std::vector<csint>& elem_nodes
+        );
+
         //----------------------------------------------------------------------
         //        Printing
         //----------------------------------------------------------------------
@@ -1058,6 +1419,117 @@ class CSCMatrix
 };  // class CSCMatrix
 
 
+/*------------------------------------------------------------------------------
+ *          Linear Combinations
+ *----------------------------------------------------------------------------*/
+/** A lazy linear combination of matrices \f$ C = \sum_k \alpha_k A_k \f$.
+ *
+ * Start an expression with `LinearCombination(A, alpha)`, then combine it
+ * with matrices and other expressions by `+`, `-` and scalar `*`. It is only
+ * evaluated when it is converted to a `CSCMatrix`. The evaluation is a single
+ * pass over the union of the patterns of the terms, so that, e.g.
+ * `C = LinearCombination(A, alpha) + beta * B - D` allocates only `C` and
+ * `beta * B`. The operators on two matrices are eager and return a
+ * `CSCMatrix`.
+ *
+ * Matrices that are lvalues are referenced, and must outlive the expression.
+ * Temporary matrices are moved into the expression.
+ *
+ * @note The evaluated matrix may *not* have sorted columns!
+ */
+class LinearCombination
+{
+    std::vector<double> alpha_;                        // the coefficients
+    std::vector<const CSCMatrix *> terms_;             // the matrices
+    std::vector<std::shared_ptr<const CSCMatrix>> owned_;  // the temporaries
+
+    public:
+        /** Create the expression `alpha * A`, referencing `A`. */
+        explicit LinearCombination(const CSCMatrix& A, double alpha=1.0);
+
+        /** Create the expression `alpha * A`, moving `A` into the expression. */
+        explicit LinearCombination(CSCMatrix&& A, double alpha=1.0);
+
+        /** The number of terms in the expression. */
+        csint num_terms() const { return static_cast<csint>(terms_.size()); }
+
+        /** The shape of the evaluated matrix. */
+        Shape shape() const { return terms_.front()->shape(); }
+
+        /** Append the terms of another expression.
+         *
+         * @param other  an expression with the same shape
+         *
+         * @throws std::invalid_argument if the shapes do not match
+         */
+        LinearCombination& operator+=(const LinearCombination& other);
+
+        /** Scale all of the coefficients by `c`. */
+        LinearCombination& operator*=(double c);
+
+        /** Evaluate the expression into a new matrix.
+         *
+         * Each column of the output is accumulated from the same column of
+         * every term in one dense workspace, so the cost is \f$ O(M + N +
+         * \sum_k \text{nnz}(A_k)) \f$, with no intermediate matrices.
+         *
+         * @return C  the matrix \f$ \sum_k \alpha_k A_k \f$
+         */
+        CSCMatrix eval() const;
+
+        operator CSCMatrix() const { return eval(); }
+};
+
+
+/** A matrix or an expression, which can be an operand of a linear combination. */
+template <typename T>
+concept LinearOperand = std::same_as<std::remove_cvref_t<T>, CSCMatrix>
+                     || std::same_as<std::remove_cvref_t<T>, LinearCombination>;
+
+
+/** A pair of operands of which at least one is an expression. */
+template <typename L, typename R>
+concept LinearOperands = LinearOperand<L> && LinearOperand<R>
+    && (std::same_as<std::remove_cvref_t<L>, LinearCombination>
+        || std::same_as<std::remove_cvref_t<R>, LinearCombination>);
+
+
+template <typename L, typename R>
+    requires LinearOperands<L, R>
+LinearCombination operator+(L&& A, R&& B)
+{
+    LinearCombination C(std::forward<L>(A));
+    C += LinearCombination(std::forward<R>(B));
+    return C;
+}
+
+
+template <typename L, typename R>
+    requires LinearOperands<L, R>
+LinearCombination operator-(L&& A, R&& B)
+{
+    LinearCombination C(std::forward<L>(A));
+    C += LinearCombination(std::forward<R>(B)) *= -1.0;
+    return C;
+}
+
+
+template <typename S>
+    requires std::is_arithmetic_v<S>
+LinearCombination operator*(S c, LinearCombination A)
+{
+    return A *= c;
+}
+
+
+template <typename S>
+    requires std::is_arithmetic_v<S>
+LinearCombination operator*(LinearCombination A, S c)
+{
+    return A *= c;
+}
+
+
 /*------------------------------------------------------------------------------
  *          Free Functions
  *----------------------------------------------------------------------------*/
@@ -13,11 +13,24 @@
 
 #include "types.h"
 #include "utils.h"
+#include "parallel.h"
+#include "stats.h"
+#include "workspace.h"
+#include "simd.h"
 #include "csc.h"
+#include "csr.h"
+#include "compact.h"
 #include "coo.h"
+#include "assembly.h"
+#include "amd.h"
+#include "nd.h"
 #include "cholesky.h"
 #include "qr.h"
+#include "lu.h"
+#include "batch.h"
 #include "solve.h"
+#include "iterative.h"
+#include "io.h"
 
 #endif  // _CSPARSE_H_
 
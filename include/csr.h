@@ -0,0 +1,227 @@
+//==============================================================================
+//     File: csr.h
+//  Created: 2025-03-26 08:40
+//   Author: Bernie Roesler
+//
+//  Description: Implements the compressed sparse row matrix class.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_CSR_H_
+#define _CSPARSE_CSR_H_
+
+#include <span>
+#include <vector>
+
+#include "types.h"
+#include "csc.h"
+
+
+namespace cs {
+
+/** A compressed sparse row matrix.
+ *
+ * The rows of an M-by-N CSR matrix are stored exactly like the columns of its
+ * N-by-M transpose in CSC format. The matrix therefore wraps the CSC matrix
+ * of its transpose, and every row-oriented operation is the corresponding
+ * column-oriented kernel of `CSCMatrix` applied to the transpose.
+ *
+ * A `CSCMatrix` can keep a CSR matrix as a lazily built mirror (see
+ * `CSCMatrix::csr()`), which its own row-oriented operations then use.
+ */
+class CSRMatrix
+{
+    CSCMatrix AT_;  // the transpose, whose columns are the rows of this matrix
+
+    public:
+        //----------------------------------------------------------------------
+        //        Constructors
+        //----------------------------------------------------------------------
+        CSRMatrix();
+
+        /** Construct a CSRMatrix from arrays of values and indices.
+         *
+         * @param data  the non-zero values, in row-major order
+         * @param indices  the column indices of each value
+         * @param indptr  the row pointers, of size `M + 1`
+         * @param shape  the dimensions of the matrix
+         */
+        CSRMatrix(
+            const std::vector<double>& data,
+            const std::vector<csint>& indices,
+            const std::vector<csint>& indptr,
+            const Shape& shape
+        );
+
+        /** Convert a CSC matrix to CSR format.
+         *
+         * The conversion is one transpose of `A`. The column indices of each
+         * row are sorted.
+         */
+        explicit CSRMatrix(const CSCMatrix& A);
+
+        //----------------------------------------------------------------------
+        //        Accessors
+        //----------------------------------------------------------------------
+        csint nnz() const { return AT_.nnz(); }
+        Shape shape() const { auto [N, M] = AT_.shape(); return {M, N}; }
+
+        const std::vector<csint>& indices() const { return AT_.indices(); }
+        const std::vector<csint>& indptr() const { return AT_.indptr(); }
+        const std::vector<double>& data() const { return AT_.data(); }
+
+        bool has_canonical_format() const { return AT_.has_canonical_format(); }
+
+        /** Return the value of `A(i, j)`. */
+        double operator()(csint i, csint j) const { return AT_(j, i); }
+
+        /** Return the transpose as a CSC matrix, without copying. */
+        const CSCMatrix& T() const { return AT_; }
+
+        /** Convert to a CSC matrix, with sorted columns. */
+        CSCMatrix tocsc() const;
+
+        /** Convert to a dense matrix in column-major ('F') or row-major ('C')
+         * order. */
+        std::vector<double> to_dense_vector(const char order='F') const;
+
+        //----------------------------------------------------------------------
+        //        Math Operations
+        //----------------------------------------------------------------------
+        /** Matrix-vector multiply `y = Ax + y`.
+         *
+         * Each row is a contiguous dot product, so the threads need no
+         * reduction (see `CSCMatrix::gatxpy`).
+         */
+        std::vector<double> gaxpy(
+            const std::vector<double>& x,
+            const std::vector<double>& y,
+            int threads=0
+        ) const;
+
+        /** Matrix-vector multiply `y += Ax` in place. */
+        void gaxpy(
+            std::span<const double> x,
+            std::span<double> y,
+            int threads=0
+        ) const;
+
+        /** Matrix transpose-vector multiply `y = A.T x + y` (see
+         * `CSCMatrix::gaxpy`). */
+        std::vector<double> gatxpy(
+            const std::vector<double>& x,
+            const std::vector<double>& y,
+            int threads=0
+        ) const;
+
+        /** Matrix transpose-vector multiply `y += A.T x` in place. */
+        void gatxpy(
+            std::span<const double> x,
+            std::span<double> y,
+            int threads=0
+        ) const;
+
+        /** Matrix-vector right-multiply `y = Ax`. */
+        std::vector<double> dot(const std::vector<double>& x) const;
+
+        /** Matrix multiply `Y = AX + Y` for row-major dense matrices `X` and `Y`.
+         *
+         * Each row `Y(i, :)` is accumulated in vector registers while
+         * traversing row `i` of `A` (see `CSCMatrix::gatxpy_simd`).
+         */
+        std::vector<double> gaxpy_row(
+            const std::vector<double>& X,
+            const std::vector<double>& Y
+        ) const;
+
+        /** Matrix multiply `Y = A.T X + Y` for row-major dense matrices `X`
+         * and `Y` (see `CSCMatrix::gaxpy_simd`). */
+        std::vector<double> gatxpy_row(
+            const std::vector<double>& X,
+            const std::vector<double>& Y
+        ) const;
+
+        /** Sum the rows (`sum_rows`) or columns (`sum_cols`) of the matrix. */
+        std::vector<double> sum_rows() const;
+        std::vector<double> sum_cols() const;
+
+        //----------------------------------------------------------------------
+        //        Indexing
+        //----------------------------------------------------------------------
+        /** Slice a matrix by row and column with contiguous indices.
+         *
+         * Only the rows `i_start ... i_end - 1` are traversed.
+         *
+         * @param i_start, i_end  the row indices to keep, where `i ∈ [i_start, i_end)`.
+         * @param j_start, j_end  the column indices to keep, where `j ∈ [j_start, j_end)`.
+         *
+         * @return C  the submatrix of A of size `(i_end - i_start) x (j_end - j_start)`
+         *         in canonical CSC format.
+         */
+        CSCMatrix slice(
+            const csint i_start,
+            const csint i_end,
+            const csint j_start,
+            const csint j_end
+        ) const;
+
+        /** Select a submatrix by row and column indices.
+         *
+         * Only the selected rows are traversed. Each row and column may be
+         * selected more than once, in any order. Explicit zeros are dropped.
+         *
+         * @param rows, cols  the indices of the rows and columns to keep
+         *
+         * @return C  the submatrix `A(rows, cols)` in CSC format, with sorted
+         *         columns. It is canonical if this matrix is.
+         */
+        CSCMatrix index(
+            const std::vector<csint>& rows,
+            const std::vector<csint>& cols
+        ) const;
+};
+
+
+/*------------------------------------------------------------------------------
+ *          Row-Permuted Triangular Solves
+ *----------------------------------------------------------------------------*/
+/** Solve Lx = b with a row-permuted L stored by rows.
+ *
+ * The diagonal of each row is its largest column index, so the permutation is
+ * found with one pass over the rows, and each unknown is then a contiguous
+ * dot product with its row.
+ *
+ * @param A  a row-permuted lower-triangular matrix, with all of the diagonal
+ *        entries present
+ * @param b  a dense RHS vector, *not* permuted.
+ *
+ * @return x  the dense solution vector, also *not* permuted.
+ *
+ * @throws std::runtime_error if the matrix is not a row-permuted triangular
+ *         matrix.
+ */
+std::vector<double> lsolve_rows(const CSRMatrix& A, const std::vector<double>& b);
+
+
+/** Solve Ux = b with a row-permuted U stored by rows.
+ *
+ * The diagonal of each row is its smallest column index (see `lsolve_rows`).
+ *
+ * @param A  a row-permuted upper-triangular matrix, with all of the diagonal
+ *        entries present
+ * @param b  a dense RHS vector, *not* permuted.
+ *
+ * @return x  the dense solution vector, also *not* permuted.
+ *
+ * @throws std::runtime_error if the matrix is not a row-permuted triangular
+ *         matrix.
+ */
+std::vector<double> usolve_rows(const CSRMatrix& A, const std::vector<double>& b);
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_CSR_H_
+
+//==============================================================================
+//==============================================================================
@@ -0,0 +1,347 @@
+//==============================================================================
+//     File: io.h
+//  Created: 2025-03-14 14:02
+//   Author: Bernie Roesler
+//
+//  Description: Declarations for reading and writing matrices in the Matrix
+//      Market and native binary file formats, and factorizations in the
+//      native factor file format.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_IO_H_
+#define _CSPARSE_IO_H_
+
+#include <cstdint>
+#include <string>
+
+#include "types.h"
+#include "csc.h"
+#include "cholesky.h"  // SymbolicChol
+#include "qr.h"        // SymbolicQR, QRResult
+
+
+namespace cs {
+
+/*------------------------------------------------------------------------------
+ *          Matrix Market Format
+ *----------------------------------------------------------------------------*/
+/** Read a matrix from a file in Matrix Market coordinate format.
+ *
+ * The header line must be of the form
+ * ```
+ * %%MatrixMarket matrix coordinate <field> <symmetry>
+ * ```
+ * where `field` is one of `real`, `double`, `integer` or `pattern`, and
+ * `symmetry` is one of `general`, `symmetric` or `skew-symmetric`. The size
+ * line `M N nnz` is used to reserve storage for the entries. For symmetric
+ * matrices, only one triangle is stored in the file, and the off-diagonal
+ * entries are mirrored into the result.
+ *
+ * The file is memory-mapped and the entries are parsed in parallel. Each
+ * thread parses a block of lines, and the blocks are concatenated in file
+ * order, so the result does not depend on the number of threads.
+ *
+ * @param filename  the name of the file to read
+ * @param threads  the number of threads to use. If `threads <= 0`, use the
+ *        default from `get_num_threads()`.
+ *
+ * @return A  the matrix in triplet form, with 0-based indices. Duplicate
+ *         entries are kept, and will be summed on conversion to CSC.
+ *
+ * @throws std::runtime_error if the file cannot be read, or if the header or
+ *         any entry is malformed.
+ */
+COOMatrix read_matrix_market(const std::string& filename, int threads=0);
+
+
+/** Write a matrix to a file in Matrix Market coordinate format.
+ *
+ * The matrix is written as `coordinate real general`, with 1-based indices
+ * and values printed with enough digits to be read back exactly.
+ *
+ * @param filename  the name of the file to write
+ * @param A  the matrix to write
+ * @param threads  the number of threads used to format the entries. If
+ *        `threads <= 0`, use the default from `get_num_threads()`.
+ *
+ * @throws std::runtime_error if the file cannot be written
+ */
+void write_matrix_market(
+    const std::string& filename,
+    const CSCMatrix& A,
+    int threads=0
+);
+
+
+/*------------------------------------------------------------------------------
+ *          Native Binary Format
+ *----------------------------------------------------------------------------*/
+/** The header of the native binary CSC file format.
+ *
+ * The header is followed by the arrays `indptr` (`N + 1` values of type
+ * `csint`), `indices` (`nnz` values of type `csint`) and `data` (`nnz` values
+ * of type `double`), in native byte order and with no padding between them.
+ * The header size is a multiple of 8 bytes, so each array is aligned for
+ * direct access when the file is memory-mapped.
+ */
+struct BinaryHeader
+{
+    static constexpr char MAGIC[8] = {'C', 'S', 'P', 'A', 'R', 'S', 'E', '\0'};
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint32_t ENDIAN_MARK = 0x01020304;
+
+    char magic[8];             // file identifier
+    std::uint32_t version;     // format version
+    std::uint32_t byte_order;  // ENDIAN_MARK as written by the host
+    std::int64_t M;            // number of rows
+    std::int64_t N;            // number of columns
+    std::int64_t nnz;          // number of non-zeros
+    std::uint64_t index_size;  // sizeof(csint)
+    std::uint64_t value_size;  // sizeof(double)
+    std::uint64_t reserved;    // pad the header to 64 bytes
+};
+
+static_assert(sizeof(BinaryHeader) == 64);
+
+
+/** Read a matrix from a file in the native binary CSC format.
+ *
+ * The file is memory-mapped, and the arrays are copied into the matrix in
+ * bulk, without any parsing.
+ *
+ * @param filename  the name of the file to read
+ *
+ * @return A  the matrix
+ *
+ * @throws std::runtime_error if the file cannot be read, or if it is not a
+ *         binary CSC file written by a compatible host.
+ */
+CSCMatrix read_binary(const std::string& filename);
+
+
+/** Write a matrix to a file in the native binary CSC format.
+ *
+ * @param filename  the name of the file to write
+ * @param A  the matrix to write
+ *
+ * @throws std::runtime_error if the file cannot be written
+ */
+void write_binary(const std::string& filename, const CSCMatrix& A);
+
+
+/*------------------------------------------------------------------------------
+ *          Native Factor Format
+ *----------------------------------------------------------------------------*/
+/** The matrix that a factor file was computed from.
+ *
+ * The pattern hash covers the shape, column pointers and row indices of the
+ * matrix, and the values hash covers the pattern and the values, so a
+ * symbolic analysis can be reused when the patterns match, and a numeric
+ * factor when the values match too.
+ */
+struct FactorKey
+{
+    std::uint64_t pattern_hash = 0;  ///< hash of the pattern of `A`
+    std::uint64_t values_hash = 0;   ///< hash of the pattern and values of `A`
+    csint M = 0,                     ///< the shape of `A`
+          N = 0,
+          nnz = 0;                   ///< the number of entries of `A`
+
+    bool operator==(const FactorKey&) const = default;
+};
+
+
+/** The kind of factorization stored in a factor file. */
+enum class FactorKind : std::uint32_t
+{
+    Cholesky = 1,  ///< a `SymbolicChol`, and optionally the factor `L`
+    QR = 2         ///< a `SymbolicQR`, and optionally the `QRResult`
+};
+
+
+/** The header of the native factor file format.
+ *
+ * The header is followed by a sequence of arrays, each stored as its length
+ * (one `std::uint64_t`) and its values, in native byte order. All values are
+ * 8 bytes, so each array is aligned for direct access when the file is
+ * memory-mapped. A matrix is stored as the array `{M, N, flags}`, followed by
+ * the arrays `indptr`, `indices` and `data`.
+ *
+ * The arrays of a Cholesky file are `p_inv`, `parent`, `cp`, `{lnz, anz}`,
+ * the matrix `C` and `C_map`, followed by the matrix `L` if `has_factor` is
+ * set. The arrays of a QR file are `p_inv`, `q`, `parent`, `leftmost` and
+ * `{m2, vnz, rnz}`, followed by the matrix `V`, `beta`, the matrix `R`,
+ * `p_inv` and `q` of the `QRResult` if `has_factor` is set.
+ *
+ * The payload hash covers every 8-byte word after the header, so that a
+ * corrupted file is rejected before its arrays are used.
+ */
+struct FactorHeader
+{
+    static constexpr char MAGIC[8] = {'C', 'S', 'F', 'A', 'C', 'T', 'O', 'R'};
+    static constexpr std::uint32_t VERSION = 2;
+
+    char magic[8];               // file identifier
+    std::uint32_t version;       // format version
+    std::uint32_t byte_order;    // BinaryHeader::ENDIAN_MARK as written by the host
+    std::uint32_t kind;          // the FactorKind
+    std::uint32_t has_factor;    // 1 if the numeric factor follows the analysis
+    std::uint64_t pattern_hash;  // the FactorKey of the analyzed matrix
+    std::uint64_t values_hash;
+    std::int64_t M;
+    std::int64_t N;
+    std::int64_t nnz;
+    std::uint64_t index_size;    // sizeof(csint)
+    std::uint64_t value_size;    // sizeof(double)
+    std::uint64_t payload_hash;  // hash of the arrays that follow the header
+    std::uint64_t reserved;      // pad the header to 96 bytes
+};
+
+static_assert(sizeof(FactorHeader) == 96);
+
+
+/** A Cholesky analysis and factor read from a factor file. */
+struct CachedChol
+{
+    SymbolicChol S;           ///< the symbolic analysis
+    CSCMatrix L;              ///< the numeric factor, if `has_factor`
+    bool has_factor = false;  ///< true if `L` is the factor of the given `A`
+};
+
+
+/** A QR analysis and factorization read from a factor file. */
+struct CachedQR
+{
+    SymbolicQR S;             ///< the symbolic analysis
+    QRResult res;             ///< the numeric factorization, if `has_factor`
+    bool has_factor = false;  ///< true if `res` is the factorization of the given `A`
+};
+
+
+/** Compute the key of a matrix.
+ *
+ * Only the used part of the arrays is hashed, in case `nzmax > nnz`.
+ *
+ * @param A  the matrix
+ *
+ * @return key  the hashes and dimensions of `A`
+ */
+FactorKey factor_key(const CSCMatrix& A);
+
+
+/** Compute the hash of the pattern of a matrix.
+ *
+ * @param A  the matrix
+ *
+ * @return h  the `pattern_hash` of `factor_key(A)`, without hashing the values
+ */
+std::uint64_t pattern_hash(const CSCMatrix& A);
+
+
+/** Read the key of the matrix that a factor file was computed from.
+ *
+ * Only the header is read, so a cache can be checked without loading it.
+ *
+ * @param filename  the name of the file to read
+ *
+ * @return key  the key stored in the file
+ *
+ * @throws std::runtime_error if the file cannot be read, or if it is not a
+ *         factor file written by a compatible host.
+ */
+FactorKey read_factor_key(const std::string& filename);
+
+
+/** Write a Cholesky analysis, and optionally its factor, to a factor file.
+ *
+ * The file is written under a temporary name and then renamed, so a reader
+ * never sees a partially written file.
+ *
+ * @param filename  the name of the file to write
+ * @param A  the matrix that was analyzed, whose key is stored in the file
+ * @param S  the symbolic analysis of `A` from `cs::schol()`
+ * @param L  the numeric factor of `A` from `cs::chol()`, if any
+ *
+ * @throws std::runtime_error if the file cannot be written
+ */
+void write_chol_cache(
+    const std::string& filename,
+    const CSCMatrix& A,
+    const SymbolicChol& S
+);
+
+void write_chol_cache(
+    const std::string& filename,
+    const CSCMatrix& A,
+    const SymbolicChol& S,
+    const CSCMatrix& L
+);
+
+
+/** Read a Cholesky analysis, and its factor, from a factor file.
+ *
+ * The file is memory-mapped, and the arrays are copied out in bulk. The factor
+ * is read only if the file has one, and `A` has the same values as the matrix
+ * it was computed from. Otherwise, `S` can be passed to `cs::chol()` to
+ * refactor `A` without repeating the analysis.
+ *
+ * @param filename  the name of the file to read
+ * @param A  the matrix to factor
+ *
+ * @return C  the analysis, and the factor if `C.has_factor`
+ *
+ * @throws std::runtime_error if the file cannot be read, if it is not a
+ *         Cholesky factor file written by a compatible host, or if `A` does
+ *         not have the pattern of the matrix that was analyzed.
+ */
+CachedChol read_chol_cache(const std::string& filename, const CSCMatrix& A);
+
+
+/** Write a QR analysis, and optionally its factorization, to a factor file.
+ *
+ * See `write_chol_cache`.
+ *
+ * @param filename  the name of the file to write
+ * @param A  the matrix that was analyzed, whose key is stored in the file
+ * @param S  the symbolic analysis of `A` from `cs::sqr()`
+ * @param res  the numeric factorization of `A` from `cs::qr()`, if any
+ *
+ * @throws std::runtime_error if the file cannot be written
+ */
+void write_qr_cache(
+    const std::string& filename,
+    const CSCMatrix& A,
+    const SymbolicQR& S
+);
+
+void write_qr_cache(
+    const std::string& filename,
+    const CSCMatrix& A,
+    const SymbolicQR& S,
+    const QRResult& res
+);
+
+
+/** Read a QR analysis, and its factorization, from a factor file.
+ *
+ * See `read_chol_cache`.
+ *
+ * @param filename  the name of the file to read
+ * @param A  the matrix to factor
+ *
+ * @return C  the analysis, and the factorization if `C.has_factor`
+ *
+ * @throws std::runtime_error if the file cannot be read, if it is not a QR
+ *         factor file written by a compatible host, or if `A` does not have
+ *         the pattern of the matrix that was analyzed.
+ */
+CachedQR read_qr_cache(const std::string& filename, const CSCMatrix& A);
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_IO_H_
+
+//==============================================================================
+//==============================================================================
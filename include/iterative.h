@@ -0,0 +1,185 @@
+//==============================================================================
+//     File: iterative.h
+//  Created: 2025-03-23 10:15
+//   Author: Bernie Roesler
+//
+//  Description: Preconditioned Krylov solvers for large sparse systems.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_ITERATIVE_H_
+#define _CSPARSE_ITERATIVE_H_
+
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "types.h"
+#include "csc.h"
+
+
+namespace cs {
+
+/** A preconditioner \f$ z = M^{-1} r \f$.
+ *
+ * The function is called once per iteration with the residual `r`, and must
+ * write the preconditioned residual into `z`, without allocating. An empty
+ * function is the identity.
+ */
+using Preconditioner = std::function<void(std::span<const double> r,
+                                          std::span<double> z)>;
+
+
+/** The solution and iteration statistics of an iterative solver. */
+struct IterativeResult
+{
+    std::vector<double> x;         ///< the solution
+    csint iterations = 0;          ///< the number of iterations performed
+    double residual = 0;           ///< the true \f$ \|b - Ax\| / \|b\| \f$ at exit
+    bool converged = false;        ///< true if the tolerance was reached
+    std::vector<double> history;   ///< the relative residual at each iteration
+};
+
+
+/** Create a Jacobi (diagonal) preconditioner.
+ *
+ * @param A  a square matrix with a non-zero diagonal
+ *
+ * @return M  the preconditioner \f$ z = r ./ \text{diag}(A) \f$
+ *
+ * @throws std::runtime_error if `A` is not square, or has a zero diagonal.
+ */
+Preconditioner jacobi_preconditioner(const CSCMatrix& A);
+
+
+/** Create a preconditioner from an incomplete Cholesky factor.
+ *
+ * The factor is copied into the preconditioner, which solves
+ * \f$ L L^T z = r \f$ in place in `z`.
+ *
+ * @param L  a lower triangular factor, e.g. from `cs::ichol()`, with the
+ *        diagonal as the first entry of each column.
+ *
+ * @return M  the preconditioner \f$ z = (L L^T)^{-1} r \f$
+ *
+ * @throws std::runtime_error if `L` is not square.
+ */
+Preconditioner ichol_preconditioner(const CSCMatrix& L);
+
+
+/** Solve \f$ Ax = b \f$ with the preconditioned conjugate gradient method.
+ *
+ * Each iteration makes one pass over `A` that also computes \f$ p^T A p \f$,
+ * one fused pass for the updates of `x` and `r` and the residual norm, and one
+ * pass for the search direction. All of the work vectors are allocated once.
+ *
+ * The products with `A` are split over the threads by blocks of columns with
+ * equal numbers of non-zeros, and each thread writes its own block of
+ * \f$ Ap \f$, as in `CSCMatrix::gatxpy`. Small matrices use one thread. The vector updates take \f$ O(N) \f$ of the
+ * \f$ O(\text{nnz}(A)) \f$ work per iteration, and are serial, as is the
+ * preconditioner.
+ *
+ * @param A  a symmetric positive definite matrix, with both triangles stored
+ * @param b  the right-hand side
+ * @param M  the preconditioner, which must be symmetric positive definite
+ * @param tol  the relative tolerance on \f$ \|r\| / \|b\| \f$
+ * @param max_iter  the maximum number of iterations. If `max_iter <= 0`, use
+ *        `N`.
+ * @param x0  the initial guess. If empty, use zero.
+ * @param threads  the number of threads for the products with `A`. If
+ *        `threads <= 0`, use the default from `get_num_threads()`.
+ *
+ * @return res  the solution and iteration statistics
+ *
+ * @throws std::runtime_error if the sizes of the inputs do not match, or if
+ *         `A` or `M` is found to be indefinite.
+ */
+IterativeResult pcg(
+    const CSCMatrix& A,
+    const std::vector<double>& b,
+    const Preconditioner& M={},
+    double tol=1e-8,
+    csint max_iter=0,
+    const std::vector<double>& x0={},
+    int threads=0
+);
+
+
+/** Solve \f$ Ax = b \f$ with the preconditioned MINRES method.
+ *
+ * See: Paige and Saunders (1975), and `scipy.sparse.linalg.minres`.
+ *
+ * The convergence test uses the recursive estimate of the residual relative
+ * to `b`, both in the norm of the preconditioner, which is the 2-norm when
+ * there is no preconditioner. The products with `A` are multithreaded as in
+ * `pcg`.
+ *
+ * @param A  a symmetric, possibly indefinite, matrix, with both triangles
+ *        stored
+ * @param b  the right-hand side
+ * @param M  the preconditioner, which must be symmetric positive definite
+ * @param tol  the relative tolerance on \f$ \|r\|_M / \|b\|_M \f$
+ * @param max_iter  the maximum number of iterations. If `max_iter <= 0`, use
+ *        `N`.
+ * @param x0  the initial guess. If empty, use zero.
+ * @param threads  the number of threads for the products with `A`. If
+ *        `threads <= 0`, use the default from `get_num_threads()`.
+ *
+ * @return res  the solution and iteration statistics
+ *
+ * @throws std::runtime_error if the sizes of the inputs do not match, or if
+ *         `M` is found to be indefinite.
+ */
+IterativeResult minres(
+    const CSCMatrix& A,
+    const std::vector<double>& b,
+    const Preconditioner& M={},
+    double tol=1e-8,
+    csint max_iter=0,
+    const std::vector<double>& x0={},
+    int threads=0
+);
+
+
+/** Solve \f$ Ax = b \f$ with the restarted, right-preconditioned GMRES method.
+ *
+ * The Arnoldi basis is orthogonalized with modified Gram-Schmidt, fusing each
+ * projection with the inner product of the next one, and the least-squares
+ * problem is updated with Givens rotations. The products with `A` use
+ * `CSCMatrix::gaxpy`, with a partial result per thread, and the rest is
+ * serial.
+ *
+ * @param A  a square matrix
+ * @param b  the right-hand side
+ * @param M  the preconditioner
+ * @param tol  the relative tolerance on \f$ \|r\| / \|b\| \f$
+ * @param max_iter  the maximum total number of iterations. If
+ *        `max_iter <= 0`, use `N`.
+ * @param restart  the number of iterations between restarts. If
+ *        `restart <= 0`, use `N`.
+ * @param x0  the initial guess. If empty, use zero.
+ * @param threads  the number of threads for the products with `A`. If
+ *        `threads <= 0`, use the default from `get_num_threads()`.
+ *
+ * @return res  the solution and iteration statistics
+ *
+ * @throws std::runtime_error if the sizes of the inputs do not match.
+ */
+IterativeResult gmres(
+    const CSCMatrix& A,
+    const std::vector<double>& b,
+    const Preconditioner& M={},
+    double tol=1e-8,
+    csint max_iter=0,
+    csint restart=30,
+    const std::vector<double>& x0={},
+    int threads=0
+);
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_ITERATIVE_H_
+
+//==============================================================================
+//==============================================================================
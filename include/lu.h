@@ -0,0 +1,128 @@
+//==============================================================================
+//     File: lu.h
+//  Created: 2025-03-17 09:12
+//   Author: Bernie Roesler
+//
+//  Description: Declarations for the sparse LU decomposition.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_LU_H_
+#define _CSPARSE_LU_H_
+
+#include <vector>
+
+#include "csc.h"
+#include "types.h"
+
+
+namespace cs {
+
+/** Symbolic LU decomposition return struct (see: cs_symbolic aka css) */
+struct SymbolicLU
+{
+    std::vector<csint> q;  ///< fill-reducing column permutation
+
+    csint lnz,  ///< initial guess for # entries in L
+          unz;  ///< initial guess for # entries in U
+};
+
+
+/** Numeric LU decomposition return struct (see: cs_numeric aka csn) */
+struct LUResult
+{
+    CSCMatrix L;                  ///< the unit lower triangular factor
+    CSCMatrix U;                  ///< the upper triangular factor
+    std::vector<csint> p_inv, q;  ///< row and column permutations
+};
+
+
+/** Compute the symbolic LU decomposition of a square matrix.
+ *
+ * The symbolic analysis computes the column ordering, and an initial guess for
+ * the number of non-zeros in `L` and `U`. Since the row permutation is only
+ * known during the numeric factorization, the factors may grow if the guess
+ * is too small.
+ *
+ * See: Davis, Section 6.1 and `cs_sqr`.
+ *
+ * @param A  the matrix to factor
+ * @param order  the ordering method to use. `ATANoDenseRows` is recommended
+ *        for LU decomposition, since the pattern of \f$ A^T A \f$ is an upper
+ *        bound on the pattern of `L` and `U` for any row permutation.
+ *
+ * @return S  the symbolic factorization
+ */
+SymbolicLU slu(const CSCMatrix& A, AMDOrder order=AMDOrder::Natural);
+
+
+/** Compute the LU decomposition of a square matrix.
+ *
+ * This function is a left-looking (Gilbert-Peierls) algorithm. Each column of
+ * `L` and `U` is computed by solving a sparse triangular system with the
+ * columns of `L` computed so far, in time proportional to the number of
+ * floating-point operations. The pivot in each column is chosen by threshold
+ * partial pivoting: the diagonal entry is used if its magnitude is at least
+ * `tol` times the largest magnitude in the column, and the largest entry is
+ * used otherwise.
+ *
+ * The decomposition is given by
+ * \f[
+ *     P A Q = L U,
+ * \f]
+ * where `L` is unit lower triangular with the diagonal as the first entry of
+ * each column, and `U` is upper triangular with the diagonal as the last entry
+ * of each column.
+ *
+ * See: Davis, Section 6.2 and `cs_lu`.
+ *
+ * @param A  the matrix to factor
+ * @param S  the symbolic factorization from `slu`
+ * @param tol  the pivot tolerance, in [0, 1]. `tol = 1.0` is partial
+ *        pivoting, and `tol = 0.0` always chooses the diagonal, if it is
+ *        non-zero.
+ *
+ * @return res  the numeric factorization, with the row permutation `p_inv` and
+ *         the column permutation `q`.
+ *
+ * @throws std::runtime_error if the matrix is structurally or numerically
+ *         singular.
+ */
+LUResult lu(const CSCMatrix& A, const SymbolicLU& S, double tol=1.0);
+
+
+/** Solve the system \f$ Ax = b \f$ with the LU decomposition.
+ *
+ * See: Davis, Section 8.1 and `cs_lusolve`.
+ *
+ * @param A  the square system matrix
+ * @param b  the dense right-hand side vector
+ * @param order  the column ordering method (see `slu`)
+ * @param tol  the pivot tolerance (see `lu`)
+ *
+ * @return x  the solution vector
+ */
+std::vector<double> lusolve(
+    const CSCMatrix& A,
+    const std::vector<double>& b,
+    AMDOrder order=AMDOrder::ATANoDenseRows,
+    double tol=1.0
+);
+
+
+/** Solve the system \f$ Ax = b \f$ with an existing LU decomposition.
+ *
+ * @param res  the numeric factorization of `A` from `lu`
+ * @param b  the dense right-hand side vector
+ *
+ * @return x  the solution vector
+ */
+std::vector<double> lusolve(const LUResult& res, const std::vector<double>& b);
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_LU_H_
+
+//==============================================================================
+//==============================================================================
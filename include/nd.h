@@ -0,0 +1,77 @@
+//==============================================================================
+//     File: nd.h
+//  Created: 2025-03-28 09:30
+//   Author: Bernie Roesler
+//
+//  Description: Declarations for the nested dissection fill-reducing
+//      ordering.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_ND_H_
+#define _CSPARSE_ND_H_
+
+#include <vector>
+
+#include "csc.h"
+#include "types.h"
+
+
+namespace cs {
+
+/*------------------------------------------------------------------------------
+ *          Nested Dissection
+ *----------------------------------------------------------------------------*/
+/** Find a vertex separator of a graph by multilevel bisection.
+ *
+ * The graph is coarsened by heavy-edge matching, until it is small or the
+ * matching stops reducing it. The coarsest graph is bisected by growing a
+ * region from several starting vertices, and the bisection is refined by
+ * Fiduccia-Mattheyses passes as it is projected back to each finer graph.
+ * The edges cut by the bisection are then covered greedily by a set of
+ * vertices, which is the separator.
+ *
+ * @param C  the symmetric pattern of the graph, without its diagonal, as
+ *        returned by `build_graph`
+ * @param seed  the seed of the random order of the matchings
+ *
+ * @return part  the part of each vertex: 0 or 1 for the two halves, or 2 for
+ *         the separator. No edge joins part 0 to part 1.
+ */
+std::vector<csint> vertex_separator(const CSCMatrix& C, unsigned seed=0);
+
+
+/** Compute the nested dissection ordering of a matrix.
+ *
+ * The graph of the matrix is split by a vertex separator (see
+ * `vertex_separator`) into two halves, which are ordered recursively, and
+ * the separator is ordered last. Subgraphs with at most `leaf_size` vertices
+ * are ordered by minimum degree (see `amd`).
+ *
+ * On 2D meshes, the fill is competitive with minimum degree (about 10-20%
+ * more), and on large 3D meshes it is less. In both cases the elimination
+ * tree is balanced and 20-50% shorter, with independent subtrees of similar
+ * size for the tree-scheduled factorizations.
+ *
+ * @param A  the matrix to order
+ * @param graph  the graph to order, `APlusAT` for Cholesky, `ATA` or
+ *        `ATANoDenseRows` for QR and LU (see `build_graph`)
+ * @param leaf_size  the largest subgraph that is ordered by minimum degree
+ *
+ * @return p  the fill-reducing permutation vector of length `N`, as for `amd`
+ *
+ * @throws std::runtime_error if `graph` is `Natural` or `NestedDissection`.
+ */
+std::vector<csint> nested_dissection(
+    const CSCMatrix& A,
+    const AMDOrder graph=AMDOrder::APlusAT,
+    csint leaf_size=256
+);
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_ND_H_
+
+//==============================================================================
+//==============================================================================
@@ -0,0 +1,95 @@
+//==============================================================================
+//     File: parallel.h
+//  Created: 2025-03-12 09:31
+//   Author: Bernie Roesler
+//
+//  Description: Thread configuration and scheduling helpers for the
+//      multithreaded kernels.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_PARALLEL_H_
+#define _CSPARSE_PARALLEL_H_
+
+#include <functional>
+#include <vector>
+
+#include "types.h"
+
+
+namespace cs {
+
+/** Minimum number of non-zeros per thread for a parallel kernel.
+ *
+ * Below this size, the cost of waking the worker threads and joining them
+ * (about 20 us for 4 threads) exceeds the work, so the kernels fall back to
+ * their serial versions.
+ */
+constexpr csint MIN_NNZ_PER_THREAD = 16384;
+
+
+/** Get the default number of threads used by the multithreaded kernels.
+ *
+ * The default is 1 (serial) until it is changed by `set_num_threads`.
+ *
+ * @return nthreads  the default number of threads
+ */
+int get_num_threads();
+
+
+/** Set the default number of threads used by the multithreaded kernels.
+ *
+ * @param nthreads  the number of threads. If `nthreads <= 0`, use the number
+ *        of hardware threads available.
+ */
+void set_num_threads(int nthreads);
+
+
+/** Determine the number of threads to use for a kernel.
+ *
+ * @param threads  the requested number of threads. If `threads <= 0`, use the
+ *        default from `get_num_threads()`.
+ * @param work  the amount of work to split, typically the number of non-zeros
+ *
+ * @return nthreads  the number of threads to use, such that each thread has at
+ *         least `MIN_NNZ_PER_THREAD` units of work.
+ */
+int resolve_num_threads(int threads, csint work);
+
+
+/** Partition the columns of a matrix into contiguous blocks with approximately
+ * equal numbers of non-zeros.
+ *
+ * @param indptr  the column pointers of the matrix, of length `N + 1`
+ * @param nparts  the number of partitions
+ *
+ * @return bounds  a vector of length `nparts + 1`, where partition `t`
+ *         consists of columns `bounds[t] ... bounds[t+1]-1`.
+ */
+std::vector<csint> partition_nnz(const std::vector<csint>& indptr, int nparts);
+
+
+/** Run a function on `nthreads` threads.
+ *
+ * The calling thread runs `f(0)`, and `nthreads - 1` worker threads run
+ * `f(1) ... f(nthreads - 1)` concurrently. The function returns when all
+ * threads are done.
+ *
+ * The workers are persistent threads, which are started on first use and
+ * reused by later calls, so they keep their thread-local state (e.g. their
+ * default `Workspace`) between calls.
+ *
+ * @param nthreads  the number of threads
+ * @param f  the function to run, called with the thread index
+ *
+ * @throws  the first exception thrown by `f`, once all threads are done
+ */
+void parallel_for(int nthreads, const std::function<void(int)>& f);
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_PARALLEL_H_
+
+//==============================================================================
+//==============================================================================
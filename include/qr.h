@@ -11,6 +11,7 @@
 #ifndef _CSPARSE_QR_H_
 #define _CSPARSE_QR_H_
 
+#include <cstdint>
 #include <span>
 #include <vector>
 
@@ -40,6 +41,8 @@ struct SymbolicQR
     csint m2,   ///< # of rows for QR, after adding fictitious rows
           vnz,  ///< # entries in V
           rnz;  ///< # entries in R
+
+    std::uint64_t pattern_hash = 0;  ///< `pattern_hash` of the analyzed `A`
 };
 
 
@@ -82,6 +85,17 @@ struct QRResult {
 Householder house(std::span<const double> x);
 
 
+/** Compute the Householder reflection of a vector in place.
+ *
+ * See `house`, which copies `x` into the Householder vector.
+ *
+ * @param[in,out] x  the input vector. On output, the Householder vector `v`.
+ * @param[out] beta  the scaling factor
+ * @param[out] s  the first element of `Hx`
+ */
+void house_inplace(std::span<double> x, double& beta, double& s);
+
+
 /** Apply a Householder reflection to a dense vector `x` with a sparse `v`.
  *
  * The Householder reflection is applied as
@@ -106,6 +120,25 @@ std::vector<double> happly(
 );
 
 
+/** Apply a Householder reflection to a dense vector `x` in place.
+ *
+ * Only the entries of `x` in the pattern of `V(:, j)` are read or written, so
+ * the cost is \f$ O(|V(:, j)|) \f$ instead of \f$ O(M) \f$.
+ *
+ * @param V  a CSCMatrix containing the Householder vector
+ * @param j  the column index of the Householder vector in `V`
+ * @param beta  the scaling factor
+ * @param[in,out] x  the dense vector to which to apply the reflection. On
+ *        output, `x` is overwritten with \f$ Hx \f$.
+ */
+void happly_inplace(
+    const CSCMatrix& V,
+    csint j,
+    double beta,
+    std::span<double> x
+);
+
+
 /** Compute the leftmost non-zero row index of each row in `A`.
  *
  * @param A  a CSCMatrix
@@ -150,6 +183,7 @@ void vcount(const CSCMatrix& A, SymbolicQR& S);
  *       - 1: amd(A + A.T)
  *       - 2: amd(A.T * A) with no dense rows
  *       - 3: amd(A.T * A)
+ *       - 4: nested_dissection(A.T * A)
  * @param use_postorder  if true, postorder the matrix in addition to the AMD
  *        (or natural) ordering. See: Davis, Exercise 5.5.
  *
@@ -212,6 +246,122 @@ QRResult qr(const CSCMatrix& A, const SymbolicQR& S);
 void reqr(const CSCMatrix& A, const SymbolicQR& S, QRResult& res);
 
 
+/** Multifrontal QR decomposition return struct.
+ *
+ * The columns of `A(:, q)` are grouped into fronts, which are the fundamental
+ * supernodes of the column elimination tree `S.parent`. Each front is a dense
+ * matrix that is assembled from the rows of `A` whose leftmost column is one
+ * of its pivots, and from the contribution blocks of its children. It is
+ * factored with blocked Householder reflections in compact WY form
+ * \f$ H_1 \cdots H_b = I - V T V^T \f$, and its trailing rows become the
+ * contribution block of its parent.
+ *
+ * The rows of each front are "slots": slot `i < M` is row `i` of `A`, and the
+ * slots `M <= i < m2` are fictitious rows of zeros, which are added to the
+ * fronts with fewer rows than pivots.
+ */
+struct MultifrontalQR
+{
+    csint M = 0,   ///< # of rows of A
+          N = 0,   ///< # of columns of A
+          m2 = 0,  ///< # of slots, after adding fictitious rows
+          block_size = 0;  ///< # of reflections in each panel
+
+    CSCMatrix R;               ///< the `N x N` upper triangular factor of A(:, q)
+    std::vector<csint> q,      ///< fill-reducing column permutation
+                       rows;   ///< row `r` of \f$ Q^T A(:, q) \f$ is slot `rows[r]`
+
+    std::vector<csint> super,       ///< front `f` has pivots `super[f]:super[f+1]`
+                       front_ptr,   ///< the slots of front `f` are
+                       front_rows,  ///< `front_rows[front_ptr[f]:front_ptr[f+1]]`
+                       H_ptr,       ///< offsets of the reflections of each front
+                       T_ptr;       ///< offsets of the T factors of each front
+
+    std::vector<double> H,  ///< `m x h` unit lower trapezoidal reflections
+                        T;  ///< upper triangular T factor of each panel
+
+    /// The number of fronts.
+    csint num_fronts() const { return static_cast<csint>(super.size()) - 1; }
+};
+
+
+/** Perform the numeric QR decomposition of a matrix with dense fronts.
+ *
+ * The fronts are factored in the order of their pivots, which is a
+ * topological order of the elimination tree. The R factor is the same as that
+ * of `cs::qr`, up to the signs of its rows, but the Householder reflections
+ * are stored in dense blocks, and are applied with `apply_qt` and `apply_q`.
+ *
+ * @param A  the `M x N` matrix to factorize, with `M >= N`
+ * @param S  the symbolic analysis of A, from `cs::sqr`
+ * @param block_size  the number of reflections in each panel
+ *
+ * @return the numeric factorization
+ *
+ * @throws std::runtime_error if `M < N`, or `block_size < 1`.
+ */
+MultifrontalQR qr_multifrontal(
+    const CSCMatrix& A,
+    const SymbolicQR& S,
+    csint block_size=32
+);
+
+
+/** Apply \f$ Q^T \f$ of a multifrontal QR factorization to a dense block.
+ *
+ * @param F  the multifrontal factorization of `A`
+ * @param B  a dense `M x K` matrix, in column-major order
+ *
+ * @return Y  the dense `m2 x K` matrix \f$ Q^T B \f$, in column-major order.
+ *         The first `N` rows correspond to the rows of `F.R`.
+ */
+std::vector<double> apply_qt(const MultifrontalQR& F, const std::vector<double>& B);
+
+
+/** Apply \f$ Q \f$ of a multifrontal QR factorization to a dense block.
+ *
+ * This function is the inverse of `apply_qt`, so that
+ * `apply_q(F, apply_qt(F, B)) == B`.
+ *
+ * @param F  the multifrontal factorization of `A`
+ * @param Y  a dense `m2 x K` matrix, in column-major order
+ *
+ * @return B  the dense `M x K` matrix \f$ Q Y \f$, in column-major order,
+ *         without the fictitious rows.
+ */
+std::vector<double> apply_q(const MultifrontalQR& F, const std::vector<double>& Y);
+
+
+/** Solve the least-squares problems \f$ \min \|A x - b\| \f$ for a block of
+ * right-hand sides.
+ *
+ * @param F  the multifrontal factorization of `A`
+ * @param B  a dense `M x K` matrix of right-hand sides, in column-major order
+ *
+ * @return X  the dense `N x K` solution, in column-major order
+ */
+std::vector<double> qrsolve(const MultifrontalQR& F, const std::vector<double>& B);
+
+
+/** Solve the least-squares problem \f$ \min \|A x - b\| \f$.
+ *
+ * See: Davis, Section 8.1 and `cs_qrsol` for `M >= N`.
+ *
+ * @param A  the `M x N` system matrix, with `M >= N`
+ * @param b  the dense right-hand side vector, or an `M x K` block
+ * @param order  the column ordering method (see `sqr`)
+ *
+ * @return x  the solution vector
+ *
+ * @throws std::runtime_error if `M < N`.
+ */
+std::vector<double> qrsolve(
+    const CSCMatrix& A,
+    const std::vector<double>& b,
+    AMDOrder order=AMDOrder::ATA
+);
+
+
 
 }  // namespace cs
 
@@ -0,0 +1,89 @@
+//==============================================================================
+//     File: simd.h
+//  Created: 2025-03-14 11:05
+//   Author: Bernie Roesler
+//
+//  Description: Minimal wrappers around the SIMD intrinsics used by the
+//      multiple right-hand side kernels. The vector width is chosen at compile
+//      time from the target instruction set:
+//
+//      - AVX-512: 8 doubles
+//      - AVX2 + FMA: 4 doubles
+//      - NEON (AArch64): 2 doubles
+//      - otherwise: 1 double (scalar fallback)
+//
+//      There is no runtime dispatch. The default build does not enable any of
+//      these instruction sets, so it uses the scalar fallback unless it is
+//      configured with CSPARSE_NATIVE_ARCH (or `make ARCH=-march=native`).
+//      `isa` names the instruction set that was compiled in.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_SIMD_H_
+#define _CSPARSE_SIMD_H_
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#elif defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "types.h"
+
+
+namespace cs::simd {
+
+#if defined(__AVX512F__)
+
+using vec = __m512d;
+constexpr csint width = 8;
+constexpr const char* isa = "AVX-512";
+
+inline vec load(const double* p) { return _mm512_loadu_pd(p); }
+inline void store(double* p, vec a) { _mm512_storeu_pd(p, a); }
+inline vec set1(double a) { return _mm512_set1_pd(a); }
+inline vec fmadd(vec a, vec b, vec c) { return _mm512_fmadd_pd(a, b, c); }
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+using vec = __m256d;
+constexpr csint width = 4;
+constexpr const char* isa = "AVX2";
+
+inline vec load(const double* p) { return _mm256_loadu_pd(p); }
+inline void store(double* p, vec a) { _mm256_storeu_pd(p, a); }
+inline vec set1(double a) { return _mm256_set1_pd(a); }
+inline vec fmadd(vec a, vec b, vec c) { return _mm256_fmadd_pd(a, b, c); }
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+using vec = float64x2_t;
+constexpr csint width = 2;
+constexpr const char* isa = "NEON";
+
+inline vec load(const double* p) { return vld1q_f64(p); }
+inline void store(double* p, vec a) { vst1q_f64(p, a); }
+inline vec set1(double a) { return vdupq_n_f64(a); }
+inline vec fmadd(vec a, vec b, vec c) { return vfmaq_f64(c, a, b); }
+
+#else
+
+using vec = double;
+constexpr csint width = 1;
+constexpr const char* isa = "scalar";
+
+inline vec load(const double* p) { return *p; }
+inline void store(double* p, vec a) { *p = a; }
+inline vec set1(double a) { return a; }
+inline vec fmadd(vec a, vec b, vec c) { return a * b + c; }
+
+#endif
+
+}  // namespace cs::simd
+
+#endif  // _CSPARSE_SIMD_H_
+
+//==============================================================================
+//==============================================================================
@@ -12,6 +12,7 @@
 
 #include <vector>
 
+#include "csc.h"
 #include "types.h"
 
 
@@ -23,11 +24,50 @@ struct SparseSolution {
 };
 
 
+/** A reusable workspace for sparse triangular solves.
+ *
+ * The nodes visited by the depth-first search are marked with a generation
+ * stamp, which is incremented for each solve, so the marks never need to be
+ * cleared. The dense values are cleared only on the pattern of each solution.
+ * After the first allocation, a solve therefore costs O(|x| + flops), and not
+ * O(N).
+ */
+struct SpsolveWorkspace {
+    std::vector<csint> mark;    ///< node `j` is visited if `mark[j] == stamp`
+    csint stamp = 0;            ///< the generation of the current solve
+    std::vector<csint> xi,      ///< the pattern of the solution
+                       rstack,  ///< the recursion stack of the search
+                       pstack;  ///< the pause stack of the search
+    std::vector<double> x;      ///< the dense values of the solution
+
+    /** Grow the workspace to fit a graph of `N` nodes. */
+    void resize(csint N);
+};
+
+
 struct TriPerm {
     std::vector<csint> p_inv, q_inv, p_diags;
 };
 
 
+/** A reusable dependency schedule for a triangular solve.
+ *
+ * The unknowns of a triangular system are grouped into levels, such that each
+ * unknown depends only on unknowns in earlier levels. All of the unknowns in
+ * a level may then be computed concurrently.
+ */
+struct LevelSchedule {
+    CSCMatrix G;                   ///< column `j` holds row `j` of the system
+    std::vector<csint> level_ptr;  ///< level `k` is `nodes[level_ptr[k] ...]`
+    std::vector<csint> nodes;      ///< the unknowns, sorted by level
+    std::vector<csint> work_ptr;   ///< cumulative `nnz(G(:, nodes[k]))`
+    bool forward;                  ///< true if the dependencies point forward
+
+    /// The number of levels in the schedule.
+    csint nlevels() const { return static_cast<csint>(level_ptr.size()) - 1; }
+};
+
+
 //------------------------------------------------------------------------------
 //        Triangular Matrix Solutions
 //------------------------------------------------------------------------------
@@ -231,7 +271,8 @@ TriPerm find_tri_permutation(const CSCMatrix& A);
  * @note In the CSparse library, this function is only called within `cs_lu`
  *       using a pre-allocated dense `x` vector, since it is called in a loop
  *       over the columns of `A`. The dense `x` vector can then be indexed
- *       directly by the row indices stored in `xi`.
+ *       directly by the row indices stored in `xi`. See the workspace
+ *       version below.
  *
  * @param A  the sparse, triangular system matrix
  * @param B  the sparse RHS matrix
@@ -239,6 +280,10 @@ TriPerm find_tri_permutation(const CSCMatrix& A);
  * @param lo  the lower bound of the diagonal entries of `G`. If `lo` is
  *        true, the function solves \f$ Lx = b_k`, otherwise it solves
  *        \f$ Ux = b_k \f$.
+ * @param p_inv  the inverse row permutation of `A`, such that row `i` of `A`
+ *        is row `p_inv[i]` of the triangular matrix, and `p_inv[i] < 0` if row
+ *        `i` is not (yet) in the triangular matrix. If empty, `A` is not
+ *        permuted. Used by the LU decomposition.
  *
  * @return res  a struct containing:
  *         * xi the row indices of the non-zero entries in `x`.
@@ -248,7 +293,94 @@ SparseSolution spsolve(
     const CSCMatrix& A,
     const CSCMatrix& B,
     csint k,
-    bool lo=true
+    bool lo=true,
+    const std::vector<csint>& p_inv={}
+);
+
+
+/** Solve a triangular system \f$ Lx = b_k \f$ using existing workspaces.
+ *
+ * This version does not allocate any O(N) memory, so it may be called once for
+ * each column of a matrix. It does not record any statistics (see `Stats`),
+ * so that the calling kernel counts its own work. See the allocating version
+ * for details.
+ *
+ * @param A  the sparse, triangular system matrix
+ * @param B  the sparse RHS matrix
+ * @param k  the column index of `B` to solve
+ * @param[in,out] marked  a workspace of length `N`, all false. It is all false
+ *        again on output.
+ * @param[out] xi  the row indices of the non-zero entries in `x`, in
+ *        topological order.
+ * @param[in,out] x  a dense workspace of length `N`. On output, `x[xi]`
+ *        contains the solution. All other entries are unchanged.
+ * @param lo  if true, solve with a lower triangular matrix, otherwise upper.
+ * @param p_inv  the inverse row permutation of `A`. If empty, `A` is not
+ *        permuted.
+ *
+ * @return xi  a reference to the row indices of the non-zero entries in `x`.
+ */
+std::vector<csint>& spsolve(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    csint k,
+    std::vector<bool>& marked,
+    std::vector<csint>& xi,
+    std::vector<double>& x,
+    bool lo=true,
+    const std::vector<csint>& p_inv={}
+);
+
+
+/** Solve a triangular system \f$ Lx = b_k \f$ using a reusable workspace.
+ *
+ * See the allocating version for details.
+ *
+ * @param A  the sparse, triangular system matrix
+ * @param B  the sparse RHS matrix
+ * @param k  the column index of `B` to solve
+ * @param[in,out] ws  the workspace. It is grown to fit `A` if needed. On
+ *        output, `ws.xi` is the pattern of the solution in topological order,
+ *        and `ws.x[ws.xi]` contains its values.
+ * @param lo  if true, solve with a lower triangular matrix, otherwise upper.
+ * @param p_inv  the inverse row permutation of `A`. If empty, `A` is not
+ *        permuted.
+ *
+ * @return xi  a reference to `ws.xi`
+ */
+std::vector<csint>& spsolve(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    csint k,
+    SpsolveWorkspace& ws,
+    bool lo=true,
+    const std::vector<csint>& p_inv={}
+);
+
+
+/** Solve a triangular system \f$ LX = B \f$ for all columns of a sparse `B`.
+ *
+ * The columns of `B` are split among the threads by their number of
+ * non-zeros. Each thread solves its columns with its own `SpsolveWorkspace`,
+ * and the solutions are then gathered into a sparse matrix.
+ *
+ * @param A  the sparse, triangular system matrix (see `spsolve`)
+ * @param B  the sparse RHS matrix
+ * @param lo  if true, solve with a lower triangular matrix, otherwise upper.
+ * @param p_inv  the inverse row permutation of `A`. If empty, `A` is not
+ *        permuted.
+ * @param threads  the number of threads to use. If `threads <= 0`, use
+ *        the default from `get_num_threads()`.
+ *
+ * @return X  the solution, in CSC format with sorted columns. Entries that
+ *         cancel numerically are kept in the pattern.
+ */
+CSCMatrix spsolve_block(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    bool lo=true,
+    const std::vector<csint>& p_inv={},
+    int threads=0
 );
 
 
@@ -258,11 +390,67 @@ SparseSolution spsolve(
  * @param A  a sparse system matrix
  * @param B  a sparse matrix containing the RHS in column `k`
  * @param k  the column index of `B` containing the RHS
+ * @param p_inv  the inverse row permutation of `A`. Node `j` of the graph is
+ *        column `p_inv[j]` of `A`, or has no edges if `p_inv[j] < 0`. If
+ *        empty, `A` is not permuted.
  *
  * @return xi  the row indices of the non-zero entries in `x`, in topological
  *         order of the graph.
  */
-std::vector<csint> reach(const CSCMatrix& A, const CSCMatrix& B, csint k);
+std::vector<csint> reach(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    csint k,
+    const std::vector<csint>& p_inv={}
+);
+
+
+/** Compute the reachability indices using existing workspaces.
+ *
+ * @param A  a sparse system matrix
+ * @param B  a sparse matrix containing the RHS in column `k`
+ * @param k  the column index of `B` containing the RHS
+ * @param[in,out] marked  a workspace of length `N`, all false. It is all false
+ *        again on output.
+ * @param[out] xi  the row indices of the non-zero entries in `x`, in
+ *        topological order of the graph.
+ * @param p_inv  the inverse row permutation of `A`. If empty, `A` is not
+ *        permuted.
+ *
+ * @return xi  a reference to the output
+ */
+std::vector<csint>& reach(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    csint k,
+    std::vector<bool>& marked,
+    std::vector<csint>& xi,
+    const std::vector<csint>& p_inv={}
+);
+
+
+/** Compute the reachability indices using a reusable workspace.
+ *
+ * The visited nodes are marked with a new generation stamp, so the marks are
+ * not cleared on output.
+ *
+ * @param A  a sparse system matrix
+ * @param B  a sparse matrix containing the RHS in column `k`
+ * @param k  the column index of `B` containing the RHS
+ * @param[in,out] ws  the workspace. It is grown to fit `A` if needed.
+ * @param p_inv  the inverse row permutation of `A`. If empty, `A` is not
+ *        permuted.
+ *
+ * @return xi  a reference to `ws.xi`, the row indices of the non-zero entries
+ *         in `x`, in topological order of the graph.
+ */
+std::vector<csint>& reach(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    csint k,
+    SpsolveWorkspace& ws,
+    const std::vector<csint>& p_inv={}
+);
 
 
 /** Perform depth-first search on the matrix graph.
@@ -273,6 +461,9 @@ std::vector<csint> reach(const CSCMatrix& A, const CSCMatrix& B, csint k);
  * @param[in,out] xi  the row indices of the non-zero entries in `x`. This
  *       vector is used as a stack to store the output. It should not be
  *       initialized, other than by a previous call to `dfs`.
+ * @param p_inv  the inverse row permutation of `A`. Node `j` of the graph is
+ *        column `p_inv[j]` of `A`, or has no edges if `p_inv[j] < 0`. If
+ *        empty, `A` is not permuted.
  *
  * @return xi  a reference to the row indices of the non-zero entries in `x`.
  */
@@ -280,7 +471,30 @@ std::vector<csint>& dfs(
     const CSCMatrix& A,
     csint j,
     std::vector<bool>& marked,
-    std::vector<csint>& xi
+    std::vector<csint>& xi,
+    const std::vector<csint>& p_inv={}
+);
+
+
+/** Perform depth-first search on the matrix graph using a reusable workspace.
+ *
+ * The nodes with `ws.mark[j] == ws.stamp` are visited, and the stacks of the
+ * workspace are reused, so the search does not allocate.
+ *
+ * @param A  a sparse matrix
+ * @param j  the starting node
+ * @param[in,out] ws  the workspace, sized for `A`. The finished nodes are
+ *        pushed onto `ws.xi`.
+ * @param p_inv  the inverse row permutation of `A`. If empty, `A` is not
+ *        permuted.
+ *
+ * @return xi  a reference to `ws.xi`
+ */
+std::vector<csint>& dfs(
+    const CSCMatrix& A,
+    csint j,
+    SpsolveWorkspace& ws,
+    const std::vector<csint>& p_inv={}
 );
 
 
@@ -326,6 +540,35 @@ SparseSolution chol_ltsolve(
 );
 
 
+/** Solve \f$ Lx = b \f$, where `L` is a supernodal Cholesky factor.
+ *
+ * The diagonal block of each supernode is solved with a dense forward solve,
+ * and the sub-diagonal block is applied as a dense matrix-vector product.
+ *
+ * @note The system is solved in the permuted space of `L`, so `b` must
+ *       already be permuted by `L.p_inv`.
+ *
+ * @param L  a supernodal Cholesky factor, from `cs::chol_super()`
+ * @param b  a dense vector
+ *
+ * @return x  the solution vector
+ */
+std::vector<double> lsolve_super(const SupernodalChol& L, const std::vector<double>& b);
+
+
+/** Solve \f$ L^T x = b \f$, where `L` is a supernodal Cholesky factor.
+ *
+ * @note The system is solved in the permuted space of `L`, so `x` must be
+ *       un-permuted by `L.p_inv` to get the solution of the original system.
+ *
+ * @param L  a supernodal Cholesky factor, from `cs::chol_super()`
+ * @param b  a dense vector
+ *
+ * @return x  the solution vector
+ */
+std::vector<double> ltsolve_super(const SupernodalChol& L, const std::vector<double>& b);
+
+
 /** Find the topological order of the nodes in the elimination tree.
  *
  * @param b  a sparse matrix
@@ -345,6 +588,148 @@ std::vector<csint> topological_order(
 );
 
 
+//------------------------------------------------------------------------------
+//        Multiple Right-Hand Sides
+//------------------------------------------------------------------------------
+/** Number of right-hand sides solved together by the block solvers.
+ *
+ * Each row of a tile spans two 64-byte cache lines, and the tile is a
+ * multiple of the SIMD width for every supported instruction set.
+ */
+constexpr csint RHS_TILE = 16;
+
+
+/** Forward solve \f$ LX = B \f$ for a block of right-hand sides.
+ *
+ * The right-hand sides are solved in tiles of `RHS_TILE` columns. Each tile
+ * is copied into a row-major workspace, so that every non-zero of `L` is read
+ * once per tile and applied to a contiguous row of the tile with SIMD
+ * instructions (see `simd.h`).
+ *
+ * @note This function assumes that the diagonal entry of `L` is always
+ * present and is the first entry in each column, as for `lsolve`.
+ *
+ * @param L  a lower-triangular matrix
+ * @param B  a dense `N x K` matrix of right-hand sides, in column-major order
+ *
+ * @return X  the dense `N x K` solution, in column-major order
+ */
+std::vector<double> lsolve_block(const CSCMatrix& L, const std::vector<double>& B);
+
+
+/** Backsolve \f$ L^T X = B \f$ for a block of right-hand sides.
+ *
+ * See `lsolve_block` and `ltsolve`.
+ *
+ * @param L  a lower-triangular matrix
+ * @param B  a dense `N x K` matrix of right-hand sides, in column-major order
+ *
+ * @return X  the dense `N x K` solution, in column-major order
+ */
+std::vector<double> ltsolve_block(const CSCMatrix& L, const std::vector<double>& B);
+
+
+/** Backsolve \f$ UX = B \f$ for a block of right-hand sides.
+ *
+ * See `lsolve_block` and `usolve`.
+ *
+ * @param U  an upper-triangular matrix
+ * @param B  a dense `N x K` matrix of right-hand sides, in column-major order
+ *
+ * @return X  the dense `N x K` solution, in column-major order
+ */
+std::vector<double> usolve_block(const CSCMatrix& U, const std::vector<double>& B);
+
+
+/** Forward solve \f$ U^T X = B \f$ for a block of right-hand sides.
+ *
+ * See `lsolve_block` and `utsolve`.
+ *
+ * @param U  an upper-triangular matrix
+ * @param B  a dense `N x K` matrix of right-hand sides, in column-major order
+ *
+ * @return X  the dense `N x K` solution, in column-major order
+ */
+std::vector<double> utsolve_block(const CSCMatrix& U, const std::vector<double>& B);
+
+
+/** Solve \f$ AX = B \f$ for a block of right-hand sides, given the Cholesky
+ * factorization \f$ PAP^T = LL^T \f$.
+ *
+ * Both triangular solves are applied to each tile while it is in the
+ * workspace, and the permutation is applied when the tile is copied in and
+ * out, so `B` is read and `X` is written only once.
+ *
+ * See: Davis, Section 8.1 and `cs_cholsol`.
+ *
+ * @param L  the Cholesky factor of `A`, from `chol`
+ * @param S  the symbolic factorization of `A`, from `schol`
+ * @param B  a dense `N x K` matrix of right-hand sides, in column-major order
+ *
+ * @return X  the dense `N x K` solution, in column-major order
+ */
+std::vector<double> chol_solve_block(
+    const CSCMatrix& L,
+    const SymbolicChol& S,
+    const std::vector<double>& B
+);
+
+
+//------------------------------------------------------------------------------
+//        Level-Scheduled Triangular Solves
+//------------------------------------------------------------------------------
+/** Compute the level schedule of a triangular system.
+ *
+ * The level of unknown `j` is one more than the largest level of the unknowns
+ * that it depends upon, so the number of levels is the length of the longest
+ * dependency path in the graph of the matrix. For a Cholesky factor `L`, the
+ * levels are the heights of the nodes in the elimination tree.
+ *
+ * The schedule stores a copy of the system in row-oriented form, so that each
+ * unknown is computed by a dot product with the unknowns before it, without
+ * any writes to shared entries. Since the copy holds the numerical values,
+ * the schedule must be recomputed if the values of `A` change.
+ *
+ * @param A  a square triangular matrix with all diagonal entries present. The
+ *        row indices in each column may appear in any order.
+ * @param lower  if true, `A` is lower triangular, otherwise upper triangular.
+ * @param trans  if true, schedule the solve with \f$ A^T \f$ rather than `A`.
+ *
+ * @return S  the level schedule
+ *
+ * @throws std::runtime_error if `A` is not triangular, or is missing a
+ *         diagonal entry.
+ */
+LevelSchedule level_schedule(
+    const CSCMatrix& A,
+    bool lower=true,
+    bool trans=false
+);
+
+
+/** Solve a triangular system using a level schedule.
+ *
+ * The levels are processed in order. The unknowns within a level are split
+ * among the threads by number of non-zeros, and the threads synchronize after
+ * each level. Consecutive levels with too little work to split are solved by
+ * a single thread. Since each unknown is computed by the same sequence of
+ * operations regardless of which thread computes it, the result does not
+ * depend on the number of threads.
+ *
+ * @param S  the level schedule from `level_schedule`
+ * @param b  a dense RHS vector
+ * @param threads  the number of threads to use. If `threads <= 0`, use the
+ *        default from `get_num_threads()`.
+ *
+ * @return x  the solution vector
+ */
+std::vector<double> level_solve(
+    const LevelSchedule& S,
+    const std::vector<double>& b,
+    int threads=0
+);
+
+
 }  // namespace cs
 
 #endif  // _SOLVE_H_
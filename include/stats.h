@@ -0,0 +1,179 @@
+//==============================================================================
+//     File: stats.h
+//  Created: 2025-03-21 10:02
+//   Author: Bernie Roesler
+//
+//  Description: Optional performance counters for the factorizations and
+//      solves.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_STATS_H_
+#define _CSPARSE_STATS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+
+namespace cs {
+
+/** Performance counters filled in by the symbolic and numeric routines.
+ *
+ * The counters are only updated while the object is installed on the calling
+ * thread with `StatsScope` (or `set_stats`). Otherwise, each instrumented
+ * routine only checks a null thread-local pointer.
+ *
+ * The counters are recorded by the thread that calls a routine, so the
+ * parallel kernels report the same flops as their serial versions.
+ *
+ * The counters accumulate over all of the calls made within the scope, until
+ * they are cleared with `reset()`.
+ *
+ * Instrumented routines:
+ *     `schol`, `chol`, `leftchol`, `rechol`, `chol_updown`, `sqr`, `qr`,
+ *     `reqr`, `qr_multifrontal`, `slu`, `lu`, `spsolve`, `spsolve_block`,
+ *     and `CSCMatrix::realloc`. The batched routines of `batch.h` record their
+ *     times and memory. The solvers of `iterative.h` record
+ *     their times, memory, and flops, excluding the preconditioner.
+ */
+struct Stats
+{
+    double flops = 0;              // floating-point operations
+    csint reallocs = 0;            // number of calls to CSCMatrix::realloc
+    std::size_t peak_bytes = 0;    // largest output + workspace of any routine
+    std::map<std::string, double> times;  // wall time [s] of each phase
+    std::map<std::string, csint> calls;   // number of calls of each phase
+
+    /** Clear all of the counters. */
+    void reset();
+};
+
+
+namespace detail {
+    extern thread_local Stats *current_stats;
+}
+
+
+/** Get the statistics object installed on this thread.
+ *
+ * @return stats  a pointer to the installed object, or `nullptr` if the
+ *         statistics are disabled.
+ */
+inline Stats* get_stats() { return detail::current_stats; }
+
+
+/** Install a statistics object on this thread.
+ *
+ * @param stats  the object to fill in, or `nullptr` to disable the statistics.
+ *        The object must outlive its installation.
+ *
+ * @return prev  the previously installed object
+ */
+Stats* set_stats(Stats *stats);
+
+
+/** Install a statistics object on this thread for the lifetime of the scope.
+ *
+ * Example:
+ * @code
+ *     Stats stats;
+ *     {
+ *         StatsScope scope(stats);
+ *         CSCMatrix L = chol(A, schol(A));
+ *     }
+ *     std::cout << stats.flops << std::endl;
+ * @endcode
+ */
+class StatsScope
+{
+    Stats *prev_;
+
+    public:
+        explicit StatsScope(Stats& stats) : prev_(set_stats(&stats)) {}
+        ~StatsScope() { set_stats(prev_); }
+
+        StatsScope(const StatsScope&) = delete;
+        StatsScope& operator=(const StatsScope&) = delete;
+};
+
+
+/** Time a phase of a routine for the lifetime of the scope, or until `stop()`
+ * is called.
+ *
+ * When the statistics are disabled, the timer is a no-op.
+ */
+class PhaseTimer
+{
+    using clock = std::chrono::steady_clock;
+
+    Stats *stats_;
+    const char *name_;
+    clock::time_point start_;
+
+    public:
+        explicit PhaseTimer(const char *name)
+            : stats_(get_stats()), name_(name)
+        {
+            if (stats_) {
+                start_ = clock::now();
+            }
+        }
+
+        ~PhaseTimer() { stop(); }
+
+        /** Record the elapsed time, and disable the timer. */
+        void stop()
+        {
+            if (stats_) {
+                std::chrono::duration<double> dt = clock::now() - start_;
+                stats_->times[name_] += dt.count();
+                stats_->calls[name_]++;
+                stats_ = nullptr;
+            }
+        }
+
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+};
+
+
+/** Record the memory used by a routine, if the statistics are enabled.
+ *
+ * @param bytes  the size of the output and workspaces of the routine
+ */
+void record_memory(std::size_t bytes);
+
+
+/** Compute the size of the arrays of a matrix.
+ *
+ * @param A  the matrix
+ *
+ * @return bytes  the allocated size of the values, indices and pointers
+ */
+std::size_t memory_bytes(const CSCMatrix& A);
+
+
+/** Compute the allocated size of a vector.
+ *
+ * @param v  the vector
+ *
+ * @return bytes  the allocated size of the vector
+ */
+template <typename T>
+std::size_t memory_bytes(const std::vector<T>& v)
+{
+    return v.capacity() * sizeof(T);
+}
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_STATS_H_
+
+//==============================================================================
+//==============================================================================
@@ -21,21 +21,51 @@ enum class AMDOrder
     Natural,
     APlusAT,
     ATANoDenseRows,
-    ATA
+    ATA,
+    NestedDissection
+};
+
+// Workspace used to accumulate each column of a sparse matrix product
+enum class SpGEMMAccumulator
+{
+    Auto,   // choose by the size of the output vs. the work
+    Dense,  // dense workspace of length M per thread
+    Hash    // hash table sized by the work in each column
+};
+
+// Storage of the values of a batch of matrices with the same pattern
+enum class BatchLayout
+{
+    Strided,     // values[b * nnz + p], each matrix is contiguous
+    Interleaved  // values[p * batch + b], each entry is contiguous
 };
 
 // Forward declarations
 enum class ICholMethod;
 
+struct AssemblyPattern;
+struct CachedChol;
+struct CachedQR;
+struct CholBatch;
 struct CholCounts;
 struct TriPerm;
+struct LevelSchedule;
 struct SparseSolution;
+struct SpsolveWorkspace;
 struct SymbolicChol;
+struct SupernodalChol;
+struct UpdownWorkspace;
 struct SymbolicQR;
 struct QRResult;
+struct MultifrontalQR;
+struct QRBatch;
+struct SymbolicLU;
+struct LUResult;
 
 class COOMatrix;
 class CSCMatrix;
+class CSRMatrix;
+class Workspace;
 
 }  // namespace cs
 
@@ -51,12 +51,17 @@ std::vector<double>& operator*=(std::vector<double>& x, const double c);
 std::vector<csint> inv_permute(const std::vector<csint>& p);
 
 /** Compute the cumulative sum of a vector, starting with 0.
+ *
+ * Large vectors are summed in parallel blocks, and each block is then offset
+ * by the total of the blocks before it.
  *
  * @param w  a reference to a vector of length N.
+ * @param threads  the number of threads to use. If `threads <= 0`, use the
+ *        default from `get_num_threads()`.
  *
  * @return p  the cumulative sum of `w`, of length N + 1.
  */
-std::vector<csint> cumsum(const std::vector<csint>& w);
+std::vector<csint> cumsum(const std::vector<csint>& w, int threads=0);
 
 
 /*------------------------------------------------------------------------------
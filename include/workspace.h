@@ -0,0 +1,421 @@
+//==============================================================================
+//     File: workspace.h
+//  Created: 2025-03-31 09:20
+//   Author: Bernie Roesler
+//
+//  Description: A reusable pool of scratch arrays for the symbolic and numeric
+//      kernels.
+//
+//==============================================================================
+
+#ifndef _CSPARSE_WORKSPACE_H_
+#define _CSPARSE_WORKSPACE_H_
+
+#include <algorithm>  // std::max
+#include <cstddef>
+#include <exception>  // std::uncaught_exceptions
+#include <mutex>
+#include <thread>     // std::thread::id
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+
+
+namespace cs {
+
+/** A pool of scratch arrays, which are borrowed by the kernels and returned to
+ * the pool when the kernel is done.
+ *
+ * The kernels draw their O(M) and O(N) workspaces from the pool of the calling
+ * thread (see `get_workspace`), so a sequence of calls on matrices of similar
+ * size allocates its workspaces only once. Each returned array keeps its
+ * capacity, and the next request is served by the smallest pooled array that
+ * fits it.
+ *
+ * An array borrowed with `zeros` is all zero, and must be returned all zero.
+ * The kernels clear only the entries that they touched, so the array is not
+ * filled again on the next call. If a kernel throws, its arrays are returned
+ * as dirty, and are cleared on their next use.
+ *
+ * A workspace is not thread-safe. Each thread uses its own, and a
+ * `WorkspaceScope` claims a workspace for its thread, so that it cannot be
+ * installed on two threads at once (see `claim`).
+ *
+ * Pooled types: `csint`, `double`, and `bool`.
+ *
+ * Pooled kernels:
+ *     `etree`, `counts`, `ereach`, `chol`, `chol_update`, `qr`, the dense
+ *     accumulator of `CSCMatrix::dot`, `reach`, `dfs`, and `spsolve`. The
+ *     kernels that fill caller-provided workspaces (e.g. `SpsolveWorkspace`)
+ *     do not use the pool.
+ *
+ * Example:
+ * @code
+ *     Workspace ws;
+ *     {
+ *         WorkspaceScope scope(ws);
+ *         for (const auto& A : matrices) {
+ *             CSCMatrix L = chol(A, S);  // allocates workspaces only once
+ *         }
+ *     }
+ *     std::cout << ws.peak_bytes() << std::endl;
+ * @endcode
+ */
+class Workspace
+{
+    public:
+        template <typename T> class Buffer;
+
+        Workspace() = default;
+
+        Workspace(const Workspace&) = delete;
+        Workspace& operator=(const Workspace&) = delete;
+
+        /** Borrow an array with unspecified values.
+         *
+         * @param n  the size of the array
+         *
+         * @return buf  the array, which is returned to the pool when `buf` is
+         *         destroyed
+         */
+        template <typename T>
+        Buffer<T> take(std::size_t n) { return lease_<T>(n, false); }
+
+        /** Borrow an array with every value equal to `value`.
+         *
+         * @param n  the size of the array
+         * @param value  the value of every entry
+         *
+         * @return buf  the array
+         */
+        template <typename T>
+        Buffer<T> fill(std::size_t n, const T& value)
+        {
+            Buffer<T> buf = lease_<T>(n, false);
+            std::fill(buf.v_.begin(), buf.v_.end(), value);
+            return buf;
+        }
+
+        /** Borrow an array that is all zero, and must be returned all zero.
+         *
+         * @param n  the size of the array
+         *
+         * @return buf  the array
+         */
+        template <typename T>
+        Buffer<T> zeros(std::size_t n) { return lease_<T>(n, true); }
+
+        /** Borrow an empty array with a capacity of at least `n`, to use as a
+         * stack.
+         *
+         * @param n  the minimum capacity of the array
+         *
+         * @return buf  the array
+         */
+        template <typename T>
+        Buffer<T> reserve(std::size_t n)
+        {
+            Buffer<T> buf = lease_<T>(0, false);
+            buf.v_.reserve(n);
+            regrow_(buf);
+            return buf;
+        }
+
+        /// The size [bytes] of the arrays that are borrowed now.
+        std::size_t bytes_in_use() const { return in_use_; }
+
+        /// The largest size [bytes] of the arrays borrowed at once.
+        std::size_t peak_bytes() const { return peak_; }
+
+        /// The size [bytes] of all of the arrays owned by the pool.
+        std::size_t reserved_bytes() const { return reserved_; }
+
+        /// The number of arrays borrowed from the pool.
+        csint leases() const { return leases_; }
+
+        /// The number of leases that had to allocate or grow their array.
+        csint allocations() const { return allocations_; }
+
+        /** Reset the high-water mark to the size of the arrays in use.
+         *
+         * @throws std::runtime_error if another thread has claimed the pool
+         */
+        void reset_peak();
+
+        /** Free all of the arrays held by the pool, but not those in use.
+         *
+         * @throws std::runtime_error if another thread has claimed the pool
+         */
+        void release();
+
+        /** Claim the workspace for the calling thread.
+         *
+         * A thread may hold several claims, e.g. from nested scopes, but only
+         * one thread may hold claims at a time.
+         *
+         * @throws std::runtime_error if another thread has claimed the pool
+         */
+        void claim();
+
+        /** Drop one claim of the calling thread. */
+        void unclaim();
+
+        /** Check if a thread other than the calling one has claimed the pool. */
+        bool claimed_elsewhere() const;
+
+    private:
+        template <typename T>
+        struct Pool {
+            std::vector<std::vector<T>> clean,  // all zero
+                                        dirty;  // unspecified values
+        };
+
+        std::tuple<Pool<csint>, Pool<double>, Pool<bool>> pools_;
+
+        std::size_t in_use_ = 0,
+                    peak_ = 0,
+                    reserved_ = 0;
+        csint leases_ = 0,
+              allocations_ = 0;
+
+        mutable std::mutex owner_mutex_;
+        std::thread::id owner_;  // the thread that holds the claims
+        csint claims_ = 0;
+
+        /** Throw if another thread has claimed the pool. */
+        void check_owner_() const;
+
+        template <typename T>
+        static std::size_t capacity_bytes_(const std::vector<T>& v)
+        {
+            if constexpr (std::is_same_v<T, bool>) {
+                return (v.capacity() + 7) / 8;
+            } else {
+                return v.capacity() * sizeof(T);
+            }
+        }
+
+        /** Remove the best fit for `n` entries from a list of pooled arrays.
+         *
+         * @return v  the smallest array with a capacity of at least `n`, or
+         *         the largest array if none fit.
+         */
+        template <typename T>
+        static std::vector<T> pop_best_fit_(std::vector<std::vector<T>>& list, std::size_t n)
+        {
+            std::size_t best = 0;
+            for (std::size_t b = 1; b < list.size(); b++) {
+                std::size_t c = list[b].capacity(),
+                            cb = list[best].capacity();
+                if ((cb < n) ? (c > cb) : (c >= n && c < cb)) {
+                    best = b;
+                }
+            }
+
+            std::vector<T> v = std::move(list[best]);
+            list[best] = std::move(list.back());
+            list.pop_back();
+            return v;
+        }
+
+        template <typename T>
+        Buffer<T> lease_(std::size_t n, bool zeroed)
+        {
+            Pool<T>& pool = std::get<Pool<T>>(pools_);
+
+            // A clean array serves any request, but a dirty one only serves
+            // a zeroed request after it is cleared
+            std::vector<T> v;
+            bool clean = !pool.clean.empty() && (zeroed || pool.dirty.empty());
+
+            if (clean) {
+                v = pop_best_fit_(pool.clean, n);
+            } else if (!pool.dirty.empty()) {
+                v = pop_best_fit_(pool.dirty, n);
+            }
+
+            std::size_t bytes0 = capacity_bytes_(v);
+
+            if (zeroed && !clean) {
+                v.assign(n, T{});
+            } else {
+                v.resize(n);  // the new entries are zero
+            }
+
+            std::size_t bytes = capacity_bytes_(v);
+            grow_(bytes0, bytes);
+            in_use_ += bytes;
+            peak_ = std::max(peak_, in_use_);
+            leases_++;
+
+            return Buffer<T>(this, std::move(v), zeroed);
+        }
+
+        /** Account for an array that changed size from `bytes0` to `bytes`. */
+        void grow_(std::size_t bytes0, std::size_t bytes)
+        {
+            reserved_ = reserved_ - bytes0 + bytes;
+            if (bytes > bytes0) {
+                allocations_++;
+            }
+        }
+
+        /** Account for an array that grew after its lease. */
+        template <typename T>
+        void regrow_(Buffer<T>& buf)
+        {
+            std::size_t bytes = capacity_bytes_(buf.v_);
+            if (bytes != buf.bytes_) {
+                grow_(buf.bytes_, bytes);
+                in_use_ = in_use_ - buf.bytes_ + bytes;
+                peak_ = std::max(peak_, in_use_);
+                buf.bytes_ = bytes;
+            }
+        }
+
+        template <typename T>
+        void give_back_(Buffer<T>& buf, bool clean)
+        {
+            regrow_(buf);
+            in_use_ -= buf.bytes_;
+
+            Pool<T>& pool = std::get<Pool<T>>(pools_);
+            (clean ? pool.clean : pool.dirty).push_back(std::move(buf.v_));
+        }
+};
+
+
+/** An array borrowed from a `Workspace`.
+ *
+ * The buffer owns the array until it is destroyed, and then returns it to the
+ * pool. The array is accessed as a `std::vector`, so that it can be passed to
+ * the existing kernels, but it must not be moved out of the buffer.
+ */
+template <typename T>
+class Workspace::Buffer
+{
+    Workspace *ws_ = nullptr;
+    std::vector<T> v_;
+    std::size_t bytes_ = 0;   // the capacity accounted for by the pool
+    bool zeroed_ = false;
+    int exceptions_ = 0;      // uncaught exceptions at the start of the lease
+
+    friend class Workspace;
+
+    Buffer(Workspace *ws, std::vector<T>&& v, bool zeroed)
+        : ws_(ws),
+          v_(std::move(v)),
+          bytes_(Workspace::capacity_bytes_(v_)),
+          zeroed_(zeroed),
+          exceptions_(std::uncaught_exceptions())
+    {}
+
+    void give_back_()
+    {
+        if (ws_) {
+            bool clean = zeroed_ && std::uncaught_exceptions() == exceptions_;
+            ws_->give_back_(*this, clean);
+            ws_ = nullptr;
+        }
+    }
+
+    public:
+        Buffer(Buffer&& other) noexcept
+            : ws_(std::exchange(other.ws_, nullptr)),
+              v_(std::move(other.v_)),
+              bytes_(other.bytes_),
+              zeroed_(other.zeroed_),
+              exceptions_(other.exceptions_)
+        {}
+
+        Buffer& operator=(Buffer&& other) noexcept
+        {
+            if (this != &other) {
+                give_back_();
+                ws_ = std::exchange(other.ws_, nullptr);
+                v_ = std::move(other.v_);
+                bytes_ = other.bytes_;
+                zeroed_ = other.zeroed_;
+                exceptions_ = other.exceptions_;
+            }
+            return *this;
+        }
+
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+
+        ~Buffer() { give_back_(); }
+
+        std::vector<T>& operator*() { return v_; }
+        const std::vector<T>& operator*() const { return v_; }
+        std::vector<T>* operator->() { return &v_; }
+        const std::vector<T>* operator->() const { return &v_; }
+
+        decltype(auto) operator[](std::size_t i) { return v_[i]; }
+        decltype(auto) operator[](std::size_t i) const { return v_[i]; }
+};
+
+
+namespace detail {
+    extern thread_local Workspace *current_workspace;
+}
+
+
+/** Get the workspace used by the kernels on this thread.
+ *
+ * @return ws  the workspace installed with `WorkspaceScope` (or
+ *         `set_workspace`), or else the default workspace of this thread. The
+ *         default workspace lives as long as the thread.
+ */
+Workspace& get_workspace();
+
+
+/** Install a workspace on this thread.
+ *
+ * The worker threads of the parallel kernels always use their own default
+ * workspaces.
+ *
+ * @param ws  the workspace to use, or `nullptr` to use the default workspace
+ *        of this thread. The workspace must outlive its installation.
+ *
+ * @return prev  the previously installed workspace
+ */
+Workspace* set_workspace(Workspace *ws);
+
+
+/** Install a workspace on this thread for the lifetime of the scope.
+ *
+ * @throws std::runtime_error if the workspace is installed on another thread
+ */
+class WorkspaceScope
+{
+    Workspace& ws_;
+    Workspace *prev_;
+
+    public:
+        explicit WorkspaceScope(Workspace& ws) : ws_(ws)
+        {
+            ws_.claim();
+            prev_ = set_workspace(&ws_);
+        }
+
+        ~WorkspaceScope()
+        {
+            set_workspace(prev_);
+            ws_.unclaim();
+        }
+
+        WorkspaceScope(const WorkspaceScope&) = delete;
+        WorkspaceScope& operator=(const WorkspaceScope&) = delete;
+};
+
+
+}  // namespace cs
+
+#endif  // _CSPARSE_WORKSPACE_H_
+
+//==============================================================================
+//==============================================================================
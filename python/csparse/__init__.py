@@ -25,6 +25,7 @@ Version: 0.1
 
 # Import all bindings from the csparse module
 from .csparse import *
+from ._async import *
 from ._cholesky import *
 from ._qr import *
 from .utils import *
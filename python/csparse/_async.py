@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+# =============================================================================
+#     File: _async.py
+#  Created: 2025-03-27 09:12
+#   Author: Bernie Roesler
+#
+"""
+Asynchronous versions of the compute-heavy functions.
+
+The bindings release the GIL while the C++ code runs, so calls submitted to a
+thread pool run concurrently with each other, and with the Python code that
+prepares the next inputs. Each `*_async` function takes the same arguments as
+its synchronous version, and returns a `concurrent.futures.Future`.
+
+Example usage:
+    import csparse
+    S = csparse.schol(A, order='APlusAT')
+    futures = [csparse.chol_async(A, S) for A in matrices]
+    factors = [f.result() for f in futures]
+
+The matrices, symbolic analyses and factors passed to a call are in use until
+the call is done, and modifying one meanwhile (e.g. ``A[i, j] = v`` or
+``A.to_canonical()``) raises a ``BufferError``.
+
+The calls run on the threads of the executor, so the ``with csparse.Stats()``
+and ``with csparse.Workspace()`` blocks of the caller do *not* apply to them.
+Both are installed per thread, and are not thread-safe, so they cannot be
+shared with the workers. To measure an asynchronous call, enter the block in
+the submitted function itself:
+
+    def timed_chol(A, S):
+        with csparse.Stats() as stats:
+            return csparse.chol(A, S), stats
+
+    L, stats = csparse.submit(timed_chol, A, S).result()
+"""
+# =============================================================================
+
+import functools
+import os
+import threading
+
+from concurrent.futures import ThreadPoolExecutor
+
+from . import csparse as _cs
+
+
+__all__ = [
+    'get_executor',
+    'set_executor',
+    'submit',
+    'read_matrix_market_async',
+    'amd_async',
+    'nested_dissection_async',
+    'schol_async',
+    'chol_async',
+    'leftchol_async',
+    'rechol_async',
+    'sqr_async',
+    'qr_async',
+    'reqr_async',
+    'qr_multifrontal_async',
+    'slu_async',
+    'lu_async',
+    'chol_batch_async',
+    'qr_batch_async',
+    'lsolve_async',
+    'usolve_async',
+    'lsolve_block_async',
+    'usolve_block_async',
+    'chol_solve_block_async',
+    'lusolve_async',
+    'qrsolve_async',
+    'pcg_async',
+    'minres_async',
+    'gmres_async',
+    'dot_async',
+]
+
+
+_executor = None
+_executor_lock = threading.Lock()
+
+
+def get_executor():
+    """Return the executor that runs the asynchronous calls.
+
+    The default executor is a thread pool with one worker per CPU, which is
+    created on the first call.
+
+    Returns
+    -------
+    executor : concurrent.futures.Executor
+        The executor used by `submit` and the `*_async` functions.
+    """
+    global _executor
+    with _executor_lock:
+        if _executor is None:
+            _executor = ThreadPoolExecutor(
+                max_workers=os.cpu_count(),
+                thread_name_prefix='csparse'
+            )
+        return _executor
+
+
+def set_executor(executor):
+    """Set the executor that runs the asynchronous calls.
+
+    Parameters
+    ----------
+    executor : concurrent.futures.Executor or None
+        The new executor. It should run its calls in threads of this process,
+        since the arguments are shared with the caller. If None, a default
+        thread pool is created on the next call.
+
+    Returns
+    -------
+    previous : concurrent.futures.Executor or None
+        The previous executor, which is *not* shut down.
+    """
+    global _executor
+    with _executor_lock:
+        previous, _executor = _executor, executor
+        return previous
+
+
+def submit(fn, *args, **kwargs):
+    """Run any function asynchronously.
+
+    Parameters
+    ----------
+    fn : callable
+        The function to run, typically a binding or a method of a matrix.
+    *args, **kwargs
+        The arguments of `fn`.
+
+    Returns
+    -------
+    future : concurrent.futures.Future
+        The future result of ``fn(*args, **kwargs)``. Any exception raised by
+        `fn` is raised by ``future.result()``.
+    """
+    return get_executor().submit(fn, *args, **kwargs)
+
+
+def _make_async(fn):
+    """Create an asynchronous version of a function."""
+    @functools.wraps(fn)
+    def wrapper(*args, **kwargs):
+        return submit(fn, *args, **kwargs)
+
+    wrapper.__name__ = fn.__name__ + '_async'
+    wrapper.__qualname__ = wrapper.__name__
+    wrapper.__doc__ = (
+        f"Asynchronous version of `{fn.__name__}`, which returns a "
+        "`concurrent.futures.Future`. The call runs on a worker thread, "
+        "outside of the caller's `Stats` and `Workspace` blocks.\n\n"
+        + (fn.__doc__ or '')
+    )
+    return wrapper
+
+
+# -----------------------------------------------------------------------------
+#         Asynchronous Versions
+# -----------------------------------------------------------------------------
+read_matrix_market_async = _make_async(_cs.read_matrix_market)
+amd_async = _make_async(_cs.amd)
+nested_dissection_async = _make_async(_cs.nested_dissection)
+
+schol_async = _make_async(_cs.schol)
+chol_async = _make_async(_cs.chol)
+leftchol_async = _make_async(_cs.leftchol)
+rechol_async = _make_async(_cs.rechol)
+
+sqr_async = _make_async(_cs.sqr)
+qr_async = _make_async(_cs.qr)
+reqr_async = _make_async(_cs.reqr)
+qr_multifrontal_async = _make_async(_cs.qr_multifrontal)
+
+slu_async = _make_async(_cs.slu)
+lu_async = _make_async(_cs.lu)
+
+chol_batch_async = _make_async(_cs.chol_batch)
+qr_batch_async = _make_async(_cs.qr_batch)
+
+lsolve_async = _make_async(_cs.lsolve)
+usolve_async = _make_async(_cs.usolve)
+lsolve_block_async = _make_async(_cs.lsolve_block)
+usolve_block_async = _make_async(_cs.usolve_block)
+chol_solve_block_async = _make_async(_cs.chol_solve_block)
+lusolve_async = _make_async(_cs.lusolve)
+qrsolve_async = _make_async(_cs.qrsolve)
+
+pcg_async = _make_async(_cs.pcg)
+minres_async = _make_async(_cs.minres)
+gmres_async = _make_async(_cs.gmres)
+
+
+def dot_async(A, B):
+    """Compute the product ``A @ B`` asynchronously.
+
+    Parameters
+    ----------
+    A : CSCMatrix or CSRMatrix
+        The left operand.
+    B : CSCMatrix, array_like, or float
+        The right operand, as accepted by ``A.dot``.
+
+    Returns
+    -------
+    future : concurrent.futures.Future
+        The future product.
+    """
+    return submit(A.dot, B)
+
+
+# =============================================================================
+# =============================================================================
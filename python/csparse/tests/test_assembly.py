@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# =============================================================================
+#     File: test_assembly.py
+#  Created: 2025-03-24 10:30
+#   Author: Bernie Roesler
+#
+"""
+Unit tests for assembly into a frozen sparsity pattern.
+"""
+# =============================================================================
+
+import numpy as np
+
+from numpy.testing import assert_allclose
+from scipy import sparse
+
+import csparse
+
+
+def _quad_mesh(n):
+    """Build the connectivity of an n x n grid of quadrilaterals."""
+    nn = n + 1
+    elem_nodes = []
+    for i in range(n):
+        for j in range(n):
+            k = i * nn + j
+            elem_nodes.extend([k, k + 1, k + nn + 1, k + nn])
+    elem_ptr = list(range(0, len(elem_nodes) + 1, 4))
+    return nn * nn, elem_ptr, elem_nodes
+
+
+def test_assembly_elements():
+    """Test element-by-element assembly against scipy.sparse."""
+    N, elem_ptr, elem_nodes = _quad_mesh(6)
+    K0 = np.array([[ 4, -1, -2, -1],
+                   [-1,  4, -1, -2],
+                   [-2, -1,  4, -1],
+                   [-1, -2, -1,  4]], dtype=float) / 6
+
+    P = csparse.assembly_pattern(N, elem_ptr, elem_nodes)
+    assert P.num_elements == len(elem_ptr) - 1
+
+    rows, cols, vals = [], [], []
+    for e in range(P.num_elements):
+        nodes = elem_nodes[elem_ptr[e]:elem_ptr[e+1]]
+        Ke = (1 + 0.1 * e) * K0
+        P.add_element(e, Ke.flatten(order='F'))
+        rr, cc = np.meshgrid(nodes, nodes, indexing='ij')
+        rows.extend(rr.ravel())
+        cols.extend(cc.ravel())
+        vals.extend(Ke.ravel())
+
+    expect = sparse.csc_array((vals, (rows, cols)), shape=(N, N))
+    assert_allclose(P.A.toarray(), expect.toarray(), atol=1e-14)
+
+    # Reassemble in one call, with the order of the element matrices
+    P.zero()
+    assert np.all(P.A.toarray() == 0)
+
+    values = np.concatenate([
+        ((1 + 0.1 * e) * K0).flatten(order='F') for e in range(P.num_elements)
+    ])
+    P.add(values)
+    assert_allclose(P.A.toarray(), expect.toarray(), atol=1e-14)
+
+
+def test_assembly_coo():
+    """Test reassembly of a pattern built from a COO matrix."""
+    T = csparse.COOMatrix([1.0, 2.0, 3.0, 4.0], [0, 1, 0, 1], [0, 1, 0, 0], [2, 2])
+
+    P = csparse.assembly_pattern(T)
+    assert_allclose(P.A.toarray(), [[4.0, 0.0], [4.0, 2.0]])
+
+    P.zero()
+    P.add([1.0, 1.0, 1.0, 1.0])
+    assert_allclose(P.A.toarray(), [[2.0, 0.0], [1.0, 1.0]])
+
+    # The matrix is a copy, so changing it does not change the pattern
+    A = P.A
+    A[1, 1] = 5.0
+    A[0, 1] = 7.0
+    assert_allclose(P.A.toarray(), [[2.0, 0.0], [1.0, 1.0]])
+
+    P.add([1.0, 1.0, 1.0, 1.0])
+    assert_allclose(P.A.toarray(), [[4.0, 0.0], [2.0, 2.0]])
+
+
+# =============================================================================
+# =============================================================================
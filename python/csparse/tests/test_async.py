@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# =============================================================================
+#     File: test_async.py
+#  Created: 2025-03-27 09:12
+#   Author: Bernie Roesler
+#
+"""
+Unit tests for the asynchronous versions of the compute-heavy functions.
+"""
+# =============================================================================
+
+import pytest
+import numpy as np
+
+from concurrent.futures import Future, ThreadPoolExecutor, wait
+from numpy.testing import assert_allclose
+from scipy import sparse
+
+import csparse
+
+
+def test_chol_async():
+    """Test that an asynchronous factorization matches the synchronous one."""
+    A = csparse.davis_example_chol()
+    S = csparse.schol(A, order='APlusAT')
+
+    future = csparse.chol_async(A, S)
+    assert isinstance(future, Future)
+
+    assert_allclose(future.result().toarray(), csparse.chol(A, S).toarray())
+
+
+def test_concurrent_factorizations():
+    """Test many factorizations in flight at once, while Python keeps working."""
+    A = csparse.davis_example_chol()
+    S = csparse.schol(A)
+    Ad = A.toarray()
+
+    # Scaling the values keeps the pattern, so S is shared by all calls
+    scales = np.linspace(1.0, 2.0, 16)
+    futures = [
+        csparse.chol_async(csparse.from_scipy_sparse(sparse.csc_array(s * Ad)), S)
+        for s in scales
+    ]
+
+    for s, future in zip(scales, futures):
+        L = future.result().toarray()
+        assert_allclose(L @ L.T, s * Ad, atol=1e-12)
+
+
+def test_solve_and_dot_async():
+    """Test asynchronous solves and products."""
+    A = csparse.davis_example_chol()
+    b = np.arange(1.0, A.shape[0] + 1)
+
+    res = csparse.lu_async(A).result()
+    x = csparse.lusolve_async(res, b).result()
+    assert_allclose(A.toarray() @ x, b, atol=1e-12)
+
+    assert_allclose(csparse.dot_async(A, x).result(), b, atol=1e-12)
+    assert_allclose(csparse.submit(A.dot, x).result(), b, atol=1e-12)
+
+
+def test_async_stats_scope():
+    """Test that the caller's Stats block does not count asynchronous calls."""
+    A = csparse.davis_example_chol()
+    S = csparse.schol(A)
+
+    with csparse.Stats() as stats:
+        csparse.chol_async(A, S).result()
+    assert stats.flops == 0
+
+    # A block entered on the worker thread counts the call
+    def counted_chol(A, S):
+        with csparse.Stats() as stats:
+            return csparse.chol(A, S), stats
+
+    L, stats = csparse.submit(counted_chol, A, S).result()
+    assert stats.flops > 0
+    assert stats.calls["chol"] == 1
+
+
+def test_async_exception():
+    """Test that an exception is raised by the result of the future."""
+    A = csparse.davis_example_chol()
+    A_neg = csparse.from_scipy_sparse(sparse.csc_array(-A.toarray()))
+
+    future = csparse.chol_async(A_neg)
+    with pytest.raises(RuntimeError):
+        future.result()
+
+
+def test_mutate_pending_argument():
+    """Test that an argument cannot be modified while a call is using it."""
+    # A 2D Laplacian in the natural order has enough fill to factor slowly
+    n = 150
+    T = sparse.diags([-1.0, 4.0, -1.0], [-1, 0, 1], shape=(n, n))
+    E = sparse.diags([-1.0, -1.0], [-1, 1], shape=(n, n))
+    Ad = sparse.csc_array(sparse.kron(sparse.eye(n), T) + sparse.kron(E, sparse.eye(n)))
+    A = csparse.from_scipy_sparse(Ad)
+    a00 = A[0, 0]
+
+    # Assigning the same value does not change the factor, if it runs before
+    # the call starts
+    future = csparse.chol_async(A)
+    raised = False
+    while not future.done():
+        try:
+            A[0, 0] = a00
+        except BufferError:
+            raised = True
+            break
+
+    L = future.result()
+    assert raised
+
+    x = np.arange(1.0, n * n + 1)
+    assert_allclose(L @ (L.T @ x), Ad @ x, atol=1e-8)
+
+    # The matrix can be modified again once the call is done
+    A[0, 0] = a00
+
+
+def test_set_executor():
+    """Test that the calls run on a custom executor."""
+    A = csparse.davis_example_chol()
+
+    with ThreadPoolExecutor(max_workers=2) as executor:
+        previous = csparse.set_executor(executor)
+        try:
+            assert csparse.get_executor() is executor
+            futures = [csparse.qr_async(A) for _ in range(4)]
+            wait(futures)
+            for future in futures:
+                assert_allclose(future.result().R.toarray(),
+                                csparse.qr(A).R.toarray())
+        finally:
+            csparse.set_executor(previous)
+
+    assert csparse.get_executor() is not executor
+
+
+# =============================================================================
+# =============================================================================
@@ -13,6 +13,8 @@ import pytest
 import numpy as np
 
 from scipy import linalg as la
+from scipy import sparse
+from scipy.sparse.linalg import LaplacianNd
 
 import csparse
 
@@ -50,6 +52,179 @@ def test_cholesky_interface():
     np.testing.assert_allclose(Ll.toarray(), Lr.toarray())
 
 
+@pytest.mark.parametrize("order", ["Natural", "APlusAT", "NestedDissection"])
+def test_cholesky_amd(order):
+    """Test the Cholesky decomposition with a fill-reducing ordering."""
+    A = csparse.davis_example_chol()
+    Ad = A.toarray()
+
+    p = csparse.amd(A, order=order)
+    np.testing.assert_array_equal(np.sort(p), np.arange(A.shape[0]))
+
+    if order == "Natural":
+        np.testing.assert_array_equal(p, np.arange(A.shape[0]))
+
+    L = csparse.chol(A, order=order).toarray()
+    np.testing.assert_allclose(L @ L.T, Ad[p][:, p], atol=1e-13)
+
+
+def test_cholesky_symbolic_reuse():
+    """Test reusing the symbolic analysis for multiple factorizations."""
+    A = csparse.davis_example_chol()
+    Ad = A.toarray()
+    N = A.shape[0]
+
+    S = csparse.schol(A, order="APlusAT")
+    assert isinstance(S, csparse.SymbolicChol)
+    assert S.lnz == S.cp[-1]
+    assert S.p_inv.shape == (N,)
+    assert S.parent.shape == (N,)
+
+    p = csparse.inv_permute(S.p_inv)
+    L_sym = csparse.symbolic_cholesky(A, S)
+
+    # Refactor a matrix with the same pattern, but different values
+    for scale in [1.0, 2.0, 10.0]:
+        Bd = scale * Ad + np.diag(np.arange(N))
+        B = csparse.CSCMatrix(Bd.ravel(order='F'), Bd.shape)
+        Bp = Bd[p][:, p]
+
+        L = csparse.chol(B, S).toarray()
+        np.testing.assert_allclose(L @ L.T, Bp, atol=1e-13)
+
+        L = csparse.rechol(B, S).toarray()
+        np.testing.assert_allclose(L @ L.T, Bp, atol=1e-13)
+
+        L = csparse.leftchol(B, S).toarray()
+        np.testing.assert_allclose(L @ L.T, Bp, atol=1e-13)
+
+        # Refactor in place
+        csparse.rechol(B, S, L_sym)
+        L = L_sym.toarray()
+        np.testing.assert_allclose(L @ L.T, Bp, atol=1e-13)
+
+
+def test_cholesky_symbolic_mismatch():
+    """Test that an analysis of another matrix is rejected."""
+    A = csparse.davis_example_chol()
+    Ad = A.toarray()
+    S = csparse.schol(A, order="APlusAT")
+
+    # A different size
+    B = csparse.CSCMatrix(np.eye(3).ravel(), (3, 3))
+    with pytest.raises(ValueError):
+        csparse.chol(B, S)
+
+    # The same size, with another entry
+    i, j = np.argwhere(Ad == 0)[0]
+    Bd = Ad.copy()
+    Bd[i, j] = Bd[j, i] = 0.1
+    B = csparse.CSCMatrix(Bd.ravel(order='F'), Bd.shape)
+
+    for func in [csparse.chol, csparse.leftchol, csparse.rechol,
+                 csparse.symbolic_cholesky]:
+        with pytest.raises(ValueError):
+            func(B, S)
+
+    L = csparse.symbolic_cholesky(A, S)
+    with pytest.raises(ValueError):
+        csparse.rechol(B, S, L)
+
+
+def test_cholesky_nested_dissection():
+    """Test the nested dissection ordering on a 2D mesh."""
+    n = 30
+    L_nd = LaplacianNd((n, n), boundary_conditions='dirichlet')
+    Ad = -L_nd.toarray()
+    A = csparse.from_scipy_sparse(sparse.csc_array(Ad))
+    N = A.shape[0]
+
+    p = csparse.nested_dissection(A, leaf_size=16)
+    np.testing.assert_array_equal(np.sort(p), np.arange(N))
+
+    # The separator splits the mesh into two halves
+    part = np.asarray(csparse.vertex_separator(A))
+    n_sep = np.sum(part == 2)
+    assert 0 < n_sep <= 2 * n
+    assert np.sum(part == 0) > N // 3
+    assert np.sum(part == 1) > N // 3
+
+    S_nd = csparse.schol(A, order='NestedDissection')
+    S_amd = csparse.schol(A, order='APlusAT')
+    np.testing.assert_array_equal(csparse.inv_permute(S_nd.p_inv),
+                                  csparse.nested_dissection(A))
+    assert (csparse.etree_height(S_nd.parent)
+            < csparse.etree_height(S_amd.parent))
+
+    p = csparse.inv_permute(S_nd.p_inv)
+    L = csparse.chol(A, S_nd).toarray()
+    np.testing.assert_allclose(L @ L.T, Ad[p][:, p], atol=1e-12)
+
+
+@pytest.mark.parametrize("layout", ["Strided", "Interleaved"])
+def test_cholesky_batch(layout):
+    """Test factoring and solving a batch of matrices with the same pattern."""
+    A = csparse.davis_example_chol()
+    N = A.shape[0]
+    S = csparse.schol(A, order="APlusAT")
+
+    batch = 11
+    scales = 1.0 + np.arange(batch)
+    values = np.outer(scales, A.data)  # (batch, nnz), strided
+    B = np.outer(scales, np.arange(1, N + 1))
+    if layout == "Interleaved":
+        values, B = values.T, B.T
+
+    F = csparse.chol_batch(A, S, values.ravel(), layout=layout)
+    assert F.batch == batch
+
+    X = csparse.chol_solve_batch(F, B.ravel())
+    X = X.reshape(B.shape)
+    if layout == "Interleaved":
+        X = X.T
+
+    for b, scale in enumerate(scales):
+        Ab = csparse.CSCMatrix(scale * A.data, A.indices, A.indptr, A.shape)
+        np.testing.assert_allclose(F.factor(b).toarray(),
+                                   csparse.chol(Ab, S).toarray(), atol=1e-13)
+        # A_b = scale * A and b_b = scale * (1, ..., N)
+        np.testing.assert_allclose(X[b], la.solve(A.toarray(),
+                                                  np.arange(1, N + 1)),
+                                   atol=1e-12)
+
+
+@pytest.mark.parametrize("order", ["Natural", "APlusAT"])
+def test_cholesky_block_solve(order):
+    """Test solving a block of right-hand sides with the Cholesky factor."""
+    A = csparse.davis_example_chol()
+    Ad = A.toarray()
+    N = A.shape[0]
+
+    S = csparse.schol(A, order=order)
+    L = csparse.chol(A, S)
+
+    rng = np.random.default_rng(565656)
+    B = rng.random((N, 20))
+
+    X = csparse.chol_solve_block(L, S, B)
+    assert X.shape == B.shape
+    np.testing.assert_allclose(X, la.solve(Ad, B), atol=1e-13)
+
+    # A single right-hand side keeps its shape
+    x = csparse.chol_solve_block(L, S, B[:, 0])
+    assert x.shape == (N,)
+    np.testing.assert_allclose(x, X[:, 0], atol=1e-13)
+
+    # Compare the triangular solves to the dense solves
+    Ld = L.toarray()
+    np.testing.assert_allclose(csparse.lsolve_block(L, B),
+                               la.solve_triangular(Ld, B, lower=True),
+                               atol=1e-13)
+    np.testing.assert_allclose(csparse.ltsolve_block(L, B),
+                               la.solve_triangular(Ld.T, B, lower=False),
+                               atol=1e-13)
+
+
 @pytest.mark.parametrize("chol_func", PYTHON_CHOL_FUNCS)
 def test_python_cholesky(A_matrix, chol_func):
     """Test the Cholesky decomposition algorithms."""
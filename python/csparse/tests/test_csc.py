@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+# =============================================================================
+#     File: test_csc.py
+#  Created: 2025-03-14 09:20
+#   Author: Bernie Roesler
+#
+"""
+Unit tests for the NumPy and SciPy interoperability of csparse.CSCMatrix.
+"""
+# =============================================================================
+
+import pytest
+import numpy as np
+
+from scipy import sparse
+
+import csparse
+
+
+def test_construct_from_numpy():
+    """Build a CSCMatrix directly from the arrays of a SciPy matrix."""
+    As = csparse.davis_example_qr(format='csc')
+    A = csparse.CSCMatrix(As.data, As.indices, As.indptr, As.shape)
+
+    np.testing.assert_equal(A.indptr, As.indptr)
+    np.testing.assert_equal(A.indices, As.indices)
+    np.testing.assert_equal(A.data, As.data)
+    np.testing.assert_equal(A.toarray(), As.toarray())
+
+
+def test_array_views():
+    """Check that the matrix arrays are read-only views of the matrix."""
+    A = csparse.davis_example_qr()
+
+    data = A.data
+    assert isinstance(data, np.ndarray)
+    assert not data.flags.writeable
+    assert not data.flags.owndata
+
+    # The view keeps the matrix alive
+    del A
+    np.testing.assert_equal(data, data.copy())
+
+    with pytest.raises(ValueError):
+        data[0] = 1.0
+
+
+def test_mutate_with_views():
+    """Check that a matrix cannot be modified while its arrays are viewed."""
+    A = csparse.CSCMatrix(np.eye(3).ravel(), (3, 3))
+    expect = A.toarray()
+
+    data = A.data
+    As = A.toscipy()
+
+    with pytest.raises(BufferError):
+        A[0, 1] = 1.0
+    with pytest.raises(BufferError):
+        A.assign(0, 1, 1.0)
+    with pytest.raises(BufferError):
+        A.to_canonical()
+
+    # Reading does not insert an entry
+    assert A[0, 1] == 0.0
+
+    np.testing.assert_equal(data, np.ones(3))
+    np.testing.assert_equal(As.toarray(), expect)
+
+    # The matrix can be modified again once the views are deleted
+    del data, As
+    A[0, 1] = 1.0
+    expect[0, 1] = 1.0
+    np.testing.assert_equal(A.toarray(), expect)
+
+    # Views of in-place factors block the refactorization
+    B = A.T @ A
+    S = csparse.schol(B)
+    L = csparse.symbolic_cholesky(B, S)
+    L_data = L.data
+    with pytest.raises(BufferError):
+        csparse.rechol(B, S, L)
+    del L_data
+    csparse.rechol(B, S, L)
+    np.testing.assert_allclose((L @ L.T).toarray(), B.toarray(), atol=1e-15)
+
+
+def test_toscipy():
+    """Check that the SciPy matrix shares the arrays of the matrix."""
+    A = csparse.davis_example_qr()
+    As = A.toscipy()
+
+    assert isinstance(As, sparse.csc_array)
+    assert As.shape == A.shape
+    assert np.shares_memory(As.data, A.data)
+    np.testing.assert_equal(As.toarray(), A.toarray())
+
+    # The default conversion copies, so it can be modified in place
+    Ac = csparse.to_scipy_sparse(A)
+    assert not np.shares_memory(Ac.data, A.data)
+
+
+def test_result_vectors():
+    """Check that result vectors are returned as NumPy arrays."""
+    A = csparse.davis_example_qr()
+    M, N = A.shape
+    x = np.arange(1, N + 1, dtype=float)
+    y = np.zeros(M)
+
+    z = A.gaxpy(x, y)
+    assert isinstance(z, np.ndarray)
+    assert z.flags.writeable
+    np.testing.assert_allclose(z, A.toarray() @ x)
+
+    d = A.to_dense_vector()
+    assert isinstance(d, np.ndarray)
+    np.testing.assert_equal(d, A.toarray().ravel(order='F'))
+
+
+# =============================================================================
+# =============================================================================
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+# =============================================================================
+#     File: test_csr.py
+#  Created: 2025-03-26 10:05
+#   Author: Bernie Roesler
+#
+"""
+Unit tests for the CSRMatrix class and the cached CSR mirror.
+"""
+# =============================================================================
+
+import numpy as np
+
+from numpy.testing import assert_allclose
+from scipy import sparse
+
+import csparse
+
+
+def _random(M=30, N=20, seed=565656):
+    rng = np.random.default_rng(seed)
+    A = sparse.random(M, N, density=0.2, format='csc', random_state=rng)
+    return A, csparse.from_scipy_sparse(A, format='csc')
+
+
+def test_csr_conversion():
+    """Test conversion to CSR against scipy.sparse."""
+    A, Ac = _random()
+    R = Ac.tocsr()
+    As = A.tocsr()
+    As.sort_indices()
+
+    assert R.shape == A.shape
+    assert R.nnz == A.nnz
+    assert_allclose(R.indptr, As.indptr)
+    assert_allclose(R.indices, As.indices)
+    assert_allclose(R.data, As.data)
+    assert_allclose(R.toarray(), A.toarray())
+    assert_allclose(R.toscipy().toarray(), A.toarray())
+    assert_allclose(R.tocsc().toarray(), A.toarray())
+
+
+def test_csr_products():
+    """Test the products of a CSR matrix."""
+    A, Ac = _random()
+    R = csparse.CSRMatrix(Ac)
+    x = np.arange(A.shape[1], dtype=float)
+    y = np.ones(A.shape[0])
+
+    assert_allclose(R @ x, A @ x)
+    assert_allclose(R.gaxpy(x, y), A @ x + y)
+    assert_allclose(R.gatxpy(y, x), A.T @ y + x)
+    assert_allclose(R.sum_rows(), np.asarray(A.sum(axis=1)).ravel())
+    assert_allclose(R.sum_cols(), np.asarray(A.sum(axis=0)).ravel())
+
+
+def test_csr_mirror():
+    """Test that the mirror is built on request and gives the same results."""
+    A, Ac = _random()
+    assert not Ac.has_csr
+
+    expect_slice = Ac.slice(3, 7, 0, A.shape[1]).toarray()
+    expect_index = Ac.index([5, 1, 1], [0, 4, 2]).toarray()
+
+    Ac.build_csr()
+    assert Ac.has_csr
+    assert_allclose(Ac.slice(3, 7, 0, A.shape[1]).toarray(), expect_slice)
+    assert_allclose(Ac.index([5, 1, 1], [0, 4, 2]).toarray(), expect_index)
+    assert_allclose(Ac.T.toarray(), A.T.toarray())
+
+    Ac.clear_csr()
+    assert not Ac.has_csr
+
+# =============================================================================
+# =============================================================================
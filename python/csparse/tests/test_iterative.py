@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+# =============================================================================
+#     File: test_iterative.py
+#  Created: 2025-03-23 11:40
+#   Author: Bernie Roesler
+#
+"""
+Unit tests for the preconditioned Krylov solvers.
+"""
+# =============================================================================
+
+import numpy as np
+import pytest
+
+from numpy.testing import assert_allclose
+from scipy import sparse
+
+import csparse
+
+
+def _laplacian(n, shift=0.0, convection=0.0):
+    """Build the (shifted, convected) 2D Laplacian on an n x n grid."""
+    T = sparse.diags([-1 - convection, 2, -1 + convection], [-1, 0, 1],
+                     shape=(n, n))
+    I = sparse.eye_array(n)
+    A = sparse.kron(T, I) + sparse.kron(I, T) + shift * sparse.eye_array(n*n)
+    return A.tocsc()
+
+
+@pytest.mark.parametrize("precond", [None, "jacobi", "ichol"])
+def test_pcg(precond):
+    """Test PCG with each preconditioner against a known solution."""
+    A = _laplacian(15)
+    Ac = csparse.from_scipy_sparse(A, format='csc')
+    x_true = np.arange(1, A.shape[0] + 1, dtype=float) / A.shape[0]
+    b = A @ x_true
+
+    M = {
+        None: None,
+        "jacobi": csparse.jacobi_preconditioner(Ac),
+        "ichol": csparse.ichol_preconditioner(csparse.ichol(Ac, "NoFill")),
+    }[precond]
+
+    res = csparse.pcg(Ac, b, M, tol=1e-10)
+
+    assert res.converged
+    assert res.residual <= 1e-9
+    assert len(res.history) == res.iterations
+    assert_allclose(res.x, x_true, atol=1e-8)
+
+
+@pytest.mark.parametrize("solver", ["pcg", "minres", "gmres"])
+def test_threads(solver):
+    """Test that the multithreaded products match the known solution."""
+    A = _laplacian(130, shift=2.0)  # large enough for several threads
+    Ac = csparse.from_scipy_sparse(A, format='csc')
+    x_true = 1 + np.arange(A.shape[0]) % 7 / 7
+    b = A @ x_true
+
+    res = getattr(csparse, solver)(Ac, b, tol=1e-10, threads=4)
+
+    assert res.converged
+    assert_allclose(res.x, x_true, atol=1e-8)
+
+
+def test_ichol_preconditioner_iterations():
+    """Test that IC(0) reduces the number of iterations."""
+    Ac = csparse.from_scipy_sparse(_laplacian(15), format='csc')
+    b = np.ones(Ac.shape[0])
+
+    plain = csparse.pcg(Ac, b)
+    ic0 = csparse.pcg(Ac, b, csparse.ichol_preconditioner(csparse.ichol(Ac)))
+
+    assert ic0.iterations < plain.iterations
+
+
+def test_minres_indefinite():
+    """Test MINRES on a symmetric indefinite system."""
+    A = _laplacian(10, shift=-3.0)
+    Ac = csparse.from_scipy_sparse(A, format='csc')
+    x_true = np.ones(A.shape[0])
+
+    res = csparse.minres(Ac, A @ x_true, tol=1e-10, max_iter=4 * A.shape[0])
+
+    assert res.converged
+    assert_allclose(res.x, x_true, atol=1e-6)
+
+
+def test_gmres_nonsymmetric():
+    """Test restarted GMRES on a nonsymmetric system."""
+    A = _laplacian(10, convection=0.4)
+    Ac = csparse.from_scipy_sparse(A, format='csc')
+    x_true = np.ones(A.shape[0])
+
+    res = csparse.gmres(Ac, A @ x_true, tol=1e-10, max_iter=1000, restart=20)
+
+    assert res.converged
+    assert_allclose(res.x, x_true, atol=1e-8)
+
+
+def test_iteration_limit():
+    """Test that the solvers stop at the iteration limit."""
+    Ac = csparse.from_scipy_sparse(_laplacian(10), format='csc')
+    b = np.ones(Ac.shape[0])
+
+    res = csparse.pcg(Ac, b, tol=1e-12, max_iter=2)
+
+    assert not res.converged
+    assert res.iterations == 2
+
+
+# =============================================================================
+# =============================================================================
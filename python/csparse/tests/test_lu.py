@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+# =============================================================================
+#     File: test_lu.py
+#  Created: 2025-03-17 10:05
+#   Author: Bernie Roesler
+#
+"""
+Unit tests for the csparse.lu() function.
+"""
+# =============================================================================
+
+import pytest
+import numpy as np
+
+from scipy import sparse
+
+import csparse
+
+
+ATOL = 1e-12
+
+N = 7  # arbitrary matrix size for testing
+TEST_MATRICES = [
+    ("Identity", sparse.eye_array(N).tocsc()),
+    ("Diagonal", sparse.diags(np.arange(1, N)).tocsc()),
+    ("Asymmetric Banded",
+        sparse.diags([np.ones(N-1), np.arange(1, N+1)], [-1, 0]).tocsc()),
+    ("Davis 8x8", csparse.davis_example_qr(format='csc')),
+    ("Davis 4x4", csparse.davis_small_example(format='csc')),
+    # Requires row pivoting, since A[0, 0] == 0
+    ("Strang 3x3", sparse.csc_array(
+        np.array([[0, 1, 2], [1, 0, 1], [1, 1, 0]], dtype=float)
+    )),
+]
+
+
+def _test_lu_decomposition(A, order, tol):
+    """Check that P A Q = L U for the given matrix."""
+    Ac = csparse.from_scipy_sparse(A, format='csc')
+    A_dense = A.toarray()
+
+    res = csparse.lu(Ac, order=order, tol=tol)
+    L, U = res.L.toarray(), res.U.toarray()
+    p = csparse.inv_permute(res.p_inv)
+
+    np.testing.assert_allclose(np.tril(L), L, atol=ATOL)
+    np.testing.assert_allclose(np.triu(U), U, atol=ATOL)
+    np.testing.assert_allclose(np.diag(L), np.ones(A.shape[0]), atol=ATOL)
+    np.testing.assert_allclose(L @ U, A_dense[p][:, res.q], atol=ATOL)
+
+    # Solve a system
+    expect = np.arange(1, A.shape[0] + 1, dtype=float)
+    b = A_dense @ expect
+    np.testing.assert_allclose(csparse.lusolve(res, b), expect, atol=ATOL)
+
+
+@pytest.mark.parametrize("order", ["Natural", "APlusAT", "ATANoDenseRows"])
+@pytest.mark.parametrize("tol", [0.0, 0.1, 1.0])
+@pytest.mark.parametrize("case_name, A", TEST_MATRICES)
+def test_lu_fixed(case_name, A, order, tol):
+    """Test LU decomposition with various matrices."""
+    _test_lu_decomposition(A, order, tol)
+
+
+@pytest.mark.parametrize("N", [2, 7, 10])
+def test_lu_random(N):
+    """Test LU decomposition with random matrices."""
+    rng = np.random.default_rng(565656)
+    for _ in range(10):
+        A = sparse.random(N, N, density=0.5, format='csc', random_state=rng)
+        A.setdiag(N * np.arange(1, N+1))  # ensure structural full rank
+        _test_lu_decomposition(A, "ATANoDenseRows", 1.0)
+
+
+def test_lu_symbolic_reuse():
+    """Test reusing the symbolic analysis for multiple LU factorizations."""
+    A = csparse.davis_example_qr(format='csc')
+    S = csparse.slu(csparse.from_scipy_sparse(A, format='csc'),
+                    order="ATANoDenseRows")
+    assert isinstance(S, csparse.SymbolicLU)
+    assert S.q.shape == (A.shape[0],)
+
+    for scale in [1.0, 2.0, 10.0]:
+        B = csparse.from_scipy_sparse(scale * A, format='csc')
+        res = csparse.lu(B, S)
+        expect = csparse.lu(B, order="ATANoDenseRows")
+        np.testing.assert_allclose(res.L.toarray(), expect.L.toarray(),
+                                   atol=ATOL)
+        np.testing.assert_allclose(res.U.toarray(), expect.U.toarray(),
+                                   atol=ATOL)
+
+
+def test_lu_symbolic_mismatch():
+    """Test that an analysis of another matrix is rejected."""
+    A = csparse.davis_example_qr(format='csc')
+    S = csparse.slu(csparse.from_scipy_sparse(A, format='csc'))
+
+    # A different size
+    B = csparse.from_scipy_sparse(A[:5, :5], format='csc')
+    with pytest.raises(ValueError):
+        csparse.lu(B, S)
+
+    # Not square
+    B = csparse.from_scipy_sparse(A[:, :5], format='csc')
+    with pytest.raises(ValueError):
+        csparse.lu(B, S)
+
+
+def test_lu_singular():
+    """Test that a singular matrix raises an error."""
+    A = sparse.csc_array(np.array([[1, 2], [2, 4]], dtype=float))
+    with pytest.raises(RuntimeError):
+        csparse.lu(csparse.from_scipy_sparse(A, format='csc'))
+
+
+# =============================================================================
+# =============================================================================
@@ -104,6 +104,96 @@ def _test_qr_decomposition(case_name, A):
     np.testing.assert_allclose(Q @ R, A_dense, atol=ATOL)
 
 
+def test_qr_symbolic_reuse():
+    """Test reusing the symbolic analysis for multiple QR factorizations."""
+    A = csparse.davis_example_qr(format='csc')
+    Ac = csparse.from_scipy_sparse(A, format='csc')
+    M, N = A.shape
+
+    S = csparse.sqr(Ac)
+    assert isinstance(S, csparse.SymbolicQR)
+    assert S.q.shape == (N,)
+    assert S.m2 >= M
+
+    res = csparse.symbolic_qr(Ac, S)
+
+    for scale in [1.0, 2.0, 10.0]:
+        B = csparse.from_scipy_sparse(scale * A, format='csc')
+        expect = csparse.qr(B)
+
+        for QRres in [csparse.qr(B, S), csparse.reqr(B, S)]:
+            np.testing.assert_allclose(QRres.V.toarray(), expect.V.toarray(),
+                                       atol=ATOL)
+            np.testing.assert_allclose(QRres.beta, expect.beta, atol=ATOL)
+            np.testing.assert_allclose(QRres.R.toarray(), expect.R.toarray(),
+                                       atol=ATOL)
+
+        # Refactor in place
+        csparse.reqr(B, S, res)
+        np.testing.assert_allclose(res.R.toarray(), expect.R.toarray(),
+                                   atol=ATOL)
+
+
+def test_qr_symbolic_mismatch():
+    """Test that an analysis of another matrix is rejected."""
+    A = csparse.davis_example_qr(format='csc')
+    Ac = csparse.from_scipy_sparse(A, format='csc')
+    S = csparse.sqr(Ac)
+
+    # A different size
+    B = csparse.from_scipy_sparse(A[:5, :], format='csc')
+    with pytest.raises(ValueError):
+        csparse.qr(B, S)
+
+    # The same size, with a row that starts in another column
+    Bd = A.toarray()
+    i = np.argmax(Bd[:, 0] == 0)
+    Bd[i, 0] = 1.0
+    B = csparse.from_scipy_sparse(sparse.csc_array(Bd), format='csc')
+
+    for func in [csparse.qr, csparse.reqr, csparse.symbolic_qr]:
+        with pytest.raises(ValueError):
+            func(B, S)
+
+    res = csparse.symbolic_qr(Ac, S)
+    with pytest.raises(ValueError):
+        csparse.reqr(B, S, res)
+
+    # The same leftmost columns, with more entries in R
+    n = 5
+    S = csparse.sqr(csparse.from_scipy_sparse(sparse.eye_array(n, format='csc')))
+    Bd = np.eye(n)
+    Bd[0, n-1] = 1.0
+    B = csparse.from_scipy_sparse(sparse.csc_array(Bd), format='csc')
+    with pytest.raises(ValueError):
+        csparse.qr(B, S)
+
+
+def test_qr_batch():
+    """Test factoring and solving a batch of matrices with the same pattern."""
+    A = csparse.davis_example_qr(format='csc')
+    Ac = csparse.from_scipy_sparse(A, format='csc')
+    M, N = A.shape
+    S = csparse.sqr(Ac)
+
+    batch = 5
+    scales = 1.0 + np.arange(batch)
+    values = np.outer(scales, Ac.data)
+    x = np.arange(1, N + 1, dtype=float)
+    B = np.outer(scales, A @ x)
+
+    F = csparse.qr_batch(Ac, S, values.ravel())
+    X = csparse.qr_solve_batch(F, B.ravel()).reshape(batch, N)
+
+    for b, scale in enumerate(scales):
+        expect = csparse.qr(csparse.from_scipy_sparse(scale * A, format='csc'), S)
+        res = F.factor(b)
+        np.testing.assert_allclose(res.R.toarray(), expect.R.toarray(),
+                                   atol=ATOL)
+        np.testing.assert_allclose(res.beta, expect.beta, atol=ATOL)
+        np.testing.assert_allclose(X[b], x, atol=1e-12)
+
+
 def test_apply_q():
     """Test application of the Householder reflectors."""
     A = csparse.davis_example_qr(format='ndarray')
@@ -130,6 +220,46 @@ def test_apply_q():
     np.testing.assert_allclose(R_, Rraw, atol=ATOL)
 
 
+@pytest.mark.parametrize("order", ['Natural', 'ATA'])
+@pytest.mark.parametrize("block_size", [1, 2, 32])
+def test_qr_multifrontal(order, block_size):
+    """Test the multifrontal QR and its application of Q."""
+    A = sparse.vstack([
+        csparse.davis_example_qr(format='csc'),
+        sparse.random(4, 8, density=0.5, format='csc',
+                      random_state=np.random.default_rng(565656))
+    ]).tocsc()
+    M, N = A.shape
+    Ac = csparse.from_scipy_sparse(A, format='csc')
+
+    S = csparse.sqr(Ac, order=order)
+    F = csparse.qr_multifrontal(Ac, S, block_size)
+    q = np.asarray(F.q)
+
+    # R matches the column-by-column QR, up to the signs of its rows
+    res = csparse.qr(Ac, S)
+    np.testing.assert_allclose(np.abs(F.R.toarray()),
+                               np.abs(res.R.toarray()[:N]),
+                               atol=ATOL)
+
+    # Q^T A[:, q] = [R; 0]
+    Y = csparse.apply_qt(F, A[:, q].toarray())
+    np.testing.assert_allclose(Y[:N], F.R.toarray(), atol=ATOL)
+    np.testing.assert_allclose(Y[N:], 0, atol=ATOL)
+
+    B = np.arange(1.0, 3 * M + 1).reshape(M, 3)
+    np.testing.assert_allclose(csparse.apply_q(F, csparse.apply_qt(F, B)), B,
+                               atol=ATOL)
+
+    # Least-squares solutions
+    X = csparse.qrsolve(F, B)
+    expect_X, *_ = la.lstsq(A.toarray(), B)
+    np.testing.assert_allclose(X, expect_X, atol=ATOL)
+
+    x = csparse.qrsolve(Ac, B[:, 0], order=order)
+    np.testing.assert_allclose(x, expect_X[:, 0], atol=ATOL)
+
+
 def test_qrightleft():
     """Test the python QR decomposition algorithms."""
     A = csparse.davis_small_example(format='ndarray')
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# =============================================================================
+#     File: test_stats.py
+#  Created: 2025-03-21 11:30
+#   Author: Bernie Roesler
+#
+"""
+Unit tests for the csparse.Stats performance counters.
+"""
+# =============================================================================
+
+import threading
+
+import numpy as np
+import pytest
+
+from scipy import sparse
+
+import csparse
+
+
+def _laplacian(n):
+    """Build the 2D Laplacian on an n x n grid."""
+    T = sparse.diags([-1, 2, -1], [-1, 0, 1], shape=(n, n))
+    I = sparse.eye_array(n)
+    A = sparse.kron(T, I) + sparse.kron(I, T)
+    return csparse.from_scipy_sparse(A.tocsc(), format='csc')
+
+
+def test_stats_cholesky():
+    """Test the counters of a Cholesky factorization."""
+    A = _laplacian(10)
+
+    with csparse.Stats() as stats:
+        S = csparse.schol(A, order="APlusAT")
+        csparse.chol(A, S)
+
+    cp = np.asarray(S.cp)
+    assert stats.flops == np.sum(np.diff(cp)**2)
+    assert stats.calls["schol"] == 1
+    assert stats.calls["chol"] == 1
+    assert set(stats.times) >= {"schol", "schol.amd", "chol"}
+    assert stats.peak_bytes >= 16 * S.lnz
+
+    # Counters are not updated outside of the block
+    flops = stats.flops
+    csparse.chol(A, S)
+    assert stats.flops == flops
+
+    stats.reset()
+    assert stats.flops == 0
+    assert not stats.times
+
+
+def test_stats_nested():
+    """Test that the inner block does not update the outer counters."""
+    A = _laplacian(5)
+
+    with csparse.Stats() as outer:
+        with csparse.Stats() as inner:
+            csparse.lu(A, order="APlusAT")
+        assert outer.flops == 0
+        assert inner.flops > 0
+        assert inner.calls["lu"] == 1
+        assert "spsolve" not in inner.calls  # the solves are part of lu
+
+        csparse.qr(A)
+        assert outer.flops > 0
+
+
+
+def test_workspace():
+    """Test that repeated factorizations reuse the pooled workspaces."""
+    A = _laplacian(10)
+    S = csparse.schol(A, order="APlusAT")
+    L0 = csparse.chol(A, S).toarray()
+
+    with csparse.Workspace() as ws:
+        for _ in range(2):
+            csparse.chol(A, S)   # fill the pool
+        allocations = ws.allocations
+
+        for _ in range(5):
+            np.testing.assert_array_equal(csparse.chol(A, S).toarray(), L0)
+
+    assert ws.allocations == allocations
+    assert ws.leases > 0
+    assert ws.bytes_in_use == 0
+    assert ws.peak_bytes >= 8 * A.shape[0]
+    assert ws.reserved_bytes >= ws.peak_bytes
+
+    # The workspace is not used outside of the block
+    leases = ws.leases
+    csparse.chol(A, S)
+    assert ws.leases == leases
+
+    ws.release()
+    assert ws.reserved_bytes == 0
+
+
+def test_workspace_owner_thread():
+    """Test that a workspace is installed on one thread at a time."""
+    ws = csparse.Workspace()
+    entered = threading.Event()
+    done = threading.Event()
+
+    def worker():
+        with ws:
+            entered.set()
+            done.wait()
+
+    thread = threading.Thread(target=worker)
+    thread.start()
+    entered.wait()
+    try:
+        with pytest.raises(RuntimeError):
+            with ws:
+                pass
+        with pytest.raises(RuntimeError):
+            ws.peak_bytes
+        with pytest.raises(RuntimeError):
+            ws.release()
+    finally:
+        done.set()
+        thread.join()
+
+    # The workspace is free again once the worker has left its block
+    with ws:
+        assert ws.bytes_in_use == 0
+
+
+# =============================================================================
+# =============================================================================
@@ -184,7 +184,7 @@ def from_ndarray(A, format='csc'):
     return from_scipy_sparse(A, format=format)
     
 
-def to_scipy_sparse(A, format='csc'):
+def to_scipy_sparse(A, format='csc', copy=True):
     r"""Convert a csparse matrix to a scipy.sparse matrix.
 
     Parameters
@@ -193,6 +193,9 @@ def to_scipy_sparse(A, format='csc'):
         The matrix to convert.
     format : str, optional in {'bsr', 'coo', 'csc', 'csr', 'dia', 'dok', 'lil'}
         The format of the output matrix.
+    copy : bool, optional
+        If False, the 'csc' result shares the read-only arrays of `A` instead
+        of copying them, so it cannot be modified in place.
 
     Returns
     -------
@@ -201,7 +204,9 @@ def to_scipy_sparse(A, format='csc'):
     """
     if isinstance(A, COOMatrix):
         A = A.tocsc()
-    A_sparse = sparse.csc_array((A.data, A.indices, A.indptr), shape=A.shape)
+    A_sparse = A.toscipy()
+    if copy:
+        A_sparse = A_sparse.copy()
     format_method_name = f"to{format}"
     try:
         format_method = getattr(A_sparse, format_method_name)
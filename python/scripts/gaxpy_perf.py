@@ -40,9 +40,9 @@ N_samples = 1  # number of samples in each run (100,000 is default)
 
 # TODO include the transpose versions and plot as subfigs
 if filestem.startswith('gaxpy'):
-    gaxpy_methods = ['gaxpy_col', 'gaxpy_row', 'gaxpy_block']
+    gaxpy_methods = ['gaxpy_col', 'gaxpy_row', 'gaxpy_block', 'gaxpy_simd']
 elif filestem.startswith('gatxpy'):
-    gaxpy_methods = ['gatxpy_col', 'gatxpy_row', 'gatxpy_block']
+    gaxpy_methods = ['gatxpy_col', 'gatxpy_row', 'gatxpy_block', 'gatxpy_simd']
 else:
     raise ValueError(f"Unknown filestem: {filestem}")
 
@@ -72,7 +72,9 @@ for N in Ns:
     Y_row = Y.to_dense_vector('C')
 
     for method_name in gaxpy_methods:
-        args = (X_row, Y_row) if method_name.endswith('row') else (X_col, Y_col)
+        # The SIMD kernels use row-major storage
+        is_row = method_name.endswith(('row', 'simd'))
+        args = (X_row, Y_row) if is_row else (X_col, Y_col)
         method = getattr(A, method_name)
 
         # Create a partial function with the arguments for timing
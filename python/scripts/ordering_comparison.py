@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+# =============================================================================
+#     File: ordering_comparison.py
+#  Created: 2025-03-30 10:15
+#   Author: Bernie Roesler
+#
+"""
+Compare the fill-in and elimination tree height of the Cholesky factor of
+2D and 3D Laplacians under the natural, minimum degree, and nested dissection
+orderings.
+
+The height of the elimination tree bounds the length of the critical path of
+a parallel factorization, since the subtrees below each node are independent.
+"""
+# =============================================================================
+
+import time
+
+from scipy import sparse
+from scipy.sparse.linalg import LaplacianNd
+
+import csparse
+
+
+ORDERS = ['Natural', 'APlusAT', 'NestedDissection']
+
+GRIDS = [
+    (50, 50),
+    (100, 100),
+    (200, 200),
+    (15, 15, 15),
+    (30, 30, 30),
+]
+
+
+def laplacian(grid_shape):
+    """Create the (positive definite) Laplacian of a regular grid."""
+    L = LaplacianNd(grid_shape, boundary_conditions='dirichlet')
+    return csparse.from_scipy_sparse(sparse.csc_array(-L.tosparse()))
+
+
+# -----------------------------------------------------------------------------
+#         Run the comparison
+# -----------------------------------------------------------------------------
+print(f"{'grid':>14s} {'order':>17s} {'lnz':>10s} {'height':>7s} "
+      f"{'analysis [s]':>12s}")
+
+for grid_shape in GRIDS:
+    A = laplacian(grid_shape)
+    grid_str = 'x'.join(str(n) for n in grid_shape)
+
+    for order in ORDERS:
+        tic = time.perf_counter()
+        S = csparse.schol(A, order=order)
+        toc = time.perf_counter() - tic
+
+        height = csparse.etree_height(S.parent)
+        print(f"{grid_str:>14s} {order:>17s} {S.lnz:10d} {height:7d} "
+              f"{toc:12.3f}")
+
+    print()
+
+# =============================================================================
+# =============================================================================
@@ -0,0 +1,477 @@
+/*==============================================================================
+ *     File: amd.cpp
+ *  Created: 2025-03-10 10:15
+ *   Author: Bernie Roesler
+ *
+ *  Description: Implements the approximate minimum degree ordering.
+ *
+ *============================================================================*/
+
+#include <algorithm>  // std::min, std::max
+#include <cmath>      // std::sqrt
+#include <numeric>    // std::iota
+#include <vector>
+
+#include "amd.h"
+#include "cholesky.h"  // tdfs
+#include "csc.h"
+#include "nd.h"
+
+namespace cs {
+
+/*------------------------------------------------------------------------------
+ *         Helpers
+ *----------------------------------------------------------------------------*/
+/** Flip an index about -1 to mark it (see: CS_FLIP). */
+static inline csint flip(csint i) { return -i - 2; }
+
+
+/** Clear the workspace `w` if the marker would overflow.
+ *
+ * @param mark  the current marker value
+ * @param lemax  the largest element degree seen so far
+ * @param[in,out] w  the workspace to clear
+ * @param N  the number of nodes
+ *
+ * @return mark  the new marker value, such that `w[0:N] < mark`.
+ */
+static csint wclear(csint mark, csint lemax, std::vector<csint>& w, csint N)
+{
+    if (mark < 2 || (mark + lemax < 0)) {
+        for (csint k = 0; k < N; k++) {
+            if (w[k] != 0) {
+                w[k] = 1;
+            }
+        }
+        mark = 2;
+    }
+    return mark;  // at this point, w[0:N] < mark holds
+}
+
+
+/*------------------------------------------------------------------------------
+ *         Fill-Reducing Orderings
+ *----------------------------------------------------------------------------*/
+CSCMatrix build_graph(const CSCMatrix& A, const AMDOrder order)
+{
+    auto [M, N] = A.shape();
+    CSCMatrix AT = A.transpose();
+    CSCMatrix C;
+
+    if (order == AMDOrder::APlusAT && M == N) {
+        C = A + AT;
+    } else if (order == AMDOrder::ATANoDenseRows) {
+        // Drop dense columns from AT (dense rows of A)
+        csint dense = std::max(16.0, 10 * std::sqrt(static_cast<double>(N)));
+        dense = std::min(N - 2, dense);
+
+        csint nz = 0;
+        for (csint j = 0; j < M; j++) {
+            csint p = AT.p_[j];  // column j of AT starts here
+            AT.p_[j] = nz;       // new column j starts here
+            if (AT.p_[j+1] - p > dense) {
+                continue;        // skip dense column j
+            }
+            for (; p < AT.p_[j+1]; p++) {
+                AT.i_[nz] = AT.i_[p];
+                AT.v_[nz++] = AT.v_[p];
+            }
+        }
+        AT.p_[M] = nz;  // finalize AT
+        AT.realloc();
+
+        C = AT * AT.transpose();  // C = A^T A with no dense rows
+    } else {
+        C = AT * A;
+    }
+
+    // Drop the diagonal entries
+    C.fkeep([] (csint i, csint j, [[maybe_unused]] double Aij) { return i != j; });
+
+    return C;
+}
+
+
+std::vector<csint> amd(const CSCMatrix& A, const AMDOrder order)
+{
+    const csint N = A.N_;
+
+    if (order == AMDOrder::Natural) {
+        std::vector<csint> p(N);
+        std::iota(p.begin(), p.end(), 0);  // identity permutation
+        return p;
+    }
+
+    if (order == AMDOrder::NestedDissection) {
+        // Order the graph that APlusAT would, A + A^T if A is square
+        return nested_dissection(A, AMDOrder::APlusAT);
+    }
+
+    // --- Construct matrix C --------------------------------------------------
+    CSCMatrix C = build_graph(A, order);
+
+    csint dense = std::max(16.0, 10 * std::sqrt(static_cast<double>(N)));
+    dense = std::min(N - 2, dense);  // find dense threshold
+
+    // Take a copy of the pattern of C, so that it can be used in-place as the
+    // quotient graph. Add elbow room for the new elements.
+    std::vector<csint> Cp = C.p_;
+    csint cnz = Cp[N];
+    std::vector<csint> Ci = C.i_;
+    Ci.resize(cnz + cnz / 5 + 2 * N);
+    const csint nzmax = Ci.size();
+
+    // Allocate workspaces
+    std::vector<csint> len(N + 1),    // length of adjacency list of each node
+                       nv(N + 1),     // size of each supernode
+                       next(N + 1),   // next node in degree or hash list
+                       head(N + 1),   // head of each degree list
+                       elen(N + 1),   // # of elements in adjacency of node
+                       degree(N + 1), // approximate degree of each node
+                       w(N + 1),      // workspace for set differences
+                       hhead(N + 1),  // head of each hash list
+                       last(N + 1);   // previous node in degree list
+
+    // --- Initialize quotient graph -------------------------------------------
+    for (csint k = 0; k < N; k++) {
+        len[k] = Cp[k+1] - Cp[k];
+    }
+    len[N] = 0;
+
+    for (csint i = 0; i <= N; i++) {
+        head[i] = -1;         // degree list i is empty
+        last[i] = -1;
+        next[i] = -1;
+        hhead[i] = -1;        // hash list i is empty
+        nv[i] = 1;            // node i is just one node
+        w[i] = 1;             // node i is alive
+        elen[i] = 0;          // Ek of node i is empty
+        degree[i] = len[i];   // degree of node i
+    }
+
+    csint mark = wclear(0, 0, w, N);  // clear w
+    elen[N] = -2;                     // N is a dead element
+    Cp[N] = -1;                       // N is a root of assembly tree
+    w[N] = 0;                         // N is a dead element
+
+    csint nel = 0;  // number of nodes eliminated so far
+
+    // --- Initialize degree lists ---------------------------------------------
+    for (csint i = 0; i < N; i++) {
+        csint d = degree[i];
+        if (d == 0) {                  // node i is empty
+            elen[i] = -2;              // element i is dead
+            nel++;
+            Cp[i] = -1;                // i is a root of assembly tree
+            w[i] = 0;
+        } else if (d > dense) {        // node i is dense
+            nv[i] = 0;                 // absorb i into element N
+            elen[i] = -1;              // node i is dead
+            nel++;
+            Cp[i] = flip(N);
+            nv[N]++;
+        } else {
+            if (head[d] != -1) {
+                last[head[d]] = i;
+            }
+            next[i] = head[d];         // put node i in degree list d
+            head[d] = i;
+        }
+    }
+
+    csint mindeg = 0,  // current minimum degree
+          lemax = 0;   // largest |Le| seen so far
+
+    while (nel < N) {  // while (selecting pivots) do
+        // --- Select node of minimum approximate degree -----------------------
+        csint k = -1;
+        for (; mindeg < N && (k = head[mindeg]) == -1; mindeg++) {}
+
+        if (next[k] != -1) {
+            last[next[k]] = -1;
+        }
+        head[mindeg] = next[k];  // remove k from degree list
+        csint elenk = elen[k];   // elenk = |Ek|
+        csint nvk = nv[k];       // # of nodes k represents
+        nel += nvk;              // nv[k] nodes of A eliminated
+
+        // --- Garbage collection ----------------------------------------------
+        if (elenk > 0 && cnz + mindeg >= nzmax) {
+            for (csint j = 0; j < N; j++) {
+                csint p = Cp[j];
+                if (p >= 0) {         // j is a live node or element
+                    Cp[j] = Ci[p];    // save first entry of object
+                    Ci[p] = flip(j);  // first entry is now flip(j)
+                }
+            }
+
+            csint q = 0;
+            for (csint p = 0; p < cnz; ) {  // scan all of memory
+                csint j = flip(Ci[p++]);
+                if (j >= 0) {               // found object j
+                    Ci[q] = Cp[j];          // restore first entry of object
+                    Cp[j] = q++;            // new pointer to object j
+                    for (csint k3 = 0; k3 < len[j] - 1; k3++) {
+                        Ci[q++] = Ci[p++];
+                    }
+                }
+            }
+            cnz = q;  // Ci[cnz:nzmax] now free
+        }
+
+        // --- Construct new element -------------------------------------------
+        csint dk = 0;
+        nv[k] = -nvk;  // flag k as in Lk
+        csint p = Cp[k];
+        csint pk1 = (elenk == 0) ? p : cnz;  // do in place if elen[k] == 0
+        csint pk2 = pk1;
+
+        for (csint k1 = 1; k1 <= elenk + 1; k1++) {
+            csint e, pj, ln;
+            if (k1 > elenk) {
+                e = k;                   // search the nodes in k
+                pj = p;                  // list of nodes starts at Ci[pj]
+                ln = len[k] - elenk;     // length of list of nodes in k
+            } else {
+                e = Ci[p++];             // search the nodes in e
+                pj = Cp[e];
+                ln = len[e];             // length of list of nodes in e
+            }
+
+            for (csint k2 = 1; k2 <= ln; k2++) {
+                csint i = Ci[pj++];
+                csint nvi = nv[i];
+                if (nvi <= 0) {
+                    continue;            // node i dead, or seen
+                }
+                dk += nvi;               // degree[Lk] += size of node i
+                nv[i] = -nvi;            // negate nv[i] to denote i in Lk
+                Ci[pk2++] = i;           // place i in Lk
+                if (next[i] != -1) {
+                    last[next[i]] = last[i];
+                }
+                if (last[i] != -1) {     // remove i from degree list
+                    next[last[i]] = next[i];
+                } else {
+                    head[degree[i]] = next[i];
+                }
+            }
+
+            if (e != k) {
+                Cp[e] = flip(k);  // absorb e into k
+                w[e] = 0;         // e is now a dead element
+            }
+        }
+
+        if (elenk != 0) {
+            cnz = pk2;           // Ci[cnz:nzmax] is free
+        }
+        degree[k] = dk;          // external degree of k - |Lk \ i|
+        Cp[k] = pk1;             // element k is in Ci[pk1:pk2]
+        len[k] = pk2 - pk1;
+        elen[k] = -2;            // k is now an element
+
+        // --- Find set differences --------------------------------------------
+        mark = wclear(mark, lemax, w, N);  // clear w if necessary
+
+        for (csint pk = pk1; pk < pk2; pk++) {  // scan 1: find |Le \ Lk|
+            csint i = Ci[pk];
+            csint eln = elen[i];
+            if (eln <= 0) {
+                continue;                      // skip if elen[i] empty
+            }
+            csint nvi = -nv[i];                // nv[i] was negated
+            csint wnvi = mark - nvi;
+            for (p = Cp[i]; p <= Cp[i] + eln - 1; p++) {  // scan Ei
+                csint e = Ci[p];
+                if (w[e] >= mark) {
+                    w[e] -= nvi;               // decrement |Le \ Lk|
+                } else if (w[e] != 0) {        // ensure e is a live element
+                    w[e] = degree[e] + wnvi;   // 1st time e seen in scan 1
+                }
+            }
+        }
+
+        // --- Degree update ---------------------------------------------------
+        for (csint pk = pk1; pk < pk2; pk++) {  // scan 2: degree update
+            csint i = Ci[pk];                   // consider node i in Lk
+            csint p1 = Cp[i];
+            csint p2 = p1 + elen[i] - 1;
+            csint pn = p1;
+            csint h = 0,
+                  d = 0;
+
+            for (p = p1; p <= p2; p++) {        // scan Ei
+                csint e = Ci[p];
+                if (w[e] != 0) {                // e is an unabsorbed element
+                    csint dext = w[e] - mark;   // dext = |Le \ Lk|
+                    if (dext > 0) {
+                        d += dext;              // sum up the set differences
+                        Ci[pn++] = e;           // keep e in Ei
+                        h += e;                 // compute the hash of node i
+                    } else {
+                        Cp[e] = flip(k);        // aggressive absorb. e -> k
+                        w[e] = 0;               // e is a dead element
+                    }
+                }
+            }
+
+            elen[i] = pn - p1 + 1;              // elen[i] = |Ei|
+            csint p3 = pn;
+            csint p4 = p1 + len[i];
+
+            for (p = p2 + 1; p < p4; p++) {     // prune edges in Ai
+                csint j = Ci[p];
+                csint nvj = nv[j];
+                if (nvj <= 0) {
+                    continue;                   // node j dead or in Lk
+                }
+                d += nvj;                       // degree(i) += |j|
+                Ci[pn++] = j;                   // place j in node list of i
+                h += j;                         // compute hash for node i
+            }
+
+            if (d == 0) {                       // check for mass elimination
+                Cp[i] = flip(k);                // absorb i into k
+                csint nvi = -nv[i];
+                dk -= nvi;                      // |Lk| -= |i|
+                nvk += nvi;                     // |k| += nv[i]
+                nel += nvi;
+                nv[i] = 0;
+                elen[i] = -1;                   // node i is dead
+            } else {
+                degree[i] = std::min(degree[i], d);  // update degree(i)
+                Ci[pn] = Ci[p3];                // move first node to end
+                Ci[p3] = Ci[p1];                // move 1st el. to end of Ei
+                Ci[p1] = k;                     // add k as 1st element of Ei
+                len[i] = pn - p1 + 1;           // new len of adj. list of i
+                h = ((h < 0) ? -h : h) % N;     // finalize hash of i
+                next[i] = hhead[h];             // place i in hash bucket
+                hhead[h] = i;
+                last[i] = h;                    // save hash of i in last[i]
+            }
+        }  // scan 2 is done
+
+        degree[k] = dk;  // finalize |Lk|
+        lemax = std::max(lemax, dk);
+        mark = wclear(mark + lemax, lemax, w, N);  // clear w
+
+        // --- Supernode detection ---------------------------------------------
+        for (csint pk = pk1; pk < pk2; pk++) {
+            csint i = Ci[pk];
+            if (nv[i] >= 0) {
+                continue;                    // skip if i is dead
+            }
+            csint h = last[i];               // scan hash bucket of node i
+            i = hhead[h];
+            hhead[h] = -1;                   // hash bucket will be empty
+
+            for (; i != -1 && next[i] != -1; i = next[i], mark++) {
+                csint ln = len[i];
+                csint eln = elen[i];
+                for (p = Cp[i] + 1; p <= Cp[i] + ln - 1; p++) {
+                    w[Ci[p]] = mark;
+                }
+
+                csint jlast = i;
+                for (csint j = next[i]; j != -1; ) {  // compare i with all j
+                    bool ok = (len[j] == ln) && (elen[j] == eln);
+                    for (p = Cp[j] + 1; ok && p <= Cp[j] + ln - 1; p++) {
+                        if (w[Ci[p]] != mark) {
+                            ok = false;      // compare i and j
+                        }
+                    }
+
+                    if (ok) {                // i and j are identical
+                        Cp[j] = flip(i);     // absorb j into i
+                        nv[i] += nv[j];
+                        nv[j] = 0;
+                        elen[j] = -1;        // node j is dead
+                        j = next[j];         // delete j from hash bucket
+                        next[jlast] = j;
+                    } else {
+                        jlast = j;           // j and i are different
+                        j = next[j];
+                    }
+                }
+            }
+        }
+
+        // --- Finalize new element --------------------------------------------
+        p = pk1;
+        for (csint pk = pk1; pk < pk2; pk++) {  // finalize Lk
+            csint i = Ci[pk];
+            csint nvi = -nv[i];
+            if (nvi <= 0) {
+                continue;                       // skip if i is dead
+            }
+            nv[i] = nvi;                        // restore nv[i]
+            csint d = degree[i] + dk - nvi;     // compute external degree(i)
+            d = std::min(d, N - nel - nvi);
+            if (head[d] != -1) {
+                last[head[d]] = i;
+            }
+            next[i] = head[d];                  // put i back in degree list
+            last[i] = -1;
+            head[d] = i;
+            mindeg = std::min(mindeg, d);       // find new minimum degree
+            degree[i] = d;
+            Ci[p++] = i;                        // place i in Lk
+        }
+
+        nv[k] = nvk;                  // # nodes absorbed into k
+        len[k] = p - pk1;
+        if (len[k] == 0) {            // length of adj list of element k
+            Cp[k] = -1;               // k is a root of the tree
+            w[k] = 0;                 // k is now a dead element
+        }
+        if (elenk != 0) {
+            cnz = p;                  // free unused space in Lk
+        }
+    }
+
+    // --- Postordering --------------------------------------------------------
+    for (csint i = 0; i < N; i++) {
+        Cp[i] = flip(Cp[i]);  // fix assembly tree
+    }
+
+    std::fill(head.begin(), head.end(), -1);
+
+    for (csint j = N; j >= 0; j--) {  // place unordered nodes in lists
+        if (nv[j] > 0) {
+            continue;                 // skip if j is an element
+        }
+        next[j] = head[Cp[j]];        // place j in list of its parent
+        head[Cp[j]] = j;
+    }
+
+    for (csint e = N; e >= 0; e--) {  // place elements in lists
+        if (nv[e] <= 0) {
+            continue;                 // skip unless e is an element
+        }
+        if (Cp[e] != -1) {
+            next[e] = head[Cp[e]];    // place e in list of its parent
+            head[Cp[e]] = e;
+        }
+    }
+
+    std::vector<csint> P;  // the output permutation
+    P.reserve(N + 1);
+
+    for (csint i = 0; i <= N; i++) {  // postorder the assembly tree
+        if (Cp[i] == -1) {
+            tdfs(i, head, next, P);
+        }
+    }
+
+    // The dead element N is always the last node in the postorder
+    P.pop_back();
+
+    return P;
+}
+
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/
@@ -0,0 +1,379 @@
+/*==============================================================================
+ *     File: assembly.cpp
+ *  Created: 2025-03-24 09:05
+ *   Author: Bernie Roesler
+ *
+ *  Description: Implements assembly into a frozen sparsity pattern.
+ *
+ *============================================================================*/
+
+#include <algorithm>  // std::fill, std::max
+#include <atomic>
+#include <barrier>
+#include <exception>  // std::exception_ptr
+#include <stdexcept>
+
+#include "assembly.h"
+#include "coo.h"
+#include "csc.h"
+#include "parallel.h"
+#include "stats.h"
+#include "utils.h"  // cumsum
+
+namespace cs {
+
+/** Sort the contributions by column and row, and map each one to an entry.
+ *
+ * @param M, N  the size of the matrix
+ * @param rows, cols  the row and column of each contribution
+ *
+ * @return P  the pattern, with `A`, `slots`, `slot_ptr` and `slot_contribs`
+ *         filled in, and the values of `A` set to zero.
+ */
+static AssemblyPattern build_slots(
+    csint M,
+    csint N,
+    const std::vector<csint>& rows,
+    const std::vector<csint>& cols
+)
+{
+    csint nc = static_cast<csint>(rows.size());
+
+    // Stable counting sorts by row, then by column
+    std::vector<csint> count(M, 0);
+    for (const auto& i : rows) {
+        count[i]++;
+    }
+
+    std::vector<csint> next = cumsum(count);
+    std::vector<csint> by_row(nc);
+    for (csint k = 0; k < nc; k++) {
+        by_row[next[rows[k]]++] = k;
+    }
+
+    count.assign(N, 0);
+    for (const auto& j : cols) {
+        count[j]++;
+    }
+
+    next = cumsum(count);
+    std::vector<csint> order(nc);
+    for (const auto& k : by_row) {
+        order[next[cols[k]]++] = k;
+    }
+
+    // Each run of equal (i, j) is one entry of A
+    AssemblyPattern P;
+    P.slots.resize(nc);
+    P.slot_ptr.reserve(nc + 1);
+
+    std::vector<csint> Ai, Ap(N + 1, 0);
+    Ai.reserve(nc);
+
+    csint prev_i = -1,
+          prev_j = -1;
+
+    for (csint q = 0; q < nc; q++) {
+        csint k = order[q];
+        csint i = rows[k],
+              j = cols[k];
+
+        if (i != prev_i || j != prev_j) {
+            P.slot_ptr.push_back(q);
+            Ai.push_back(i);
+            Ap[j+1]++;
+            prev_i = i;
+            prev_j = j;
+        }
+
+        P.slots[k] = static_cast<csint>(Ai.size()) - 1;
+    }
+
+    P.slot_ptr.push_back(nc);
+    P.slot_contribs = std::move(order);
+
+    for (csint j = 0; j < N; j++) {
+        Ap[j+1] += Ap[j];
+    }
+
+    csint nz = static_cast<csint>(Ai.size());
+    Ai.shrink_to_fit();
+
+    P.A = CSCMatrix(std::vector<double>(nz, 0.0), std::move(Ai), std::move(Ap), {M, N});
+
+    return P;
+}
+
+
+/** Color the elements, such that no two elements of a color share a node.
+ *
+ * Each element is greedily given the smallest color that is not used by any
+ * element that shares one of its nodes.
+ */
+static void color_elements(csint N, AssemblyPattern& P)
+{
+    csint ne = P.num_elements();
+
+    // The elements of each node
+    std::vector<csint> count(N, 0);
+    for (const auto& n : P.elem_nodes) {
+        count[n]++;
+    }
+
+    std::vector<csint> node_ptr = cumsum(count);
+    std::vector<csint> next(node_ptr.begin(), node_ptr.end() - 1);
+    std::vector<csint> node_elems(P.elem_nodes.size());
+
+    for (csint e = 0; e < ne; e++) {
+        for (csint q = P.elem_ptr[e]; q < P.elem_ptr[e+1]; q++) {
+            node_elems[next[P.elem_nodes[q]]++] = e;
+        }
+    }
+
+    std::vector<csint> color(ne, -1);
+    std::vector<csint> forbid;  // forbid[c] == e if color c is used by a neighbor
+
+    for (csint e = 0; e < ne; e++) {
+        for (csint q = P.elem_ptr[e]; q < P.elem_ptr[e+1]; q++) {
+            csint n = P.elem_nodes[q];
+            for (csint r = node_ptr[n]; r < node_ptr[n+1]; r++) {
+                csint c = color[node_elems[r]];
+                if (c >= 0) {
+                    forbid[c] = e;
+                }
+            }
+        }
+
+        csint c = 0;
+        while (c < static_cast<csint>(forbid.size()) && forbid[c] == e) {
+            c++;
+        }
+
+        if (c == static_cast<csint>(forbid.size())) {
+            forbid.push_back(-1);
+        }
+
+        color[e] = c;
+    }
+
+    // Group the elements by color
+    count.assign(forbid.size(), 0);
+    for (const auto& c : color) {
+        count[c]++;
+    }
+
+    P.color_ptr = cumsum(count);
+    next.assign(P.color_ptr.begin(), P.color_ptr.end() - 1);
+    P.color_elems.resize(ne);
+
+    for (csint e = 0; e < ne; e++) {
+        P.color_elems[next[color[e]]++] = e;
+    }
+}
+
+
+AssemblyPattern assembly_pattern(const COOMatrix& T)
+{
+    PhaseTimer timer("assembly_pattern");
+
+    auto [M, N] = T.shape();
+
+    AssemblyPattern P = build_slots(M, N, T.row(), T.column());
+    P.A.has_sorted_indices_ = true;
+    P.A.has_canonical_format_ = true;
+
+    if (!T.data().empty()) {
+        P.add(T.data(), 1);
+    }
+
+    return P;
+}
+
+
+AssemblyPattern assembly_pattern(
+    csint N,
+    const std::vector<csint>& elem_ptr,
+    const std::vector<csint>& elem_nodes
+)
+{
+    PhaseTimer timer("assembly_pattern");
+
+    if (elem_ptr.empty()
+        || elem_ptr.front() != 0
+        || elem_ptr.back() != static_cast<csint>(elem_nodes.size())
+    ) {
+        throw std::runtime_error("Element offsets do not match the nodes!");
+    }
+
+    csint ne = static_cast<csint>(elem_ptr.size()) - 1;
+
+    // The contributions of each element, in column-major order
+    std::vector<csint> map_ptr(ne + 1, 0);
+    for (csint e = 0; e < ne; e++) {
+        csint m = elem_ptr[e+1] - elem_ptr[e];
+        if (m < 0) {
+            throw std::runtime_error("Element offsets must be non-decreasing!");
+        }
+        map_ptr[e+1] = map_ptr[e] + m * m;
+    }
+
+    for (const auto& n : elem_nodes) {
+        if (n < 0 || n >= N) {
+            throw std::runtime_error("Element node out of range!");
+        }
+    }
+
+    std::vector<csint> rows(map_ptr[ne]), cols(map_ptr[ne]);
+
+    for (csint e = 0; e < ne; e++) {
+        const csint *nodes = elem_nodes.data() + elem_ptr[e];
+        csint m = elem_ptr[e+1] - elem_ptr[e];
+        csint k = map_ptr[e];
+        for (csint b = 0; b < m; b++) {
+            for (csint a = 0; a < m; a++, k++) {
+                rows[k] = nodes[a];
+                cols[k] = nodes[b];
+            }
+        }
+    }
+
+    AssemblyPattern P = build_slots(N, N, rows, cols);
+    P.A.has_sorted_indices_ = true;
+    P.A.has_canonical_format_ = true;
+
+    P.elem_ptr = elem_ptr;
+    P.elem_nodes = elem_nodes;
+    P.map_ptr = std::move(map_ptr);
+
+    color_elements(N, P);
+
+    record_memory(
+        memory_bytes(P.A) + memory_bytes(P.slots) + memory_bytes(P.slot_ptr)
+        + memory_bytes(P.slot_contribs) + memory_bytes(rows) + memory_bytes(cols)
+    );
+
+    return P;
+}
+
+
+void AssemblyPattern::zero()
+{
+    A.invalidate_csr_();
+    std::fill(A.v_.begin(), A.v_.end(), 0.0);
+}
+
+
+void AssemblyPattern::add(const std::vector<double>& values, int threads)
+{
+    PhaseTimer timer("assemble");
+    A.invalidate_csr_();
+
+    csint nc = static_cast<csint>(slots.size());
+
+    if (static_cast<csint>(values.size()) != nc) {
+        throw std::runtime_error("Values must match the number of contributions!");
+    }
+
+    // Each entry gathers its contributions, so the threads never conflict
+    int nthreads = resolve_num_threads(threads, nc);
+    std::vector<csint> bounds = partition_nnz(slot_ptr, nthreads);
+
+    parallel_for(nthreads, [&](int t) {
+        for (csint p = bounds[t]; p < bounds[t+1]; p++) {
+            double s = 0.0;
+            for (csint q = slot_ptr[p]; q < slot_ptr[p+1]; q++) {
+                s += values[slot_contribs[q]];
+            }
+            A.v_[p] += s;
+        }
+    });
+}
+
+
+void AssemblyPattern::add_element(csint e, std::span<const double> Ke)
+{
+    if (e < 0 || e >= num_elements()) {
+        throw std::runtime_error("Element index out of range!");
+    }
+
+    csint m = elem_ptr[e+1] - elem_ptr[e];
+
+    if (static_cast<csint>(Ke.size()) != m * m) {
+        throw std::runtime_error("Element matrix must be m x m!");
+    }
+
+    A.invalidate_csr_();
+
+    const csint *s = slots.data() + map_ptr[e];
+    for (csint k = 0; k < m * m; k++) {
+        A.v_[s[k]] += Ke[k];
+    }
+}
+
+
+void AssemblyPattern::assemble(const ElementKernel& kernel, int threads)
+{
+    PhaseTimer timer("assemble");
+    A.invalidate_csr_();
+
+    csint ne = num_elements();
+
+    if (ne == 0) {
+        throw std::runtime_error("Pattern has no elements!");
+    }
+
+    csint max_m = 0;
+    for (csint e = 0; e < ne; e++) {
+        max_m = std::max(max_m, elem_ptr[e+1] - elem_ptr[e]);
+    }
+
+    int nthreads = resolve_num_threads(threads, static_cast<csint>(slots.size()));
+    csint nc = num_colors();
+
+    // The threads wait for each other after each color. A thread whose kernel
+    // throws skips the remaining work, but keeps arriving at the barrier.
+    std::barrier sync(nthreads);
+    std::atomic<bool> failed = false;
+    std::vector<std::exception_ptr> errors(nthreads);
+
+    parallel_for(nthreads, [&](int t) {
+        std::vector<double> Ke(max_m * max_m);  // one workspace per thread
+
+        for (csint c = 0; c < nc; c++) {
+            if (!failed) {
+                try {
+                    for (csint q = color_ptr[c] + t; q < color_ptr[c+1]; q += nthreads) {
+                        csint e = color_elems[q];
+                        csint m = elem_ptr[e+1] - elem_ptr[e];
+                        std::span<double> Ke_e(Ke.data(), m * m);
+
+                        std::fill(Ke_e.begin(), Ke_e.end(), 0.0);
+                        kernel(e, Ke_e);
+
+                        const csint *s = slots.data() + map_ptr[e];
+                        for (csint k = 0; k < m * m; k++) {
+                            A.v_[s[k]] += Ke_e[k];
+                        }
+                    }
+                } catch (...) {
+                    errors[t] = std::current_exception();
+                    failed = true;
+                }
+            }
+
+            sync.arrive_and_wait();
+        }
+    });
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/
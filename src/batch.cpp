@@ -0,0 +1,595 @@
+/*==============================================================================
+ *     File: batch.cpp
+ *  Created: 2025-03-22 09:40
+ *   Author: Bernie Roesler
+ *
+ *  Description: Implements the batched factorizations and solves.
+ *
+ *============================================================================*/
+
+#include <algorithm>  // std::min, std::fill
+#include <cassert>
+#include <cmath>      // std::sqrt
+#include <exception>  // std::exception_ptr
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "batch.h"
+#include "cholesky.h"
+#include "csc.h"
+#include "parallel.h"
+#include "qr.h"
+#include "stats.h"
+#include "utils.h"
+
+namespace cs {
+
+// Index of entry `p` of matrix `b` in a batch of arrays of size `size`
+static inline csint batch_index(
+    BatchLayout layout,
+    csint size,
+    csint batch,
+    csint b,
+    csint p
+)
+{
+    return (layout == BatchLayout::Strided) ? b * size + p : p * batch + b;
+}
+
+
+// Get the number of matrices in a batch of values
+static csint batch_size(const CSCMatrix& A, const std::vector<double>& values)
+{
+    csint nnz = A.nnz();
+    csint size = static_cast<csint>(values.size());
+
+    if ((nnz == 0 && size != 0) || (nnz > 0 && size % nnz != 0)) {
+        throw std::runtime_error(
+            std::format("Batch values of size {} are not a multiple of nnz = {}.",
+                        size, nnz)
+        );
+    }
+
+    return (nnz == 0) ? 0 : size / nnz;
+}
+
+
+/** Run `f(begin, end)` on contiguous blocks of `[0, n)`, one per thread.
+ *
+ * The first exception thrown by any thread is rethrown on the calling thread.
+ */
+template <typename F>
+static void parallel_blocks(csint n, int nthreads, F f)
+{
+    nthreads = static_cast<int>(std::max<csint>(1, std::min<csint>(nthreads, n)));
+
+    std::vector<std::exception_ptr> errors(nthreads);
+
+    parallel_for(nthreads, [&](int t) {
+        try {
+            f(n * t / nthreads, n * (t + 1) / nthreads);
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    });
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+
+/*------------------------------------------------------------------------------
+ *         Cholesky
+ *----------------------------------------------------------------------------*/
+CSCMatrix CholBatch::factor(csint b) const
+{
+    assert(b >= 0 && b < batch);
+
+    csint lnz = L.nnz();
+    std::vector<double> v(lnz);
+    for (csint p = 0; p < lnz; p++) {
+        v[p] = values[batch_index(layout, lnz, batch, b, p)];
+    }
+
+    return CSCMatrix(std::move(v), L.indices(), L.indptr(), L.shape());
+}
+
+
+CholBatch chol_batch(
+    const CSCMatrix& A,
+    const SymbolicChol& S,
+    const std::vector<double>& values,
+    BatchLayout layout,
+    int threads
+)
+{
+    PhaseTimer timer("chol_batch");
+
+    constexpr csint G = BATCH_LANES;
+
+    auto [M, N] = A.shape();
+    csint nnz = A.nnz();
+    csint batch = batch_size(A, values);
+
+    // --- Per-batch analysis --------------------------------------------------
+    // Map each entry of C = triu(A(p, p)) to its entry in the values of A
+    const SymPermView Cv(A, S);
+    const CSCMatrix& C = Cv.C;
+    const std::vector<csint>& Cmap = Cv.map;
+
+    const auto& Cp = C.indptr();
+    const auto& Ci = C.indices();
+
+    CholBatch F {
+        .L = symbolic_cholesky(A, S),
+        .p_inv = S.p_inv,
+        .values = std::vector<double>(S.lnz * batch),
+        .batch = batch,
+        .layout = layout
+    };
+
+    const auto& Lp = F.L.indptr();
+    const auto& Li = F.L.indices();
+    csint lnz = S.lnz;
+
+    // The pattern of each row of L, with the position of each L(k, i) in
+    // column i. The columns of L are visited in order, so each row is in
+    // topological order.
+    std::vector<csint> rp(N, -1), rcol(lnz - N), rpos(lnz - N);
+    for (csint p = 0; p < lnz; p++) {
+        rp[Li[p]]++;  // count the row, excluding the diagonal
+    }
+    rp = cumsum(rp);
+    std::vector<csint> next(rp.begin(), rp.end() - 1);
+    for (csint i = 0; i < N; i++) {
+        for (csint p = Lp[i] + 1; p < Lp[i+1]; p++) {
+            csint q = next[Li[p]]++;
+            rcol[q] = i;
+            rpos[q] = p;
+        }
+    }
+
+    // --- Numeric factorization of each group ---------------------------------
+    // The lanes of the workspaces are interleaved, so that entry p of lane l
+    // is at p * G + l.
+    auto factor_group = [&](
+        csint b0,
+        std::vector<double>& Cx,
+        std::vector<double>& Lx,
+        std::vector<double>& x
+    ) {
+        csint nb = std::min(G, batch - b0);
+
+        // Gather the permuted values, padding with copies of the first lane
+        for (csint p = 0; p < C.nnz(); p++) {
+            for (csint l = 0; l < G; l++) {
+                csint b = b0 + ((l < nb) ? l : 0);
+                Cx[p * G + l] = values[batch_index(layout, nnz, batch, b, Cmap[p])];
+            }
+        }
+
+        double d[G], lki[G];
+
+        // Compute L(k, :) for L*L' = C, as in rechol
+        for (csint k = 0; k < N; k++) {
+            // scatter C into x = full(triu(C(:,k)))
+            for (csint p = Cp[k]; p < Cp[k+1]; p++) {
+                csint i = Ci[p];
+                for (csint l = 0; l < G; l++) {
+                    x[i * G + l] = Cx[p * G + l];
+                }
+            }
+
+            for (csint l = 0; l < G; l++) {
+                d[l] = x[k * G + l];  // d = C(k, k)
+                x[k * G + l] = 0.0;   // clear x for k + 1st iteration
+            }
+
+            // Solve L(0:k-1, 0:k-1) * x = C(0:k-1, k)
+            for (csint q = rp[k]; q < rp[k+1]; q++) {
+                csint i = rcol[q];
+                csint pk = rpos[q];  // position of L(k, i)
+
+                for (csint l = 0; l < G; l++) {
+                    lki[l] = x[i * G + l] / Lx[Lp[i] * G + l];
+                    x[i * G + l] = 0.0;
+                    d[l] -= lki[l] * lki[l];
+                    Lx[pk * G + l] = lki[l];
+                }
+
+                for (csint p = Lp[i] + 1; p < pk; p++) {
+                    double *xr = &x[Li[p] * G];
+                    const double *lr = &Lx[p * G];
+                    for (csint l = 0; l < G; l++) {
+                        xr[l] -= lr[l] * lki[l];  // x -= L(i, :) * L(k, i)
+                    }
+                }
+            }
+
+            // Compute L(k, k)
+            for (csint l = 0; l < nb; l++) {
+                if (d[l] <= 0) {
+                    throw std::runtime_error(
+                        std::format("Matrix {} not positive definite!", b0 + l)
+                    );
+                }
+            }
+
+            for (csint l = 0; l < G; l++) {
+                Lx[Lp[k] * G + l] = std::sqrt(d[l]);
+            }
+        }
+
+        // Scatter the factors into the output
+        for (csint p = 0; p < lnz; p++) {
+            for (csint l = 0; l < nb; l++) {
+                F.values[batch_index(layout, lnz, batch, b0 + l, p)] = Lx[p * G + l];
+            }
+        }
+    };
+
+    csint ngroups = (batch + G - 1) / G;
+    int nthreads = resolve_num_threads(threads, lnz * batch);
+
+    parallel_blocks(ngroups, nthreads, [&](csint begin, csint end) {
+        // Workspaces are allocated once per thread
+        std::vector<double> Cx(C.nnz() * G), Lx(lnz * G), x(N * G);
+        for (csint g = begin; g < end; g++) {
+            factor_group(g * G, Cx, Lx, x);
+        }
+    });
+
+    record_memory(memory_bytes(F.values) + memory_bytes(F.L) + memory_bytes(C)
+                  + nthreads * (C.nnz() + lnz + N) * G * sizeof(double));
+
+    return F;
+}
+
+
+std::vector<double> chol_solve_batch(
+    const CholBatch& F,
+    const std::vector<double>& B,
+    int threads
+)
+{
+    PhaseTimer timer("chol_solve_batch");
+
+    constexpr csint G = BATCH_LANES;
+
+    csint N = F.L.shape()[1];
+    csint lnz = F.L.nnz();
+    csint batch = F.batch;
+    BatchLayout layout = F.layout;
+
+    if (static_cast<csint>(B.size()) != N * batch) {
+        throw std::runtime_error(
+            std::format("B must be of size N * batch = {}.", N * batch)
+        );
+    }
+
+    const auto& Lp = F.L.indptr();
+    const auto& Li = F.L.indices();
+
+    std::vector<double> X(B.size());
+
+    // Solve the lanes of one group, with x = P b, packed as in chol_batch
+    auto solve_group = [&](csint b0, std::vector<double>& Lx, std::vector<double>& W) {
+        csint nb = std::min(G, batch - b0);
+
+        for (csint p = 0; p < lnz; p++) {
+            for (csint l = 0; l < G; l++) {
+                csint b = b0 + ((l < nb) ? l : 0);
+                Lx[p * G + l] = F.values[batch_index(layout, lnz, batch, b, p)];
+            }
+        }
+
+        for (csint i = 0; i < N; i++) {
+            for (csint l = 0; l < G; l++) {
+                csint b = b0 + ((l < nb) ? l : 0);
+                W[F.p_inv[i] * G + l] = B[batch_index(layout, N, batch, b, i)];
+            }
+        }
+
+        // W = L \ W
+        for (csint j = 0; j < N; j++) {
+            double *wj = &W[j * G];
+            for (csint l = 0; l < G; l++) {
+                wj[l] /= Lx[Lp[j] * G + l];
+            }
+            for (csint p = Lp[j] + 1; p < Lp[j+1]; p++) {
+                double *wi = &W[Li[p] * G];
+                const double *lp = &Lx[p * G];
+                for (csint l = 0; l < G; l++) {
+                    wi[l] -= lp[l] * wj[l];
+                }
+            }
+        }
+
+        // W = L^T \ W
+        for (csint j = N - 1; j >= 0; j--) {
+            double *wj = &W[j * G];
+            for (csint p = Lp[j] + 1; p < Lp[j+1]; p++) {
+                const double *wi = &W[Li[p] * G];
+                const double *lp = &Lx[p * G];
+                for (csint l = 0; l < G; l++) {
+                    wj[l] -= lp[l] * wi[l];
+                }
+            }
+            for (csint l = 0; l < G; l++) {
+                wj[l] /= Lx[Lp[j] * G + l];
+            }
+        }
+
+        for (csint i = 0; i < N; i++) {
+            for (csint l = 0; l < nb; l++) {
+                X[batch_index(layout, N, batch, b0 + l, i)] = W[F.p_inv[i] * G + l];
+            }
+        }
+    };
+
+    csint ngroups = (batch + G - 1) / G;
+    int nthreads = resolve_num_threads(threads, lnz * batch);
+
+    parallel_blocks(ngroups, nthreads, [&](csint begin, csint end) {
+        std::vector<double> Lx(lnz * G), W(N * G);
+        for (csint g = begin; g < end; g++) {
+            solve_group(g * G, Lx, W);
+        }
+    });
+
+    return X;
+}
+
+
+/*------------------------------------------------------------------------------
+ *         QR
+ *----------------------------------------------------------------------------*/
+QRResult QRBatch::factor(csint b) const
+{
+    assert(b >= 0 && b < batch);
+
+    csint N = R.shape()[1];
+    csint vnz = V.nnz(),
+          rnz = R.nnz();
+
+    std::vector<double> Vx(vnz), Rx(rnz), bk(N);
+    for (csint p = 0; p < vnz; p++) {
+        Vx[p] = V_values[batch_index(layout, vnz, batch, b, p)];
+    }
+    for (csint p = 0; p < rnz; p++) {
+        Rx[p] = R_values[batch_index(layout, rnz, batch, b, p)];
+    }
+    for (csint k = 0; k < N; k++) {
+        bk[k] = beta[batch_index(layout, N, batch, b, k)];
+    }
+
+    return {
+        CSCMatrix(std::move(Vx), V.indices(), V.indptr(), V.shape()),
+        std::move(bk),
+        CSCMatrix(std::move(Rx), R.indices(), R.indptr(), R.shape()),
+        p_inv,
+        q
+    };
+}
+
+
+// Apply the Householder reflection in column j of (Vp, Vi, Vx) to x
+static inline void happly_raw(
+    const std::vector<csint>& Vp,
+    const std::vector<csint>& Vi,
+    const double *Vx,
+    csint j,
+    double beta,
+    double *x
+)
+{
+    double tau = 0.0;
+    for (csint p = Vp[j]; p < Vp[j+1]; p++) {
+        tau += Vx[p] * x[Vi[p]];
+    }
+    tau *= beta;
+    for (csint p = Vp[j]; p < Vp[j+1]; p++) {
+        x[Vi[p]] -= Vx[p] * tau;
+    }
+}
+
+
+QRBatch qr_batch(
+    const CSCMatrix& A,
+    const SymbolicQR& S,
+    const std::vector<double>& values,
+    BatchLayout layout,
+    int threads
+)
+{
+    PhaseTimer timer("qr_batch");
+
+    auto [M, N] = A.shape();
+
+    if (M < N) {
+        throw std::runtime_error("Batched QR requires M >= N.");
+    }
+
+    csint nnz = A.nnz();
+    csint batch = batch_size(A, values);
+
+    // The patterns of V and R are the same for every matrix
+    QRResult P = symbolic_qr(A, S);
+
+    csint m2 = S.m2;
+    csint vnz = P.V.nnz(),
+          rnz = P.R.nnz();
+
+    QRBatch F {
+        .V = std::move(P.V),
+        .R = std::move(P.R),
+        .p_inv = S.p_inv,
+        .q = S.q,
+        .M = M,
+        .V_values = std::vector<double>(vnz * batch),
+        .R_values = std::vector<double>(rnz * batch),
+        .beta = std::vector<double>(N * batch),
+        .batch = batch,
+        .layout = layout
+    };
+
+    const auto& Ap = A.indptr();
+    const auto& Ai = A.indices();
+    const auto& Vp = F.V.indptr();
+    const auto& Vi = F.V.indices();
+    const auto& Rp = F.R.indptr();
+    const auto& Ri = F.R.indices();
+
+    // Factor matrix b, as in reqr
+    auto factor_one = [&](
+        csint b,
+        std::vector<double>& Vx,
+        std::vector<double>& Rx,
+        std::vector<double>& beta,
+        std::vector<double>& x
+    ) {
+        for (csint k = 0; k < N; k++) {
+            csint col = S.q[k];  // permuted column of A
+
+            // R[:, k] pattern known. Scatter A[:, col] into x
+            for (csint p = Ap[col]; p < Ap[col+1]; p++) {
+                x[S.p_inv[Ai[p]]] = values[batch_index(layout, nnz, batch, b, p)];
+            }
+
+            // for each i in pattern of R[:, k] (R(i, k) is non-zero)
+            for (csint p = Rp[k]; p < Rp[k+1] - 1; p++) {
+                csint i = Ri[p];
+                happly_raw(Vp, Vi, Vx.data(), i, beta[i], x.data());
+                Rx[p] = x[i];
+                x[i] = 0;
+            }
+
+            // gather V(:, k) = x
+            for (csint p = Vp[k]; p < Vp[k+1]; p++) {
+                Vx[p] = x[Vi[p]];
+                x[Vi[p]] = 0;
+            }
+
+            // [v, beta, s] = house(V[:, k]), in place
+            auto V_k = std::span(Vx).subspan(Vp[k], Vp[k+1] - Vp[k]);
+            house_inplace(V_k, beta[k], Rx[Rp[k+1] - 1]);
+        }
+
+        for (csint p = 0; p < vnz; p++) {
+            F.V_values[batch_index(layout, vnz, batch, b, p)] = Vx[p];
+        }
+        for (csint p = 0; p < rnz; p++) {
+            F.R_values[batch_index(layout, rnz, batch, b, p)] = Rx[p];
+        }
+        for (csint k = 0; k < N; k++) {
+            F.beta[batch_index(layout, N, batch, b, k)] = beta[k];
+        }
+    };
+
+    int nthreads = resolve_num_threads(threads, (vnz + rnz) * batch);
+
+    parallel_blocks(batch, nthreads, [&](csint begin, csint end) {
+        // Workspaces are allocated once per thread
+        std::vector<double> Vx(vnz), Rx(rnz), beta(N), x(m2);
+        for (csint b = begin; b < end; b++) {
+            factor_one(b, Vx, Rx, beta, x);
+        }
+    });
+
+    record_memory(memory_bytes(F.V_values) + memory_bytes(F.R_values)
+                  + memory_bytes(F.beta) + memory_bytes(F.V) + memory_bytes(F.R)
+                  + nthreads * (vnz + rnz + N + m2) * sizeof(double));
+
+    return F;
+}
+
+
+std::vector<double> qr_solve_batch(
+    const QRBatch& F,
+    const std::vector<double>& B,
+    int threads
+)
+{
+    PhaseTimer timer("qr_solve_batch");
+
+    auto [m2, N] = F.R.shape();
+    csint M = F.M;
+    csint vnz = F.V.nnz(),
+          rnz = F.R.nnz();
+    csint batch = F.batch;
+    BatchLayout layout = F.layout;
+
+    if (static_cast<csint>(B.size()) != M * batch) {
+        throw std::runtime_error(
+            std::format("B must be of size M * batch = {}.", M * batch)
+        );
+    }
+
+    const auto& Vp = F.V.indptr();
+    const auto& Vi = F.V.indices();
+    const auto& Rp = F.R.indptr();
+    const auto& Ri = F.R.indices();
+
+    std::vector<double> X(N * batch);
+
+    // Solve for matrix b: x = R \ (Q^T P b)
+    auto solve_one = [&](
+        csint b,
+        std::vector<double>& Vx,
+        std::vector<double>& Rx,
+        std::vector<double>& x
+    ) {
+        for (csint p = 0; p < vnz; p++) {
+            Vx[p] = F.V_values[batch_index(layout, vnz, batch, b, p)];
+        }
+        for (csint p = 0; p < rnz; p++) {
+            Rx[p] = F.R_values[batch_index(layout, rnz, batch, b, p)];
+        }
+
+        std::fill(x.begin(), x.end(), 0.0);  // zero the fictitious rows
+        for (csint i = 0; i < M; i++) {
+            x[F.p_inv[i]] = B[batch_index(layout, M, batch, b, i)];
+        }
+
+        // x = Q^T x
+        for (csint k = 0; k < N; k++) {
+            double beta = F.beta[batch_index(layout, N, batch, b, k)];
+            happly_raw(Vp, Vi, Vx.data(), k, beta, x.data());
+        }
+
+        // x = R(0:N, 0:N) \ x, as in usolve
+        for (csint j = N - 1; j >= 0; j--) {
+            x[j] /= Rx[Rp[j+1] - 1];  // diagonal entry
+            for (csint p = Rp[j]; p < Rp[j+1] - 1; p++) {
+                x[Ri[p]] -= Rx[p] * x[j];
+            }
+        }
+
+        // X(q, b) = x
+        for (csint k = 0; k < N; k++) {
+            X[batch_index(layout, N, batch, b, F.q[k])] = x[k];
+        }
+    };
+
+    int nthreads = resolve_num_threads(threads, (vnz + rnz) * batch);
+
+    parallel_blocks(batch, nthreads, [&](csint begin, csint end) {
+        std::vector<double> Vx(vnz), Rx(rnz), x(m2);
+        for (csint b = begin; b < end; b++) {
+            solve_one(b, Vx, Rx, x);
+        }
+    });
+
+    return X;
+}
+
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/
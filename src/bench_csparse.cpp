@@ -0,0 +1,501 @@
+/*==============================================================================
+ *     File: bench_csparse.cpp
+ *  Created: 2025-03-20 09:15
+ *   Author: Bernie Roesler
+ *
+ *  Description: Micro-benchmarks of the CSparse++ kernels, with the results
+ *      written as JSON.
+ *
+ *  Usage:
+ *      csparse_bench [options] [matrix.mtx ...]
+ *
+ *  Each Matrix Market file (e.g. from the SuiteSparse Matrix Collection) is
+ *  benchmarked in turn. If no files are given, a matrix generated by
+ *  `COOMatrix::random` is used.
+ *
+ *  Options:
+ *      --random M N density  size and density of the generated matrix
+ *                            (default: 2000 2000 0.002)
+ *      --seed S              seed of the generated matrix (default: 565656)
+ *      --rhs K               number of right-hand sides of the block kernels
+ *                            (default: 16)
+ *      --threads T           threads for the parallel kernels (default: 1)
+ *      --repeat R            number of timed runs of each kernel (default: 10)
+ *      --filter STR          only run the kernels with STR in their name
+ *      --output FILE         write the JSON to FILE (default: stdout)
+ *
+ *============================================================================*/
+
+#include <algorithm>  // std::sort, std::min
+#include <chrono>
+#include <cmath>      // std::abs
+#include <exception>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>    // std::iota, std::accumulate
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "csparse.h"
+
+using namespace cs;
+
+
+/*------------------------------------------------------------------------------
+ *         Benchmark Inputs
+ *----------------------------------------------------------------------------*/
+struct Options
+{
+    csint M = 2000,
+          N = 2000;
+    double density = 0.002;
+    unsigned int seed = 565656;
+    csint K = 16;
+    int threads = 1;
+    int repeat = 10;
+    std::string filter;
+    std::string output;
+    std::vector<std::string> files;
+};
+
+
+/** The matrices and vectors used by the kernels, built once per input. */
+struct Inputs
+{
+    std::string name;           // file name, or description of the generator
+    COOMatrix T;                // the input in triplet form
+    CSCMatrix A;                // the input matrix
+    CSCMatrix S;                // symmetric positive definite matrix
+    std::string spd_source;     // "input" if S == A, or "derived" from A
+
+    // Dense operands
+    std::vector<double> x, y;   // x is size N, y is size M
+    std::vector<double> X, Y;   // N x K and M x K, column-major
+    std::vector<double> Xt, Yt; // M x K and N x K, column-major
+    std::vector<double> b, B;   // size n and n x K, for the square kernels
+    CSCMatrix32 A32;            // A with 32-bit indices
+
+    // Factorizations of S
+    SymbolicChol Sc;
+    CSCMatrix L, U;             // chol(S) and its transpose
+    SymbolicQR Sq;
+    SymbolicLU Slu;
+    LevelSchedule Ls;
+    CSCMatrix Lsym;             // the pattern of L, refactorized by rechol
+    QRResult Rsym;              // the pattern of V and R, refactorized by reqr
+};
+
+
+// Build a symmetric positive definite matrix with the pattern of A + A^T
+static CSCMatrix derive_spd(const CSCMatrix& A)
+{
+    auto [M, N] = A.shape();
+    csint n = std::min(M, N);
+
+    CSCMatrix C = A.slice(0, n, 0, n);
+    C = C + C.T();
+
+    // Make the matrix strictly diagonally dominant
+    std::vector<double> absv(C.data().begin(), C.data().begin() + C.nnz());
+    for (auto& v : absv) {
+        v = std::abs(v);
+    }
+    const CSCMatrix absC(std::move(absv), C.indices(), C.indptr(), C.shape());
+    std::vector<double> d = absC.sum_rows();
+    for (auto& v : d) {
+        v += 1.0;
+    }
+
+    std::vector<csint> idx(n);
+    std::iota(idx.begin(), idx.end(), 0);
+
+    return (C + COOMatrix(d, idx, idx, Shape {n, n}).tocsc()).to_canonical();
+}
+
+
+static Inputs make_inputs(std::string name, COOMatrix T, const Options& opts)
+{
+    Inputs in;
+    in.name = std::move(name);
+    in.T = std::move(T);
+    in.A = in.T.tocsc();
+    in.A32 = CSCMatrix32(in.A);
+
+    auto [M, N] = in.A.shape();
+
+    if (M == N && in.A.is_symmetric()) {
+        in.S = in.A;
+        in.spd_source = "input";
+    } else {
+        in.S = derive_spd(in.A);
+        in.spd_source = "derived";
+    }
+
+    csint n = in.S.shape()[0];
+    csint K = opts.K;
+
+    auto iota = [](csint size, double start) {
+        std::vector<double> v(size);
+        std::iota(v.begin(), v.end(), start);
+        return v;
+    };
+
+    in.x = iota(N, 1);
+    in.y = iota(M, -1);
+    in.X = iota(N * K, 1);
+    in.Y = iota(M * K, -1);
+    in.Xt = iota(M * K, 1);
+    in.Yt = iota(N * K, -1);
+    in.b = iota(n, 1);
+    in.B = iota(n * K, 1);
+
+    // The factorizations may fail if an input matrix is not positive
+    // definite. The kernels that need them will then report the error.
+    in.Sc = schol(in.S, AMDOrder::APlusAT);
+    in.Lsym = symbolic_cholesky(in.S, in.Sc);
+    try {
+        in.L = chol(in.S, in.Sc);
+        in.U = in.L.T();
+        in.Ls = level_schedule(in.L);
+    } catch (const std::exception&) {
+        in.L = CSCMatrix();
+    }
+
+    in.Sq = sqr(in.S, AMDOrder::ATANoDenseRows);
+    in.Rsym = symbolic_qr(in.S, in.Sq);
+    in.Slu = slu(in.S, AMDOrder::ATANoDenseRows);
+
+    return in;
+}
+
+
+// Require the Cholesky factor for the triangular solves
+static void need_chol(const Inputs& in)
+{
+    if (in.L.nnz() == 0) {
+        throw std::runtime_error("chol(S) failed; S is not positive definite.");
+    }
+}
+
+
+/*------------------------------------------------------------------------------
+ *         Benchmark Cases
+ *----------------------------------------------------------------------------*/
+struct Case
+{
+    std::string name;
+    std::string matrix;          // which matrix the kernel uses: "A" or "S"
+    std::function<void()> run;
+};
+
+
+struct Result
+{
+    std::string name;
+    std::string input;
+    std::string matrix;
+    Shape shape;
+    csint nnz;
+    int threads;
+    int repeat;
+    double min_s = 0,
+           median_s = 0,
+           mean_s = 0;
+    std::string error;
+};
+
+
+static std::vector<Case> make_cases(Inputs& in, const Options& opts)
+{
+    const int T = opts.threads;
+
+    // Keep the results of the kernels alive, so they are not optimized away
+    static std::vector<double> sink_v;
+    static CSCMatrix sink_m;
+
+    std::vector<Case> cases = {
+        // ---------- Matrix-vector multiply
+        {"gaxpy", "A", [&] { sink_v = in.A.gaxpy(in.x, in.y, T); }},
+        {"gatxpy", "A", [&] { sink_v = in.A.gatxpy(in.y, in.x, T); }},
+        {"sym_gaxpy", "S", [&] { sink_v = in.S.sym_gaxpy(in.b, in.b, T); }},
+        {"gaxpy_col", "A", [&] { sink_v = in.A.gaxpy_col(in.X, in.Y); }},
+        {"gaxpy_row", "A", [&] { sink_v = in.A.gaxpy_row(in.X, in.Y); }},
+        {"gaxpy_block", "A", [&] { sink_v = in.A.gaxpy_block(in.X, in.Y); }},
+        {"gaxpy_simd", "A", [&] { sink_v = in.A.gaxpy_simd(in.X, in.Y); }},
+        {"gatxpy_col", "A", [&] { sink_v = in.A.gatxpy_col(in.Xt, in.Yt); }},
+        {"gatxpy_row", "A", [&] { sink_v = in.A.gatxpy_row(in.Xt, in.Yt); }},
+        {"gatxpy_block", "A", [&] { sink_v = in.A.gatxpy_block(in.Xt, in.Yt); }},
+        {"gatxpy_simd", "A", [&] { sink_v = in.A.gatxpy_simd(in.Xt, in.Yt); }},
+        {"compact32_gaxpy", "A", [&] { sink_v = in.A32.gaxpy(in.x, in.y, T); }},
+
+        // ---------- Matrix-matrix multiply
+        {"dot", "A", [&] { sink_m = in.A.dot(in.A.T()); }},
+        {"dot_2x_dense", "A", [&] {
+            sink_m = in.A.dot_2x(in.A.T(), T, SpGEMMAccumulator::Dense);
+        }},
+        {"dot_2x_hash", "A", [&] {
+            sink_m = in.A.dot_2x(in.A.T(), T, SpGEMMAccumulator::Hash);
+        }},
+
+        // ---------- Conversions and permutations
+        {"tocsc", "A", [&] { sink_m = in.T.tocsc(T); }},
+        {"compress", "A", [&] { sink_m = in.T.compress(T); }},
+        {"transpose", "A", [&] { sink_m = in.A.transpose(); }},
+        {"symperm", "S", [&] { sink_m = in.S.symperm(in.Sc.p_inv); }},
+
+        // ---------- Cholesky
+        {"schol", "S", [&] { in.Sc = schol(in.S, AMDOrder::APlusAT); }},
+        {"chol", "S", [&] { sink_m = chol(in.S, in.Sc, 0.0, T); }},
+        {"leftchol", "S", [&] {
+            CSCMatrix L = symbolic_cholesky(in.S, in.Sc);
+            sink_m = leftchol(in.S, in.Sc, L);
+        }},
+        {"rechol", "S", [&] { sink_m = rechol(in.S, in.Sc, in.Lsym); }},
+
+        // ---------- QR
+        {"qr", "S", [&] { sink_m = qr(in.S, in.Sq).R; }},
+        {"reqr", "S", [&] { reqr(in.S, in.Sq, in.Rsym); }},
+
+        // ---------- LU
+        {"lu", "S", [&] { sink_m = lu(in.S, in.Slu).U; }},
+
+        // ---------- Triangular solves with the Cholesky factor
+        {"lsolve", "S", [&] { need_chol(in); sink_v = lsolve(in.L, in.b); }},
+        {"ltsolve", "S", [&] { need_chol(in); sink_v = ltsolve(in.L, in.b); }},
+        {"usolve", "S", [&] { need_chol(in); sink_v = usolve(in.U, in.b); }},
+        {"utsolve", "S", [&] { need_chol(in); sink_v = utsolve(in.U, in.b); }},
+        {"lsolve_opt", "S", [&] { need_chol(in); sink_v = lsolve_opt(in.L, in.b); }},
+        {"usolve_opt", "S", [&] { need_chol(in); sink_v = usolve_opt(in.U, in.b); }},
+        {"level_schedule", "S", [&] { need_chol(in); in.Ls = level_schedule(in.L); }},
+        {"level_solve", "S", [&] { need_chol(in); sink_v = level_solve(in.Ls, in.b, T); }},
+        {"lsolve_block", "S", [&] { need_chol(in); sink_v = lsolve_block(in.L, in.B); }},
+        {"chol_solve_block", "S", [&] {
+            need_chol(in);
+            sink_v = chol_solve_block(in.L, in.Sc, in.B);
+        }},
+        {"lusolve", "S", [&] {
+            sink_v = lusolve(in.S, in.b, AMDOrder::ATANoDenseRows);
+        }},
+
+        // ---------- Iterative solvers
+        {"pcg", "S", [&] { sink_v = pcg(in.S, in.b).x; }},
+        {"pcg_jacobi", "S", [&] {
+            sink_v = pcg(in.S, in.b, jacobi_preconditioner(in.S)).x;
+        }},
+        {"pcg_ichol", "S", [&] {
+            CSCMatrix Li = ichol(in.S, ICholMethod::NoFill);
+            sink_v = pcg(in.S, in.b, ichol_preconditioner(Li)).x;
+        }},
+    };
+
+    if (!opts.filter.empty()) {
+        std::erase_if(cases, [&](const Case& c) {
+            return c.name.find(opts.filter) == std::string::npos;
+        });
+    }
+
+    return cases;
+}
+
+
+static Result run_case(const Case& c, const Inputs& in, const Options& opts)
+{
+    const CSCMatrix& A = (c.matrix == "S") ? in.S : in.A;
+
+    Result res {
+        .name = c.name,
+        .input = in.name,
+        .matrix = c.matrix,
+        .shape = A.shape(),
+        .nnz = A.nnz(),
+        .threads = opts.threads,
+        .repeat = opts.repeat
+    };
+
+    try {
+        c.run();  // warm up the caches
+
+        std::vector<double> times;
+        times.reserve(opts.repeat);
+
+        for (int r = 0; r < opts.repeat; r++) {
+            auto start = std::chrono::steady_clock::now();
+            c.run();
+            auto end = std::chrono::steady_clock::now();
+            times.push_back(std::chrono::duration<double>(end - start).count());
+        }
+
+        std::sort(times.begin(), times.end());
+        res.min_s = times.front();
+        res.median_s = times[times.size() / 2];
+        res.mean_s = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+    } catch (const std::exception& e) {
+        res.error = e.what();
+    }
+
+    return res;
+}
+
+
+/*------------------------------------------------------------------------------
+ *         Output
+ *----------------------------------------------------------------------------*/
+static std::string json_string(const std::string& s)
+{
+    std::string out = "\"";
+    for (char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:   out += c;
+        }
+    }
+    return out + "\"";
+}
+
+
+static void write_json(
+    std::ostream& os,
+    const std::vector<Result>& results,
+    const Options& opts
+)
+{
+    os << "{\n";
+    os << "  \"context\": {\n";
+    os << std::format("    \"simd\": {},\n", json_string(simd::isa));
+    os << std::format("    \"simd_width\": {},\n", simd::width);
+    os << std::format("    \"hardware_threads\": {},\n", std::thread::hardware_concurrency());
+    os << std::format("    \"threads\": {},\n", opts.threads);
+    os << std::format("    \"repeat\": {},\n", opts.repeat);
+    os << std::format("    \"rhs\": {}\n", opts.K);
+    os << "  },\n";
+    os << "  \"benchmarks\": [\n";
+
+    for (size_t k = 0; k < results.size(); k++) {
+        const Result& r = results[k];
+        os << "    {";
+        os << std::format("\"name\": {}, ", json_string(r.name));
+        os << std::format("\"input\": {}, ", json_string(r.input));
+        os << std::format("\"matrix\": {}, ", json_string(r.matrix));
+        os << std::format("\"M\": {}, \"N\": {}, \"nnz\": {}, ", r.shape[0], r.shape[1], r.nnz);
+        os << std::format("\"threads\": {}, \"repeat\": {}, ", r.threads, r.repeat);
+        if (r.error.empty()) {
+            os << std::format("\"min_s\": {:.6e}, \"median_s\": {:.6e}, \"mean_s\": {:.6e}",
+                              r.min_s, r.median_s, r.mean_s);
+        } else {
+            os << std::format("\"error\": {}", json_string(r.error));
+        }
+        os << ((k + 1 < results.size()) ? "},\n" : "}\n");
+    }
+
+    os << "  ]\n";
+    os << "}\n";
+}
+
+
+/*------------------------------------------------------------------------------
+ *         Main
+ *----------------------------------------------------------------------------*/
+static Options parse_args(int argc, char *argv[])
+{
+    Options opts;
+
+    auto next = [&](int& k) -> std::string {
+        if (k + 1 >= argc) {
+            throw std::runtime_error(std::format("Missing value for {}", argv[k]));
+        }
+        return argv[++k];
+    };
+
+    for (int k = 1; k < argc; k++) {
+        std::string arg = argv[k];
+        if (arg == "--random") {
+            opts.M = std::stol(next(k));
+            opts.N = std::stol(next(k));
+            opts.density = std::stod(next(k));
+        } else if (arg == "--seed") {
+            opts.seed = std::stoul(next(k));
+        } else if (arg == "--rhs") {
+            opts.K = std::stol(next(k));
+        } else if (arg == "--threads") {
+            opts.threads = std::stoi(next(k));
+        } else if (arg == "--repeat") {
+            opts.repeat = std::max(1, std::stoi(next(k)));
+        } else if (arg == "--filter") {
+            opts.filter = next(k);
+        } else if (arg == "--output") {
+            opts.output = next(k);
+        } else if (arg.starts_with("--")) {
+            throw std::runtime_error(std::format("Unknown option {}", arg));
+        } else {
+            opts.files.push_back(arg);
+        }
+    }
+
+    return opts;
+}
+
+
+int main(int argc, char *argv[])
+{
+    Options opts;
+    try {
+        opts = parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<Result> results;
+
+    auto bench = [&](std::string name, COOMatrix T) {
+        Inputs in = make_inputs(std::move(name), std::move(T), opts);
+        for (const auto& c : make_cases(in, opts)) {
+            results.push_back(run_case(c, in, opts));
+            std::cerr << std::format("{:<20} {:<30} ", c.name, in.name)
+                      << (results.back().error.empty()
+                          ? std::format("{:.3e} s", results.back().median_s)
+                          : "error: " + results.back().error)
+                      << std::endl;
+        }
+    };
+
+    try {
+        if (opts.files.empty()) {
+            std::string name = std::format(
+                "random({}, {}, {}, {})", opts.M, opts.N, opts.density, opts.seed
+            );
+            bench(name, COOMatrix::random(opts.M, opts.N, opts.density, opts.seed));
+        }
+
+        for (const auto& file : opts.files) {
+            bench(file, read_matrix_market(file));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if (opts.output.empty()) {
+        write_json(std::cout, results, opts);
+    } else {
+        std::ofstream os(opts.output);
+        if (!os) {
+            std::cerr << "Could not open " << opts.output << std::endl;
+            return 1;
+        }
+        write_json(os, results, opts);
+    }
+
+    return 0;
+}
+
+/*==============================================================================
+ *============================================================================*/
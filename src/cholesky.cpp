@@ -7,15 +7,24 @@
  *
  *============================================================================*/
 
-#include <algorithm>  // std::copy
+#include <algorithm>  // std::copy, std::sort
 #include <cassert>
 #include <cmath>      // std::sqrt
+#include <condition_variable>
+#include <exception>  // std::exception_ptr
+#include <functional>
 #include <iterator>   // std::back_inserter
+#include <mutex>
 #include <numeric>    // std::iota
 
+#include "amd.h"
 #include "cholesky.h"
 #include "csc.h"
+#include "io.h"  // pattern_hash
+#include "parallel.h"
+#include "stats.h"
 #include "utils.h"
+#include "workspace.h"
 
 namespace cs {
 
@@ -25,11 +34,11 @@ namespace cs {
 std::vector<csint> etree(const CSCMatrix& A, bool ata)
 {
     std::vector<csint> parent(A.N_, -1);    // parent of i is parent[i]
-    std::vector<csint> ancestor(A.N_, -1);  // workspaces
-    std::vector<csint> prev;
-    if (ata) {
-        prev = std::vector<csint>(A.M_, -1);
-    }
+
+    // Workspaces
+    Workspace& ws = get_workspace();
+    auto ancestor = ws.fill<csint>(A.N_, -1);
+    auto prev = ws.fill<csint>(ata ? A.M_ : 0, -1);
 
     for (csint k = 0; k < A.N_; k++) {
         for (csint p = A.p_[k]; p < A.p_[k+1]; p++) {
@@ -76,10 +85,11 @@ std::vector<csint> ereach(
     const std::vector<csint>& parent
 )
 {
-    std::vector<bool> marked(A.N_, false);  // workspace
-    std::vector<csint> s, xi;  // internal dfs stack, output stack
-    s.reserve(A.N_);
-    xi.reserve(A.N_);
+    // Workspaces, which are returned unmarked
+    Workspace& ws = get_workspace();
+    auto marked = ws.zeros<bool>(A.N_);
+    auto s = ws.reserve<csint>(A.N_);   // internal dfs stack
+    auto xi = ws.reserve<csint>(A.N_);  // output stack
 
     marked[k] = true;  // mark node k as visited
 
@@ -88,19 +98,25 @@ std::vector<csint> ereach(
         if (i <= k) {     // only consider upper triangular part of A
             // Traverse up the etree
             while (!marked[i]) {
-                s.push_back(i);  // L(k, i) is nonzero
+                s->push_back(i);  // L(k, i) is nonzero
                 marked[i] = true;  // mark i as visited
                 i = parent[i];
             }
 
             // Push path onto output stack
-            std::copy(s.rbegin(), s.rend(), std::back_inserter(xi));
-            s.clear();
+            std::copy(s->rbegin(), s->rend(), std::back_inserter(*xi));
+            s->clear();
         }
     }
 
+    // Restore the workspace for the next call
+    marked[k] = false;
+    for (const auto& i : *xi) {
+        marked[i] = false;
+    }
+
     // Reverse the stack to get the topological order
-    return std::vector<csint>(xi.rbegin(), xi.rend());
+    return std::vector<csint>(xi->rbegin(), xi->rend());
 }
 
 
@@ -112,7 +128,7 @@ std::vector<csint> ereach_post(
 {
     assert(A.has_sorted_indices_);
 
-    std::vector<bool> marked(A.N_, false);  // workspace
+    auto marked = get_workspace().zeros<bool>(A.N_);  // workspace
     std::vector<csint> xi;  // internal dfs stack, output stack
     xi.reserve(A.N_);
 
@@ -131,6 +147,12 @@ std::vector<csint> ereach_post(
         }
     }
 
+    // Restore the workspace for the next call
+    marked[k] = false;
+    for (const auto& i : xi) {
+        marked[i] = false;
+    }
+
     return xi;
 }
 
@@ -141,7 +163,7 @@ std::vector<csint> ereach_queue(
     const std::vector<csint>& parent
 )
 {
-    std::vector<bool> marked(A.N_, false);  // workspace
+    auto marked = get_workspace().zeros<bool>(A.N_);  // workspace
     std::vector<csint> s;  // internal dfs stack, output stack
     s.reserve(A.N_);
 
@@ -159,6 +181,12 @@ std::vector<csint> ereach_queue(
         }
     }
 
+    // Restore the workspace for the next call
+    marked[k] = false;
+    for (const auto& i : s) {
+        marked[i] = false;
+    }
+
     return s;
 }
 
@@ -375,15 +403,16 @@ std::vector<csint> counts(
     std::vector<csint> delta(A.N_);  // allocate the result
 
     // Workspaces
-    std::vector<csint> ancestor(A.N_),
-                       maxfirst(A.N_, -1),  // max first[i] for nodes in subtree of i
-                       prevleaf(A.N_, -1),  // previous leaf of ith row subtree
-                       first(A.N_, -1),     // first descendant of each node in the tree
-                       head,                // head of the linked list
-                       next;                // next node of the linked list
+    Workspace& ws = get_workspace();
+    auto ancestor = ws.take<csint>(A.N_),
+         maxfirst = ws.fill<csint>(A.N_, -1),  // max first[i] for nodes in subtree of i
+         prevleaf = ws.fill<csint>(A.N_, -1),  // previous leaf of ith row subtree
+         first = ws.fill<csint>(A.N_, -1),     // first descendant of each node in the tree
+         head = ws.take<csint>(0),             // head of the linked list
+         next = ws.take<csint>(0);             // next node of the linked list
 
     // every node is its own ancestor
-    std::iota(ancestor.begin(), ancestor.end(), 0);
+    std::iota(ancestor->begin(), ancestor->end(), 0);
 
     // Compute first descendent of each node in the tree
     for (csint k = 0; k < A.N_; k++) {
@@ -399,7 +428,7 @@ std::vector<csint> counts(
     CSCMatrix AT = A.transpose(false);  // do not copy values in the transpose
 
     if (ata) {
-        init_ata(AT, postorder, head, next);
+        init_ata(AT, postorder, *head, *next);
     }
 
     for (csint k = 0; k < A.N_; k++) {
@@ -412,7 +441,7 @@ std::vector<csint> counts(
         for (csint J = ata ? head[k] : j; J != -1; J = ata ? next[J] : -1) {
             for (csint p = AT.p_[J]; p < AT.p_[J+1]; p++) {
                 csint i = AT.i_[p];  // AT(i, j) is nonzero
-                auto [q, jleaf] = least_common_ancestor(i, j, first, maxfirst, prevleaf, ancestor);
+                auto [q, jleaf] = least_common_ancestor(i, j, *first, *maxfirst, *prevleaf, *ancestor);
                 if (jleaf != LeafStatus::NotLeaf) {
                     delta[j]++;  // A(i, j) is in skeleton
                 }
@@ -465,8 +494,110 @@ std::vector<csint> chol_colcounts(const CSCMatrix& A, bool ata)
 }
 
 
+// The upper triangle of A is scanned in the order of symperm_map, so the
+// pattern matches if and only if each entry lands on the cached entry of C
+// that maps back to it.
+bool has_symperm_map(const CSCMatrix& A, const SymbolicChol& S)
+{
+    auto [M, N] = A.shape();
+    const std::vector<csint>& Ap = A.indptr();
+    const std::vector<csint>& Ai = A.indices();
+    const std::vector<csint>& Cp = S.C.indptr();
+    const std::vector<csint>& Ci = S.C.indices();
+
+    if (M != N
+        || S.anz != A.nnz()
+        || S.C.shape() != Shape {N, N}
+        || static_cast<csint>(Cp.size()) != N + 1
+        || static_cast<csint>(S.C_map.size()) != Cp[N]
+        || static_cast<csint>(S.p_inv.size()) != N) {
+        return false;
+    }
+
+    auto w = get_workspace().take<csint>(N);  // next entry of each column
+    std::copy(Cp.begin(), Cp.end() - 1, w->begin());
+    csint nz = 0;
+
+    for (csint j = 0; j < N; j++) {
+        csint j2 = S.p_inv[j];
+        for (csint p = Ap[j]; p < Ap[j+1]; p++) {
+            csint i = Ai[p];
+            if (i <= j) {
+                csint i2 = S.p_inv[i];
+                csint k = std::max(i2, j2);
+                csint q = w[k]++;
+                if (q >= Cp[k+1] || Ci[q] != std::min(i2, j2) || S.C_map[q] != p) {
+                    return false;
+                }
+                nz++;
+            }
+        }
+    }
+
+    return nz == Cp[N];
+}
+
+
+SymPermView::SymPermView(const CSCMatrix& A, const SymbolicChol& S)
+    : SymPermView(A, S, has_symperm_map(A, S))
+{}
+
+
+SymPermView::SymPermView(const CSCMatrix& A, const SymbolicChol& S, bool cached)
+    : local_C_(cached ? CSCMatrix() : A.symperm_map(S.p_inv, local_map_)),
+      C(cached ? S.C : local_C_),
+      map(cached ? S.C_map : local_map_)
+{}
+
+
+/** Transpose a pattern, and the map from its entries into the values of
+ * a matrix.
+ *
+ * @param C  a pattern
+ * @param map  the position in the values of the matrix of each entry of `C`
+ * @param[out] tmap  the position in the values of the matrix of each entry of
+ *        the transpose
+ *
+ * @return Ct  the transposed pattern, with sorted columns, without values
+ */
+static CSCMatrix transpose_map(
+    const CSCMatrix& C,
+    const std::vector<csint>& map,
+    std::vector<csint>& tmap
+)
+{
+    auto [M, N] = C.shape();
+    const auto& Cp = C.indptr();
+    const auto& Ci = C.indices();
+    csint nz = Cp[N];
+
+    std::vector<csint> w(M, 0);
+    for (csint p = 0; p < nz; p++) {
+        w[Ci[p]]++;
+    }
+
+    std::vector<csint> Tp = cumsum(w);
+    w.assign(Tp.begin(), Tp.end() - 1);
+
+    std::vector<csint> Ti(nz);
+    tmap.resize(nz);
+
+    for (csint j = 0; j < N; j++) {
+        for (csint p = Cp[j]; p < Cp[j+1]; p++) {
+            csint q = w[Ci[p]]++;
+            Ti[q] = j;
+            tmap[q] = map[p];
+        }
+    }
+
+    return CSCMatrix(std::vector<double>{}, std::move(Ti), std::move(Tp), {N, M});
+}
+
+
 SymbolicChol schol(const CSCMatrix& A, AMDOrder order, bool use_postorder)
 {
+    PhaseTimer timer("schol");
+
     SymbolicChol S;
     std::vector<csint> p(A.shape()[1]);  // the matrix permutation
 
@@ -474,31 +605,41 @@ SymbolicChol schol(const CSCMatrix& A, AMDOrder order, bool use_postorder)
         std::iota(p.begin(), p.end(), 0);  // identity permutation
         S.p_inv = p;                       // identity is its own inverse
     } else {
-        // TODO implement amd order (see Chapter 7)
-        // p = amd(order, A);  // P = amd(A + A.T()) or natural
-        // S.p_inv = inv_permute(p);
-        throw std::runtime_error("Ordering method not implemented!");
+        PhaseTimer amd_timer("schol.amd");
+        p = amd(A, order);  // P = amd(A + A.T()) or natural
+        S.p_inv = inv_permute(p);
     }
 
-    // Find pattern of Cholesky factor
-    CSCMatrix C = A.symperm(S.p_inv, false);  // C = spones(triu(A(p, p)))
-    S.parent = etree(C);
+    // Find pattern of Cholesky factor, and cache the map from the entries of
+    // C = spones(triu(A(p, p))) to the values of A
+    PhaseTimer etree_timer("schol.etree");
+    S.C = A.symperm_map(S.p_inv, S.C_map);
+    S.parent = etree(S.C);
     std::vector<csint> postorder = post(S.parent);
 
     // Exercise 4.9
     if (use_postorder) {
         p = pvec(postorder, p);         // combine the permutations
         S.p_inv = inv_permute(p);
-        C = A.symperm(S.p_inv, false);  // apply combined permutation
-        S.parent = etree(C);
+        S.C = A.symperm_map(S.p_inv, S.C_map);  // apply combined permutation
+        S.parent = etree(S.C);
         postorder = post(S.parent);     // should be identity for natural order
     }
 
-    std::vector<csint> c = counts(C, S.parent, postorder);
+    S.anz = A.nnz();
+    S.pattern_hash = pattern_hash(A);
+
+    etree_timer.stop();
+    PhaseTimer counts_timer("schol.counts");
+
+    std::vector<csint> c = counts(S.C, S.parent, postorder);
 
     S.cp = cumsum(c);                   // find column pointers for L
     S.lnz = S.cp.back();                // number of non-zeros in L
 
+    record_memory(memory_bytes(S.C) + memory_bytes(S.C_map) + memory_bytes(S.p_inv)
+                  + memory_bytes(S.parent) + memory_bytes(S.cp));
+
     return S;
 }
 
@@ -510,7 +651,8 @@ CSCMatrix symbolic_cholesky(const CSCMatrix& A, const SymbolicChol& S)
 
     std::vector<csint> c(S.cp);      // column pointers for L
 
-    const CSCMatrix C = A.symperm(S.p_inv);
+    const SymPermView Cv(A, S);
+    const CSCMatrix& C = Cv.C;       // pattern of triu(A(p, p))
 
     L.p_ = S.cp;  // column pointers for L
 
@@ -533,31 +675,197 @@ CSCMatrix symbolic_cholesky(const CSCMatrix& A, const SymbolicChol& S)
 }
 
 
-CSCMatrix chol(const CSCMatrix& A, const SymbolicChol& S, double drop_tol)
+// Count the flops of a Cholesky factorization with column pointers `cp`. Each
+// off-diagonal L(i, j) updates column j with every entry of L(i:, j).
+static double chol_flops(const std::vector<csint>& cp)
+{
+    double flops = 0;
+    for (csint k = 0; k < static_cast<csint>(cp.size()) - 1; k++) {
+        double count = cp[k+1] - cp[k];
+        flops += count * count;
+    }
+    return flops;
+}
+
+
+// Number of subtree tasks per thread in the tree-scheduled factorization. More
+// tasks balance the load better, but leave more nodes at the top of the tree.
+static constexpr csint SUBTREE_TASKS_PER_THREAD = 4;
+
+
+/** Visit each node of an elimination tree in parallel, after all of its
+ * descendants.
+ *
+ * The tree is split into subtree tasks, each with at most
+ * `1 / (SUBTREE_TASKS_PER_THREAD * nthreads)` of the total work, and the
+ * remaining nodes at the top of the tree, which are each a task of their own.
+ * The nodes of a subtree task are visited in postorder by a single thread. The
+ * tasks are taken from a shared ready list, largest subtrees first, and a node
+ * at the top becomes ready when all of its children are done. Disjoint
+ * subtrees are thus visited concurrently.
+ *
+ * @param parent  the elimination tree, with `parent[j] > j`
+ * @param work  the estimated work of each node
+ * @param nthreads  the number of threads
+ * @param f  the function to apply, called as `f(j, t)` for node `j` on thread
+ *        `t`. If it throws, no more tasks are started, and the first exception
+ *        is rethrown once all threads are done.
+ */
+static void etree_parallel_for(
+    const std::vector<csint>& parent,
+    const std::vector<csint>& work,
+    int nthreads,
+    const std::function<void(csint, int)>& f
+)
+{
+    csint N = parent.size();
+
+    // Accumulate the work and size of each subtree into its parent
+    std::vector<csint> subtree_work(work);
+    std::vector<csint> subtree_size(N, 1);
+    csint total = 0;
+
+    for (csint j = 0; j < N; j++) {
+        if (parent[j] == -1) {
+            total += subtree_work[j];
+        } else {
+            assert(parent[j] > j);
+            subtree_work[parent[j]] += subtree_work[j];
+            subtree_size[parent[j]] += subtree_size[j];
+        }
+    }
+
+    csint grain = std::max<csint>(1, total / (SUBTREE_TASKS_PER_THREAD * nthreads));
+
+    // The largest subtrees within the grain are tasks. Any node above them is
+    // a task by itself, which waits for each of its children.
+    std::vector<bool> is_subtree(N);
+    std::vector<csint> pending(N, 0);
+    std::vector<csint> ready;
+    csint ntasks = 0;
+
+    for (csint j = 0; j < N; j++) {
+        csint p = parent[j];
+        bool is_top = subtree_work[j] > grain;
+        is_subtree[j] = !is_top && (p == -1 || subtree_work[p] > grain);
+        if (is_top || is_subtree[j]) {
+            ntasks++;
+            if (p != -1) {
+                pending[p]++;
+            }
+        }
+    }
+
+    for (csint j = 0; j < N; j++) {
+        if (is_subtree[j] || (subtree_work[j] > grain && pending[j] == 0)) {
+            ready.push_back(j);
+        }
+    }
+
+    // Take the largest tasks first, from the back of the list
+    std::sort(ready.begin(), ready.end(),
+        [&](csint a, csint b) { return subtree_work[a] < subtree_work[b]; });
+
+    // The nodes of each subtree are contiguous in postorder, ending at the root
+    const std::vector<csint> postorder = post(parent);
+    std::vector<csint> post_pos(N);
+    for (csint k = 0; k < N; k++) {
+        post_pos[postorder[k]] = k;
+    }
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    csint ndone = 0;
+    std::exception_ptr error;
+
+    parallel_for(nthreads, [&](int t) {
+        while (true) {
+            csint j;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [&] {
+                    return !ready.empty() || ndone == ntasks || error;
+                });
+                if (ready.empty() || error) {
+                    return;
+                }
+                j = ready.back();
+                ready.pop_back();
+            }
+
+            try {
+                if (is_subtree[j]) {
+                    csint end = post_pos[j] + 1;
+                    for (csint k = end - subtree_size[j]; k < end; k++) {
+                        f(postorder[k], t);
+                    }
+                } else {
+                    f(j, t);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                cv.notify_all();
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                ndone++;
+                csint p = parent[j];
+                if (p != -1 && --pending[p] == 0) {
+                    ready.push_back(p);
+                }
+            }
+            cv.notify_all();
+        }
+    });
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+
+CSCMatrix chol(
+    const CSCMatrix& A,
+    const SymbolicChol& S,
+    double drop_tol,
+    int threads
+)
 {
+    PhaseTimer timer("chol");
+
     auto [M, N] = A.shape();
     CSCMatrix L({M, N}, S.lnz);  // allocate result
 
     // Workspaces
-    std::vector<csint> c(S.cp);  // column pointers for L
-    std::vector<double> x(N);    // sparse accumulator
+    Workspace& ws = get_workspace();
+    auto c = ws.take<csint>(S.cp.size());  // column pointers for L
+    std::copy(S.cp.begin(), S.cp.end(), c->begin());
 
-    const CSCMatrix C = A.symperm(S.p_inv);
+    // C = triu(A(p, p)), with its values read from A through the map
+    const SymPermView Cv(A, S);
+    const CSCMatrix& C = Cv.C;
+    const std::vector<csint>& Cmap = Cv.map;
 
     L.p_ = S.cp;  // column pointers for L
 
-    // Compute L(k, :) for L*L' = C in up-looking order
-    for (csint k = 0; k < N; k++) {
+    // Compute L(k, :) for L*L' = C, using the sparse accumulator x. Row k
+    // depends only on the rows of its subtree in the elimination tree, and
+    // only writes to the columns of its subtree, which it appends in row
+    // order. Any order that visits the children of k before k thus computes
+    // the same factor. Each row leaves x all zero again.
+    auto compute_row = [&](csint k, std::vector<double>& x) {
         //--- Nonzero pattern of L(k, :) ---------------------------------------
         x[k] = 0.0;  // x(0:k) is now zero
 
         // scatter C into x = full(triu(C(:,k)))
         // C does not have to be in sorted order (d = x[k] gets the diagonal)
         for (csint p = C.p_[k]; p < C.p_[k+1]; p++) {
-            csint i = C.i_[p];
-            if (i <= k) {
-                x[i] = C.v_[p];
-            }
+            x[C.i_[p]] = A.v_[Cmap[p]];
         }
 
         double d = x[k];  // d = C(k, k)
@@ -599,6 +907,37 @@ CSCMatrix chol(const CSCMatrix& A, const SymbolicChol& S, double drop_tol)
             L.i_[p] = k;  // store L(k, k) = sqrt(d) in column k
             L.v_[p] = sqrt_d;
         }
+    };
+
+    int nthreads = resolve_num_threads(threads, S.lnz);
+
+    if (nthreads == 1) {
+        auto x = ws.zeros<double>(N);  // sparse accumulator
+        for (csint k = 0; k < N; k++) {
+            compute_row(k, *x);
+        }
+    } else {
+        // Estimate the work of each node by the updates with its column
+        std::vector<csint> work(N);
+        for (csint j = 0; j < N; j++) {
+            csint count = S.cp[j+1] - S.cp[j];
+            work[j] = count * count;
+        }
+
+        // The accumulators are borrowed by this thread for all of the others
+        std::vector<Workspace::Buffer<double>> xs;
+        for (int t = 0; t < nthreads; t++) {
+            xs.push_back(ws.zeros<double>(N));
+        }
+
+        etree_parallel_for(S.parent, work, nthreads,
+            [&](csint k, int t) { compute_row(k, *xs[t]); });
+    }
+
+    if (Stats *stats = get_stats()) {
+        stats->flops += chol_flops(S.cp);
+        record_memory(memory_bytes(L) + memory_bytes(*c)
+                      + nthreads * N * sizeof(double));
     }
 
     // Guaranteed by construction
@@ -617,14 +956,21 @@ CSCMatrix& leftchol(const CSCMatrix& A, const SymbolicChol& S, CSCMatrix& L)
     assert(!L.data().empty());
     assert(L.has_sorted_indices_);
 
+    PhaseTimer timer("leftchol");
+    L.invalidate_csr_();
+
     csint N = A.shape()[1];
 
     // Workspaces
     std::vector<csint> c(S.cp);  // column pointers for L
     std::vector<double> x(N);    // sparse accumulator
 
-    // Need the *lower* triangular part for a_{32}, so do a full permutation
-    const CSCMatrix C = A.permute(S.p_inv, inv_permute(S.p_inv));
+    // Need the *lower* triangular part for a_{32}, which is the transpose of
+    // C = triu(A(p, p)). Both are read from A through their maps.
+    const SymPermView Cv(A, S);
+    const CSCMatrix& C = Cv.C;
+    std::vector<csint> Ct_map;
+    const CSCMatrix Ct = transpose_map(C, Cv.map, Ct_map);
 
     L.p_ = S.cp;  // column pointers for L
 
@@ -633,11 +979,8 @@ CSCMatrix& leftchol(const CSCMatrix& A, const SymbolicChol& S, CSCMatrix& L)
         // scatter [ a22 | --- a32 --- ].T into x
         //            k    k+1  ...  N
         // x := full(tril(C(:, k))) == full(triu(C(k, :)))
-        for (csint p = C.p_[k]; p < C.p_[k+1]; p++) {
-            csint i = C.i_[p];
-            if (i >= k) {  // only take lower triangular
-                x[i] = C.v_[p];
-            }
+        for (csint p = Ct.p_[k]; p < Ct.p_[k+1]; p++) {
+            x[Ct.i_[p]] = A.v_[Ct_map[p]];
         }
 
         //--- Sparse Multiply --------------------------------------------------
@@ -678,6 +1021,12 @@ CSCMatrix& leftchol(const CSCMatrix& A, const SymbolicChol& S, CSCMatrix& L)
         }
     }
 
+    if (Stats *stats = get_stats()) {
+        stats->flops += chol_flops(S.cp);
+        record_memory(memory_bytes(L) + memory_bytes(Ct) + memory_bytes(Ct_map)
+                      + memory_bytes(c) + memory_bytes(x));
+    }
+
     // Guaranteed by construction
     L.has_sorted_indices_ = true;
     L.has_canonical_format_ = true;  // L retains numerically 0 entries
@@ -694,13 +1043,19 @@ CSCMatrix& rechol(const CSCMatrix& A, const SymbolicChol& S, CSCMatrix& L)
     assert(!L.v_.empty());
     assert(L.has_sorted_indices_);
 
+    PhaseTimer timer("rechol");
+    L.invalidate_csr_();
+
     csint N = A.shape()[1];
 
     // Workspaces
     std::vector<csint> c(S.cp);  // column pointers for L
     std::vector<double> x(N);    // sparse accumulator
 
-    const CSCMatrix C = A.symperm(S.p_inv);
+    // C = triu(A(p, p)), with its values read from A through the map
+    const SymPermView Cv(A, S);
+    const CSCMatrix& C = Cv.C;
+    const std::vector<csint>& Cmap = Cv.map;
 
     L.p_ = S.cp;  // column pointers for L
 
@@ -711,10 +1066,7 @@ CSCMatrix& rechol(const CSCMatrix& A, const SymbolicChol& S, CSCMatrix& L)
 
         // scatter C into x = full(triu(C(:,k)))
         for (csint p = C.p_[k]; p < C.p_[k+1]; p++) {
-            csint i = C.i_[p];
-            if (i <= k) {
-                x[i] = C.v_[p];
-            }
+            x[C.i_[p]] = A.v_[Cmap[p]];
         }
 
         double d = x[k];  // d = C(k, k)
@@ -748,6 +1100,11 @@ CSCMatrix& rechol(const CSCMatrix& A, const SymbolicChol& S, CSCMatrix& L)
         L.v_[c[k]++] = std::sqrt(d);  // store L(k, k) = sqrt(d) in column k
     }
 
+    if (Stats *stats = get_stats()) {
+        stats->flops += chol_flops(S.cp);
+        record_memory(memory_bytes(L) + memory_bytes(c) + memory_bytes(x));
+    }
+
     // Guaranteed by construction
     L.has_sorted_indices_ = true;
     L.has_canonical_format_ = true;  // L retains numerically 0 entries
@@ -766,6 +1123,8 @@ CSCMatrix& chol_update(
     assert(L.shape()[0] == C.shape()[0]);
     assert(C.shape()[1] == 1);  // C must be a column vector
 
+    L.invalidate_csr_();
+
     double α,
            β = 1.0,
            β2 = 1.0,
@@ -773,7 +1132,8 @@ CSCMatrix& chol_update(
            γ,
            σ = (update) ? 1.0 : -1.0;
 
-    std::vector<double> w(L.shape()[0]);  // sparse accumulator workspace
+    // Sparse accumulator workspace, which is cleared on the path
+    auto w = get_workspace().zeros<double>(L.shape()[0]);
 
     // Find the minimum row index in the update vector
     csint p = C.p_[0];
@@ -795,6 +1155,7 @@ CSCMatrix& chol_update(
         δ = update ? (β / β2) : (β2 / β);
         γ = σ * α / (β2 * β);
         L.v_[p] = δ * L.v_[p] + (update ? (γ * w[j]) : 0.0);
+        w[j] = 0.0;  // w(j) is not used again
         β = β2;
         for (p++; p < L.p_[j+1]; p++) {
             double w1 = w[L.i_[p]];
@@ -804,10 +1165,153 @@ CSCMatrix& chol_update(
         }
     }
 
+    // Clear any entries of C that are not on the path
+    for (p = C.p_[0]; p < C.p_[1]; p++) {
+        w[C.i_[p]] = 0.0;
+    }
+
     return L;
 }
 
 
+CSCMatrix& chol_updown(
+    CSCMatrix& L,
+    bool update,
+    const CSCMatrix& C,
+    const std::vector<csint>& parent,
+    UpdownWorkspace& ws
+)
+{
+    PhaseTimer timer("chol_updown");
+
+    auto [N, K] = C.shape();
+    assert(L.shape()[0] == N);
+    assert(static_cast<csint>(parent.size()) == N);
+
+    L.invalidate_csr_();
+
+    if (static_cast<csint>(ws.W.size()) < N * K) {
+        ws.W.resize(N * K, 0.0);  // the workspace is zero between calls
+    }
+
+    if (static_cast<csint>(ws.marked.size()) < N) {
+        ws.marked.resize(N, false);
+    }
+
+    ws.beta.assign(K, 1.0);
+    ws.path.clear();
+
+    double *W = ws.W.data();  // W(i, c) = W[i * K + c]
+    double σ = update ? 1.0 : -1.0;
+
+    // Scatter C into W, and merge the path from the first row of each column
+    for (csint c = 0; c < K; c++) {
+        if (C.p_[c] == C.p_[c+1]) {
+            continue;  // an empty column does not change L
+        }
+
+        csint f = C.i_[C.p_[c]];
+        for (csint p = C.p_[c]; p < C.p_[c+1]; p++) {
+            f = std::min(f, C.i_[p]);
+            W[C.i_[p] * K + c] += C.v_[p];
+        }
+
+        for (csint j = f; j != -1 && !ws.marked[j]; j = parent[j]) {
+            ws.marked[j] = true;
+            ws.path.push_back(j);
+        }
+    }
+
+    // A parent always follows its children, so each path is in increasing order
+    std::sort(ws.path.begin(), ws.path.end());
+
+    std::vector<double> α(K), δ(K), γ(K);
+    double flops = 0;
+    bool failed = false;
+
+    for (const auto& j : ws.path) {
+        csint p0 = L.p_[j],
+              p1 = L.p_[j+1];
+        double *w = W + j * K;
+
+        // Rotate the diagonal by each column in turn. A column that has not
+        // reached j is zero here, and its rotation is the identity.
+        for (csint c = 0; c < K; c++) {
+            if (w[c] == 0.0) {
+                α[c] = 0.0;
+                δ[c] = 1.0;
+                γ[c] = 0.0;
+                continue;
+            }
+
+            double β = ws.beta[c];
+            α[c] = w[c] / L.v_[p0];  // α = w(j) / L(j, j)
+            double β2 = β*β + σ * α[c]*α[c];
+            if (β2 <= 0) {
+                failed = true;
+                break;
+            }
+            β2 = std::sqrt(β2);
+            δ[c] = update ? (β / β2) : (β2 / β);
+            γ[c] = σ * α[c] / (β2 * β);
+            L.v_[p0] = δ[c] * L.v_[p0] + (update ? (γ[c] * w[c]) : 0.0);
+            ws.beta[c] = β2;
+            flops += 5 * (p1 - p0) + 10;
+        }
+
+        if (failed) {
+            break;
+        }
+
+        // Apply all of the rotations to each off-diagonal entry
+        for (csint p = p0 + 1; p < p1; p++) {
+            double *wi = W + L.i_[p] * K;
+            double Lp = L.v_[p];
+            for (csint c = 0; c < K; c++) {
+                double w1 = wi[c];
+                double w2 = w1 - α[c] * Lp;
+                wi[c] = w2;
+                Lp = δ[c] * Lp + γ[c] * (update ? w1 : w2);
+            }
+            L.v_[p] = Lp;
+        }
+    }
+
+    // Clean the workspace for the next call. All of the fill of W is on the path.
+    for (const auto& j : ws.path) {
+        std::fill(W + j * K, W + (j + 1) * K, 0.0);
+        ws.marked[j] = false;
+    }
+
+    for (csint p = 0; p < C.p_[K]; p++) {
+        std::fill(W + C.i_[p] * K, W + (C.i_[p] + 1) * K, 0.0);
+    }
+
+    if (failed) {
+        throw std::runtime_error("Matrix not positive definite!");
+    }
+
+    if (Stats *stats = get_stats()) {
+        stats->flops += flops;
+        record_memory(memory_bytes(ws.W) + memory_bytes(ws.path) + memory_bytes(ws.marked));
+    }
+
+    return L;
+}
+
+
+CSCMatrix& chol_updown(
+    CSCMatrix& L,
+    bool update,
+    const CSCMatrix& C,
+    const std::vector<csint>& parent
+)
+{
+    UpdownWorkspace ws;
+    return chol_updown(L, update, C, parent, ws);
+}
+
+
 // Exercise 4.1 O(|L|)-time elimination tree and row/column counts
 // Use ereach to compute the elimination tree one node at a time (pp 43--44)
 CholCounts chol_etree_counts(const CSCMatrix& A)
@@ -850,10 +1354,50 @@ CSCMatrix ichol(
 )
 {
     switch (method) {
-        case ICholMethod::NoFill:
-            // L = A;  // just copy the matrix and update the values
-            throw std::runtime_error("Not implemented!");
-            break;
+        case ICholMethod::NoFill: {
+            // L = triu(A).T, so each column is sorted, with the diagonal first
+            CSCMatrix L = A.band(0, A.N_).T();
+            csint N = L.N_;
+
+            std::vector<csint> pos(N, -1);  // positions of the entries of L(:, j)
+
+            // Right-looking factorization, restricted to the pattern of L
+            for (csint k = 0; k < N; k++) {
+                csint dk = L.p_[k];
+                if (dk == L.p_[k+1] || L.i_[dk] != k || L.v_[dk] <= 0) {
+                    throw std::runtime_error("Matrix not positive definite!");
+                }
+
+                double lkk = std::sqrt(L.v_[dk]);
+                L.v_[dk] = lkk;
+                for (csint p = dk + 1; p < L.p_[k+1]; p++) {
+                    L.v_[p] /= lkk;  // L(k+1:, k) /= L(k, k)
+                }
+
+                // L(i, j) -= L(i, k) * L(j, k), for each (i, j) in the pattern
+                for (csint pj = dk + 1; pj < L.p_[k+1]; pj++) {
+                    csint j = L.i_[pj];
+                    double ljk = L.v_[pj];
+
+                    for (csint q = L.p_[j]; q < L.p_[j+1]; q++) {
+                        pos[L.i_[q]] = q;
+                    }
+
+                    for (csint pi = pj; pi < L.p_[k+1]; pi++) {
+                        csint q = pos[L.i_[pi]];
+                        if (q >= 0) {
+                            L.v_[q] -= L.v_[pi] * ljk;
+                        }
+                    }
+
+                    for (csint q = L.p_[j]; q < L.p_[j+1]; q++) {
+                        pos[L.i_[q]] = -1;
+                    }
+                }
+            }
+
+            return L;
+        }
 
         case ICholMethod::ICT:
             return chol(A, schol(A), drop_tol);
@@ -866,6 +1410,330 @@ CSCMatrix ichol(
 
 
 
+/*------------------------------------------------------------------------------
+ *         Supernodal Cholesky
+ *----------------------------------------------------------------------------*/
+std::vector<csint> find_supernodes(
+    const std::vector<csint>& parent,
+    const std::vector<csint>& cp
+)
+{
+    const csint N = static_cast<csint>(parent.size());
+    assert(static_cast<csint>(cp.size()) == N + 1);
+
+    std::vector<csint> super;
+    super.reserve(N + 1);
+
+    for (csint j = 0; j < N; j++) {
+        // Start a new supernode unless column j extends the previous one
+        bool extends = (j > 0)
+            && (parent[j-1] == j)
+            && (cp[j] - cp[j-1] == cp[j+1] - cp[j] + 1);
+
+        if (!extends) {
+            super.push_back(j);
+        }
+    }
+
+    super.push_back(N);
+
+    return super;
+}
+
+
+SupernodalChol symbolic_super(const CSCMatrix& A, const SymbolicChol& S)
+{
+    const csint N = A.N_;
+
+    SupernodalChol L;
+    L.p_inv = S.p_inv;
+    L.super = find_supernodes(S.parent, S.cp);
+
+    const csint ns = L.super.size() - 1;  // number of supernodes
+
+    // Map each column to its supernode
+    std::vector<csint> col_super(N);
+    for (csint s = 0; s < ns; s++) {
+        for (csint j = L.super[s]; j < L.super[s+1]; j++) {
+            col_super[j] = s;
+        }
+    }
+
+    // Children of each supernode in the supernodal elimination tree
+    std::vector<csint> head(ns, -1), next(ns, -1);
+    for (csint s = ns - 1; s >= 0; s--) {
+        csint pa = S.parent[L.super[s+1] - 1];  // parent of last column
+        if (pa != -1) {
+            csint t = col_super[pa];
+            next[s] = head[t];
+            head[t] = s;
+        }
+    }
+
+    // Allocate the row indices and values
+    L.rp.assign(ns + 1, 0);
+    L.xp.assign(ns + 1, 0);
+    for (csint s = 0; s < ns; s++) {
+        csint f = L.super[s];
+        csint nrows = S.cp[f+1] - S.cp[f];
+        csint ncols = L.super[s+1] - f;
+        L.rp[s+1] = L.rp[s] + nrows;
+        L.xp[s+1] = L.xp[s] + nrows * ncols;
+    }
+
+    L.ri.resize(L.rp[ns]);
+    L.x.assign(L.xp[ns], 0.0);
+
+    // Lower triangular pattern of C = A[p, p]
+    const SymPermView Cv(A, S);
+    const CSCMatrix C = Cv.C.transpose(false);
+
+    std::vector<csint> w(N, -1);  // marks rows in the current supernode
+
+    for (csint s = 0; s < ns; s++) {
+        csint f = L.super[s],
+              l = L.super[s+1];
+        csint nz = L.rp[s];
+
+        // The diagonal block comes first
+        for (csint j = f; j < l; j++) {
+            L.ri[nz++] = j;
+            w[j] = s;
+        }
+
+        csint start = nz;
+
+        // Rows of C(l:, f:l)
+        for (csint j = f; j < l; j++) {
+            for (csint p = C.p_[j]; p < C.p_[j+1]; p++) {
+                csint i = C.i_[p];
+                if (i >= l && w[i] != s) {
+                    w[i] = s;
+                    L.ri[nz++] = i;
+                }
+            }
+        }
+
+        // Sub-diagonal rows of each child supernode
+        for (csint t = head[s]; t != -1; t = next[t]) {
+            csint nct = L.super[t+1] - L.super[t];
+            for (csint p = L.rp[t] + nct; p < L.rp[t+1]; p++) {
+                csint i = L.ri[p];
+                if (i >= l && w[i] != s) {
+                    w[i] = s;
+                    L.ri[nz++] = i;
+                }
+            }
+        }
+
+        assert(nz == L.rp[s+1]);  // guaranteed by the column counts
+        std::sort(L.ri.begin() + start, L.ri.begin() + nz);
+    }
+
+    return L;
+}
+
+
+SupernodalChol& rechol_super(
+    const CSCMatrix& A,
+    const SymbolicChol& S,
+    SupernodalChol& L
+)
+{
+    // Ensure L has been allocated via symbolic_super
+    assert(!L.super.empty());
+    assert(static_cast<csint>(L.x.size()) == L.xp.back());
+
+    const csint N = A.N_;
+    const csint ns = L.super.size() - 1;
+
+    // Lower triangular part of C = A[p, p], read from A through the map
+    const SymPermView Cv(A, S);
+    std::vector<csint> Cmap;
+    const CSCMatrix C = transpose_map(Cv.C, Cv.map, Cmap);
+
+    std::vector<csint> col_super(N);
+    for (csint s = 0; s < ns; s++) {
+        for (csint j = L.super[s]; j < L.super[s+1]; j++) {
+            col_super[j] = s;
+        }
+    }
+
+    // Workspaces
+    std::vector<csint> map(N),         // row index -> local row in supernode
+                       head(ns, -1),   // supernodes that update supernode s
+                       next(ns, -1),   // linked list of updating supernodes
+                       pos(ns);        // next row of each supernode to use
+    std::vector<double> W;             // dense update block
+
+    std::fill(L.x.begin(), L.x.end(), 0.0);
+
+    for (csint s = 0; s < ns; s++) {
+        const csint f = L.super[s],
+                    l = L.super[s+1],
+                    ncols = l - f,
+                    nrows = L.rp[s+1] - L.rp[s];
+        const csint *rows = L.ri.data() + L.rp[s];
+        double *X = L.x.data() + L.xp[s];
+
+        for (csint r = 0; r < nrows; r++) {
+            map[rows[r]] = r;
+        }
+
+        //--- Scatter C(f:, f:l) into the dense block --------------------------
+        for (csint j = f; j < l; j++) {
+            for (csint p = C.p_[j]; p < C.p_[j+1]; p++) {
+                csint i = C.i_[p];
+                if (i >= j) {
+                    X[map[i] + (j - f) * nrows] += A.v_[Cmap[p]];
+                }
+            }
+        }
+
+        //--- Update with each descendant supernode ----------------------------
+        csint t = head[s];
+        head[s] = -1;
+
+        while (t != -1) {
+            csint t_next = next[t];
+
+            const csint nct = L.super[t+1] - L.super[t],
+                        nrt = L.rp[t+1] - L.rp[t];
+            const csint *trows = L.ri.data() + L.rp[t];
+            const double *Xt = L.x.data() + L.xp[t];
+
+            // Rows p1:p2 of supernode t are in the columns of supernode s
+            csint p1 = pos[t];
+            csint p2 = p1;
+            while (p2 < nrt && trows[p2] < l) {
+                p2++;
+            }
+
+            // W = Lt[p1:, :] * Lt[p1:p2, :]^T, lower triangle only
+            const csint m = nrt - p1,
+                        n = p2 - p1;
+            W.assign(m * n, 0.0);
+
+            for (csint k = 0; k < nct; k++) {
+                const double *Lk = Xt + k * nrt + p1;  // column k of Lt[p1:, :]
+                for (csint c = 0; c < n; c++) {
+                    double lck = Lk[c];
+                    if (lck == 0.0) {
+                        continue;
+                    }
+                    double *Wc = W.data() + c * m;
+                    for (csint r = c; r < m; r++) {
+                        Wc[r] += Lk[r] * lck;
+                    }
+                }
+            }
+
+            // Subtract W from the dense block with relative indexing
+            for (csint c = 0; c < n; c++) {
+                double *Xc = X + (trows[p1 + c] - f) * nrows;
+                const double *Wc = W.data() + c * m;
+                for (csint r = c; r < m; r++) {
+                    Xc[map[trows[p1 + r]]] -= Wc[r];
+                }
+            }
+
+            // Move t to the list of the next supernode it updates
+            pos[t] = p2;
+            if (p2 < nrt) {
+                csint u = col_super[trows[p2]];
+                next[t] = head[u];
+                head[u] = t;
+            }
+
+            t = t_next;
+        }
+
+        //--- Dense factorization of the supernode -----------------------------
+        // Right-looking Cholesky of the diagonal block, which also solves for
+        // the sub-diagonal block L[ncols:, :] = X[ncols:, :] * L[:ncols, :]^{-T}
+        for (csint k = 0; k < ncols; k++) {
+            double *Xk = X + k * nrows;
+            double d = Xk[k];
+
+            if (d <= 0) {
+                throw std::runtime_error("Matrix not positive definite!");
+            }
+
+            d = std::sqrt(d);
+            Xk[k] = d;
+
+            for (csint r = k + 1; r < nrows; r++) {
+                Xk[r] /= d;
+            }
+
+            for (csint c = k + 1; c < ncols; c++) {
+                double *Xc = X + c * nrows;
+                double lck = Xk[c];
+                for (csint r = c; r < nrows; r++) {
+                    Xc[r] -= Xk[r] * lck;
+                }
+            }
+        }
+
+        // Add s to the list of the first supernode it updates
+        pos[s] = ncols;
+        if (ncols < nrows) {
+            csint u = col_super[rows[ncols]];
+            next[s] = head[u];
+            head[u] = s;
+        }
+    }
+
+    return L;
+}
+
+
+SupernodalChol chol_super(const CSCMatrix& A, const SymbolicChol& S)
+{
+    SupernodalChol L = symbolic_super(A, S);
+    return rechol_super(A, S, L);
+}
+
+
+CSCMatrix super_to_csc(const SupernodalChol& L)
+{
+    const csint N = L.super.back();
+    const csint ns = L.super.size() - 1;
+
+    // Count the entries in the lower trapezoid of each supernode
+    csint lnz = 0;
+    for (csint s = 0; s < ns; s++) {
+        csint ncols = L.super[s+1] - L.super[s],
+              nrows = L.rp[s+1] - L.rp[s];
+        lnz += ncols * nrows - ncols * (ncols - 1) / 2;
+    }
+
+    CSCMatrix C({N, N}, lnz);
+
+    csint nz = 0;
+    for (csint s = 0; s < ns; s++) {
+        csint f = L.super[s],
+              nrows = L.rp[s+1] - L.rp[s];
+        for (csint j = f; j < L.super[s+1]; j++) {
+            C.p_[j] = nz;
+            for (csint r = j - f; r < nrows; r++) {
+                C.i_[nz] = L.ri[L.rp[s] + r];
+                C.v_[nz++] = L.x[L.xp[s] + (j - f) * nrows + r];
+            }
+        }
+    }
+
+    C.p_[N] = nz;
+
+    // Guaranteed by construction
+    C.has_sorted_indices_ = true;
+    C.has_canonical_format_ = true;
+
+    return C;
+}
+
+
+
 } // namespace cs
 
 /*==============================================================================
@@ -0,0 +1,327 @@
+/*==============================================================================
+ *     File: compact.cpp
+ *  Created: 2025-03-19 10:40
+ *   Author: Bernie Roesler
+ *
+ *  Description: Implements the CSC matrix with compact index and value types.
+ *
+ *============================================================================*/
+
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+#include "compact.h"
+#include "csc.h"
+#include "parallel.h"
+
+namespace cs {
+
+/*------------------------------------------------------------------------------
+ *      Constructors
+ *----------------------------------------------------------------------------*/
+// Check that the dimensions of a matrix fit in the index type
+template <typename Index>
+static void check_index_range(const Shape& shape)
+{
+    constexpr csint max_index = std::numeric_limits<Index>::max();
+    if (shape[0] > max_index || shape[1] > max_index) {
+        throw std::runtime_error("Matrix dimensions do not fit the index type!");
+    }
+}
+
+
+template <typename Index, typename Value>
+CompactCSC<Index, Value>::CompactCSC(const CSCMatrix& A)
+    : p_(A.indptr()),
+      M_(A.shape()[0]),
+      N_(A.shape()[1])
+{
+    check_index_range<Index>(A.shape());
+
+    // Copy only the entries in use, since A may have extra capacity
+    csint nz = p_[N_];
+    i_.assign(A.indices().begin(), A.indices().begin() + nz);
+    v_.reserve(nz);
+    for (csint p = 0; p < nz; p++) {
+        v_.push_back(static_cast<Value>(A.data()[p]));
+    }
+}
+
+
+template <typename Index, typename Value>
+CompactCSC<Index, Value>::CompactCSC(
+    std::vector<Value>&& data,
+    std::vector<Index>&& indices,
+    std::vector<csint>&& indptr,
+    const Shape& shape
+) : v_(std::move(data)),
+    i_(std::move(indices)),
+    p_(std::move(indptr)),
+    M_(shape[0]),
+    N_(shape[1])
+{
+    check_index_range<Index>(shape);
+
+    if (static_cast<csint>(p_.size()) != N_ + 1
+        || i_.size() != v_.size()
+        || p_[N_] != nnz()) {
+        throw std::runtime_error("Inconsistent array sizes for CompactCSC!");
+    }
+}
+
+
+template <typename Index, typename Value>
+CSCMatrix CompactCSC<Index, Value>::tocsc() const
+    requires (!std::is_same_v<Value, std::complex<double>>)
+{
+    return CSCMatrix(
+        std::vector<double>(v_.begin(), v_.end()),
+        std::vector<csint>(i_.begin(), i_.end()),
+        std::vector<csint>(p_),
+        Shape {M_, N_}
+    );
+}
+
+
+/*------------------------------------------------------------------------------
+ *      Math Operations
+ *----------------------------------------------------------------------------*/
+template <typename Index, typename Value>
+std::vector<Value> CompactCSC<Index, Value>::gaxpy(
+    const std::vector<Value>& x,
+    const std::vector<Value>& y,
+    int threads
+) const
+{
+    assert(M_ == static_cast<csint>(y.size()));  // addition
+    assert(N_ == static_cast<csint>(x.size()));  // multiplication
+
+    std::vector<Value> out = y;  // copy the input vector
+
+    const int nthreads = resolve_num_threads(threads, nnz());
+
+    if (nthreads == 1) {
+        for (csint j = 0; j < N_; j++) {
+            for (csint p = p_[j]; p < p_[j+1]; p++) {
+                out[i_[p]] += v_[p] * x[j];
+            }
+        }
+        return out;
+    }
+
+    // Each thread scatters its block of columns into its own partial output.
+    // Thread 0 uses the output vector directly.
+    const std::vector<csint> bounds = partition_nnz(p_, nthreads);
+    std::vector<std::vector<Value>> partial(nthreads);
+
+    parallel_for(nthreads, [&](int t) {
+        if (t > 0) {
+            partial[t].assign(M_, Value(0));
+        }
+        std::vector<Value>& yt = (t == 0) ? out : partial[t];
+        for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+            for (csint p = p_[j]; p < p_[j+1]; p++) {
+                yt[i_[p]] += v_[p] * x[j];
+            }
+        }
+    });
+
+    // Reduce the partial outputs over blocks of rows
+    parallel_for(nthreads, [&](int t) {
+        csint start = (M_ * t) / nthreads,
+              end = (M_ * (t + 1)) / nthreads;
+        for (int s = 1; s < nthreads; s++) {
+            for (csint i = start; i < end; i++) {
+                out[i] += partial[s][i];
+            }
+        }
+    });
+
+    return out;
+}
+
+
+template <typename Index, typename Value>
+std::vector<Value> CompactCSC<Index, Value>::gatxpy(
+    const std::vector<Value>& x,
+    const std::vector<Value>& y,
+    int threads
+) const
+{
+    assert(M_ == static_cast<csint>(x.size()));  // multiplication
+    assert(N_ == static_cast<csint>(y.size()));  // addition
+
+    std::vector<Value> out = y;  // copy the input vector
+
+    const int nthreads = resolve_num_threads(threads, nnz());
+    const std::vector<csint> bounds = partition_nnz(p_, nthreads);
+
+    // Each column is an independent dot product, so no reduction is needed
+    parallel_for(nthreads, [&](int t) {
+        for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+            for (csint p = p_[j]; p < p_[j+1]; p++) {
+                out[j] += v_[p] * x[i_[p]];
+            }
+        }
+    });
+
+    return out;
+}
+
+
+/*------------------------------------------------------------------------------
+ *      Triangular Matrix Solutions
+ *----------------------------------------------------------------------------*/
+template <typename Index, typename Value>
+std::vector<Value> lsolve(
+    const CompactCSC<Index, Value>& L,
+    const std::vector<Value>& b
+)
+{
+    auto [M, N] = L.shape();
+    assert(M == N);
+    assert(N == static_cast<csint>(b.size()));
+
+    const auto& Lp = L.indptr();
+    const auto& Li = L.indices();
+    const auto& Lx = L.data();
+
+    std::vector<Value> x = b;
+
+    for (csint j = 0; j < N; j++) {
+        x[j] /= Lx[Lp[j]];
+        for (csint p = Lp[j] + 1; p < Lp[j+1]; p++) {
+            x[Li[p]] -= Lx[p] * x[j];
+        }
+    }
+
+    return x;
+}
+
+
+template <typename Index, typename Value>
+std::vector<Value> ltsolve(
+    const CompactCSC<Index, Value>& L,
+    const std::vector<Value>& b
+)
+{
+    auto [M, N] = L.shape();
+    assert(M == N);
+    assert(N == static_cast<csint>(b.size()));
+
+    const auto& Lp = L.indptr();
+    const auto& Li = L.indices();
+    const auto& Lx = L.data();
+
+    std::vector<Value> x = b;
+
+    for (csint j = N - 1; j >= 0; j--) {
+        for (csint p = Lp[j] + 1; p < Lp[j+1]; p++) {
+            x[j] -= Lx[p] * x[Li[p]];
+        }
+        x[j] /= Lx[Lp[j]];
+    }
+
+    return x;
+}
+
+
+template <typename Index, typename Value>
+std::vector<Value> usolve(
+    const CompactCSC<Index, Value>& U,
+    const std::vector<Value>& b
+)
+{
+    auto [M, N] = U.shape();
+    assert(M == N);
+    assert(N == static_cast<csint>(b.size()));
+
+    const auto& Up = U.indptr();
+    const auto& Ui = U.indices();
+    const auto& Ux = U.data();
+
+    std::vector<Value> x = b;
+
+    for (csint j = N - 1; j >= 0; j--) {
+        x[j] /= Ux[Up[j+1] - 1];  // diagonal entry
+        for (csint p = Up[j]; p < Up[j+1] - 1; p++) {
+            x[Ui[p]] -= Ux[p] * x[j];
+        }
+    }
+
+    return x;
+}
+
+
+template <typename Index, typename Value>
+std::vector<Value> utsolve(
+    const CompactCSC<Index, Value>& U,
+    const std::vector<Value>& b
+)
+{
+    auto [M, N] = U.shape();
+    assert(M == N);
+    assert(N == static_cast<csint>(b.size()));
+
+    const auto& Up = U.indptr();
+    const auto& Ui = U.indices();
+    const auto& Ux = U.data();
+
+    std::vector<Value> x = b;
+
+    for (csint j = 0; j < N; j++) {
+        for (csint p = Up[j]; p < Up[j+1] - 1; p++) {
+            x[j] -= Ux[p] * x[Ui[p]];
+        }
+        x[j] /= Ux[Up[j+1] - 1];  // diagonal entry
+    }
+
+    return x;
+}
+
+
+/*------------------------------------------------------------------------------
+ *      Explicit Instantiations
+ *----------------------------------------------------------------------------*/
+template class CompactCSC<std::int32_t, float>;
+template class CompactCSC<std::int32_t, double>;
+template class CompactCSC<std::int32_t, std::complex<double>>;
+template class CompactCSC<std::int64_t, float>;
+template class CompactCSC<std::int64_t, double>;
+template class CompactCSC<std::int64_t, std::complex<double>>;
+
+template std::vector<float> lsolve(const CompactCSC<std::int32_t, float>&, const std::vector<float>&);
+template std::vector<float> ltsolve(const CompactCSC<std::int32_t, float>&, const std::vector<float>&);
+template std::vector<float> usolve(const CompactCSC<std::int32_t, float>&, const std::vector<float>&);
+template std::vector<float> utsolve(const CompactCSC<std::int32_t, float>&, const std::vector<float>&);
+
+template std::vector<double> lsolve(const CompactCSC<std::int32_t, double>&, const std::vector<double>&);
+template std::vector<double> ltsolve(const CompactCSC<std::int32_t, double>&, const std::vector<double>&);
+template std::vector<double> usolve(const CompactCSC<std::int32_t, double>&, const std::vector<double>&);
+template std::vector<double> utsolve(const CompactCSC<std::int32_t, double>&, const std::vector<double>&);
+
+template std::vector<std::complex<double>> lsolve(const CompactCSC<std::int32_t, std::complex<double>>&, const std::vector<std::complex<double>>&);
+template std::vector<std::complex<double>> ltsolve(const CompactCSC<std::int32_t, std::complex<double>>&, const std::vector<std::complex<double>>&);
+template std::vector<std::complex<double>> usolve(const CompactCSC<std::int32_t, std::complex<double>>&, const std::vector<std::complex<double>>&);
+template std::vector<std::complex<double>> utsolve(const CompactCSC<std::int32_t, std::complex<double>>&, const std::vector<std::complex<double>>&);
+
+template std::vector<float> lsolve(const CompactCSC<std::int64_t, float>&, const std::vector<float>&);
+template std::vector<float> ltsolve(const CompactCSC<std::int64_t, float>&, const std::vector<float>&);
+template std::vector<float> usolve(const CompactCSC<std::int64_t, float>&, const std::vector<float>&);
+template std::vector<float> utsolve(const CompactCSC<std::int64_t, float>&, const std::vector<float>&);
+
+template std::vector<double> lsolve(const CompactCSC<std::int64_t, double>&, const std::vector<double>&);
+template std::vector<double> ltsolve(const CompactCSC<std::int64_t, double>&, const std::vector<double>&);
+template std::vector<double> usolve(const CompactCSC<std::int64_t, double>&, const std::vector<double>&);
+template std::vector<double> utsolve(const CompactCSC<std::int64_t, double>&, const std::vector<double>&);
+
+template std::vector<std::complex<double>> lsolve(const CompactCSC<std::int64_t, std::complex<double>>&, const std::vector<std::complex<double>>&);
+template std::vector<std::complex<double>> ltsolve(const CompactCSC<std::int64_t, std::complex<double>>&, const std::vector<std::complex<double>>&);
+template std::vector<std::complex<double>> usolve(const CompactCSC<std::int64_t, std::complex<double>>&, const std::vector<std::complex<double>>&);
+template std::vector<std::complex<double>> utsolve(const CompactCSC<std::int64_t, std::complex<double>>&, const std::vector<std::complex<double>>&);
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/
@@ -18,6 +18,7 @@
 #include "utils.h"
 #include "coo.h"
 #include "csc.h"
+#include "parallel.h"
 
 namespace cs {
 
@@ -46,6 +47,23 @@ COOMatrix::COOMatrix(
 }
 
 
+COOMatrix::COOMatrix(
+    std::vector<double>&& vals,
+    std::vector<csint>&& rows,
+    std::vector<csint>&& cols,
+    const Shape& shape
+    )
+    : v_(std::move(vals)),
+      i_(std::move(rows)),
+      j_(std::move(cols)),
+      M_(shape[0]),
+      N_(shape[1])
+{
+    assert(v_.size() == i_.size());
+    assert(v_.size() == j_.size());
+}
+
+
 COOMatrix::COOMatrix(const Shape& shape, csint nzmax)
     : M_(shape[0]),
       N_(shape[1]) 
@@ -192,33 +210,203 @@ COOMatrix& COOMatrix::assign(
 /*------------------------------------------------------------------------------
  *          Format Conversions 
  *----------------------------------------------------------------------------*/
-CSCMatrix COOMatrix::compress() const 
+/** Compute the destination of each entry in a stable counting sort by key.
+ *
+ * The entries are split into `nthreads` contiguous blocks. Each thread counts
+ * the keys of its block, the counts are combined into the pointers of the
+ * output, and each thread then scatters its block starting from its own
+ * offset in each bucket. Entries with equal keys therefore keep their input
+ * order, and the result is identical to the serial sort.
+ *
+ * The per-thread histograms take `nthreads * nkeys` space, so the number of
+ * threads is limited to keep the histogram work below the scatter work.
+ *
+ * @param keys  the key of each entry, in `[0, nkeys)`
+ * @param nkeys  the number of buckets
+ * @param threads  the requested number of threads
+ * @param scatter  a function called as `scatter(k, p)` to move entry `k` to
+ *        position `p` of the output
+ *
+ * @return ptr  the start of each bucket in the output, of length `nkeys + 1`
+ */
+template <typename Scatter>
+static std::vector<csint> counting_sort(
+    const std::vector<csint>& keys,
+    csint nkeys,
+    int threads,
+    Scatter scatter
+)
 {
-    csint nnz_ = nnz();
-    CSCMatrix C({M_, N_}, nnz_);
-    std::vector<csint> w(N_);  // workspace
+    csint nnz = static_cast<csint>(keys.size());
+    int nthreads = resolve_num_threads(threads, nnz);
+    nthreads = static_cast<int>(
+        std::min<csint>(nthreads, std::max<csint>(1, nnz / std::max<csint>(nkeys, 1)))
+    );
+
+    if (nthreads <= 1) {
+        std::vector<csint> w(nkeys);
+
+        for (csint k = 0; k < nnz; k++) {
+            w[keys[k]]++;
+        }
 
-    // Compute number of elements in each column
-    for (csint k = 0; k < nnz_; k++)
-        w[j_[k]]++;
+        std::vector<csint> ptr = cumsum(w);
+        std::copy(ptr.begin(), ptr.end() - 1, w.begin());
 
-    // Column pointers are the cumulative sum
-    C.p_ = cumsum(w);
-    w = C.p_;  // copy back into workspace
+        for (csint k = 0; k < nnz; k++) {
+            scatter(k, w[keys[k]]++);
+        }
 
-    for (csint k = 0; k < nnz_; k++) {
-        // A(i, j) is the pth entry in the CSC matrix
-        csint p = w[j_[k]]++;  // "pointer" to the current element's column
-        C.i_[p] = i_[k];
-        C.v_[p] = v_[k];
+        return ptr;
     }
 
+    // Count the keys of each block
+    std::vector<std::vector<csint>> hist(nthreads);
+
+    parallel_for(nthreads, [&](int t) {
+        hist[t].assign(nkeys, 0);
+        for (csint k = nnz * t / nthreads; k < nnz * (t + 1) / nthreads; k++) {
+            hist[t][keys[k]]++;
+        }
+    });
+
+    // Total count of each key
+    std::vector<csint> counts(nkeys);
+
+    parallel_for(nthreads, [&](int t) {
+        for (csint j = nkeys * t / nthreads; j < nkeys * (t + 1) / nthreads; j++) {
+            csint c = 0;
+            for (int s = 0; s < nthreads; s++) {
+                c += hist[s][j];
+            }
+            counts[j] = c;
+        }
+    });
+
+    std::vector<csint> ptr = cumsum(counts, nthreads);
+
+    // Convert the histograms to the starting offset of each block in each bucket
+    parallel_for(nthreads, [&](int t) {
+        for (csint j = nkeys * t / nthreads; j < nkeys * (t + 1) / nthreads; j++) {
+            csint offset = ptr[j];
+            for (int s = 0; s < nthreads; s++) {
+                csint c = hist[s][j];
+                hist[s][j] = offset;
+                offset += c;
+            }
+        }
+    });
+
+    // Scatter each block
+    parallel_for(nthreads, [&](int t) {
+        std::vector<csint>& w = hist[t];
+        for (csint k = nnz * t / nthreads; k < nnz * (t + 1) / nthreads; k++) {
+            scatter(k, w[keys[k]]++);
+        }
+    });
+
+    return ptr;
+}
+
+
+CSCMatrix COOMatrix::compress(int threads) const
+{
+    CSCMatrix C({M_, N_}, nnz());
+
+    // Bucket the entries by column
+    C.p_ = counting_sort(j_, N_, threads,
+        [&](csint k, csint p) {
+            // A(i, j) is the pth entry in the CSC matrix
+            C.i_[p] = i_[k];
+            C.v_[p] = v_[k];
+        }
+    );
+
     return C;
 }
 
 
 // Exercise 2.9
-CSCMatrix COOMatrix::tocsc() const { return CSCMatrix(*this); }
+CSCMatrix COOMatrix::tocsc(int threads) const
+{
+    csint nnz_ = nnz();
+
+    // Bucket the entries by row, so that the column sort below leaves each
+    // column sorted by row. Both sorts are stable, so duplicates stay in
+    // input order, and are summed in the same order as `sum_duplicates()`.
+    std::vector<csint> ti(nnz_), tj(nnz_);
+    std::vector<double> tv(nnz_);
+
+    counting_sort(i_, M_, threads,
+        [&](csint k, csint p) {
+            ti[p] = i_[k];
+            tj[p] = j_[k];
+            tv[p] = v_[k];
+        }
+    );
+
+    // Bucket the entries by column
+    CSCMatrix C({M_, N_}, nnz_);
+
+    C.p_ = counting_sort(tj, N_, threads,
+        [&](csint k, csint p) {
+            C.i_[p] = ti[k];
+            C.v_[p] = tv[k];
+        }
+    );
+
+    // Sum duplicates and drop zeros within each block of columns, compacting
+    // each block towards its start
+    int nthreads = resolve_num_threads(threads, nnz_);
+    std::vector<csint> bounds = partition_nnz(C.p_, nthreads);
+    std::vector<csint> counts(N_);
+
+    parallel_for(nthreads, [&](int t) {
+        csint nz = C.p_[bounds[t]];
+        for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+            csint q = nz;  // column j will start at q
+            csint p = C.p_[j];
+            while (p < C.p_[j+1]) {
+                csint i = C.i_[p];
+                double x = C.v_[p++];
+                while (p < C.p_[j+1] && C.i_[p] == i) {
+                    x += C.v_[p++];  // A(i, j) is a duplicate
+                }
+                if (x != 0) {
+                    C.i_[nz] = i;
+                    C.v_[nz++] = x;
+                }
+            }
+            counts[j] = nz - q;
+        }
+    });
+
+    // Move the blocks into place. Blocks only move towards the front, so
+    // they are moved in order. A block may overlap its destination, which
+    // std::copy allows only if the destination starts before the source.
+    std::vector<csint> p = cumsum(counts, nthreads);
+
+    if (p[N_] != C.p_[N_]) {
+        for (int t = 0; t < nthreads; t++) {
+            csint src = C.p_[bounds[t]],
+                  dst = p[bounds[t]];
+            if (src == dst) {
+                continue;  // the block is already in place
+            }
+            csint len = p[bounds[t+1]] - dst;
+            std::copy(C.i_.begin() + src, C.i_.begin() + src + len, C.i_.begin() + dst);
+            std::copy(C.v_.begin() + src, C.v_.begin() + src + len, C.v_.begin() + dst);
+        }
+    }
+
+    C.p_ = std::move(p);
+    C.realloc();
+
+    C.has_sorted_indices_ = true;
+    C.has_canonical_format_ = true;
+
+    return C;
+}
 
 
 std::vector<double> COOMatrix::to_dense_vector(const char order) const
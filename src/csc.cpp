@@ -10,7 +10,10 @@
 #include <algorithm>  // for std::lower_bound
 #include <cassert>
 #include <cmath>      // for std::fabs
+#include <cstdint>    // for std::uint64_t
 #include <format>
+#include <memory>     // for std::make_shared
+#include <mutex>
 #include <ranges>     // for std::views::reverse
 #include <string>
 #include <sstream>
@@ -18,7 +21,12 @@
 
 #include "utils.h"
 #include "csc.h"
+#include "csr.h"
 #include "coo.h"
+#include "parallel.h"
+#include "simd.h"
+#include "stats.h"
+#include "workspace.h"
 
 namespace cs {
 
@@ -42,6 +50,20 @@ CSCMatrix::CSCMatrix(
 {}
 
 
+CSCMatrix::CSCMatrix(
+    std::vector<double>&& data,
+    std::vector<csint>&& indices,
+    std::vector<csint>&& indptr,
+    const Shape& shape
+    )
+    : v_(std::move(data)),
+      i_(std::move(indices)),
+      p_(std::move(indptr)),
+      M_(shape[0]),
+      N_(shape[1])
+{}
+
+
 CSCMatrix::CSCMatrix(const Shape& shape, csint nzmax, bool values)
     : i_(nzmax),
       p_(shape[1] + 1),
@@ -57,13 +79,7 @@ CSCMatrix::CSCMatrix(const Shape& shape, csint nzmax, bool values)
 }
 
 
-CSCMatrix::CSCMatrix(const COOMatrix& A) : CSCMatrix(A.compress())
-{
-    sum_duplicates();  // O(N) space, O(nnz) time
-    dropzeros();       // O(nnz) time
-    sort();            // O(M) space, O(M + N + nnz) time
-    has_canonical_format_ = true;
-}
+CSCMatrix::CSCMatrix(const COOMatrix& A) : CSCMatrix(A.tocsc()) {}
 
 
 CSCMatrix::CSCMatrix(
@@ -119,6 +135,10 @@ CSCMatrix& CSCMatrix::realloc(csint nzmax)
 {
     csint Z = (nzmax <= 0) ? p_[N_] : nzmax;
 
+    if (Stats *stats = get_stats()) {
+        stats->reallocs++;
+    }
+
     p_.resize(N_ + 1);  // always contains N_ columns + nz
     i_.resize(Z);
     v_.resize(Z);
@@ -216,6 +236,8 @@ const double CSCMatrix::operator()(csint i, csint j) const
 
 double& CSCMatrix::operator()(const csint i, const csint j)
 {
+    invalidate_csr_();
+
     // Assert indices are in-bounds
     assert(i >= 0 && i < M_);
     assert(j >= 0 && j < N_);
@@ -278,6 +300,8 @@ CSCMatrix& CSCMatrix::assign(
     const std::vector<double>& C
     )
 {
+    invalidate_csr_();
+
     assert(C.size() == rows.size() * cols.size());
 
     for (csint i = 0; i < rows.size(); i++) {
@@ -296,6 +320,8 @@ CSCMatrix& CSCMatrix::assign(
     const CSCMatrix& C
     )
 {
+    invalidate_csr_();
+
     assert(C.M_ == rows.size());
     assert(C.N_ == cols.size());
 
@@ -312,6 +338,8 @@ CSCMatrix& CSCMatrix::assign(
 
 double& CSCMatrix::insert(csint i, csint j, double v, csint p)
 {
+    invalidate_csr_();
+
     i_.insert(i_.begin() + p, i);
     v_.insert(v_.begin() + p, v);
 
@@ -358,8 +386,87 @@ std::vector<double> CSCMatrix::to_dense_vector(const char order) const
 }
 
 
+/*------------------------------------------------------------------------------
+ *     CSR Mirror
+ *----------------------------------------------------------------------------*/
+// Serializes all access to the pointers of the mirrors
+static std::mutex csr_mutex;
+
+
+CSCMatrix::CSRCache::CSRCache(const CSRCache& other)
+{
+    std::lock_guard<std::mutex> lock(csr_mutex);
+    ptr = other.ptr;
+}
+
+
+CSCMatrix::CSRCache& CSCMatrix::CSRCache::operator=(const CSRCache& other)
+{
+    if (this != &other) {
+        std::lock_guard<std::mutex> lock(csr_mutex);
+        ptr = other.ptr;
+    }
+    return *this;
+}
+
+
+const CSRMatrix *CSCMatrix::cached_csr_() const
+{
+    std::lock_guard<std::mutex> lock(csr_mutex);
+    return csr_.ptr.get();
+}
+
+
+void CSCMatrix::invalidate_csr_()
+{
+    // Modifying the matrix is not thread-safe anyway, so skip the lock when
+    // there is nothing to discard.
+    if (csr_.ptr) {
+        std::lock_guard<std::mutex> lock(csr_mutex);
+        csr_.ptr.reset();
+    }
+}
+
+
+const CSRMatrix& CSCMatrix::csr() const
+{
+    if (const CSRMatrix *R = cached_csr_()) {
+        return *R;
+    }
+
+    // Build without the lock, so that other mirrors can be built concurrently.
+    // If two threads build the same mirror, the first one is kept.
+    auto R = std::make_shared<const CSRMatrix>(*this);
+
+    std::lock_guard<std::mutex> lock(csr_mutex);
+    if (!csr_.ptr) {
+        csr_.ptr = std::move(R);
+    }
+
+    return *csr_.ptr;
+}
+
+
+bool CSCMatrix::has_csr() const { return cached_csr_() != nullptr; }
+
+
+CSRMatrix CSCMatrix::tocsr() const
+{
+    if (const CSRMatrix *R = cached_csr_()) {
+        return *R;
+    }
+    return CSRMatrix(*this);
+}
+
+
 CSCMatrix CSCMatrix::transpose(bool values) const
 {
+    if (values) {
+        if (const CSRMatrix *R = cached_csr_()) {
+            return R->T();  // copy the mirror
+        }
+    }
+
     std::vector<csint> w(M_);   // workspace
     CSCMatrix C({N_, M_}, nnz(), values);  // output
 
@@ -400,6 +507,8 @@ CSCMatrix CSCMatrix::tsort() const
 
 CSCMatrix& CSCMatrix::qsort()
 {
+    invalidate_csr_();
+
     // Allocate workspaces
     std::vector<csint> w(nnz());
     std::vector<double> x(nnz());
@@ -435,6 +544,8 @@ CSCMatrix& CSCMatrix::qsort()
 
 CSCMatrix& CSCMatrix::sort()
 {
+    invalidate_csr_();
+
     // ----- first transpose
     std::vector<csint> w(M_);   // workspace
     CSCMatrix C({N_, M_}, nnz());  // intermediate transpose
@@ -477,6 +588,8 @@ CSCMatrix& CSCMatrix::sort()
 
 CSCMatrix& CSCMatrix::sum_duplicates()
 {
+    invalidate_csr_();
+
     csint nz = 0;  // count actual number of non-zeros (excluding dups)
     std::vector<csint> w(M_, -1);                      // row i not yet seen
 
@@ -504,6 +617,8 @@ CSCMatrix& CSCMatrix::sum_duplicates()
 
 CSCMatrix& CSCMatrix::fkeep(KeepFunc fk)
 {
+    invalidate_csr_();
+
     csint nz = 0;  // count actual number of non-zeros
 
     for (csint j = 0; j < N_; j++) {
@@ -571,72 +686,162 @@ CSCMatrix CSCMatrix::band(const csint kl, const csint ku) const
 ----------------------------------------------------------------------------*/
 std::vector<double> CSCMatrix::gaxpy(
     const std::vector<double>& x,
-    const std::vector<double>& y
+    const std::vector<double>& y,
+    int threads
+    ) const
+{
+    std::vector<double> out = y;  // copy the input vector
+    gaxpy(std::span<const double>(x), std::span<double>(out), threads);
+    return out;
+};
+
+
+void CSCMatrix::gaxpy(
+    std::span<const double> x,
+    std::span<double> y,
+    int threads
     ) const
 {
     assert(M_ == y.size());  // addition
     assert(N_ == x.size());  // multiplication
 
-    std::vector<double> out = y;  // copy the input vector
+    const int nthreads = resolve_num_threads(threads, nnz());
 
-    for (csint j = 0; j < N_; j++) {
-        for (csint p = p_[j]; p < p_[j+1]; p++) {
-            out[i_[p]] += v_[p] * x[j];
+    if (nthreads == 1) {
+        for (csint j = 0; j < N_; j++) {
+            for (csint p = p_[j]; p < p_[j+1]; p++) {
+                y[i_[p]] += v_[p] * x[j];
+            }
         }
+        return;
     }
 
-    return out;
+    // Each thread scatters its block of columns into its own partial output.
+    // Thread 0 uses the output vector directly.
+    const std::vector<csint> bounds = partition_nnz(p_, nthreads);
+    std::vector<std::vector<double>> partial(nthreads);
+
+    parallel_for(nthreads, [&](int t) {
+        if (t > 0) {
+            partial[t].assign(M_, 0.0);
+        }
+        double *yt = (t == 0) ? y.data() : partial[t].data();
+        for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+            for (csint p = p_[j]; p < p_[j+1]; p++) {
+                yt[i_[p]] += v_[p] * x[j];
+            }
+        }
+    });
+
+    // Reduce the partial outputs over blocks of rows
+    parallel_for(nthreads, [&](int t) {
+        csint start = (M_ * t) / nthreads,
+              end = (M_ * (t + 1)) / nthreads;
+        for (int s = 1; s < nthreads; s++) {
+            for (csint i = start; i < end; i++) {
+                y[i] += partial[s][i];
+            }
+        }
+    });
 };
 
 
 std::vector<double> CSCMatrix::gatxpy(
     const std::vector<double>& x,
-    const std::vector<double>& y
+    const std::vector<double>& y,
+    int threads
+    ) const
+{
+    std::vector<double> out = y;  // copy the input vector
+    gatxpy(std::span<const double>(x), std::span<double>(out), threads);
+    return out;
+};
+
+
+void CSCMatrix::gatxpy(
+    std::span<const double> x,
+    std::span<double> y,
+    int threads
     ) const
 {
     assert(M_ == x.size());  // multiplication
     assert(N_ == y.size());  // addition
 
-    std::vector<double> out = y;  // copy the input vector
+    const int nthreads = resolve_num_threads(threads, nnz());
+    const std::vector<csint> bounds = partition_nnz(p_, nthreads);
 
-    for (csint j = 0; j < N_; j++) {
-        for (csint p = p_[j]; p < p_[j+1]; p++) {
-            out[j] += v_[p] * x[i_[p]];
+    // Each column is an independent dot product, so no reduction is needed
+    parallel_for(nthreads, [&](int t) {
+        for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+            for (csint p = p_[j]; p < p_[j+1]; p++) {
+                y[j] += v_[p] * x[i_[p]];
+            }
         }
-    }
-
-    return out;
+    });
 };
 
 
 std::vector<double> CSCMatrix::sym_gaxpy(
     const std::vector<double>& x,
-    const std::vector<double>& y
+    const std::vector<double>& y,
+    int threads
+    ) const
+{
+    std::vector<double> out = y;  // copy the input vector
+    sym_gaxpy(std::span<const double>(x), std::span<double>(out), threads);
+    return out;
+};
+
+
+void CSCMatrix::sym_gaxpy(
+    std::span<const double> x,
+    std::span<double> y,
+    int threads
     ) const
 {
     assert(M_ == N_);  // matrix must be square to be symmetric
     assert(N_ == x.size());
     assert(x.size() == y.size());
 
-    std::vector<double> out = y;  // copy the input vector
+    const int nthreads = resolve_num_threads(threads, nnz());
+    const std::vector<csint> bounds = partition_nnz(p_, nthreads);
+    std::vector<std::vector<double>> partial(nthreads);
 
-    for (csint j = 0; j < N_; j++) {
-        for (csint p = p_[j]; p < p_[j+1]; p++) {
-            csint i = i_[p];
+    parallel_for(nthreads, [&](int t) {
+        if (t > 0) {
+            partial[t].assign(M_, 0.0);
+        }
+        double *yt = (t == 0) ? y.data() : partial[t].data();
 
-            if (i > j)
-                continue;  // skip lower triangular
+        for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+            for (csint p = p_[j]; p < p_[j+1]; p++) {
+                csint i = i_[p];
 
-            // Add the upper triangular elements
-            out[i] += v_[p] * x[j];
+                if (i > j)
+                    continue;  // skip lower triangular
 
-            // If off-diagonal, also add the symmetric element
-            if (i < j)
-                out[j] += v_[p] * x[i];
+                // Add the upper triangular elements
+                yt[i] += v_[p] * x[j];
+
+                // If off-diagonal, also add the symmetric element
+                if (i < j)
+                    yt[j] += v_[p] * x[i];
+            }
         }
+    });
+
+    // Reduce the partial outputs over blocks of rows
+    if (nthreads > 1) {
+        parallel_for(nthreads, [&](int t) {
+            csint start = (M_ * t) / nthreads,
+                  end = (M_ * (t + 1)) / nthreads;
+            for (int s = 1; s < nthreads; s++) {
+                for (csint i = start; i < end; i++) {
+                    y[i] += partial[s][i];
+                }
+            }
+        });
     }
-
-    return out;
 };
 
 
@@ -722,17 +927,17 @@ std::vector<double> CSCMatrix::gaxpy_row(
 
     csint K = X.size() / N_;  // number of columns in X
 
-    // For each column of X
-    for (csint k = 0; k < K; k++) {
-        // Compute one column of Y (see gaxpy)
-        for (csint j = 0; j < N_; j++) {
-            double x_val = X[k + j * K];  // cache value (row-major indexing)
-
-            // Only compute if x_val is non-zero
-            if (x_val != 0.0) {
-                for (csint p = p_[j]; p < p_[j+1]; p++) {
-                    // Indexing in row-major order
-                    out[k + i_[p] * K] += v_[p] * x_val;
+    // Each entry A(i, j) updates the contiguous row Y(i, :) with X(j, :).
+    // The entries are applied to each Y(i, k) in the same order as computing
+    // one column of Y at a time (see gaxpy).
+    for (csint j = 0; j < N_; j++) {
+        const double *Xj = X.data() + j * K;  // row-major indexing
+        for (csint p = p_[j]; p < p_[j+1]; p++) {
+            double *Yi = out.data() + i_[p] * K;
+            for (csint k = 0; k < K; k++) {
+                // Only compute if X(j, k) is non-zero
+                if (Xj[k] != 0.0) {
+                    Yi[k] += v_[p] * Xj[k];
                 }
             }
         }
@@ -814,13 +1019,14 @@ std::vector<double> CSCMatrix::gatxpy_row(
 
     csint K = X.size() / M_;  // number of columns in X
 
-    // For each column of X
-    for (csint k = 0; k < K; k++) {
-        // Compute one column of Y (see gaxpy)
-        for (csint j = 0; j < N_; j++) {
-            for (csint p = p_[j]; p < p_[j+1]; p++) {
-                // Indexing in row-major order
-                out[k + j * K] += v_[p] * X[k + i_[p] * K];
+    // Each entry A(i, j) updates the contiguous row Y(j, :) with X(i, :),
+    // in the same order as computing one column of Y at a time.
+    for (csint j = 0; j < N_; j++) {
+        double *Yj = out.data() + j * K;  // row-major indexing
+        for (csint p = p_[j]; p < p_[j+1]; p++) {
+            const double *Xi = X.data() + i_[p] * K;
+            for (csint k = 0; k < K; k++) {
+                Yj[k] += v_[p] * Xi[k];
             }
         }
     }
@@ -829,16 +1035,35 @@ std::vector<double> CSCMatrix::gatxpy_row(
 }
 
 
-CSCMatrix CSCMatrix::scale(const std::vector<double>& r, const std::vector<double> c) const
+std::vector<double> CSCMatrix::gaxpy_simd(
+    const std::vector<double>& X,
+    const std::vector<double>& Y
+    ) const
 {
-    assert(r.size() == M_);
-    assert(c.size() == N_);
+    assert(X.size() % N_ == 0);  // check that X.size() is a multiple of N_
+    assert(Y.size() == M_ * (X.size() / N_));
 
-    CSCMatrix out(*this);
+    std::vector<double> out = Y;  // copy the input matrix
+
+    const csint K = X.size() / N_;  // number of columns in X
+    const csint W = simd::width;
 
     for (csint j = 0; j < N_; j++) {
+        const double *xj = X.data() + j * K;  // row j of X
+
         for (csint p = p_[j]; p < p_[j+1]; p++) {
-            out.v_[p] *= r[i_[p]] * c[j];
+            const double a = v_[p];
+            const simd::vec va = simd::set1(a);
+            double *yi = out.data() + i_[p] * K;  // row i of Y
+
+            // Y(i, :) += A(i, j) * X(j, :)
+            csint k = 0;
+            for (; k + W <= K; k += W) {
+                simd::store(yi + k, simd::fmadd(va, simd::load(xj + k), simd::load(yi + k)));
+            }
+            for (; k < K; k++) {
+                yi[k] += a * xj[k];
+            }
         }
     }
 
@@ -846,22 +1071,110 @@ CSCMatrix CSCMatrix::scale(const std::vector<double>& r, const std::vector<doubl
 }
 
 
-std::vector<double> CSCMatrix::dot(const std::vector<double>& x) const
+std::vector<double> CSCMatrix::gatxpy_simd(
+    const std::vector<double>& X,
+    const std::vector<double>& Y
+    ) const
 {
-    assert(N_ == x.size());
+    assert(X.size() % M_ == 0);  // check that X.size() is a multiple of M_
+    assert(Y.size() == N_ * (X.size() / M_));
 
-    std::vector<double> out(M_);
+    std::vector<double> out = Y;  // copy the input matrix
+
+    const csint K = X.size() / M_;  // number of columns in X
+    const csint W = simd::width;
+    const csint T = 4 * W;           // tile of 4 vector registers
+
+    for (csint j = 0; j < N_; j++) {
+        double *yj = out.data() + j * K;  // row j of Y
+
+        // Y(j, k:k+T) += A(:, j).T X(:, k:k+T) in registers
+        csint k = 0;
+        for (; k + T <= K; k += T) {
+            simd::vec acc0 = simd::load(yj + k),
+                      acc1 = simd::load(yj + k + W),
+                      acc2 = simd::load(yj + k + 2*W),
+                      acc3 = simd::load(yj + k + 3*W);
+
+            for (csint p = p_[j]; p < p_[j+1]; p++) {
+                const simd::vec va = simd::set1(v_[p]);
+                const double *xi = X.data() + i_[p] * K + k;  // row i of X
+                acc0 = simd::fmadd(va, simd::load(xi), acc0);
+                acc1 = simd::fmadd(va, simd::load(xi + W), acc1);
+                acc2 = simd::fmadd(va, simd::load(xi + 2*W), acc2);
+                acc3 = simd::fmadd(va, simd::load(xi + 3*W), acc3);
+            }
+
+            simd::store(yj + k, acc0);
+            simd::store(yj + k + W, acc1);
+            simd::store(yj + k + 2*W, acc2);
+            simd::store(yj + k + 3*W, acc3);
+        }
+
+        // Remaining full vectors
+        for (; k + W <= K; k += W) {
+            simd::vec acc = simd::load(yj + k);
+            for (csint p = p_[j]; p < p_[j+1]; p++) {
+                acc = simd::fmadd(simd::set1(v_[p]), simd::load(X.data() + i_[p] * K + k), acc);
+            }
+            simd::store(yj + k, acc);
+        }
+
+        // Scalar remainder
+        for (; k < K; k++) {
+            double acc = yj[k];
+            for (csint p = p_[j]; p < p_[j+1]; p++) {
+                acc += v_[p] * X[i_[p] * K + k];
+            }
+            yj[k] = acc;
+        }
+    }
+
+    return out;
+}
+
+
+CSCMatrix CSCMatrix::scale(const std::vector<double>& r, const std::vector<double>& c) const
+{
+    CSCMatrix out(*this);
+    out.scale_inplace(r, c);
+    return out;
+}
+
+
+CSCMatrix& CSCMatrix::scale_inplace(std::span<const double> r, std::span<const double> c)
+{
+    invalidate_csr_();
+
+    assert(r.size() == M_);
+    assert(c.size() == N_);
 
     for (csint j = 0; j < N_; j++) {
         for (csint p = p_[j]; p < p_[j+1]; p++) {
-            out[i_[p]] += v_[p] * x[j];
+            v_[p] *= r[i_[p]] * c[j];
         }
     }
 
+    return *this;
+}
+
+
+std::vector<double> CSCMatrix::dot(const std::vector<double>& x) const
+{
+    std::vector<double> out(M_);
+    dot(std::span<const double>(x), std::span<double>(out), 1);
     return out;
 }
 
 
+void CSCMatrix::dot(std::span<const double> x, std::span<double> y, int threads) const
+{
+    assert(M_ == static_cast<csint>(y.size()));
+    std::fill(y.begin(), y.end(), 0.0);
+    gaxpy(x, y, threads);
+}
+
+
 CSCMatrix CSCMatrix::dot(const double c) const
 {
     CSCMatrix out(v_, i_, p_, shape());
@@ -870,107 +1183,220 @@ CSCMatrix CSCMatrix::dot(const double c) const
 }
 
 
-CSCMatrix CSCMatrix::dot(const CSCMatrix& B) const
-{
-    auto [M, Ka] = shape();
-    auto [Kb, N] = B.shape();
-    assert(Ka == Kb);
-
-    // NOTE See Problem 2.20 for how to compute nnz(A*B)
-    CSCMatrix C({M, N}, nnz() + B.nnz());  // output
-
-    // Allocate workspaces
-    std::vector<csint> w(M);
-    std::vector<double> x(M);
+CSCMatrix CSCMatrix::dot(const CSCMatrix& B) const { return dot_2x(B); }
 
-    csint nz = 0;  // track total number of non-zeros in C
 
-    bool fs = true;  // Exercise 2.19 -- first call to scatter
+namespace {
 
-    for (csint j = 0; j < N; j++) {
-        if (nz + M > C.nzmax()) {
-            C.realloc(2 * C.nzmax() + M);  // double the size of C
+/** An open-addressing hash table that accumulates one column of a product.
+ *
+ * The table is sized for the largest column it will accumulate, and only the
+ * slots used by a column are reset when the column is done, so each column
+ * costs time proportional to its own work.
+ */
+class HashAccumulator
+{
+    std::vector<csint> keys_;   // row index in each slot, or -1 if empty
+    std::vector<double> vals_;  // accumulated value in each slot
+    std::vector<csint> used_;   // slots used by the current column
+    int shift_;                 // 64 - log2(table size)
+
+    csint slot_(csint i) const
+    {
+        // Fibonacci hashing of the row index
+        std::uint64_t h = static_cast<std::uint64_t>(i) * 0x9E3779B97F4A7C15ULL;
+        csint k = static_cast<csint>(h >> shift_);
+
+        while (keys_[k] != -1 && keys_[k] != i) {
+            k = (k + 1) & (static_cast<csint>(keys_.size()) - 1);  // linear probing
         }
 
-        C.p_[j] = nz;  // column j of C starts here
+        return k;
+    }
 
-        // Compute x = A @ B[:, j]
-        for (csint p = B.p_[j]; p < B.p_[j+1]; p++) {
-            // Compute x += A[:, B.i_[p]] * B.v_[p]
-            nz = scatter(B.i_[p], B.v_[p], w, x, j+1, C, nz, fs);
-            fs = false;
+    public:
+        /** Allocate a table for columns with at most `capacity` updates. */
+        HashAccumulator(csint capacity)
+        {
+            int bits = 4;
+            while ((csint {1} << bits) < 2 * capacity) {
+                bits++;
+            }
+            keys_.assign(csint {1} << bits, -1);
+            vals_.resize(keys_.size());
+            used_.reserve(capacity);
+            shift_ = 64 - bits;
         }
 
-        // Gather values into the correct locations in C
-        for (csint p = C.p_[j]; p < nz; p++) {
-            C.v_[p] = x[C.i_[p]];
+        /** Compute `x[i] = v` if `i` is new, or `x[i] += v` otherwise.
+         *
+         * @return true if `i` is a new entry in the column
+         */
+        bool add(csint i, double v)
+        {
+            csint k = slot_(i);
+            if (keys_[k] == -1) {
+                keys_[k] = i;
+                vals_[k] = v;
+                used_.push_back(k);
+                return true;
+            }
+            vals_[k] += v;
+            return false;
         }
-    }
 
-    // Finalize and deallocate unused memory
-    C.p_[N] = nz;
-    C.realloc();
+        /** Return the accumulated value of row `i`, which must be present. */
+        double get(csint i) const { return vals_[slot_(i)]; }
 
-    return C;
-}
+        /** Empty the table for the next column. */
+        void clear()
+        {
+            for (csint k : used_) {
+                keys_[k] = -1;
+            }
+            used_.clear();
+        }
+};
 
+}  // namespace
 
-CSCMatrix CSCMatrix::dot_2x(const CSCMatrix& B) const
+
+CSCMatrix CSCMatrix::dot_2x(
+    const CSCMatrix& B,
+    int threads,
+    SpGEMMAccumulator acc
+) const
 {
     auto [M, Ka] = shape();
     auto [Kb, N] = B.shape();
     assert(Ka == Kb);
 
-    // Allocate workspace
-    std::vector<csint> w(M);
-
-    // Compute nnz(A*B) by counting non-zeros in each column of C
-    csint nz_C = 0;
+    // Count the multiplications in each column of C, an upper bound on its
+    // number of non-zeros
+    std::vector<csint> flops(N);
 
     for (csint j = 0; j < N; j++) {
-        csint mark = j + 1;
         for (csint p = B.p_[j]; p < B.p_[j+1]; p++) {
-            // Scatter, but without x or C
             csint k = B.i_[p];  // B(k, j) is non-zero
-            for (csint pa = p_[k]; pa < p_[k+1]; pa++) {
-                csint i = i_[pa];     // A(i, k) is non-zero
-                if (w[i] < mark) {
-                    w[i] = mark;     // i is new entry in column k
-                    nz_C++;         // count non-zeros in C, but don't compute
+            flops[j] += p_[k+1] - p_[k];
+        }
+    }
+
+    // Split the columns of C into blocks with about equal work
+    std::vector<csint> work = cumsum(flops, threads);
+    int nthreads = resolve_num_threads(threads, work[N]);
+    std::vector<csint> bounds = partition_nnz(work, nthreads);
+
+    if (acc == SpGEMMAccumulator::Auto) {
+        acc = (M * nthreads > work[N]) ? SpGEMMAccumulator::Hash
+                                       : SpGEMMAccumulator::Dense;
+    }
+
+    // The largest column of each block sizes its hash table
+    auto max_flops = [&](int t) {
+        csint f = 0;
+        for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+            f = std::max(f, std::min(flops[j], M));
+        }
+        return f;
+    };
+
+    // Compute nnz(A*B) by counting non-zeros in each column of C
+    std::vector<csint> counts(N);
+
+    parallel_for(nthreads, [&](int t) {
+        if (acc == SpGEMMAccumulator::Dense) {
+            auto w = get_workspace().fill<csint>(M, 0);  // workspace
+
+            for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+                csint mark = j + 1;
+                csint nz = 0;
+                for (csint p = B.p_[j]; p < B.p_[j+1]; p++) {
+                    // Scatter, but without x or C
+                    csint k = B.i_[p];  // B(k, j) is non-zero
+                    for (csint pa = p_[k]; pa < p_[k+1]; pa++) {
+                        csint i = i_[pa];     // A(i, k) is non-zero
+                        if (w[i] < mark) {
+                            w[i] = mark;     // i is new entry in column j
+                            nz++;           // count non-zeros in C, but don't compute
+                        }
+                    }
+                }
+                counts[j] = nz;
+            }
+        } else {
+            HashAccumulator h(max_flops(t));
+
+            for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+                csint nz = 0;
+                for (csint p = B.p_[j]; p < B.p_[j+1]; p++) {
+                    csint k = B.i_[p];
+                    for (csint pa = p_[k]; pa < p_[k+1]; pa++) {
+                        nz += h.add(i_[pa], 0.0);
+                    }
                 }
+                counts[j] = nz;
+                h.clear();
             }
         }
-    }
+    });
 
     // Allocate the correct size output matrix
-    CSCMatrix C({M, N}, nz_C);
+    std::vector<csint> Cp = cumsum(counts, threads);
+    CSCMatrix C({M, N}, Cp[N]);
+    C.p_ = std::move(Cp);
 
     // Compute the actual multiplication
-    std::fill(w.begin(), w.end(), 0);  // reset workspace
-    std::vector<double> x(M);
-
-    csint nz = 0;  // track total number of non-zeros in C
-    bool fs = true;  // first call to scatter
+    parallel_for(nthreads, [&](int t) {
+        if (acc == SpGEMMAccumulator::Dense) {
+            // Borrow the workspaces of this thread. Each column leaves x all
+            // zero again.
+            Workspace& ws = get_workspace();
+            auto w = ws.fill<csint>(M, 0);
+            auto x = ws.zeros<double>(M);
+
+            for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+                csint nz = C.p_[j];  // column j of C starts here
+
+                // Compute x = A @ B[:, j]
+                for (csint p = B.p_[j]; p < B.p_[j+1]; p++) {
+                    // Compute x += A[:, B.i_[p]] * B.v_[p]
+                    nz = scatter(B.i_[p], B.v_[p], *w, *x, j+1, C, nz);
+                }
 
-    for (csint j = 0; j < N; j++) {
-        C.p_[j] = nz;  // column j of C starts here
+                // Gather values into the correct locations in C
+                for (csint p = C.p_[j]; p < nz; p++) {
+                    C.v_[p] = x[C.i_[p]];
+                    x[C.i_[p]] = 0;
+                }
+            }
+        } else {
+            HashAccumulator h(max_flops(t));
+
+            for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+                csint nz = C.p_[j];
+
+                // Accumulate A @ B[:, j], recording the pattern in the same
+                // order as the dense scatter
+                for (csint p = B.p_[j]; p < B.p_[j+1]; p++) {
+                    csint k = B.i_[p];
+                    double beta = B.v_[p];
+                    for (csint pa = p_[k]; pa < p_[k+1]; pa++) {
+                        csint i = i_[pa];
+                        if (h.add(i, beta * v_[pa])) {
+                            C.i_[nz++] = i;
+                        }
+                    }
+                }
 
-        // Compute x = A @ B[:, j]
-        for (csint p = B.p_[j]; p < B.p_[j+1]; p++) {
-            // Compute x += A[:, B.i_[p]] * B.v_[p]
-            nz = scatter(B.i_[p], B.v_[p], w, x, j+1, C, nz, fs);
-            fs = false;
-        }
+                for (csint p = C.p_[j]; p < nz; p++) {
+                    C.v_[p] = h.get(C.i_[p]);
+                }
 
-        // Gather values into the correct locations in C
-        for (csint p = C.p_[j]; p < nz; p++) {
-            C.v_[p] = x[C.i_[p]];
+                h.clear();
+            }
         }
-    }
-
-    // Finalize and deallocate unused memory
-    C.p_[N] = nz;
-    C.realloc();
+    });
 
     return C;
 }
@@ -1030,35 +1456,7 @@ CSCMatrix add_scaled(
     double beta=1.0
     )
 {
-    assert(A.shape() == B.shape());
-    auto [M, N] = A.shape();
-
-    CSCMatrix C({M, N}, A.nnz() + B.nnz());  // output
-
-    // Allocate workspaces
-    std::vector<csint> w(M);
-    std::vector<double> x(M);
-
-    csint nz = 0;    // track total number of non-zeros in C
-    bool fs = true;  // Exercise 2.19 -- first call to scatter
-
-    for (csint j = 0; j < N; j++) {
-        C.p_[j] = nz;  // column j of C starts here
-        nz = A.scatter(j, alpha, w, x, j+1, C, nz, fs);  // alpha * A(:, j)
-        fs = false;
-        nz = B.scatter(j,  beta, w, x, j+1, C, nz, fs);  //  beta * B(:, j)
-
-        // Gather results into the correct column of C
-        for (csint p = C.p_[j]; p < nz; p++) {
-            C.v_[p] = x[C.i_[p]];
-        }
-    }
-
-    // Finalize and deallocate unused memory
-    C.p_[N] = nz;
-    C.realloc();
-
-    return C;
+    return LinearCombination(A, alpha) + LinearCombination(B, beta);
 }
 
 
@@ -1109,6 +1507,86 @@ CSCMatrix operator+(const CSCMatrix& A, const CSCMatrix& B) { return A.add(B); }
 CSCMatrix operator-(const CSCMatrix& A, const CSCMatrix& B) { return A.subtract(B); }
 
 
+/*------------------------------------------------------------------------------
+ *          Linear Combinations
+ *----------------------------------------------------------------------------*/
+LinearCombination::LinearCombination(const CSCMatrix& A, double alpha)
+    : alpha_{alpha}, terms_{&A}
+{}
+
+
+LinearCombination::LinearCombination(CSCMatrix&& A, double alpha)
+    : alpha_{alpha},
+      owned_{std::make_shared<const CSCMatrix>(std::move(A))}
+{
+    terms_.push_back(owned_.front().get());
+}
+
+
+LinearCombination& LinearCombination::operator+=(const LinearCombination& other)
+{
+    if (shape() != other.shape()) {
+        throw std::invalid_argument("Matrix shapes must match.");
+    }
+
+    alpha_.insert(alpha_.end(), other.alpha_.begin(), other.alpha_.end());
+    terms_.insert(terms_.end(), other.terms_.begin(), other.terms_.end());
+    owned_.insert(owned_.end(), other.owned_.begin(), other.owned_.end());
+
+    return *this;
+}
+
+
+LinearCombination& LinearCombination::operator*=(double c)
+{
+    for (auto& a : alpha_) {
+        a *= c;
+    }
+    return *this;
+}
+
+
+CSCMatrix LinearCombination::eval() const
+{
+    auto [M, N] = shape();
+
+    csint nzmax = 0;
+    for (const auto& A : terms_) {
+        nzmax += A->nnz();
+    }
+
+    CSCMatrix C({M, N}, nzmax);  // output
+
+    // Allocate workspaces
+    std::vector<csint> w(M);
+    std::vector<double> x(M);
+
+    csint nz = 0;  // track total number of non-zeros in C
+    const bool fs = terms_.front()->has_canonical_format_;
+
+    for (csint j = 0; j < N; j++) {
+        C.p_[j] = nz;  // column j of C starts here
+
+        // Scatter alpha_k * A_k(:, j) for every term. The first term is
+        // copied without checking for duplicates if it has none (Exercise 2.19).
+        for (std::size_t k = 0; k < terms_.size(); k++) {
+            nz = terms_[k]->scatter(j, alpha_[k], w, x, j+1, C, nz, k == 0 && fs);
+        }
+
+        // Gather results into the correct column of C
+        for (csint p = C.p_[j]; p < nz; p++) {
+            C.v_[p] = x[C.i_[p]];
+        }
+    }
+
+    // Finalize and deallocate unused memory
+    C.p_[N] = nz;
+    C.realloc();
+
+    return C;
+}
+
+
 csint CSCMatrix::scatter(
     csint j,
     double beta,
@@ -1247,6 +1725,49 @@ CSCMatrix CSCMatrix::symperm(const std::vector<csint> p_inv, bool values) const
 }
 
 
+CSCMatrix CSCMatrix::symperm_map(
+    const std::vector<csint>& p_inv,
+    std::vector<csint>& map
+) const
+{
+    assert(M_ == N_);  // matrix must be square. Symmetry not checked.
+
+    std::vector<csint> w(N_);  // workspace for column counts
+
+    // Count entries in each column of C
+    for (csint j = 0; j < N_; j++) {
+        csint j2 = p_inv[j];
+        for (csint p = p_[j]; p < p_[j+1]; p++) {
+            csint i = i_[p];
+            if (i <= j) {
+                w[std::max(p_inv[i], j2)]++;
+            }
+        }
+    }
+
+    std::vector<csint> Cp = cumsum(w);
+    w = Cp;
+
+    std::vector<csint> Ci(Cp.back());
+    map.resize(Cp.back());
+
+    for (csint j = 0; j < N_; j++) {
+        csint j2 = p_inv[j];
+        for (csint p = p_[j]; p < p_[j+1]; p++) {
+            csint i = i_[p];
+            if (i <= j) {
+                csint i2 = p_inv[i];
+                csint q = w[std::max(i2, j2)]++;
+                Ci[q] = std::min(i2, j2);
+                map[q] = p;
+            }
+        }
+    }
+
+    return CSCMatrix(std::vector<double>{}, std::move(Ci), std::move(Cp), {N_, N_});
+}
+
+
 CSCMatrix CSCMatrix::permute_transpose(
     const std::vector<csint>& p_inv,
     const std::vector<csint>& q_inv,
@@ -1419,6 +1940,14 @@ CSCMatrix CSCMatrix::slice(
     assert((i_start >= 0) && (i_end <= M_) && (i_start < i_end));
     assert((j_start >= 0) && (j_end <= N_) && (j_start < j_end));
 
+    // Traverse the rows of the mirror if they have fewer entries
+    if (const CSRMatrix *R = cached_csr_()) {
+        const std::vector<csint>& Rp = R->indptr();
+        if (Rp[i_end] - Rp[i_start] < p_[j_end] - p_[j_start]) {
+            return R->slice(i_start, i_end, j_start, j_end);
+        }
+    }
+
     CSCMatrix C({i_end - i_start, j_end - j_start}, nnz());
 
     csint nz = 0;
@@ -1454,6 +1983,14 @@ CSCMatrix CSCMatrix::index(
     const std::vector<csint>& cols
     ) const
 {
+    // Gather the selected rows of the mirror, instead of searching every
+    // selected column for every selected row
+    if (has_canonical_format_) {
+        if (const CSRMatrix *R = cached_csr_()) {
+            return R->index(rows, cols);
+        }
+    }
+
     csint M = rows.size();
     csint N = cols.size();
     CSCMatrix C({M, N}, nnz());
@@ -1526,6 +2063,11 @@ CSCMatrix CSCMatrix::add_empty_right(const csint k) const
 
 std::vector<double> CSCMatrix::sum_rows() const
 {
+    // Each row of the mirror is a contiguous sum, in the same order
+    if (const CSRMatrix *R = cached_csr_()) {
+        return R->sum_rows();
+    }
+
     std::vector<double> out(M_, 0.0);
 
     for (csint j = 0; j < N_; j++) {
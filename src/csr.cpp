@@ -0,0 +1,304 @@
+/*==============================================================================
+ *     File: csr.cpp
+ *  Created: 2025-03-26 08:40
+ *   Author: Bernie Roesler
+ *
+ *  Description: Implements the compressed sparse row matrix class.
+ *
+ *============================================================================*/
+
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
+#include "csc.h"
+#include "csr.h"
+#include "utils.h"  // cumsum
+
+namespace cs {
+
+/*------------------------------------------------------------------------------
+ *     Constructors
+ *----------------------------------------------------------------------------*/
+CSRMatrix::CSRMatrix() {}
+
+
+CSRMatrix::CSRMatrix(
+    const std::vector<double>& data,
+    const std::vector<csint>& indices,
+    const std::vector<csint>& indptr,
+    const Shape& shape
+    )
+    : AT_(data, indices, indptr, Shape {shape[1], shape[0]})
+{}
+
+
+CSRMatrix::CSRMatrix(const CSCMatrix& A) : AT_(A.transpose())
+{
+    // The transpose traverses the columns in order, so each row is sorted
+    AT_.has_sorted_indices_ = true;
+    AT_.has_canonical_format_ = A.has_canonical_format_;
+}
+
+
+/*------------------------------------------------------------------------------
+ *     Format Operations
+ *----------------------------------------------------------------------------*/
+CSCMatrix CSRMatrix::tocsc() const
+{
+    CSCMatrix A = AT_.transpose();
+    A.has_sorted_indices_ = true;
+    A.has_canonical_format_ = AT_.has_canonical_format_;
+    return A;
+}
+
+
+std::vector<double> CSRMatrix::to_dense_vector(const char order) const
+{
+    // The transpose in row-major order is this matrix in column-major order
+    char t_order = (order == 'F') ? 'C' : (order == 'C') ? 'F' : order;
+    return AT_.to_dense_vector(t_order);
+}
+
+
+/*------------------------------------------------------------------------------
+ *     Math Operations
+ *----------------------------------------------------------------------------*/
+std::vector<double> CSRMatrix::gaxpy(
+    const std::vector<double>& x,
+    const std::vector<double>& y,
+    int threads
+    ) const
+{
+    return AT_.gatxpy(x, y, threads);
+}
+
+
+void CSRMatrix::gaxpy(std::span<const double> x, std::span<double> y, int threads) const
+{
+    AT_.gatxpy(x, y, threads);
+}
+
+
+std::vector<double> CSRMatrix::gatxpy(
+    const std::vector<double>& x,
+    const std::vector<double>& y,
+    int threads
+    ) const
+{
+    return AT_.gaxpy(x, y, threads);
+}
+
+
+void CSRMatrix::gatxpy(std::span<const double> x, std::span<double> y, int threads) const
+{
+    AT_.gaxpy(x, y, threads);
+}
+
+
+std::vector<double> CSRMatrix::dot(const std::vector<double>& x) const
+{
+    std::vector<double> y(AT_.N_);
+    AT_.gatxpy(std::span<const double>(x), std::span<double>(y), 1);
+    return y;
+}
+
+
+std::vector<double> CSRMatrix::gaxpy_row(
+    const std::vector<double>& X,
+    const std::vector<double>& Y
+    ) const
+{
+    return AT_.gatxpy_simd(X, Y);
+}
+
+
+std::vector<double> CSRMatrix::gatxpy_row(
+    const std::vector<double>& X,
+    const std::vector<double>& Y
+    ) const
+{
+    return AT_.gaxpy_simd(X, Y);
+}
+
+
+std::vector<double> CSRMatrix::sum_rows() const { return AT_.sum_cols(); }
+std::vector<double> CSRMatrix::sum_cols() const { return AT_.sum_rows(); }
+
+
+/*------------------------------------------------------------------------------
+ *     Indexing
+ *----------------------------------------------------------------------------*/
+CSCMatrix CSRMatrix::slice(
+    const csint i_start,
+    const csint i_end,
+    const csint j_start,
+    const csint j_end
+    ) const
+{
+    // Slice the columns of the transpose, and transpose the result back
+    CSCMatrix C = AT_.slice(j_start, j_end, i_start, i_end).transpose();
+    C.has_sorted_indices_ = true;
+    C.has_canonical_format_ = true;
+    return C;
+}
+
+
+CSCMatrix CSRMatrix::index(
+    const std::vector<csint>& rows,
+    const std::vector<csint>& cols
+    ) const
+{
+    csint N = AT_.M_;
+    csint Mr = rows.size(),
+          Nc = cols.size();
+
+    // The positions in `cols` of each column of A
+    std::vector<csint> count(N, 0);
+    for (const auto& j : cols) {
+        assert(j >= 0 && j < N);
+        count[j]++;
+    }
+
+    std::vector<csint> col_ptr = cumsum(count);
+    std::vector<csint> next(col_ptr.begin(), col_ptr.end() - 1);
+    std::vector<csint> col_pos(Nc);
+    for (csint c = 0; c < Nc; c++) {
+        col_pos[next[cols[c]]++] = c;
+    }
+
+    // Count the entries of each selected row
+    csint nz = 0;
+    for (const auto& i : rows) {
+        assert(i >= 0 && i < AT_.N_);
+        for (csint p = AT_.p_[i]; p < AT_.p_[i+1]; p++) {
+            if (AT_.v_[p] != 0) {
+                nz += count[AT_.i_[p]];
+            }
+        }
+    }
+
+    // Gather the rows into the transpose of the result
+    CSCMatrix CT({Nc, Mr}, nz);
+    nz = 0;
+
+    for (csint k = 0; k < Mr; k++) {
+        CT.p_[k] = nz;
+        csint i = rows[k];
+        for (csint p = AT_.p_[i]; p < AT_.p_[i+1]; p++) {
+            if (AT_.v_[p] != 0) {
+                csint j = AT_.i_[p];
+                for (csint q = col_ptr[j]; q < col_ptr[j+1]; q++) {
+                    CT.i_[nz] = col_pos[q];
+                    CT.v_[nz] = AT_.v_[p];
+                    nz++;
+                }
+            }
+        }
+    }
+
+    CT.p_[Mr] = nz;
+
+    // The transpose sorts the columns
+    CSCMatrix C = CT.transpose();
+    C.has_sorted_indices_ = true;
+    C.has_canonical_format_ = AT_.has_canonical_format_;
+
+    return C;
+}
+
+
+/*------------------------------------------------------------------------------
+ *          Row-Permuted Triangular Solves
+ *----------------------------------------------------------------------------*/
+/** Solve a row-permuted triangular system stored by rows.
+ *
+ * @param A  the matrix
+ * @param b  the right-hand side
+ * @param lower  if true, the diagonal of each row is its largest column
+ *        index, and the unknowns are computed in increasing order. Otherwise,
+ *        it is the smallest column index, in decreasing order.
+ *
+ * @return x  the solution
+ */
+static std::vector<double> trisolve_rows(
+    const CSRMatrix& A,
+    const std::vector<double>& b,
+    bool lower
+)
+{
+    auto [M, N] = A.shape();
+    assert(M == N);
+    assert(M == static_cast<csint>(b.size()));
+
+    const std::vector<csint>& Ap = A.indptr();
+    const std::vector<csint>& Aj = A.indices();
+    const std::vector<double>& Ax = A.data();
+
+    const char *msg = lower
+        ? "Matrix is not a permuted lower triangular matrix!"
+        : "Matrix is not a permuted upper triangular matrix!";
+
+    // Find the diagonal of each row, and the row of each unknown
+    std::vector<csint> diag_row(N, -1),  // the row whose diagonal is column k
+                       p_diag(M);        // the position of the diagonal of row r
+
+    for (csint r = 0; r < M; r++) {
+        if (Ap[r] == Ap[r+1]) {
+            throw std::runtime_error(msg);
+        }
+
+        csint d = Ap[r];
+        for (csint p = Ap[r] + 1; p < Ap[r+1]; p++) {
+            if (lower ? (Aj[p] > Aj[d]) : (Aj[p] < Aj[d])) {
+                d = p;
+            }
+        }
+
+        csint k = Aj[d];
+        if (diag_row[k] != -1) {
+            throw std::runtime_error(msg);
+        }
+
+        diag_row[k] = r;
+        p_diag[r] = d;
+    }
+
+    // Each unknown is a dot product with its row
+    std::vector<double> x(N);
+
+    for (csint s = 0; s < N; s++) {
+        csint k = lower ? s : N - 1 - s;
+        csint r = diag_row[k],
+              d = p_diag[r];
+
+        double xk = b[k];  // b is in the order of the triangular matrix
+        for (csint p = Ap[r]; p < Ap[r+1]; p++) {
+            if (p != d) {
+                xk -= Ax[p] * x[Aj[p]];
+            }
+        }
+
+        x[k] = xk / Ax[d];
+    }
+
+    return x;
+}
+
+
+std::vector<double> lsolve_rows(const CSRMatrix& A, const std::vector<double>& b)
+{
+    return trisolve_rows(A, b, true);
+}
+
+
+std::vector<double> usolve_rows(const CSRMatrix& A, const std::vector<double>& b)
+{
+    return trisolve_rows(A, b, false);
+}
+
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/
@@ -0,0 +1,1171 @@
+/*==============================================================================
+ *     File: io.cpp
+ *  Created: 2025-03-14 14:05
+ *   Author: Bernie Roesler
+ *
+ *  Description: Implements reading and writing matrices in the Matrix Market
+ *      and native binary file formats, and factorizations in the native
+ *      factor file format.
+ *
+ *============================================================================*/
+
+#include <algorithm>  // std::transform, std::copy
+#include <bit>        // std::bit_cast
+#include <cctype>     // std::isspace, std::tolower
+#include <charconv>   // std::from_chars
+#include <cstddef>    // offsetof
+#include <cstdio>     // std::rename, std::remove
+#include <cstdlib>    // std::strtod
+#include <cstring>    // std::memcmp, std::memcpy
+#include <exception>  // std::exception_ptr
+#include <format>
+#include <fstream>
+#include <numeric>    // std::accumulate
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>    // std::pair
+#include <vector>
+
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // fstat
+#include <unistd.h>    // close
+
+#include "io.h"
+#include "cholesky.h"
+#include "coo.h"
+#include "csc.h"
+#include "parallel.h"
+#include "qr.h"
+#include "utils.h"
+
+namespace cs {
+
+/*------------------------------------------------------------------------------
+ *         Helpers
+ *----------------------------------------------------------------------------*/
+namespace {
+
+/** A read-only memory mapping of an entire file. */
+class MappedFile
+{
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+
+    public:
+        MappedFile(const std::string& filename)
+        {
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Could not open file: " + filename);
+            }
+
+            struct stat st;
+            if (::fstat(fd, &st) < 0) {
+                ::close(fd);
+                throw std::runtime_error("Could not stat file: " + filename);
+            }
+
+            size_ = static_cast<std::size_t>(st.st_size);
+
+            if (size_ > 0) {
+                void *addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr == MAP_FAILED) {
+                    ::close(fd);
+                    throw std::runtime_error("Could not map file: " + filename);
+                }
+                data_ = static_cast<const char *>(addr);
+                ::madvise(addr, size_, MADV_SEQUENTIAL);
+            }
+
+            ::close(fd);  // the mapping stays valid
+        }
+
+        ~MappedFile()
+        {
+            if (data_ != nullptr) {
+                ::munmap(const_cast<char *>(data_), size_);
+            }
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char *data() const { return data_; }
+        std::size_t size() const { return size_; }
+        std::string_view view() const { return {data_, size_}; }
+};
+
+}  // namespace
+
+
+/** Check that compressed-column arrays describe a valid `M`-by-`N` matrix.
+ *
+ * @param indptr  the `N + 1` column pointers
+ * @param indices  the `indptr[N]` row indices
+ * @param M, N  the shape of the matrix
+ * @param what  the name of the source, for the error messages
+ *
+ * @throws std::runtime_error if the column pointers do not start at 0 and
+ *         increase, or if a row index is outside of `[0, M)`.
+ */
+static void check_compressed(
+    const csint *indptr,
+    const csint *indices,
+    csint M,
+    csint N,
+    const std::string& what
+)
+{
+    if (indptr[0] != 0) {
+        throw std::runtime_error(what + " has invalid column pointers!");
+    }
+
+    for (csint j = 0; j < N; j++) {
+        if (indptr[j+1] < indptr[j]) {
+            throw std::runtime_error(what + " has invalid column pointers!");
+        }
+    }
+
+    for (csint p = 0; p < indptr[N]; p++) {
+        if (indices[p] < 0 || indices[p] >= M) {
+            throw std::runtime_error(what + " has invalid row indices!");
+        }
+    }
+}
+
+
+/** Return the line starting at `pos` and advance `pos` past its newline. */
+static std::string_view next_line(std::string_view buf, std::size_t& pos)
+{
+    std::size_t end = buf.find('\n', pos);
+    if (end == std::string_view::npos) {
+        end = buf.size();
+    }
+    std::string_view line = buf.substr(pos, end - pos);
+    pos = std::min(end + 1, buf.size());
+    return line;
+}
+
+
+/** Skip leading whitespace in `s`. */
+static void skip_space(std::string_view& s)
+{
+    std::size_t k = 0;
+    while (k < s.size() && std::isspace(static_cast<unsigned char>(s[k]))) {
+        k++;
+    }
+    s.remove_prefix(k);
+}
+
+
+/** Parse an integer from the front of `s`, and advance `s` past it. */
+static bool parse_int(std::string_view& s, csint& x)
+{
+    skip_space(s);
+    auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), x);
+    if (ec != std::errc()) {
+        return false;
+    }
+    s.remove_prefix(ptr - s.data());
+    return true;
+}
+
+
+/** Parse a floating-point number from the front of `s`.
+ *
+ * The token is copied into a null-terminated buffer, since the memory-mapped
+ * file is not null-terminated.
+ */
+static bool parse_double(std::string_view& s, double& x)
+{
+    skip_space(s);
+
+    std::size_t len = 0;
+    while (len < s.size() && !std::isspace(static_cast<unsigned char>(s[len]))) {
+        len++;
+    }
+
+    char token[64];
+    if (len == 0 || len >= sizeof(token)) {
+        return false;
+    }
+    std::memcpy(token, s.data(), len);
+    token[len] = '\0';
+
+    char *end;
+    x = std::strtod(token, &end);
+    if (end != token + len) {
+        return false;
+    }
+    s.remove_prefix(len);
+    return true;
+}
+
+
+/*------------------------------------------------------------------------------
+ *          Matrix Market Format
+ *----------------------------------------------------------------------------*/
+COOMatrix read_matrix_market(const std::string& filename, int threads)
+{
+    MappedFile file(filename);
+    std::string_view buf = file.view();
+    std::size_t pos = 0;
+
+    // Parse the banner
+    std::string banner(next_line(buf, pos));
+    std::transform(banner.begin(), banner.end(), banner.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+
+    std::string tag, object, format, field, symmetry;
+    std::istringstream(banner) >> tag >> object >> format >> field >> symmetry;
+
+    if (tag != "%%matrixmarket" || object != "matrix") {
+        throw std::runtime_error("File is not in Matrix Market format!");
+    }
+
+    if (format != "coordinate") {
+        throw std::runtime_error("Only Matrix Market coordinate format is supported!");
+    }
+
+    bool is_pattern = (field == "pattern");
+    if (!is_pattern && field != "real" && field != "double" && field != "integer") {
+        throw std::runtime_error("Unsupported Matrix Market field: " + field);
+    }
+
+    bool is_symmetric = (symmetry == "symmetric");
+    bool is_skew = (symmetry == "skew-symmetric");
+    if (!is_symmetric && !is_skew && symmetry != "general") {
+        throw std::runtime_error("Unsupported Matrix Market symmetry: " + symmetry);
+    }
+
+    // Skip comments and blank lines, and parse the size line
+    csint M = 0, N = 0, nnz = 0;
+    while (pos < buf.size()) {
+        std::string_view line = next_line(buf, pos);
+        skip_space(line);
+        if (line.empty() || line.front() == '%') {
+            continue;
+        }
+        if (!parse_int(line, M) || !parse_int(line, N) || !parse_int(line, nnz)
+            || M < 0 || N < 0 || nnz < 0) {
+            throw std::runtime_error("Invalid Matrix Market size line!");
+        }
+        break;
+    }
+
+    // Split the entries into blocks of whole lines
+    std::string_view body = buf.substr(pos);
+    int nthreads = resolve_num_threads(threads, nnz);
+
+    std::vector<std::size_t> bounds(nthreads + 1, body.size());
+    bounds[0] = 0;
+    for (int t = 1; t < nthreads; t++) {
+        std::size_t b = std::max(bounds[t-1], body.size() * t / nthreads);
+        std::size_t nl = body.find('\n', b > 0 ? b - 1 : 0);
+        bounds[t] = (nl == std::string_view::npos) ? body.size() : nl + 1;
+    }
+
+    // Parse each block into its own triplets
+    bool mirror = is_symmetric || is_skew;
+    csint nz_block = (mirror ? 2 : 1) * nnz / nthreads + 1;
+
+    std::vector<std::vector<csint>> rows(nthreads), cols(nthreads);
+    std::vector<std::vector<double>> vals(nthreads);
+    std::vector<csint> counts(nthreads, 0);  // entries read from the file
+    std::vector<std::exception_ptr> errors(nthreads);
+
+    parallel_for(nthreads, [&](int t) {
+        try {
+            auto& Ri = rows[t];
+            auto& Rj = cols[t];
+            auto& Rv = vals[t];
+            Ri.reserve(nz_block);
+            Rj.reserve(nz_block);
+            Rv.reserve(nz_block);
+
+            std::string_view block = body.substr(bounds[t], bounds[t+1] - bounds[t]);
+            std::size_t bpos = 0;
+
+            while (bpos < block.size()) {
+                std::string_view line = next_line(block, bpos);
+                skip_space(line);
+                if (line.empty() || line.front() == '%') {
+                    continue;
+                }
+
+                csint i, j;
+                double v = 1.0;
+                if (!parse_int(line, i) || !parse_int(line, j)
+                    || (!is_pattern && !parse_double(line, v))) {
+                    throw std::runtime_error("File is not in (i, j, v) format!");
+                }
+
+                i--;  // convert to 0-based indices
+                j--;
+
+                if (i < 0 || i >= M || j < 0 || j >= N) {
+                    throw std::runtime_error(
+                        std::format("Entry ({}, {}) is out of bounds!", i + 1, j + 1)
+                    );
+                }
+
+                Ri.push_back(i);
+                Rj.push_back(j);
+                Rv.push_back(v);
+                counts[t]++;
+
+                if (mirror && i != j) {
+                    Ri.push_back(j);
+                    Rj.push_back(i);
+                    Rv.push_back(is_skew ? -v : v);
+                }
+            }
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    });
+
+    for (const auto& e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+
+    // Compute the offset of each block in the result
+    std::vector<csint> offsets(nthreads + 1, 0);
+    csint nread = 0;
+    for (int t = 0; t < nthreads; t++) {
+        offsets[t+1] = offsets[t] + static_cast<csint>(rows[t].size());
+        nread += counts[t];
+    }
+
+    if (nread != nnz) {
+        throw std::runtime_error(
+            std::format("Expected {} entries, but read {}!", nnz, nread)
+        );
+    }
+
+    // Concatenate the blocks in file order
+    csint total = offsets[nthreads];
+    std::vector<csint> Ti(total), Tj(total);
+    std::vector<double> Tv(total);
+
+    parallel_for(nthreads, [&](int t) {
+        std::copy(rows[t].begin(), rows[t].end(), Ti.begin() + offsets[t]);
+        std::copy(cols[t].begin(), cols[t].end(), Tj.begin() + offsets[t]);
+        std::copy(vals[t].begin(), vals[t].end(), Tv.begin() + offsets[t]);
+        // Free the block storage early
+        std::vector<csint>().swap(rows[t]);
+        std::vector<csint>().swap(cols[t]);
+        std::vector<double>().swap(vals[t]);
+    });
+
+    return COOMatrix(std::move(Tv), std::move(Ti), std::move(Tj), {M, N});
+}
+
+
+void write_matrix_market(
+    const std::string& filename,
+    const CSCMatrix& A,
+    int threads
+)
+{
+    std::ofstream fp(filename, std::ios::binary);
+    if (!fp) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    auto [M, N] = A.shape();
+    const auto& Ap = A.indptr();
+    const auto& Ai = A.indices();
+    const auto& Ax = A.data();
+    csint nnz = Ap[N];
+
+    fp << "%%MatrixMarket matrix coordinate real general\n";
+    fp << std::format("{} {} {}\n", M, N, nnz);
+
+    // Format blocks of columns in parallel, then write them in order
+    int nthreads = resolve_num_threads(threads, nnz);
+    std::vector<csint> bounds = partition_nnz(Ap, nthreads);
+    std::vector<std::string> blocks(nthreads);
+
+    parallel_for(nthreads, [&](int t) {
+        std::string& s = blocks[t];
+        s.reserve((Ap[bounds[t+1]] - Ap[bounds[t]]) * 32);
+        auto out = std::back_inserter(s);
+        for (csint j = bounds[t]; j < bounds[t+1]; j++) {
+            for (csint p = Ap[j]; p < Ap[j+1]; p++) {
+                std::format_to(out, "{} {} {:.17g}\n", Ai[p] + 1, j + 1, Ax[p]);
+            }
+        }
+    });
+
+    for (const auto& s : blocks) {
+        fp.write(s.data(), s.size());
+    }
+
+    if (!fp) {
+        throw std::runtime_error("Could not write file: " + filename);
+    }
+}
+
+
+/*------------------------------------------------------------------------------
+ *          Native Binary Format
+ *----------------------------------------------------------------------------*/
+CSCMatrix read_binary(const std::string& filename)
+{
+    MappedFile file(filename);
+
+    if (file.size() < sizeof(BinaryHeader)) {
+        throw std::runtime_error("File is too small to be a binary CSC file!");
+    }
+
+    BinaryHeader h;
+    std::memcpy(&h, file.data(), sizeof(h));
+
+    if (std::memcmp(h.magic, BinaryHeader::MAGIC, sizeof(h.magic)) != 0) {
+        throw std::runtime_error("File is not a binary CSC file!");
+    }
+
+    if (h.version != BinaryHeader::VERSION) {
+        throw std::runtime_error(
+            std::format("Unsupported binary CSC version {}!", h.version)
+        );
+    }
+
+    if (h.byte_order != BinaryHeader::ENDIAN_MARK
+        || h.index_size != sizeof(csint)
+        || h.value_size != sizeof(double)) {
+        throw std::runtime_error("Binary CSC file was written by an incompatible host!");
+    }
+
+    // Bound the sizes by the file size, so that the expected size cannot
+    // overflow
+    csint max_count = static_cast<csint>(file.size() / sizeof(csint));
+
+    if (h.M < 0 || h.N < 0 || h.nnz < 0 || h.N >= max_count || h.nnz >= max_count) {
+        throw std::runtime_error("Invalid binary CSC dimensions!");
+    }
+
+    std::size_t expect_size = sizeof(BinaryHeader)
+        + (h.N + 1 + h.nnz) * sizeof(csint)
+        + h.nnz * sizeof(double);
+
+    if (file.size() != expect_size) {
+        throw std::runtime_error("Binary CSC file has the wrong size!");
+    }
+
+    // The arrays are aligned, since the header size is a multiple of 8
+    const csint *indptr = reinterpret_cast<const csint *>(
+        file.data() + sizeof(BinaryHeader)
+    );
+    const csint *indices = indptr + h.N + 1;
+    const double *data = reinterpret_cast<const double *>(indices + h.nnz);
+
+    if (indptr[h.N] != h.nnz) {
+        throw std::runtime_error("Binary CSC file has invalid column pointers!");
+    }
+
+    check_compressed(indptr, indices, h.M, h.N, "Binary CSC file");
+
+    return CSCMatrix(
+        std::vector<double>(data, data + h.nnz),
+        std::vector<csint>(indices, indices + h.nnz),
+        std::vector<csint>(indptr, indptr + h.N + 1),
+        {h.M, h.N}
+    );
+}
+
+
+void write_binary(const std::string& filename, const CSCMatrix& A)
+{
+    std::ofstream fp(filename, std::ios::binary);
+    if (!fp) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    auto [M, N] = A.shape();
+    const auto& Ap = A.indptr();
+    const auto& Ai = A.indices();
+    const auto& Ax = A.data();
+    csint nnz = Ap[N];
+
+    BinaryHeader h {};
+    std::memcpy(h.magic, BinaryHeader::MAGIC, sizeof(h.magic));
+    h.version = BinaryHeader::VERSION;
+    h.byte_order = BinaryHeader::ENDIAN_MARK;
+    h.M = M;
+    h.N = N;
+    h.nnz = nnz;
+    h.index_size = sizeof(csint);
+    h.value_size = sizeof(double);
+
+    // Only write the used part of the arrays, in case nzmax > nnz
+    fp.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    fp.write(reinterpret_cast<const char *>(Ap.data()), (N + 1) * sizeof(csint));
+    fp.write(reinterpret_cast<const char *>(Ai.data()), nnz * sizeof(csint));
+    fp.write(reinterpret_cast<const char *>(Ax.data()), nnz * sizeof(double));
+
+    if (!fp) {
+        throw std::runtime_error("Could not write file: " + filename);
+    }
+}
+
+
+/*------------------------------------------------------------------------------
+ *          Native Factor Format
+ *----------------------------------------------------------------------------*/
+namespace {
+
+/** Combine one 64-bit word into a hash, mixed by the MurmurHash3 finalizer. */
+std::uint64_t hash_mix(std::uint64_t h, std::uint64_t w)
+{
+    h ^= w + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+
+/** Mix an array of 8-byte values into a hash. */
+template <typename T>
+std::uint64_t hash_array(std::uint64_t h, const T *x, csint n)
+{
+    static_assert(sizeof(T) == sizeof(std::uint64_t));
+    h = hash_mix(h, static_cast<std::uint64_t>(n));
+    for (csint k = 0; k < n; k++) {
+        h = hash_mix(h, std::bit_cast<std::uint64_t>(x[k]));
+    }
+    return h;
+}
+
+
+/** Check that `p` is a permutation of `0, ..., n-1`. */
+bool is_permutation(const std::vector<csint>& p, csint n)
+{
+    if (static_cast<csint>(p.size()) != n) {
+        return false;
+    }
+
+    std::vector<char> seen(n, false);
+    for (csint i : p) {
+        if (i < 0 || i >= n || seen[i]) {
+            return false;
+        }
+        seen[i] = true;
+    }
+
+    return true;
+}
+
+
+/** Check that every entry of `x` is in `[lo, hi)`. */
+bool in_range(const std::vector<csint>& x, csint lo, csint hi)
+{
+    return std::all_of(x.begin(), x.end(), [=](csint v) { return lo <= v && v < hi; });
+}
+
+
+/** Check that `cp` are the column pointers of `N` columns with `nz` entries. */
+bool is_column_pointers(const std::vector<csint>& cp, csint N, csint nz)
+{
+    return static_cast<csint>(cp.size()) == N + 1
+        && cp[0] == 0
+        && cp[N] == nz
+        && std::is_sorted(cp.begin(), cp.end());
+}
+
+
+/** The seed of the payload hash of a factor file. */
+constexpr std::uint64_t PAYLOAD_SEED = 0x43534641435430ULL;
+
+
+/** Check that the elimination tree is ordered, with each parent after its
+ * children, as the tree-scheduled kernels require.
+ */
+bool is_ordered_tree(const std::vector<csint>& parent)
+{
+    for (csint j = 0; j < static_cast<csint>(parent.size()); j++) {
+        if (parent[j] != -1 && parent[j] <= j) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/** Check that a Cholesky analysis is that of `A`.
+ *
+ * The elimination tree and column counts are recomputed from the pattern of
+ * `triu(A(p, p))`, so that the factor fits the column pointers of `S`.
+ */
+bool is_analysis_of(const CSCMatrix& A, const SymbolicChol& S, bool has_C)
+{
+    if (!is_ordered_tree(S.parent) || (has_C && !has_symperm_map(A, S))) {
+        return false;
+    }
+
+    const CSCMatrix C = has_C ? S.C : A.symperm(S.p_inv, false);
+
+    return etree(C) == S.parent
+        && cumsum(counts(C, S.parent, post(S.parent))) == S.cp;
+}
+
+
+/** Check that a QR analysis is that of `A`.
+ *
+ * The elimination tree, leftmost columns, row permutation and counts are
+ * recomputed from the pattern of `A(:, q)`, so that the factors fit the
+ * counts of `S`.
+ */
+bool is_analysis_of(const CSCMatrix& A, const SymbolicQR& S)
+{
+    if (!is_ordered_tree(S.parent)) {
+        return false;
+    }
+
+    const CSCMatrix C = A.permute_cols(S.q, false);
+    bool CTC = true;
+
+    if (etree(C, CTC) != S.parent || find_leftmost(C) != S.leftmost) {
+        return false;
+    }
+
+    std::vector<csint> cp = counts(C, S.parent, post(S.parent), CTC);
+
+    SymbolicQR T;
+    T.parent = S.parent;
+    T.leftmost = S.leftmost;
+    vcount(C, T);
+
+    return std::accumulate(cp.begin(), cp.end(), csint{0}) == S.rnz
+        && T.vnz == S.vnz
+        && T.m2 == S.m2
+        && T.p_inv == S.p_inv;
+}
+
+
+/** Write the arrays of a factor file under a temporary name. */
+class FactorWriter
+{
+    std::string filename_, tmpname_;
+    std::ofstream fp_;
+    std::uint64_t hash_ = PAYLOAD_SEED;  // the payload hash so far
+
+    /** Write 8-byte words to the payload. */
+    template <typename T>
+    void write_(const T *x, csint n)
+    {
+        static_assert(sizeof(T) == sizeof(std::uint64_t));
+        for (csint k = 0; k < n; k++) {
+            hash_ = hash_mix(hash_, std::bit_cast<std::uint64_t>(x[k]));
+        }
+        fp_.write(reinterpret_cast<const char *>(x), n * sizeof(T));
+    }
+
+    public:
+        FactorWriter(const std::string& filename)
+            : filename_(filename),
+              tmpname_(filename + ".tmp"),
+              fp_(tmpname_, std::ios::binary)
+        {
+            if (!fp_) {
+                throw std::runtime_error("Could not open file: " + tmpname_);
+            }
+        }
+
+        ~FactorWriter()
+        {
+            if (fp_.is_open()) {
+                fp_.close();
+                std::remove(tmpname_.c_str());  // not committed
+            }
+        }
+
+        FactorWriter(const FactorWriter&) = delete;
+        FactorWriter& operator=(const FactorWriter&) = delete;
+
+        void header(const CSCMatrix& A, FactorKind kind, bool has_factor)
+        {
+            FactorKey key = factor_key(A);
+
+            FactorHeader h {};
+            std::memcpy(h.magic, FactorHeader::MAGIC, sizeof(h.magic));
+            h.version = FactorHeader::VERSION;
+            h.byte_order = BinaryHeader::ENDIAN_MARK;
+            h.kind = static_cast<std::uint32_t>(kind);
+            h.has_factor = has_factor ? 1 : 0;
+            h.pattern_hash = key.pattern_hash;
+            h.values_hash = key.values_hash;
+            h.M = key.M;
+            h.N = key.N;
+            h.nnz = key.nnz;
+            h.index_size = sizeof(csint);
+            h.value_size = sizeof(double);
+
+            fp_.write(reinterpret_cast<const char *>(&h), sizeof(h));
+        }
+
+        template <typename T>
+        void array(const T *x, csint n)
+        {
+            std::uint64_t len = static_cast<std::uint64_t>(n);
+            write_(&len, 1);
+            write_(x, n);
+        }
+
+        template <typename T>
+        void array(const std::vector<T>& x)
+        {
+            array(x.data(), static_cast<csint>(x.size()));
+        }
+
+        void matrix(const CSCMatrix& A)
+        {
+            auto [M, N] = A.shape();
+            csint nnz = A.indptr().empty() ? 0 : A.indptr()[N];
+            csint flags = (A.has_sorted_indices() ? 1 : 0)
+                        | (A.has_canonical_format() ? 2 : 0);
+
+            // Only write the used part of the arrays, in case nzmax > nnz
+            array(std::vector<csint> {M, N, flags});
+            if (A.indptr().empty()) {
+                array(std::vector<csint>(N + 1, 0));  // a default-constructed matrix
+            } else {
+                array(A.indptr().data(), N + 1);
+            }
+            array(A.indices().data(), nnz);
+            array(A.data().data(), A.data().empty() ? 0 : nnz);
+        }
+
+        /** Write the payload hash, flush the file, and rename it to its final
+         * name.
+         */
+        void commit()
+        {
+            fp_.seekp(offsetof(FactorHeader, payload_hash));
+            fp_.write(reinterpret_cast<const char *>(&hash_), sizeof(hash_));
+            fp_.close();
+            if (!fp_ || std::rename(tmpname_.c_str(), filename_.c_str()) != 0) {
+                std::remove(tmpname_.c_str());
+                throw std::runtime_error("Could not write file: " + filename_);
+            }
+        }
+};
+
+
+/** Read the arrays of a factor file in order from its memory mapping. */
+class FactorReader
+{
+    MappedFile file_;
+    FactorHeader h_;
+    std::size_t pos_ = sizeof(FactorHeader);
+
+    public:
+        FactorReader(const std::string& filename) : file_(filename)
+        {
+            if (file_.size() < sizeof(FactorHeader)) {
+                throw std::runtime_error("File is too small to be a factor file!");
+            }
+
+            std::memcpy(&h_, file_.data(), sizeof(h_));
+
+            if (std::memcmp(h_.magic, FactorHeader::MAGIC, sizeof(h_.magic)) != 0) {
+                throw std::runtime_error("File is not a factor file!");
+            }
+
+            if (h_.version != FactorHeader::VERSION) {
+                throw std::runtime_error(
+                    std::format("Unsupported factor file version {}!", h_.version)
+                );
+            }
+
+            if (h_.byte_order != BinaryHeader::ENDIAN_MARK
+                || h_.index_size != sizeof(csint)
+                || h_.value_size != sizeof(double)) {
+                throw std::runtime_error("Factor file was written by an incompatible host!");
+            }
+
+            std::size_t payload = file_.size() - sizeof(FactorHeader);
+            if (payload % sizeof(std::uint64_t) != 0) {
+                throw std::runtime_error("Factor file has the wrong size!");
+            }
+
+            std::uint64_t h = PAYLOAD_SEED;
+            for (std::size_t pos = sizeof(FactorHeader); pos < file_.size(); pos += sizeof(h)) {
+                std::uint64_t w;
+                std::memcpy(&w, file_.data() + pos, sizeof(w));
+                h = hash_mix(h, w);
+            }
+
+            if (h != h_.payload_hash) {
+                throw std::runtime_error("Factor file is corrupted!");
+            }
+        }
+
+        const FactorHeader& header() const { return h_; }
+
+        FactorKey key() const
+        {
+            return {h_.pattern_hash, h_.values_hash, h_.M, h_.N, h_.nnz};
+        }
+
+        /** Check the kind of the file, and that `A` has the analyzed pattern. */
+        void check(FactorKind kind, const FactorKey& key) const
+        {
+            if (h_.kind != static_cast<std::uint32_t>(kind)) {
+                throw std::runtime_error("Factor file has the wrong kind of factorization!");
+            }
+
+            FactorKey k = this->key();
+            if (k.pattern_hash != key.pattern_hash
+                || k.M != key.M || k.N != key.N || k.nnz != key.nnz) {
+                throw std::runtime_error("Factor file does not match the pattern of the matrix!");
+            }
+        }
+
+        template <typename T>
+        std::vector<T> array()
+        {
+            std::uint64_t len;
+            if (file_.size() - pos_ < sizeof(len)) {
+                throw std::runtime_error("Factor file is truncated!");
+            }
+            std::memcpy(&len, file_.data() + pos_, sizeof(len));
+            pos_ += sizeof(len);
+
+            if (len > (file_.size() - pos_) / sizeof(T)) {
+                throw std::runtime_error("Factor file is truncated!");
+            }
+
+            // The arrays are aligned, since every field is 8 bytes
+            const T *x = reinterpret_cast<const T *>(file_.data() + pos_);
+            pos_ += len * sizeof(T);
+
+            return std::vector<T>(x, x + len);
+        }
+
+        /** Read a scalar array of a given length. */
+        std::vector<csint> scalars(std::size_t len)
+        {
+            std::vector<csint> x = array<csint>();
+            if (x.size() != len) {
+                throw std::runtime_error("Factor file has an invalid array!");
+            }
+            return x;
+        }
+
+        /** Read a matrix, with its format flags.
+         *
+         * @return A  the matrix
+         * @return flags  bit 0 is set if the indices are sorted, and bit 1 if
+         *         the matrix is in canonical format.
+         */
+        std::pair<CSCMatrix, csint> matrix()
+        {
+            std::vector<csint> dims = scalars(3);
+            csint M = dims[0],
+                  N = dims[1];
+
+            std::vector<csint> indptr = array<csint>();
+            std::vector<csint> indices = array<csint>();
+            std::vector<double> data = array<double>();
+
+            csint nnz = static_cast<csint>(indices.size());
+
+            if (M < 0 || N < 0
+                || static_cast<csint>(indptr.size()) != N + 1
+                || indptr[N] != nnz
+                || !(data.empty() || static_cast<csint>(data.size()) == nnz)) {
+                throw std::runtime_error("Factor file has an invalid matrix!");
+            }
+
+            check_compressed(indptr.data(), indices.data(), M, N, "Factor file");
+
+            return {
+                CSCMatrix(std::move(data), std::move(indices), std::move(indptr), {M, N}),
+                dims[2]
+            };
+        }
+
+        /** Check that the whole file was read. */
+        void finish() const
+        {
+            if (pos_ != file_.size()) {
+                throw std::runtime_error("Factor file has the wrong size!");
+            }
+        }
+};
+
+
+void write_symbolic(FactorWriter& w, const SymbolicChol& S)
+{
+    w.array(S.p_inv);
+    w.array(S.parent);
+    w.array(S.cp);
+    w.array(std::vector<csint> {S.lnz, S.anz});
+    w.matrix(S.C);
+    w.array(S.C_map);
+}
+
+
+void write_symbolic(FactorWriter& w, const SymbolicQR& S)
+{
+    w.array(S.p_inv);
+    w.array(S.q);
+    w.array(S.parent);
+    w.array(S.leftmost);
+    w.array(std::vector<csint> {S.m2, S.vnz, S.rnz});
+}
+
+}  // namespace
+
+
+FactorKey factor_key(const CSCMatrix& A)
+{
+    auto [M, N] = A.shape();
+    csint nnz = A.indptr().empty() ? 0 : A.indptr()[N];
+
+    FactorKey key;
+    key.M = M;
+    key.N = N;
+    key.nnz = nnz;
+    key.pattern_hash = pattern_hash(A);
+
+    // An empty value array hashes as a pattern-only matrix
+    key.values_hash = hash_array(
+        key.pattern_hash, A.data().data(), A.data().empty() ? 0 : nnz
+    );
+
+    return key;
+}
+
+
+std::uint64_t pattern_hash(const CSCMatrix& A)
+{
+    auto [M, N] = A.shape();
+
+    // A default-constructed matrix has no column pointers
+    const std::vector<csint> empty_indptr(N + 1, 0);
+    const std::vector<csint>& indptr = A.indptr().empty() ? empty_indptr : A.indptr();
+    csint nnz = indptr[N];
+
+    std::uint64_t h = hash_mix(static_cast<std::uint64_t>(M), static_cast<std::uint64_t>(N));
+    h = hash_array(h, indptr.data(), N + 1);
+    return hash_array(h, A.indices().data(), nnz);
+}
+
+
+FactorKey read_factor_key(const std::string& filename)
+{
+    return FactorReader(filename).key();
+}
+
+
+void write_chol_cache(
+    const std::string& filename,
+    const CSCMatrix& A,
+    const SymbolicChol& S
+)
+{
+    FactorWriter w(filename);
+    w.header(A, FactorKind::Cholesky, false);
+    write_symbolic(w, S);
+    w.commit();
+}
+
+
+void write_chol_cache(
+    const std::string& filename,
+    const CSCMatrix& A,
+    const SymbolicChol& S,
+    const CSCMatrix& L
+)
+{
+    FactorWriter w(filename);
+    w.header(A, FactorKind::Cholesky, true);
+    write_symbolic(w, S);
+    w.matrix(L);
+    w.commit();
+}
+
+
+CachedChol read_chol_cache(const std::string& filename, const CSCMatrix& A)
+{
+    FactorReader r(filename);
+    FactorKey key = factor_key(A);
+    r.check(FactorKind::Cholesky, key);
+
+    CachedChol res;
+    SymbolicChol& S = res.S;
+
+    S.p_inv = r.array<csint>();
+    S.parent = r.array<csint>();
+    S.cp = r.array<csint>();
+
+    std::vector<csint> counts = r.scalars(2);
+    S.lnz = counts[0];
+    S.anz = counts[1];
+
+    auto [C, C_flags] = r.matrix();
+    S.C = std::move(C);
+    S.C.has_sorted_indices_ = C_flags & 1;
+    S.C.has_canonical_format_ = C_flags & 2;
+    S.C_map = r.array<csint>();
+    S.pattern_hash = key.pattern_hash;  // checked against the header
+
+    // The pattern of C is either absent, or that of triu(A(p, p))
+    csint N = key.N;
+    auto [C_M, C_N] = S.C.shape();
+    bool has_C = C_M == N && C_N == N;
+
+    if (key.M != N
+        || !is_permutation(S.p_inv, N)
+        || !in_range(S.parent, -1, N)
+        || static_cast<csint>(S.parent.size()) != N
+        || !is_column_pointers(S.cp, N, S.lnz)
+        || S.anz != key.nnz
+        || !(has_C || (C_M == 0 && C_N == 0))
+        || static_cast<csint>(S.C_map.size()) != S.C.nnz()
+        || !in_range(S.C_map, 0, S.anz)
+        || !is_analysis_of(A, S, has_C)) {
+        throw std::runtime_error("Factor file has an invalid analysis!");
+    }
+
+    // The factor is only valid for the same values
+    if (r.header().has_factor && r.key().values_hash == key.values_hash) {
+        auto [L, L_flags] = r.matrix();
+        res.L = std::move(L);
+        res.L.has_sorted_indices_ = L_flags & 1;
+        res.L.has_canonical_format_ = L_flags & 2;
+        res.has_factor = true;
+
+        if (res.L.shape() != Shape {N, N} || res.L.nnz() != S.lnz) {
+            throw std::runtime_error("Factor file has an invalid factor!");
+        }
+
+        r.finish();
+    } else if (!r.header().has_factor) {
+        r.finish();
+    }
+
+    return res;
+}
+
+
+void write_qr_cache(
+    const std::string& filename,
+    const CSCMatrix& A,
+    const SymbolicQR& S
+)
+{
+    FactorWriter w(filename);
+    w.header(A, FactorKind::QR, false);
+    write_symbolic(w, S);
+    w.commit();
+}
+
+
+void write_qr_cache(
+    const std::string& filename,
+    const CSCMatrix& A,
+    const SymbolicQR& S,
+    const QRResult& res
+)
+{
+    FactorWriter w(filename);
+    w.header(A, FactorKind::QR, true);
+    write_symbolic(w, S);
+    w.matrix(res.V);
+    w.array(res.beta);
+    w.matrix(res.R);
+    w.array(res.p_inv);
+    w.array(res.q);
+    w.commit();
+}
+
+
+CachedQR read_qr_cache(const std::string& filename, const CSCMatrix& A)
+{
+    FactorReader r(filename);
+    FactorKey key = factor_key(A);
+    r.check(FactorKind::QR, key);
+
+    CachedQR res;
+    SymbolicQR& S = res.S;
+
+    S.p_inv = r.array<csint>();
+    S.q = r.array<csint>();
+    S.parent = r.array<csint>();
+    S.leftmost = r.array<csint>();
+
+    std::vector<csint> counts = r.scalars(3);
+    S.m2 = counts[0];
+    S.vnz = counts[1];
+    S.rnz = counts[2];
+    S.pattern_hash = key.pattern_hash;  // checked against the header
+
+    csint M = key.M,
+          N = key.N;
+
+    if (S.m2 < M
+        || !is_permutation(S.p_inv, S.m2)
+        || !is_permutation(S.q, N)
+        || static_cast<csint>(S.parent.size()) != N
+        || !in_range(S.parent, -1, N)
+        || static_cast<csint>(S.leftmost.size()) != M
+        || !in_range(S.leftmost, -1, N)
+        || !is_analysis_of(A, S)) {
+        throw std::runtime_error("Factor file has an invalid analysis!");
+    }
+
+    // The factorization is only valid for the same values
+    if (r.header().has_factor && r.key().values_hash == key.values_hash) {
+        auto [V, V_flags] = r.matrix();
+        res.res.V = std::move(V);
+        res.res.V.has_sorted_indices_ = V_flags & 1;
+        res.res.V.has_canonical_format_ = V_flags & 2;
+
+        res.res.beta = r.array<double>();
+
+        auto [R, R_flags] = r.matrix();
+        res.res.R = std::move(R);
+        res.res.R.has_sorted_indices_ = R_flags & 1;
+        res.res.R.has_canonical_format_ = R_flags & 2;
+
+        res.res.p_inv = r.array<csint>();
+        res.res.q = r.array<csint>();
+        res.has_factor = true;
+
+        // An underdetermined factorization is truncated to M rows
+        auto [V_M, V_N] = res.res.V.shape();
+        auto [R_M, R_N] = res.res.R.shape();
+
+        if (V_M > S.m2 || R_M != V_M || R_N != N
+            || static_cast<csint>(res.res.beta.size()) != V_N
+            || static_cast<csint>(res.res.p_inv.size()) != V_M
+            || !in_range(res.res.p_inv, 0, S.m2)
+            || !is_permutation(res.res.q, N)) {
+            throw std::runtime_error("Factor file has an invalid factor!");
+        }
+
+        r.finish();
+    } else if (!r.header().has_factor) {
+        r.finish();
+    }
+
+    return res;
+}
+
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/
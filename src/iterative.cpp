@@ -0,0 +1,796 @@
+/*==============================================================================
+ *     File: iterative.cpp
+ *  Created: 2025-03-23 10:15
+ *   Author: Bernie Roesler
+ *
+ *  Description: Implements the preconditioned Krylov solvers.
+ *
+ *============================================================================*/
+
+#include <algorithm>  // std::copy, std::fill, std::max, std::min
+#include <cmath>      // std::sqrt, std::hypot, std::abs
+#include <limits>     // std::numeric_limits
+#include <memory>     // std::make_shared
+#include <numeric>    // std::accumulate
+#include <span>
+#include <stdexcept>
+#include <utility>    // std::swap
+
+#include "iterative.h"
+#include "csc.h"
+#include "parallel.h"
+#include "stats.h"
+
+namespace cs {
+
+/*------------------------------------------------------------------------------
+ *         Fused Kernels
+ *----------------------------------------------------------------------------*/
+/** The blocks of columns of `A` that the threads of a solver work on. */
+struct ColumnBlocks
+{
+    int nthreads;                  // the number of threads
+    std::vector<csint> bounds;     // the first column of each block
+    std::vector<double> partial;   // the partial dot product of each block
+};
+
+
+/** Split the columns of `A` into blocks with equal numbers of non-zeros. */
+static ColumnBlocks column_blocks(const CSCMatrix& A, int threads)
+{
+    int nthreads = resolve_num_threads(threads, A.nnz());
+    return {nthreads, partition_nnz(A.indptr(), nthreads),
+            std::vector<double>(nthreads)};
+}
+
+
+/** Compute \f$ y = Ax \f$. */
+static void spmv(const CSCMatrix& A, const double *x, double *y, int nthreads)
+{
+    auto [M, N] = A.shape();
+
+    if (nthreads > 1) {
+        A.dot(std::span<const double>(x, N), std::span<double>(y, M), nthreads);
+        return;
+    }
+
+    const auto& Ap = A.indptr();
+    const auto& Ai = A.indices();
+    const auto& Ax = A.data();
+
+    std::fill(y, y + M, 0.0);
+
+    for (csint j = 0; j < N; j++) {
+        double xj = x[j];
+        for (csint p = Ap[j]; p < Ap[j+1]; p++) {
+            y[Ai[p]] += Ax[p] * xj;
+        }
+    }
+}
+
+
+/** Compute \f$ r = b - Ax \f$. */
+static void residual(
+    const CSCMatrix& A,
+    const double *x,
+    const std::vector<double>& b,
+    double *r,
+    int nthreads
+)
+{
+    if (nthreads > 1) {
+        spmv(A, x, r, nthreads);
+        for (std::size_t k = 0; k < b.size(); k++) {
+            r[k] = b[k] - r[k];
+        }
+        return;
+    }
+
+    const auto& Ap = A.indptr();
+    const auto& Ai = A.indices();
+    const auto& Ax = A.data();
+
+    std::copy(b.begin(), b.end(), r);
+
+    for (csint j = 0; j < A.shape()[1]; j++) {
+        double xj = x[j];
+        for (csint p = Ap[j]; p < Ap[j+1]; p++) {
+            r[Ai[p]] -= Ax[p] * xj;
+        }
+    }
+}
+
+
+/** Compute \f$ y = Ax - c r \f$, and return \f$ x^T y \f$.
+ *
+ * Since `A` is symmetric, row `j` of `A` is column `j`, so each entry of `y`
+ * is a gather over one column, and the dot product is fused into the same
+ * pass. Each thread writes its own block of `y`.
+ */
+static double spmv_axpy_dot(
+    const CSCMatrix& A,
+    const double *x,
+    double c,
+    const double *r,
+    double *y,
+    ColumnBlocks& blocks
+)
+{
+    const auto& Ap = A.indptr();
+    const auto& Ai = A.indices();
+    const auto& Ax = A.data();
+
+    parallel_for(blocks.nthreads, [&](int t) {
+        double xy = 0.0;
+        for (csint j = blocks.bounds[t]; j < blocks.bounds[t+1]; j++) {
+            double yj = -c * r[j];
+            for (csint p = Ap[j]; p < Ap[j+1]; p++) {
+                yj += Ax[p] * x[Ai[p]];
+            }
+            y[j] = yj;
+            xy += x[j] * yj;
+        }
+        blocks.partial[t] = xy;
+    });
+
+    return std::accumulate(blocks.partial.begin(), blocks.partial.end(), 0.0);
+}
+
+
+/** Compute \f$ y = Ax \f$ for a symmetric `A`, and return \f$ x^T y \f$. */
+static double spmv_dot(
+    const CSCMatrix& A,
+    const double *x,
+    double *y,
+    ColumnBlocks& blocks
+)
+{
+    const auto& Ap = A.indptr();
+    const auto& Ai = A.indices();
+    const auto& Ax = A.data();
+
+    parallel_for(blocks.nthreads, [&](int t) {
+        double xy = 0.0;
+        for (csint j = blocks.bounds[t]; j < blocks.bounds[t+1]; j++) {
+            double yj = 0.0;
+            for (csint p = Ap[j]; p < Ap[j+1]; p++) {
+                yj += Ax[p] * x[Ai[p]];
+            }
+            y[j] = yj;
+            xy += x[j] * yj;
+        }
+        blocks.partial[t] = xy;
+    });
+
+    return std::accumulate(blocks.partial.begin(), blocks.partial.end(), 0.0);
+}
+
+
+/** Compute \f$ x = x + a p \f$ and \f$ r = r - a q \f$, and return
+ * \f$ r^T r \f$.
+ */
+static double axpy2_dot(
+    csint N,
+    double a,
+    const double *p,
+    const double *q,
+    double *x,
+    double *r
+)
+{
+    double rr = 0.0;
+    for (csint k = 0; k < N; k++) {
+        x[k] += a * p[k];
+        r[k] -= a * q[k];
+        rr += r[k] * r[k];
+    }
+    return rr;
+}
+
+
+/** Compute \f$ y = y - a x \f$, and return \f$ y^T z \f$.
+ *
+ * `z` may be the same as `y`, to return the squared norm of the result.
+ */
+static double axpy_dot(
+    csint N,
+    double a,
+    const double *x,
+    double *y,
+    const double *z
+)
+{
+    double yz = 0.0;
+    for (csint k = 0; k < N; k++) {
+        y[k] -= a * x[k];
+        yz += y[k] * z[k];
+    }
+    return yz;
+}
+
+
+/** Compute \f$ p = z + \beta p \f$. */
+static void xpby(csint N, const double *z, double beta, double *p)
+{
+    for (csint k = 0; k < N; k++) {
+        p[k] = z[k] + beta * p[k];
+    }
+}
+
+
+static double dot(csint N, const double *x, const double *y)
+{
+    double xy = 0.0;
+    for (csint k = 0; k < N; k++) {
+        xy += x[k] * y[k];
+    }
+    return xy;
+}
+
+
+/** Check the inputs of a solver, and return the initial guess. */
+static std::vector<double> initial_guess(
+    const CSCMatrix& A,
+    const std::vector<double>& b,
+    const std::vector<double>& x0
+)
+{
+    auto [M, N] = A.shape();
+
+    if (M != N) {
+        throw std::runtime_error("Matrix must be square!");
+    }
+
+    if (static_cast<csint>(b.size()) != N) {
+        throw std::runtime_error("RHS vector must be the same size as A!");
+    }
+
+    if (x0.empty()) {
+        return std::vector<double>(N, 0.0);
+    }
+
+    if (static_cast<csint>(x0.size()) != N) {
+        throw std::runtime_error("Initial guess must be the same size as A!");
+    }
+
+    return x0;
+}
+
+
+/** Add the operations of a solver to the statistics, if they are enabled. */
+static void record_solver(double flops, std::size_t bytes)
+{
+    if (Stats *stats = get_stats()) {
+        stats->flops += flops;
+    }
+    record_memory(bytes);
+}
+
+
+/*------------------------------------------------------------------------------
+ *         Preconditioners
+ *----------------------------------------------------------------------------*/
+Preconditioner jacobi_preconditioner(const CSCMatrix& A)
+{
+    auto [M, N] = A.shape();
+
+    if (M != N) {
+        throw std::runtime_error("Matrix must be square!");
+    }
+
+    const auto& Ap = A.indptr();
+    const auto& Ai = A.indices();
+    const auto& Ax = A.data();
+
+    std::vector<double> d(N, 0.0);
+
+    for (csint j = 0; j < N; j++) {
+        for (csint p = Ap[j]; p < Ap[j+1]; p++) {
+            if (Ai[p] == j) {
+                d[j] += Ax[p];  // sum any duplicates
+            }
+        }
+    }
+
+    for (auto& dj : d) {
+        if (dj == 0.0) {
+            throw std::runtime_error("Matrix has a zero diagonal!");
+        }
+        dj = 1.0 / dj;
+    }
+
+    auto d_inv = std::make_shared<const std::vector<double>>(std::move(d));
+
+    return [d_inv](std::span<const double> r, std::span<double> z) {
+        const auto& di = *d_inv;
+        for (std::size_t k = 0; k < di.size(); k++) {
+            z[k] = r[k] * di[k];
+        }
+    };
+}
+
+
+Preconditioner ichol_preconditioner(const CSCMatrix& L)
+{
+    auto [M, N] = L.shape();
+
+    if (M != N) {
+        throw std::runtime_error("Matrix must be square!");
+    }
+
+    // Share the factor between copies of the preconditioner
+    auto Lc = std::make_shared<const CSCMatrix>(L);
+
+    return [Lc](std::span<const double> r, std::span<double> z) {
+        const auto& Lp = Lc->indptr();
+        const auto& Li = Lc->indices();
+        const auto& Lx = Lc->data();
+        csint N = Lc->shape()[1];
+
+        std::copy(r.begin(), r.end(), z.begin());
+
+        // Solve L y = r, in place
+        for (csint j = 0; j < N; j++) {
+            z[j] /= Lx[Lp[j]];
+            for (csint p = Lp[j] + 1; p < Lp[j+1]; p++) {
+                z[Li[p]] -= Lx[p] * z[j];
+            }
+        }
+
+        // Solve L^T z = y, in place
+        for (csint j = N - 1; j >= 0; j--) {
+            for (csint p = Lp[j] + 1; p < Lp[j+1]; p++) {
+                z[j] -= Lx[p] * z[Li[p]];
+            }
+            z[j] /= Lx[Lp[j]];
+        }
+    };
+}
+
+
+/*------------------------------------------------------------------------------
+ *         Solvers
+ *----------------------------------------------------------------------------*/
+IterativeResult pcg(
+    const CSCMatrix& A,
+    const std::vector<double>& b,
+    const Preconditioner& M,
+    double tol,
+    csint max_iter,
+    const std::vector<double>& x0,
+    int threads
+)
+{
+    PhaseTimer timer("pcg");
+
+    IterativeResult res;
+    res.x = initial_guess(A, b, x0);
+
+    csint N = A.shape()[1];
+    double nnz = static_cast<double>(A.nnz());
+
+    if (max_iter <= 0) {
+        max_iter = N;
+    }
+
+    double bnorm = std::sqrt(dot(N, b.data(), b.data()));
+
+    if (bnorm == 0.0) {
+        std::fill(res.x.begin(), res.x.end(), 0.0);
+        res.converged = true;
+        return res;
+    }
+
+    // Allocate all of the work vectors up front
+    ColumnBlocks blocks = column_blocks(A, threads);
+    std::vector<double> r(N), p(N), q(N), z(M ? N : 0);
+    std::vector<double>& zr = M ? z : r;  // the preconditioned residual
+
+    double *x = res.x.data();
+
+    residual(A, x, b, r.data(), blocks.nthreads);
+
+    if (M) {
+        M(r, z);
+    }
+    p = zr;
+
+    double rr = dot(N, r.data(), r.data());
+    double rz = M ? dot(N, r.data(), z.data()) : rr;
+    double flops = 2 * nnz + 4 * N;
+
+    res.converged = (std::sqrt(rr) / bnorm <= tol);
+
+    while (!res.converged && res.iterations < max_iter) {
+        // q = A p, in the same pass as p^T A p
+        double pq = spmv_dot(A, p.data(), q.data(), blocks);
+
+        if (pq <= 0.0) {
+            throw std::runtime_error("Matrix not positive definite!");
+        }
+
+        double alpha = rz / pq;
+
+        // x += alpha p, r -= alpha q, and ||r||^2, in one pass
+        rr = axpy2_dot(N, alpha, p.data(), q.data(), x, r.data());
+
+        res.iterations++;
+
+        double rel = std::sqrt(rr) / bnorm;
+        res.history.push_back(rel);
+        flops += 2 * nnz + 8 * N;
+
+        if (rel <= tol) {
+            res.converged = true;
+            break;
+        }
+
+        double rz_new = rr;
+
+        if (M) {
+            M(r, z);
+            rz_new = dot(N, r.data(), z.data());
+            flops += 2 * N;
+
+            if (rz_new <= 0.0) {
+                throw std::runtime_error("Preconditioner not positive definite!");
+            }
+        }
+
+        double beta = rz_new / rz;
+        rz = rz_new;
+
+        xpby(N, zr.data(), beta, p.data());
+        flops += 2 * N;
+    }
+
+    residual(A, x, b, r.data(), blocks.nthreads);
+    res.residual = std::sqrt(dot(N, r.data(), r.data())) / bnorm;
+
+    record_solver(
+        flops + 2 * nnz + 2 * N,
+        memory_bytes(r) + memory_bytes(p) + memory_bytes(q) + memory_bytes(z)
+    );
+
+    return res;
+}
+
+
+IterativeResult minres(
+    const CSCMatrix& A,
+    const std::vector<double>& b,
+    const Preconditioner& M,
+    double tol,
+    csint max_iter,
+    const std::vector<double>& x0,
+    int threads
+)
+{
+    PhaseTimer timer("minres");
+
+    IterativeResult res;
+    res.x = initial_guess(A, b, x0);
+
+    csint N = A.shape()[1];
+    double nnz = static_cast<double>(A.nnz());
+
+    if (max_iter <= 0) {
+        max_iter = N;
+    }
+
+    // Allocate all of the work vectors up front
+    ColumnBlocks blocks = column_blocks(A, threads);
+    std::vector<double> r1(N), r2(N), y(N), v(N),
+                        w(N, 0.0), w1(N, 0.0), w2(N, 0.0);
+    const std::vector<double>& z = M ? y : r2;  // the preconditioned r2
+
+    double *x = res.x.data();
+
+    // The norm of b in the norm of the preconditioner
+    double bnorm = std::sqrt(dot(N, b.data(), b.data()));
+    double bnorm_M = bnorm;
+
+    if (M) {
+        M(b, y);
+        bnorm_M = std::sqrt(std::max(dot(N, b.data(), y.data()), 0.0));
+    }
+
+    if (bnorm == 0.0 || bnorm_M == 0.0) {
+        std::fill(res.x.begin(), res.x.end(), 0.0);
+        res.converged = true;
+        return res;
+    }
+
+    residual(A, x, b, r1.data(), blocks.nthreads);
+    r2 = r1;
+
+    if (M) {
+        M(r1, y);
+    }
+
+    double beta1 = dot(N, r1.data(), z.data());
+
+    if (beta1 < 0.0) {
+        throw std::runtime_error("Preconditioner not positive definite!");
+    }
+
+    beta1 = std::sqrt(beta1);
+
+    // Lanczos and QR recurrences
+    double oldb = 0.0,
+           beta = beta1,
+           dbar = 0.0,
+           epsln = 0.0,
+           phibar = beta1,
+           cs = -1.0,
+           sn = 0.0;
+
+    double flops = 2 * nnz + 7 * N;
+    constexpr double eps = std::numeric_limits<double>::epsilon();
+
+    res.converged = (beta1 / bnorm_M <= tol);
+
+    while (!res.converged && res.iterations < max_iter) {
+        // v = z / beta
+        double s = 1.0 / beta;
+        for (csint k = 0; k < N; k++) {
+            v[k] = s * z[k];
+        }
+
+        // y = A v - (beta / oldb) r1, in the same pass as alfa = v^T y
+        double c = (res.iterations > 0) ? beta / oldb : 0.0;
+        double alfa = spmv_axpy_dot(A, v.data(), c, r1.data(), y.data(), blocks);
+
+        // y -= (alfa / beta) r2, in the same pass as ||y||^2
+        double yy = axpy_dot(N, alfa / beta, r2.data(), y.data(), y.data());
+
+        std::swap(r1, r2);  // r1 = r2
+        std::swap(r2, y);   // r2 = y
+
+        oldb = beta;
+
+        if (M) {
+            M(r2, y);
+            beta = dot(N, r2.data(), y.data());
+            flops += 2 * N;
+
+            if (beta < 0.0) {
+                throw std::runtime_error("Preconditioner not positive definite!");
+            }
+        } else {
+            beta = yy;
+        }
+
+        beta = std::sqrt(beta);
+
+        // Apply the previous rotation, and compute the next one
+        double oldeps = epsln;
+        double delta = cs * dbar + sn * alfa;
+        double gbar = sn * dbar - cs * alfa;
+        epsln = sn * beta;
+        dbar = -cs * beta;
+
+        double gamma = std::max(std::hypot(gbar, beta), eps);
+        cs = gbar / gamma;
+        sn = beta / gamma;
+        double phi = cs * phibar;
+        phibar = sn * phibar;
+
+        // w = (v - oldeps w1 - delta w2) / gamma, and x += phi w, in one pass
+        std::swap(w1, w2);  // w1 = w2
+        std::swap(w2, w);   // w2 = w
+        double denom = 1.0 / gamma;
+        for (csint k = 0; k < N; k++) {
+            w[k] = (v[k] - oldeps * w1[k] - delta * w2[k]) * denom;
+            x[k] += phi * w[k];
+        }
+
+        res.iterations++;
+
+        double rel = std::abs(phibar) / bnorm_M;
+        res.history.push_back(rel);
+        flops += 2 * nnz + 17 * N;
+
+        if (rel <= tol || beta == 0.0) {
+            res.converged = true;
+        }
+    }
+
+    residual(A, x, b, r1.data(), blocks.nthreads);
+    res.residual = std::sqrt(dot(N, r1.data(), r1.data())) / bnorm;
+
+    record_solver(
+        flops + 2 * nnz + 4 * N,
+        7 * memory_bytes(r1)
+    );
+
+    return res;
+}
+
+
+IterativeResult gmres(
+    const CSCMatrix& A,
+    const std::vector<double>& b,
+    const Preconditioner& M,
+    double tol,
+    csint max_iter,
+    csint restart,
+    const std::vector<double>& x0,
+    int threads
+)
+{
+    PhaseTimer timer("gmres");
+
+    IterativeResult res;
+    res.x = initial_guess(A, b, x0);
+
+    csint N = A.shape()[1];
+    double nnz = static_cast<double>(A.nnz());
+
+    if (max_iter <= 0) {
+        max_iter = N;
+    }
+
+    csint m = (restart <= 0) ? N : std::min(restart, N);
+
+    double bnorm = std::sqrt(dot(N, b.data(), b.data()));
+
+    if (bnorm == 0.0) {
+        std::fill(res.x.begin(), res.x.end(), 0.0);
+        res.converged = true;
+        return res;
+    }
+
+    // Allocate all of the work vectors up front
+    const int nthreads = resolve_num_threads(threads, A.nnz());
+    std::vector<double> V((m + 1) * N),      // the Arnoldi basis
+                        H((m + 1) * m),      // the Hessenberg matrix
+                        cs(m), sn(m),        // the Givens rotations
+                        g(m + 1),            // the rotated RHS
+                        yh(m),               // the least-squares solution
+                        w(N),
+                        z(M ? N : 0);
+
+    auto Vcol = [&](csint j) { return V.data() + j * N; };
+    auto Hij = [&](csint i, csint j) -> double& { return H[i + j * (m + 1)]; };
+
+    double *x = res.x.data();
+    double flops = 0.0;
+
+    while (true) {
+        residual(A, x, b, w.data(), nthreads);
+        double beta = std::sqrt(dot(N, w.data(), w.data()));
+        flops += 2 * nnz + 3 * N;
+
+        res.residual = beta / bnorm;
+
+        if (res.residual <= tol) {
+            res.converged = true;
+            break;
+        }
+
+        if (res.iterations >= max_iter) {
+            break;
+        }
+
+        double *v0 = Vcol(0);
+        for (csint k = 0; k < N; k++) {
+            v0[k] = w[k] / beta;
+        }
+
+        std::fill(g.begin(), g.end(), 0.0);
+        g[0] = beta;
+
+        csint j = 0;
+
+        while (j < m && res.iterations < max_iter) {
+            // w = A M^{-1} v_j
+            const double *u = Vcol(j);
+            if (M) {
+                M(std::span<const double>(u, N), z);
+                u = z.data();
+            }
+            spmv(A, u, w.data(), nthreads);
+
+            // Modified Gram-Schmidt, with each projection fused with the
+            // inner product of the next basis vector, or the norm of w.
+            Hij(0, j) = dot(N, w.data(), v0);
+            double hh = 0.0;
+            for (csint i = 0; i <= j; i++) {
+                const double *next = (i < j) ? Vcol(i + 1) : w.data();
+                double d = axpy_dot(N, Hij(i, j), Vcol(i), w.data(), next);
+                if (i < j) {
+                    Hij(i + 1, j) = d;
+                } else {
+                    hh = d;
+                }
+            }
+
+            double h = std::sqrt(hh);
+            Hij(j + 1, j) = h;
+
+            if (h > 0.0) {
+                double *vn = Vcol(j + 1);
+                for (csint k = 0; k < N; k++) {
+                    vn[k] = w[k] / h;
+                }
+            }
+
+            // Apply the previous rotations to the new column
+            for (csint i = 0; i < j; i++) {
+                double t = cs[i] * Hij(i, j) + sn[i] * Hij(i + 1, j);
+                Hij(i + 1, j) = -sn[i] * Hij(i, j) + cs[i] * Hij(i + 1, j);
+                Hij(i, j) = t;
+            }
+
+            // Compute the rotation that eliminates H(j+1, j)
+            double denom = std::hypot(Hij(j, j), h);
+            if (denom == 0.0) {
+                cs[j] = 1.0;
+                sn[j] = 0.0;
+            } else {
+                cs[j] = Hij(j, j) / denom;
+                sn[j] = h / denom;
+            }
+            Hij(j, j) = denom;
+            Hij(j + 1, j) = 0.0;
+
+            g[j + 1] = -sn[j] * g[j];
+            g[j] = cs[j] * g[j];
+
+            j++;
+            res.iterations++;
+
+            double rel = std::abs(g[j]) / bnorm;
+            res.history.push_back(rel);
+            flops += 2 * nnz + (4 * j + 3) * N + 6 * j;
+
+            if (rel <= tol || h == 0.0) {
+                break;
+            }
+        }
+
+        // Solve the upper triangular system H y = g
+        for (csint i = j - 1; i >= 0; i--) {
+            double t = g[i];
+            for (csint k = i + 1; k < j; k++) {
+                t -= Hij(i, k) * yh[k];
+            }
+            yh[i] = (Hij(i, i) != 0.0) ? t / Hij(i, i) : 0.0;
+        }
+
+        // x += M^{-1} V y
+        std::fill(w.begin(), w.end(), 0.0);
+        for (csint k = 0; k < j; k++) {
+            const double *vk = Vcol(k);
+            for (csint l = 0; l < N; l++) {
+                w[l] += yh[k] * vk[l];
+            }
+        }
+
+        const double *dx = w.data();
+        if (M) {
+            M(w, z);
+            dx = z.data();
+        }
+
+        for (csint k = 0; k < N; k++) {
+            x[k] += dx[k];
+        }
+
+        flops += (2 * j + 1) * N + j * j;
+    }
+
+    record_solver(
+        flops,
+        memory_bytes(V) + memory_bytes(H) + memory_bytes(w) + memory_bytes(z)
+    );
+
+    return res;
+}
+
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/
@@ -0,0 +1,205 @@
+/*==============================================================================
+ *     File: lu.cpp
+ *  Created: 2025-03-17 09:20
+ *   Author: Bernie Roesler
+ *
+ *  Description: Implements the sparse LU decomposition.
+ *
+ *============================================================================*/
+
+#include <cmath>      // std::fabs
+#include <numeric>    // std::iota
+#include <stdexcept>
+#include <vector>
+
+#include "amd.h"
+#include "csc.h"
+#include "lu.h"
+#include "solve.h"
+#include "stats.h"
+#include "utils.h"
+
+namespace cs {
+
+SymbolicLU slu(const CSCMatrix& A, AMDOrder order)
+{
+    PhaseTimer timer("slu");
+
+    auto [M, N] = A.shape();
+
+    if (M != N) {
+        throw std::runtime_error("Matrix must be square for LU decomposition!");
+    }
+
+    SymbolicLU S;
+
+    if (order == AMDOrder::Natural) {
+        S.q.resize(N);
+        std::iota(S.q.begin(), S.q.end(), 0);  // identity permutation
+    } else {
+        S.q = amd(A, order);  // Q = amd(A + A.T()) or amd(A.T() * A)
+    }
+
+    // Guess nnz(L) and nnz(U), which may grow in the numeric factorization
+    S.unz = 4 * A.p_[N] + N;
+    S.lnz = S.unz;
+
+    return S;
+}
+
+
+// Count the flops of an LU factorization with factors L and U. Each
+// off-diagonal U(i, k) updates column k with the strictly lower part of
+// L(:, i), and each column k is divided by the pivot.
+static double lu_flops(const CSCMatrix& L, const CSCMatrix& U)
+{
+    const auto& Lp = L.indptr();
+    const auto& Up = U.indptr();
+    const auto& Ui = U.indices();
+
+    double flops = 0;
+    for (csint k = 0; k < U.shape()[1]; k++) {
+        for (csint p = Up[k]; p < Up[k+1] - 1; p++) {
+            csint i = Ui[p];
+            flops += 2.0 * (Lp[i+1] - Lp[i] - 1);
+        }
+        flops += Lp[k+1] - Lp[k] - 1;
+    }
+    return flops;
+}
+
+
+LUResult lu(const CSCMatrix& A, const SymbolicLU& S, double tol)
+{
+    PhaseTimer timer("lu");
+
+    csint N = A.N_;
+
+    // Allocate workspaces
+    std::vector<double> x(N);
+    std::vector<csint> xi;
+    xi.reserve(N);
+    std::vector<bool> marked(N, false);
+
+    // Allocate the result
+    CSCMatrix L({N, N}, S.lnz);
+    CSCMatrix U({N, N}, S.unz);
+    std::vector<csint> p_inv(N, -1);  // no rows pivotal yet
+
+    csint lnz = 0,
+          unz = 0;
+
+    for (csint k = 0; k < N; k++) {
+        // --- Triangular solve ------------------------------------------------
+        L.p_[k] = lnz;  // L(:, k) starts here
+        U.p_[k] = unz;  // U(:, k) starts here
+
+        // Grow L and U if the next column might not fit. The arrays are
+        // sized to their allocation, so nnz() is the current capacity.
+        if (lnz + N > L.nnz()) {
+            L.realloc(2 * L.nnz() + N);
+        }
+        if (unz + N > U.nnz()) {
+            U.realloc(2 * U.nnz() + N);
+        }
+
+        csint col = S.q[k];
+
+        // Solve x = L \ A(:, col), where L has the unpivoted rows removed
+        spsolve(L, A, col, marked, xi, x, true, p_inv);
+
+        // --- Find the pivot --------------------------------------------------
+        csint ipiv = -1;
+        double a = -1;
+
+        for (const auto& i : xi) {
+            if (p_inv[i] < 0) {
+                // row i is not yet pivotal
+                double t = std::fabs(x[i]);
+                if (t > a) {
+                    a = t;  // largest pivot candidate so far
+                    ipiv = i;
+                }
+            } else {
+                // x(i) is the entry U(p_inv[i], k)
+                U.i_[unz] = p_inv[i];
+                U.v_[unz++] = x[i];
+            }
+        }
+
+        if (ipiv == -1 || a <= 0) {
+            throw std::runtime_error("Matrix is singular!");
+        }
+
+        // Prefer the diagonal, if it is large enough
+        if (p_inv[col] < 0 && x[col] != 0 && std::fabs(x[col]) >= a * tol) {
+            ipiv = col;
+        }
+
+        // --- Divide by the pivot ---------------------------------------------
+        double pivot = x[ipiv];  // the chosen pivot
+        U.i_[unz] = k;           // last entry in U(:, k) is U(k, k)
+        U.v_[unz++] = pivot;
+        p_inv[ipiv] = k;         // ipiv is the kth pivot row
+        L.i_[lnz] = ipiv;        // first entry in L(:, k) is L(k, k) = 1
+        L.v_[lnz++] = 1;
+
+        for (const auto& i : xi) {
+            if (p_inv[i] < 0) {
+                // x(i) is an entry in L(:, k)
+                L.i_[lnz] = i;
+                L.v_[lnz++] = x[i] / pivot;
+            }
+            x[i] = 0;  // clear x for the next column
+        }
+    }
+
+    // --- Finalize L and U ----------------------------------------------------
+    L.p_[N] = lnz;
+    U.p_[N] = unz;
+
+    // Fix the row indices of L with the final p_inv
+    for (csint p = 0; p < lnz; p++) {
+        L.i_[p] = p_inv[L.i_[p]];
+    }
+
+    // Remove extra space
+    L.realloc();
+    U.realloc();
+
+    if (Stats *stats = get_stats()) {
+        stats->flops += lu_flops(L, U);
+        record_memory(memory_bytes(L) + memory_bytes(U) + memory_bytes(p_inv)
+                      + memory_bytes(x) + memory_bytes(xi));
+    }
+
+    return {std::move(L), std::move(U), std::move(p_inv), S.q};
+}
+
+
+std::vector<double> lusolve(
+    const CSCMatrix& A,
+    const std::vector<double>& b,
+    AMDOrder order,
+    double tol
+)
+{
+    SymbolicLU S = slu(A, order);
+    LUResult res = lu(A, S, tol);
+    return lusolve(res, b);
+}
+
+
+std::vector<double> lusolve(const LUResult& res, const std::vector<double>& b)
+{
+    std::vector<double> x = ipvec(res.p_inv, b);  // x = P b
+    x = lsolve(res.L, x);                         // x = L \ x
+    x = usolve(res.U, x);                         // x = U \ x
+    return ipvec(res.q, x);                       // b(q) = x
+}
+
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/
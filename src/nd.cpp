@@ -0,0 +1,624 @@
+/*==============================================================================
+ *     File: nd.cpp
+ *  Created: 2025-03-28 09:30
+ *   Author: Bernie Roesler
+ *
+ *  Description: Implements the nested dissection ordering, with separators
+ *    from multilevel graph bisection.
+ *
+ *============================================================================*/
+
+#include <algorithm>  // std::min, std::max, std::shuffle, std::stable_sort
+#include <numeric>    // std::iota
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <utility>    // std::pair
+#include <vector>
+
+#include "amd.h"
+#include "csc.h"
+#include "nd.h"
+
+namespace cs {
+
+/*------------------------------------------------------------------------------
+ *         Helpers
+ *----------------------------------------------------------------------------*/
+namespace {
+
+/** A graph with weighted vertices and edges, stored by columns. */
+struct Graph
+{
+    std::vector<csint> p,   // the neighbors of vertex j are i[p[j]:p[j+1]]
+                       i,
+                       ew,  // the weight of each edge
+                       vw;  // the weight of each vertex
+
+    csint n() const { return static_cast<csint>(p.size()) - 1; }
+};
+
+
+/** The graph of a symmetric pattern, with unit weights. */
+Graph unit_graph(std::vector<csint> p, std::vector<csint> i)
+{
+    Graph G;
+    G.p = std::move(p);
+    G.i = std::move(i);
+    G.ew.assign(G.i.size(), 1);
+    G.vw.assign(G.n(), 1);
+    return G;
+}
+
+
+/** The subgraph induced by the vertices in `part == side`.
+ *
+ * @param G  the graph
+ * @param part  the part of each vertex
+ * @param side  the part to keep
+ * @param[out] verts  the vertices of `G` in the subgraph
+ * @param loc  a workspace of size `G.n()`
+ */
+Graph subgraph(
+    const Graph& G,
+    const std::vector<csint>& part,
+    csint side,
+    std::vector<csint>& verts,
+    std::vector<csint>& loc
+)
+{
+    verts.clear();
+    for (csint v = 0; v < G.n(); v++) {
+        if (part[v] == side) {
+            loc[v] = static_cast<csint>(verts.size());
+            verts.push_back(v);
+        }
+    }
+
+    std::vector<csint> p {0}, i;
+    for (const auto& v : verts) {
+        for (csint q = G.p[v]; q < G.p[v+1]; q++) {
+            if (part[G.i[q]] == side) {
+                i.push_back(loc[G.i[q]]);
+            }
+        }
+        p.push_back(static_cast<csint>(i.size()));
+    }
+
+    return unit_graph(std::move(p), std::move(i));
+}
+
+
+/** Coarsen a graph by heavy-edge matching.
+ *
+ * The vertices are visited in a random order, and each unmatched vertex is
+ * matched with the unmatched neighbor that shares its heaviest edge.
+ *
+ * @param G  the graph to coarsen
+ * @param[out] cmap  the coarse vertex of each vertex of `G`
+ * @param rng  the random number generator
+ *
+ * @return Gc  the coarse graph
+ */
+Graph coarsen(const Graph& G, std::vector<csint>& cmap, std::mt19937& rng)
+{
+    csint n = G.n();
+
+    std::vector<csint> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<csint> match(n, -1);
+    for (const auto& u : order) {
+        if (match[u] >= 0) {
+            continue;
+        }
+
+        csint best = u,
+              best_w = 0;
+
+        for (csint q = G.p[u]; q < G.p[u+1]; q++) {
+            csint v = G.i[q];
+            if (match[v] < 0 && v != u && G.ew[q] > best_w) {
+                best = v;
+                best_w = G.ew[q];
+            }
+        }
+
+        match[u] = best;
+        match[best] = u;
+    }
+
+    // Number the coarse vertices in the order of their first fine vertex
+    cmap.assign(n, -1);
+    std::vector<csint> rep;  // the first fine vertex of each coarse vertex
+    for (csint u = 0; u < n; u++) {
+        if (cmap[u] < 0) {
+            cmap[u] = cmap[match[u]] = static_cast<csint>(rep.size());
+            rep.push_back(u);
+        }
+    }
+
+    csint nc = static_cast<csint>(rep.size());
+
+    Graph Gc;
+    Gc.p.assign(1, 0);
+    Gc.vw.resize(nc);
+
+    // Merge the neighbors of each pair, summing the weights of parallel edges
+    std::vector<csint> pos(nc, -1);
+    for (csint c = 0; c < nc; c++) {
+        csint u = rep[c],
+              start = Gc.p[c];
+
+        Gc.vw[c] = G.vw[u] + ((match[u] != u) ? G.vw[match[u]] : 0);
+
+        for (csint x : {u, match[u]}) {
+            for (csint q = G.p[x]; q < G.p[x+1]; q++) {
+                csint cy = cmap[G.i[q]];
+                if (cy == c) {
+                    continue;
+                }
+                if (pos[cy] < start) {
+                    pos[cy] = static_cast<csint>(Gc.i.size());
+                    Gc.i.push_back(cy);
+                    Gc.ew.push_back(G.ew[q]);
+                } else {
+                    Gc.ew[pos[cy]] += G.ew[q];
+                }
+            }
+            if (x == match[u]) {
+                break;  // x == u when u is unmatched
+            }
+        }
+
+        Gc.p.push_back(static_cast<csint>(Gc.i.size()));
+    }
+
+    return Gc;
+}
+
+
+/** Compute the weight of the edges cut by a bisection. */
+csint edge_cut(const Graph& G, const std::vector<csint>& part)
+{
+    csint cut = 0;
+    for (csint v = 0; v < G.n(); v++) {
+        for (csint q = G.p[v]; q < G.p[v+1]; q++) {
+            if (part[G.i[q]] != part[v]) {
+                cut += G.ew[q];
+            }
+        }
+    }
+    return cut / 2;
+}
+
+
+/** Refine a bisection with Fiduccia-Mattheyses passes.
+ *
+ * Each pass moves the boundary vertex of largest gain to the other part, as
+ * long as that part stays below `max_weight`, and locks it. The pass stops
+ * after a run of moves that do not improve the cut, and the moves after the
+ * best cut are undone.
+ *
+ * @param G  the graph
+ * @param[in,out] part  the part, 0 or 1, of each vertex
+ * @param max_weight  the largest weight of either part
+ *
+ * @return cut  the weight of the edges cut by the refined bisection
+ */
+csint refine(const Graph& G, std::vector<csint>& part, csint max_weight)
+{
+    constexpr int MAX_PASSES = 4;
+    constexpr csint MAX_BAD_MOVES = 64;
+
+    csint n = G.n();
+    csint pw[2] = {0, 0};
+    for (csint v = 0; v < n; v++) {
+        pw[part[v]] += G.vw[v];
+    }
+
+    csint cut = edge_cut(G, part);
+
+    std::vector<csint> gain(n), moves;
+    std::vector<char> locked(n);
+
+    for (int pass = 0; pass < MAX_PASSES; pass++) {
+        std::priority_queue<std::pair<csint, csint>> pq;  // (gain, vertex)
+
+        for (csint v = 0; v < n; v++) {
+            csint g = 0;
+            bool boundary = false;
+            for (csint q = G.p[v]; q < G.p[v+1]; q++) {
+                if (part[G.i[q]] != part[v]) {
+                    g += G.ew[q];
+                    boundary = true;
+                } else {
+                    g -= G.ew[q];
+                }
+            }
+            gain[v] = g;
+            locked[v] = 0;
+            if (boundary) {
+                pq.emplace(g, v);
+            }
+        }
+
+        moves.clear();
+        csint best_cut = cut,
+              best_diff = std::abs(pw[0] - pw[1]);
+        std::size_t best_moves = 0;
+
+        while (!pq.empty()) {
+            auto [g, v] = pq.top();
+            pq.pop();
+
+            if (locked[v] || g != gain[v]) {
+                continue;  // stale entry
+            }
+
+            csint s = part[v],
+                  t = 1 - s;
+
+            if (pw[t] + G.vw[v] > max_weight) {
+                continue;
+            }
+
+            // Move v from s to t
+            part[v] = t;
+            pw[s] -= G.vw[v];
+            pw[t] += G.vw[v];
+            cut -= g;
+            locked[v] = 1;
+            moves.push_back(v);
+
+            for (csint q = G.p[v]; q < G.p[v+1]; q++) {
+                csint u = G.i[q];
+                gain[u] += (part[u] == t) ? -2 * G.ew[q] : 2 * G.ew[q];
+                if (!locked[u]) {
+                    pq.emplace(gain[u], u);
+                }
+            }
+
+            csint diff = std::abs(pw[0] - pw[1]);
+            if (cut < best_cut || (cut == best_cut && diff < best_diff)) {
+                best_cut = cut;
+                best_diff = diff;
+                best_moves = moves.size();
+            } else if (static_cast<csint>(moves.size() - best_moves) > MAX_BAD_MOVES) {
+                break;
+            }
+        }
+
+        // Undo the moves after the best cut
+        for (std::size_t k = moves.size(); k > best_moves; k--) {
+            csint v = moves[k-1];
+            pw[part[v]] -= G.vw[v];
+            part[v] = 1 - part[v];
+            pw[part[v]] += G.vw[v];
+        }
+
+        cut = best_cut;
+
+        if (best_moves == 0) {
+            break;  // no improvement
+        }
+    }
+
+    return cut;
+}
+
+
+/** Bisect a small graph by growing a region from several start vertices.
+ *
+ * Part 0 grows in breadth-first order from the start vertex, until it holds
+ * half of the weight of the graph. Each bisection is refined, and the one with
+ * the smallest cut is kept.
+ *
+ * @param G  the graph
+ * @param max_weight  the largest weight of either part
+ * @param rng  the random number generator
+ *
+ * @return part  the part, 0 or 1, of each vertex
+ */
+std::vector<csint> grow_bisection(const Graph& G, csint max_weight, std::mt19937& rng)
+{
+    constexpr int NUM_TRIES = 8;
+
+    csint n = G.n();
+    csint total = 0;
+    for (const auto& w : G.vw) {
+        total += w;
+    }
+
+    std::vector<csint> best_part, part(n);
+    csint best_cut = -1;
+
+    std::vector<csint> queue;
+    queue.reserve(n);
+
+    std::uniform_int_distribution<csint> pick(0, n - 1);
+
+    for (int t = 0; t < std::min<csint>(NUM_TRIES, n); t++) {
+        std::fill(part.begin(), part.end(), 1);
+        csint w0 = 0;
+        csint next_start = 0;  // restart here if the graph is disconnected
+
+        queue.clear();
+        csint start = (t == 0) ? 0 : pick(rng);
+        queue.push_back(start);
+        part[start] = 0;
+        w0 += G.vw[start];
+
+        for (std::size_t head = 0; 2 * w0 < total; head++) {
+            if (head == queue.size()) {
+                while (part[next_start] == 0) {
+                    next_start++;
+                }
+                queue.push_back(next_start);
+                part[next_start] = 0;
+                w0 += G.vw[next_start];
+            }
+
+            csint v = queue[head];
+            for (csint q = G.p[v]; q < G.p[v+1] && 2 * w0 < total; q++) {
+                csint u = G.i[q];
+                if (part[u] == 1) {
+                    part[u] = 0;
+                    w0 += G.vw[u];
+                    queue.push_back(u);
+                }
+            }
+        }
+
+        csint cut = refine(G, part, max_weight);
+
+        if (best_cut < 0 || cut < best_cut) {
+            best_cut = cut;
+            best_part = part;
+        }
+    }
+
+    return best_part;
+}
+
+
+/** Bisect a graph by multilevel coarsening, bisection and refinement. */
+std::vector<csint> multilevel_bisection(const Graph& G, std::mt19937& rng)
+{
+    constexpr csint COARSEST = 64;  // stop coarsening at this many vertices
+
+    csint total = G.n();  // unit weights
+    csint max_weight = total / 2 + std::max<csint>(1, total / 20);
+
+    // Coarsen until the graph is small, or the matching stops reducing it
+    std::vector<Graph> levels;
+    std::vector<std::vector<csint>> cmaps;
+
+    const Graph *Gf = &G;
+    while (Gf->n() > COARSEST) {
+        std::vector<csint> cmap;
+        Graph Gc = coarsen(*Gf, cmap, rng);
+        if (10 * Gc.n() > 9 * Gf->n()) {
+            break;
+        }
+        levels.push_back(std::move(Gc));
+        cmaps.push_back(std::move(cmap));
+        Gf = &levels.back();
+    }
+
+    std::vector<csint> part = grow_bisection(*Gf, max_weight, rng);
+
+    // Project the bisection back to each finer graph, and refine it
+    for (csint l = static_cast<csint>(levels.size()) - 1; l >= 0; l--) {
+        const Graph& Gl = (l == 0) ? G : levels[l-1];
+        std::vector<csint> fine(Gl.n());
+        for (csint v = 0; v < Gl.n(); v++) {
+            fine[v] = part[cmaps[l][v]];
+        }
+        part = std::move(fine);
+        refine(Gl, part, max_weight);
+    }
+
+    return part;
+}
+
+
+/** Cover the edges cut by a bisection with a vertex separator.
+ *
+ * The boundary vertices are visited in decreasing order of their cut edges,
+ * and each one that still has an uncovered cut edge joins the separator.
+ * Separator vertices that only touch one half are then moved into it.
+ *
+ * @param G  the graph
+ * @param[in,out] part  the part, 0 or 1, of each vertex. On output, the
+ *        separator vertices are in part 2.
+ */
+void edge_to_vertex_separator(const Graph& G, std::vector<csint>& part)
+{
+    csint n = G.n();
+
+    std::vector<csint> cut_degree(n, 0), boundary;
+    for (csint v = 0; v < n; v++) {
+        for (csint q = G.p[v]; q < G.p[v+1]; q++) {
+            if (part[G.i[q]] != part[v]) {
+                cut_degree[v]++;
+            }
+        }
+        if (cut_degree[v] > 0) {
+            boundary.push_back(v);
+        }
+    }
+
+    std::stable_sort(boundary.begin(), boundary.end(),
+        [&](csint a, csint b) { return cut_degree[a] > cut_degree[b]; });
+
+    // Cover the cut edges. A cut edge joins parts 0 and 1, so it is covered
+    // once either end is in the separator.
+    for (const auto& v : boundary) {
+        for (csint q = G.p[v]; q < G.p[v+1]; q++) {
+            csint u = G.i[q];
+            if (part[u] != 2 && part[u] != part[v]) {
+                part[v] = 2;
+                break;
+            }
+        }
+    }
+
+    csint size[3] = {0, 0, 0};
+    for (const auto& s : part) {
+        size[s]++;
+    }
+
+    // Move the separator vertices that do not touch both halves
+    for (const auto& v : boundary) {
+        if (part[v] != 2) {
+            continue;
+        }
+
+        bool touches[2] = {false, false};
+        for (csint q = G.p[v]; q < G.p[v+1]; q++) {
+            csint s = part[G.i[q]];
+            if (s < 2) {
+                touches[s] = true;
+            }
+        }
+
+        if (!touches[0] || !touches[1]) {
+            csint side = (touches[0] || touches[1])
+                ? (touches[0] ? 0 : 1)
+                : (size[0] <= size[1] ? 0 : 1);  // isolated: the smaller half
+            part[v] = side;
+            size[side]++;
+            size[2]--;
+        }
+    }
+}
+
+
+/** Order a small graph by minimum degree, and append it to `P`. */
+void order_leaf(const Graph& G, const std::vector<csint>& labels, std::vector<csint>& P)
+{
+    csint n = G.n();
+
+    if (n <= 2) {
+        P.insert(P.end(), labels.begin(), labels.end());
+        return;
+    }
+
+    CSCMatrix C(std::vector<double>(G.i.size(), 1.0), G.i, G.p, {n, n});
+
+    for (const auto& k : amd(C, AMDOrder::APlusAT)) {
+        P.push_back(labels[k]);
+    }
+}
+
+
+/** Order a graph by nested dissection, and append it to `P`.
+ *
+ * @param G  the graph, with unit weights
+ * @param labels  the vertex of the original graph of each vertex of `G`
+ * @param leaf_size  the largest graph that is ordered by minimum degree
+ * @param rng  the random number generator
+ * @param[in,out] P  the permutation
+ */
+void dissect(
+    const Graph& G,
+    const std::vector<csint>& labels,
+    csint leaf_size,
+    std::mt19937& rng,
+    std::vector<csint>& P
+)
+{
+    csint n = G.n();
+
+    if (n <= leaf_size) {
+        order_leaf(G, labels, P);
+        return;
+    }
+
+    std::vector<csint> part = multilevel_bisection(G, rng);
+    edge_to_vertex_separator(G, part);
+
+    csint size[3] = {0, 0, 0};
+    for (const auto& s : part) {
+        size[s]++;
+    }
+
+    if (size[0] == 0 || size[1] == 0) {
+        order_leaf(G, labels, P);  // no useful separator
+        return;
+    }
+
+    // Order each half, then the separator
+    std::vector<csint> verts, loc(n);
+    for (csint side = 0; side < 2; side++) {
+        Graph Gs = subgraph(G, part, side, verts, loc);
+        std::vector<csint> sub_labels(verts.size());
+        for (std::size_t k = 0; k < verts.size(); k++) {
+            sub_labels[k] = labels[verts[k]];
+        }
+        dissect(Gs, sub_labels, leaf_size, rng, P);
+    }
+
+    for (csint v = 0; v < n; v++) {
+        if (part[v] == 2) {
+            P.push_back(labels[v]);
+        }
+    }
+}
+
+}  // namespace
+
+
+/*------------------------------------------------------------------------------
+ *         Nested Dissection
+ *----------------------------------------------------------------------------*/
+std::vector<csint> vertex_separator(const CSCMatrix& C, unsigned seed)
+{
+    auto [M, N] = C.shape();
+    if (M != N) {
+        throw std::runtime_error("Graph must be square!");
+    }
+
+    std::mt19937 rng(seed);
+    Graph G = unit_graph(C.indptr(), C.indices());
+
+    std::vector<csint> part = multilevel_bisection(G, rng);
+    edge_to_vertex_separator(G, part);
+
+    return part;
+}
+
+
+std::vector<csint> nested_dissection(
+    const CSCMatrix& A,
+    const AMDOrder graph,
+    csint leaf_size
+)
+{
+    if (graph == AMDOrder::Natural || graph == AMDOrder::NestedDissection) {
+        throw std::runtime_error("Nested dissection requires a graph order!");
+    }
+
+    CSCMatrix C = build_graph(A, graph);
+    csint N = C.shape()[1];
+
+    std::vector<csint> labels(N);
+    std::iota(labels.begin(), labels.end(), 0);
+
+    std::mt19937 rng(0);  // the ordering is deterministic
+    std::vector<csint> P;
+    P.reserve(N);
+
+    dissect(unit_graph(C.indptr(), C.indices()), labels,
+            std::max<csint>(leaf_size, 1), rng, P);
+
+    return P;
+}
+
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/
@@ -0,0 +1,224 @@
+/*==============================================================================
+ *     File: parallel.cpp
+ *  Created: 2025-03-12 09:44
+ *   Author: Bernie Roesler
+ *
+ *  Description: Thread configuration and scheduling helpers.
+ *
+ *============================================================================*/
+
+#include <algorithm>  // std::lower_bound, std::clamp
+#include <atomic>
+#include <condition_variable>
+#include <exception>  // std::exception_ptr
+#include <latch>
+#include <memory>     // std::unique_ptr
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "parallel.h"
+
+namespace cs {
+
+static std::atomic<int> default_num_threads {1};
+
+
+int get_num_threads()
+{
+    return default_num_threads.load();
+}
+
+
+void set_num_threads(int nthreads)
+{
+    if (nthreads <= 0) {
+        nthreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    default_num_threads.store(nthreads);
+}
+
+
+int resolve_num_threads(int threads, csint work)
+{
+    if (threads <= 0) {
+        threads = get_num_threads();
+    }
+
+    csint max_threads = std::max(csint{1}, work / MIN_NNZ_PER_THREAD);
+
+    return static_cast<int>(std::min(static_cast<csint>(threads), max_threads));
+}
+
+
+std::vector<csint> partition_nnz(const std::vector<csint>& indptr, int nparts)
+{
+    const csint N = indptr.size() - 1;
+    const csint nnz = indptr.back();
+
+    std::vector<csint> bounds(nparts + 1);
+    bounds[0] = 0;
+    bounds[nparts] = N;
+
+    for (int t = 1; t < nparts; t++) {
+        // First column that starts at or after the target number of non-zeros
+        csint target = (nnz * t) / nparts;
+        auto it = std::lower_bound(indptr.begin(), indptr.end() - 1, target);
+        bounds[t] = std::clamp(
+            static_cast<csint>(it - indptr.begin()),
+            bounds[t-1],
+            N
+        );
+    }
+
+    return bounds;
+}
+
+
+namespace {
+
+/** A pool of persistent worker threads.
+ *
+ * Each call takes its workers from the idle ones, and starts new workers only
+ * if there are not enough, so the workers of a call always run concurrently.
+ * The kernels may then synchronize their threads (e.g. with `std::barrier`),
+ * and may call `parallel_for` from a worker, or from several threads at once.
+ */
+class ThreadPool
+{
+    struct Worker {
+        std::thread thread;
+        std::condition_variable cv;
+        std::function<void()> task;  // empty while the worker is idle
+        std::latch *done = nullptr;
+    };
+
+    std::mutex mtx_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<Worker*> idle_;
+    bool stop_ = false;
+
+    void loop(Worker *w)
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        while (true) {
+            w->cv.wait(lock, [&] { return w->task || stop_; });
+            if (!w->task) {
+                return;  // stopped
+            }
+
+            std::function<void()> task = std::move(w->task);
+            std::latch *done = w->done;
+            w->task = nullptr;
+
+            lock.unlock();
+            task();
+            lock.lock();
+
+            // Return to the idle list before the caller can see the task done,
+            // so that its next call reuses this worker
+            idle_.push_back(w);
+            done->count_down();
+        }
+    }
+
+    public:
+        ThreadPool() = default;
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                stop_ = true;
+                for (auto& w : workers_) {
+                    w->cv.notify_one();
+                }
+            }
+
+            for (auto& w : workers_) {
+                w->thread.join();
+            }
+        }
+
+        /** Run each task on its own worker, and count down `done` as each
+         * task finishes.
+         */
+        void run(std::vector<std::function<void()>>& tasks, std::latch& done)
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+
+            for (auto& task : tasks) {
+                Worker *w;
+                if (idle_.empty()) {
+                    workers_.push_back(std::make_unique<Worker>());
+                    w = workers_.back().get();
+                    w->thread = std::thread(&ThreadPool::loop, this, w);
+                } else {
+                    w = idle_.back();
+                    idle_.pop_back();
+                }
+
+                w->task = std::move(task);
+                w->done = &done;
+                w->cv.notify_one();
+            }
+        }
+};
+
+
+ThreadPool& thread_pool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+}  // namespace
+
+
+void parallel_for(int nthreads, const std::function<void(int)>& f)
+{
+    if (nthreads <= 1) {
+        f(0);
+        return;
+    }
+
+    std::latch done(nthreads - 1);
+    std::mutex error_mtx;
+    std::exception_ptr error;
+
+    auto run = [&](int t) {
+        try {
+            f(t);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mtx);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(nthreads - 1);
+
+    for (int t = 1; t < nthreads; t++) {
+        tasks.emplace_back([&, t] { run(t); });
+    }
+
+    thread_pool().run(tasks, done);
+
+    run(0);  // run the first chunk on the calling thread
+    done.wait();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/
@@ -11,29 +11,310 @@
 #include <pybind11/stl.h>
 #include <pybind11/numpy.h>
 
+#include <unordered_map>
+#include <utility>  // std::exchange
+
 #include "csparse.h"
 
 namespace py = pybind11;
 
 
-/** Convert an array to a NumPy array.
+/** Run a function with the GIL released, and return its result.
  *
- * @param self  the array to convert
+ * @param f  the function to run. It must not touch any Python objects.
  *
- * @return a NumPy array with the same data as the array
+ * @return the result of `f()`
+ */
+template <typename F>
+auto without_gil(F&& f)
+{
+    py::gil_scoped_release release;
+    return f();
+}
+
+
+/** Convert an array to a NumPy array by taking ownership of its storage.
+ *
+ * The vector is moved to the heap and its buffer is wrapped by the NumPy
+ * array without copying. The array owns the vector through a capsule, which
+ * frees it when the array is garbage collected.
+ *
+ * @param vec  the array to convert
+ *
+ * @return a NumPy array that owns the data of the array
  */
 template <typename T>
-auto vector_to_numpy(const std::vector<T>& vec)
+py::array_t<T> vector_to_numpy(std::vector<T>&& vec)
 {
-    auto result = py::array_t<T>(vec.size());
-    py::buffer_info buf = result.request();
-    T* ptr = static_cast<T*>(buf.ptr);
-    std::memcpy(ptr, vec.data(), vec.size() * sizeof(T));
+    auto *owned = new std::vector<T>(std::move(vec));
+    py::capsule owner(owned, [](void *p) {
+        delete static_cast<std::vector<T>*>(p);
+    });
+    return py::array_t<T>(owned->size(), owned->data(), owner);
+};
+
+
+/** Create a read-only NumPy view of an array owned by a Python object.
+ *
+ * The view holds a reference to `base`, so the array stays alive as long as
+ * the view does. No data is copied.
+ *
+ * @param vec  the array to view
+ * @param base  the Python object that owns `vec`
+ *
+ * @return a read-only NumPy array that shares the data of `vec`
+ */
+template <typename T>
+py::array_t<T> vector_view(const std::vector<T>& vec, py::handle base)
+{
+    py::array_t<T> result(vec.size(), vec.data(), base);
+    result.attr("setflags")(py::arg("write")=false);
     return result;
 };
 
 
+/** The number of live views of the arrays of each object, and of the calls
+ * using it (see `UseGuard`), by its address, or -1 if the object is being
+ * modified (see `MutationGuard`).
+ *
+ * Only accessed with the GIL held.
+ */
+std::unordered_map<const void*, cs::csint>& borrow_counts()
+{
+    // Never destroyed, since views may outlive the module at exit
+    static auto *counts = new std::unordered_map<const void*, cs::csint>();
+    return *counts;
+}
+
+
+/** Create the base of the views of the arrays of a mutable object.
+ *
+ * The mutating bindings of the object refuse to run while the base is alive,
+ * since they may reallocate the arrays under the views (see
+ * `check_not_borrowed`).
+ *
+ * @param obj  the object that owns the arrays
+ * @param base  the Python object that owns `obj`
+ *
+ * @return a capsule that keeps `base` alive, and counts as a borrow of `obj`
+ *         until it is garbage collected.
+ */
+py::object borrow(const void *obj, py::handle base)
+{
+    struct Borrow {
+        const void *obj;
+        py::object base;
+    };
+
+    cs::csint& count = borrow_counts()[obj];
+    if (count < 0) {
+        throw py::buffer_error("Cannot view the arrays of an object while it is being modified.");
+    }
+    count++;
+
+    auto *b = new Borrow {obj, py::reinterpret_borrow<py::object>(base)};
+
+    // Python destroys the capsule with the GIL held
+    return py::capsule(b, [](void *p) {
+        auto *b = static_cast<Borrow*>(p);
+        auto& counts = borrow_counts();
+        if (--counts[b->obj] == 0) {
+            counts.erase(b->obj);
+        }
+        delete b;
+    });
+}
+
+
+/** Refuse to mutate an object while views of its arrays are alive.
+ *
+ * @param obj  the object to mutate
+ *
+ * @throws py::buffer_error if a view created with `borrow` is alive, if
+ *         another call is using the object, or if the object is being
+ *         modified by another call
+ */
+void check_not_borrowed(const void *obj)
+{
+    auto it = borrow_counts().find(obj);
+    if (it == borrow_counts().end()) {
+        return;
+    }
+
+    if (it->second < 0) {
+        throw py::buffer_error("Cannot modify an object while it is being modified.");
+    }
+
+    throw py::buffer_error(
+        "Cannot modify an object while NumPy views of its arrays exist, or "
+        "while another call is using it. Delete the views, or copy them with "
+        "np.array(), and wait for the pending calls."
+    );
+}
+
+
+/** Mark an object as being modified for the lifetime of the guard.
+ *
+ * No views of the object may be created, and no other modification may
+ * start, until the guard is destroyed. The guard is created and destroyed
+ * with the GIL held, but the GIL may be released in between.
+ */
+class MutationGuard
+{
+    const void *obj_;
+
+    public:
+        explicit MutationGuard(const void *obj) : obj_(obj)
+        {
+            check_not_borrowed(obj_);
+            borrow_counts()[obj_] = -1;
+        }
+
+        ~MutationGuard() { borrow_counts().erase(obj_); }
+
+        MutationGuard(const MutationGuard&) = delete;
+        MutationGuard& operator=(const MutationGuard&) = delete;
+};
+
+
+/** Mark objects as in use by a call for the lifetime of the guard.
+ *
+ * The objects count as borrowed (see `borrow`), so that their mutating
+ * bindings refuse to run on another thread while the call runs without the
+ * GIL. The guard is created and destroyed with the GIL held.
+ */
+class UseGuard
+{
+    std::vector<const void*> objs_;
+
+    /** Return the first `n` objects. */
+    void give_back_(std::size_t n)
+    {
+        auto& counts = borrow_counts();
+        for (std::size_t k = 0; k < n; k++) {
+            if (--counts[objs_[k]] == 0) {
+                counts.erase(objs_[k]);
+            }
+        }
+    }
+
+    public:
+        /** Borrow each of the objects.
+         *
+         * @throws py::buffer_error if an object is being modified
+         */
+        explicit UseGuard(std::vector<const void*> objs) : objs_(std::move(objs))
+        {
+            auto& counts = borrow_counts();
+            for (std::size_t k = 0; k < objs_.size(); k++) {
+                cs::csint& count = counts[objs_[k]];
+                if (count < 0) {
+                    give_back_(k);
+                    throw py::buffer_error("Cannot use an object while it is being modified.");
+                }
+                count++;
+            }
+        }
+
+        ~UseGuard() { give_back_(objs_.size()); }
+
+        UseGuard(const UseGuard&) = delete;
+        UseGuard& operator=(const UseGuard&) = delete;
+};
+
+
+// The arguments of the next call of a binding with `borrow_args` on this
+// thread, collected after they are converted (see `process_attribute` below)
+static thread_local std::vector<const void*> pending_args;
+
+
+/** Borrow the arguments collected for the current call (see `borrow_args`). */
+struct ArgsGuard : UseGuard
+{
+    ArgsGuard() : UseGuard(std::exchange(pending_args, {})) {}
+};
+
+
+/** Mark the arguments of a call as in use for the duration of the call.
+ *
+ * Each `CSCMatrix`, `QRResult` and symbolic analysis passed to the binding,
+ * including `self`, counts as borrowed, so that another thread cannot modify
+ * it while the call runs without the GIL.
+ */
+using borrow_args = py::call_guard<ArgsGuard>;
+
+
+/** Release the GIL for the duration of a call.
+ *
+ * The arguments are converted before, and the result after, the call, so the
+ * guard may be used by any binding whose body does not touch Python objects.
+ * The arguments are borrowed as by `borrow_args`.
+ */
+using release_gil = py::call_guard<ArgsGuard, py::gil_scoped_release>;
+
+
+/** Collect the arguments of a call to be borrowed by its `ArgsGuard`. */
+void collect_args(const py::detail::function_call& call)
+{
+    std::vector<const void*> objs;
+
+    for (py::handle h : call.args) {
+        if (py::isinstance<cs::CSCMatrix>(h)) {
+            objs.push_back(&h.cast<const cs::CSCMatrix&>());
+        } else if (py::isinstance<cs::QRResult>(h)) {
+            objs.push_back(&h.cast<const cs::QRResult&>());
+        } else if (py::isinstance<cs::SymbolicChol>(h)) {
+            objs.push_back(&h.cast<const cs::SymbolicChol&>());
+        } else if (py::isinstance<cs::SymbolicQR>(h)) {
+            objs.push_back(&h.cast<const cs::SymbolicQR&>());
+        } else if (py::isinstance<cs::SymbolicLU>(h)) {
+            objs.push_back(&h.cast<const cs::SymbolicLU&>());
+        }
+    }
+
+    pending_args = std::move(objs);
+}
+
+
+// The pre-call hooks run after the arguments are converted, and just before
+// the guard of the call is created
+namespace pybind11::detail {
+
+template <>
+struct process_attribute<borrow_args> : process_attribute_default<borrow_args>
+{
+    static void precall(function_call& call) { collect_args(call); }
+};
+
+template <>
+struct process_attribute<release_gil> : process_attribute_default<release_gil>
+{
+    static void precall(function_call& call) { collect_args(call); }
+};
+
+}  // namespace pybind11::detail
+
+
+/** Copy a NumPy array into a vector with a single bulk copy.
+ *
+ * @param arr  a contiguous NumPy array. Arrays of other types are converted
+ *        by NumPy before the copy.
+ *
+ * @return a vector with a copy of the data
+ */
+template <typename T>
+std::vector<T> numpy_to_vector(
+    const py::array_t<T, py::array::c_style | py::array::forcecast>& arr
+)
+{
+    return std::vector<T>(arr.data(), arr.data() + arr.size());
+};
+
+
 /** Convert a matrix to a NumPy array.
+ *
+ * The dense matrix is built once in the requested order and then owned by the
+ * NumPy array, without a second copy.
  *
  * @param self  the matrix to convert
  * @param order the order of the NumPy array ('C' or 'F')
@@ -43,16 +324,11 @@ auto vector_to_numpy(const std::vector<T>& vec)
 template <typename T>
 auto matrix_to_ndarray(const T& self, const char order)
 {
-    // Get the matrix in dense column-major order
-    std::vector<double> v = self.to_dense_vector('C');
-    auto [N_rows, N_cols] = self.shape();
-
-    // Create a NumPy array with specified dimensions
-    py::array_t<double> result({N_rows, N_cols});
+    if (order != 'C' && order != 'F') {
+        throw std::runtime_error("Invalid order specified. Use 'C' or 'F'.");
+    }
 
-    // Get a pointer to the underlying data of the NumPy array.
-    auto buffer_info = result.request();
-    double* ptr = static_cast<double*>(buffer_info.ptr);
+    auto [N_rows, N_cols] = self.shape();
 
     // Calculate strides based on order
     std::vector<ssize_t> strides;
@@ -61,40 +337,46 @@ auto matrix_to_ndarray(const T& self, const char order)
             static_cast<ssize_t>(N_cols * sizeof(double)),
             sizeof(double)
         };
-    } else if (order == 'F') { // Fortran-style (column-major)
+    } else { // Fortran-style (column-major)
         strides = {
             sizeof(double),
             static_cast<ssize_t>(N_rows * sizeof(double))
         };
-    } else {
-        throw std::runtime_error("Invalid order specified. Use 'C' or 'F'.");
     }
 
-    // Assign strides to the buffer info. This is crucial!
-    buffer_info.strides = strides;
-
-    // Copy the data from the vector to the NumPy array.  This is the most
-    // straightforward way.
-    std::copy(v.begin(), v.end(), ptr);
+    // Get the matrix in dense form in the requested order, and hand the
+    // storage to NumPy
+    auto *owned = new std::vector<double>(
+        without_gil([&] { return self.to_dense_vector(order); })
+    );
+    py::capsule owner(owned, [](void *p) {
+        delete static_cast<std::vector<double>*>(p);
+    });
 
-    return result;
+    return py::array_t<double>(
+        {static_cast<ssize_t>(N_rows), static_cast<ssize_t>(N_cols)},
+        strides,
+        owned->data(),
+        owner
+    );
 };
 
 
-/** Convert a CSCMatrix to a SciPy CSC matrix.
+/** Convert a CSCMatrix to a SciPy CSC matrix without copying.
  *
- * @param matrix  the CSCMatrix to convert
+ * @param A  the CSCMatrix to convert
+ * @param base  the Python object that owns `A`
  *
- * @return a SciPy CSC matrix
+ * @return a SciPy CSC matrix whose arrays are views of the arrays of `A`
  */
-py::object csc_matrix_to_scipy_csc(const cs::CSCMatrix& A, py::module_& m) {
-    py::module_ np = py::module_::import("numpy");
+py::object csc_matrix_to_scipy_csc(const cs::CSCMatrix& A, py::handle base)
+{
     py::module_ sparse = py::module_::import("scipy.sparse");
 
-    // Convert indptr, indices, and data to NumPy arrays
-    auto indptr_array = vector_to_numpy(A.indptr());
-    auto indices_array = vector_to_numpy(A.indices());
-    auto data_array = vector_to_numpy(A.data());
+    // View indptr, indices, and data as NumPy arrays
+    auto indptr_array = vector_view(A.indptr(), base);
+    auto indices_array = vector_view(A.indices(), base);
+    auto data_array = vector_view(A.data(), base);
 
     // Create the SciPy CSC A
     auto [M, N] = A.shape();
@@ -106,6 +388,185 @@ py::object csc_matrix_to_scipy_csc(const cs::CSCMatrix& A, py::module_& m) {
 }
 
 
+/** Convert a temporary CSCMatrix to a SciPy CSC matrix without copying.
+ *
+ * The matrix is moved to the heap and owned by a capsule that is shared by
+ * the arrays of the SciPy matrix.
+ *
+ * @param A  the CSCMatrix to convert
+ *
+ * @return a SciPy CSC matrix that owns the arrays of `A`
+ */
+py::object csc_matrix_to_scipy_csc(cs::CSCMatrix&& A)
+{
+    auto *owned = new cs::CSCMatrix(std::move(A));
+    py::capsule owner(owned, [](void *p) {
+        delete static_cast<cs::CSCMatrix*>(p);
+    });
+    return csc_matrix_to_scipy_csc(*owned, owner);
+}
+
+
+/** Solve a block of right-hand sides stored in a NumPy array.
+ *
+ * The array is copied once into a column-major vector, and the solution is
+ * owned by the returned array without a second copy.
+ *
+ * @param B  the right-hand sides, one per column. A 1D array is a single
+ *        right-hand side.
+ * @param N  the number of rows of the system
+ * @param solve  the block solver, called as `solve(B)` on the column-major data
+ * @param N_out  the number of rows of the solution. If `N_out < 0`, it is `N`.
+ *
+ * @return X  the solution, with the same number of columns as `B`
+ */
+template <typename F>
+py::array_t<double> solve_numpy_block(
+    const py::array_t<double, py::array::f_style | py::array::forcecast>& B,
+    cs::csint N,
+    F solve,
+    cs::csint N_out=-1
+)
+{
+    if (B.ndim() < 1 || B.ndim() > 2 || B.shape(0) != N) {
+        throw std::runtime_error("B must be a 1D or 2D array with N rows.");
+    }
+
+    ssize_t K = (B.ndim() == 2) ? B.shape(1) : 1;
+    N_out = (N_out < 0) ? N : N_out;
+
+    std::vector<double> b(B.data(), B.data() + B.size());
+    auto *owned = new std::vector<double>(without_gil([&] { return solve(b); }));
+    py::capsule owner(owned, [](void *p) {
+        delete static_cast<std::vector<double>*>(p);
+    });
+
+    if (B.ndim() == 1) {
+        return py::array_t<double>(N_out, owned->data(), owner);
+    }
+
+    return py::array_t<double>(
+        {static_cast<ssize_t>(N_out), K},
+        {
+            static_cast<ssize_t>(sizeof(double)),
+            static_cast<ssize_t>(N_out * sizeof(double))
+        },
+        owned->data(),
+        owner
+    );
+}
+
+
+/** Check that a symbolic Cholesky analysis was computed for a matrix.
+ *
+ * The analysis must match the size and the pattern of `A`, since the kernels
+ * write the factor into the column pointers of `S` without bounds checks.
+ *
+ * @param A  the matrix to factor
+ * @param S  the symbolic analysis
+ *
+ * @throws py::value_error if `S` was not computed for `A`
+ */
+void check_symbolic(const cs::CSCMatrix& A, const cs::SymbolicChol& S)
+{
+    auto [M, N] = A.shape();
+
+    if (M != N) {
+        throw py::value_error("A must be square.");
+    }
+
+    if (static_cast<cs::csint>(S.p_inv.size()) != N
+        || static_cast<cs::csint>(S.parent.size()) != N
+        || static_cast<cs::csint>(S.cp.size()) != N + 1) {
+        throw py::value_error("S was computed for a matrix of a different size.");
+    }
+
+    if (S.pattern_hash != cs::pattern_hash(A)) {
+        throw py::value_error("S was computed for a matrix with a different pattern.");
+    }
+}
+
+
+/** Check that a symbolic QR analysis was computed for a matrix.
+ *
+ * The analysis must match the size and the pattern of `A`, since the kernels
+ * allocate `V` and `R` with the counts of `S` and fill them without bounds
+ * checks.
+ *
+ * @param A  the matrix to factor
+ * @param S  the symbolic analysis
+ *
+ * @throws py::value_error if `S` was not computed for `A`
+ */
+void check_symbolic(const cs::CSCMatrix& A, const cs::SymbolicQR& S)
+{
+    auto [M, N] = A.shape();
+
+    if (S.m2 < M
+        || static_cast<cs::csint>(S.p_inv.size()) != S.m2
+        || static_cast<cs::csint>(S.q.size()) != N
+        || static_cast<cs::csint>(S.parent.size()) != N
+        || static_cast<cs::csint>(S.leftmost.size()) != M) {
+        throw py::value_error("S was computed for a matrix of a different size.");
+    }
+
+    if (S.pattern_hash != cs::pattern_hash(A)) {
+        throw py::value_error("S was computed for a matrix with a different pattern.");
+    }
+}
+
+
+/** Check that a symbolic LU analysis was computed for a matrix.
+ *
+ * The matrix must be square, and the column permutation of `S` must be a
+ * permutation of its columns, since the kernel indexes `A` through it
+ * without bounds checks.
+ *
+ * @param A  the matrix to factor
+ * @param S  the symbolic analysis
+ *
+ * @throws py::value_error if `S` was not computed for `A`
+ */
+void check_symbolic(const cs::CSCMatrix& A, const cs::SymbolicLU& S)
+{
+    auto [M, N] = A.shape();
+
+    if (M != N) {
+        throw py::value_error("A must be square.");
+    }
+
+    if (static_cast<cs::csint>(S.q.size()) != N || S.lnz < 0 || S.unz < 0) {
+        throw py::value_error("S was computed for a matrix of a different size.");
+    }
+
+    std::vector<bool> seen(N, false);
+    for (cs::csint j : S.q) {
+        if (j < 0 || j >= N || seen[j]) {
+            throw py::value_error("S.q is not a permutation of the columns of A.");
+        }
+        seen[j] = true;
+    }
+}
+
+
+/** Check that a workspace is not installed on another thread.
+ *
+ * @param ws  the workspace
+ *
+ * @return ws  the same workspace
+ *
+ * @throws std::runtime_error if another thread has installed the workspace,
+ *         since its kernels may update the pool at any time.
+ */
+const cs::Workspace& check_owner(const cs::Workspace& ws)
+{
+    if (ws.claimed_elsewhere()) {
+        throw std::runtime_error("Workspace is in use by another thread.");
+    }
+    return ws;
+}
+
+
 /** Convert a string to an AMDOrder enum.
  *
  * @param order  the string to convert
@@ -118,10 +579,61 @@ cs::AMDOrder string_to_amdorder(const std::string& order)
     if (order == "APlusAT") { return cs::AMDOrder::APlusAT; }
     if (order == "ATANoDenseRows") { return cs::AMDOrder::ATANoDenseRows; }
     if (order == "ATA") { return cs::AMDOrder::ATA; }
+    if (order == "NestedDissection") { return cs::AMDOrder::NestedDissection; }
     throw std::runtime_error("Invalid AMDOrder specified.");
 }
 
 
+/** Convert a string to a BatchLayout enum.
+ *
+ * @param layout  the string to convert
+ *
+ * @return the BatchLayout enum
+ */
+cs::BatchLayout string_to_batchlayout(const std::string& layout)
+{
+    if (layout == "Strided") { return cs::BatchLayout::Strided; }
+    if (layout == "Interleaved") { return cs::BatchLayout::Interleaved; }
+    throw std::runtime_error("Invalid BatchLayout specified.");
+}
+
+
+/** Convert a string to an ICholMethod enum.
+ *
+ * @param method  the string to convert
+ *
+ * @return the ICholMethod enum
+ */
+cs::ICholMethod string_to_icholmethod(const std::string& method)
+{
+    if (method == "NoFill") { return cs::ICholMethod::NoFill; }
+    if (method == "ICT") { return cs::ICholMethod::ICT; }
+    throw std::runtime_error("Invalid ICholMethod specified.");
+}
+
+
+/** Convert a string to an SpGEMMAccumulator enum.
+ *
+ * @param acc  the string to convert
+ *
+ * @return the SpGEMMAccumulator enum
+ */
+cs::SpGEMMAccumulator string_to_accumulator(const std::string& acc)
+{
+    if (acc == "Auto") { return cs::SpGEMMAccumulator::Auto; }
+    if (acc == "Dense") { return cs::SpGEMMAccumulator::Dense; }
+    if (acc == "Hash") { return cs::SpGEMMAccumulator::Hash; }
+    throw std::runtime_error("Invalid SpGEMMAccumulator specified.");
+}
+
+
+// The statistics objects replaced by each active `with Stats()` block
+static thread_local std::vector<cs::Stats*> stats_stack;
+
+// The workspaces replaced by each active `with Workspace()` block
+static thread_local std::vector<cs::Workspace*> workspace_stack;
+
+
 PYBIND11_MODULE(csparse, m) {
     m.doc() = "CSparse module for sparse matrix operations.";
 
@@ -130,22 +642,319 @@ PYBIND11_MODULE(csparse, m) {
     //--------------------------------------------------------------------------
     // Bind the QRResult struct
     py::class_<cs::QRResult>(m, "QRResult")
-        .def_property_readonly("V", [&m](const cs::QRResult& qr) {
-            return csc_matrix_to_scipy_csc(qr.V, m);
+        .def_property_readonly("V", [](py::object self) {
+            const auto& qr = self.cast<const cs::QRResult&>();
+            return csc_matrix_to_scipy_csc(qr.V, borrow(&qr, self));
+        })
+        .def_property_readonly("beta", [](py::object self) {
+            const auto& qr = self.cast<const cs::QRResult&>();
+            return vector_view(qr.beta, borrow(&qr, self));
+        })
+        .def_property_readonly("R", [](py::object self) {
+            const auto& qr = self.cast<const cs::QRResult&>();
+            return csc_matrix_to_scipy_csc(qr.R, borrow(&qr, self));
+        })
+        .def_property_readonly("p_inv", [](py::object self) {
+            const auto& qr = self.cast<const cs::QRResult&>();
+            return vector_view(qr.p_inv, borrow(&qr, self));
+        })
+        .def_property_readonly("q", [](py::object self) {
+            const auto& qr = self.cast<const cs::QRResult&>();
+            return vector_view(qr.q, borrow(&qr, self));
+        });
+
+    // Bind the symbolic analysis structs, so that they can be reused for
+    // multiple numeric factorizations of matrices with the same pattern.
+    py::class_<cs::SymbolicChol>(m, "SymbolicChol")
+        .def_property_readonly("p_inv", [](py::object self) {
+            const auto& S = self.cast<const cs::SymbolicChol&>();
+            return vector_view(S.p_inv, self);
+        })
+        .def_property_readonly("parent", [](py::object self) {
+            const auto& S = self.cast<const cs::SymbolicChol&>();
+            return vector_view(S.parent, self);
+        })
+        .def_property_readonly("cp", [](py::object self) {
+            const auto& S = self.cast<const cs::SymbolicChol&>();
+            return vector_view(S.cp, self);
+        })
+        .def_readonly("lnz", &cs::SymbolicChol::lnz);
+
+    py::class_<cs::SymbolicQR>(m, "SymbolicQR")
+        .def_property_readonly("p_inv", [](py::object self) {
+            const auto& S = self.cast<const cs::SymbolicQR&>();
+            return vector_view(S.p_inv, self);
+        })
+        .def_property_readonly("q", [](py::object self) {
+            const auto& S = self.cast<const cs::SymbolicQR&>();
+            return vector_view(S.q, self);
+        })
+        .def_property_readonly("parent", [](py::object self) {
+            const auto& S = self.cast<const cs::SymbolicQR&>();
+            return vector_view(S.parent, self);
+        })
+        .def_property_readonly("leftmost", [](py::object self) {
+            const auto& S = self.cast<const cs::SymbolicQR&>();
+            return vector_view(S.leftmost, self);
+        })
+        .def_readonly("m2", &cs::SymbolicQR::m2)
+        .def_readonly("vnz", &cs::SymbolicQR::vnz)
+        .def_readonly("rnz", &cs::SymbolicQR::rnz);
+
+    py::class_<cs::MultifrontalQR>(m, "MultifrontalQR")
+        .def_property_readonly("R", [](py::object self) {
+            const auto& F = self.cast<const cs::MultifrontalQR&>();
+            return csc_matrix_to_scipy_csc(F.R, self);
+        })
+        .def_property_readonly("q", [](py::object self) {
+            const auto& F = self.cast<const cs::MultifrontalQR&>();
+            return vector_view(F.q, self);
+        })
+        .def_property_readonly("rows", [](py::object self) {
+            const auto& F = self.cast<const cs::MultifrontalQR&>();
+            return vector_view(F.rows, self);
+        })
+        .def_property_readonly("super", [](py::object self) {
+            const auto& F = self.cast<const cs::MultifrontalQR&>();
+            return vector_view(F.super, self);
+        })
+        .def_readonly("M", &cs::MultifrontalQR::M)
+        .def_readonly("N", &cs::MultifrontalQR::N)
+        .def_readonly("m2", &cs::MultifrontalQR::m2)
+        .def_readonly("block_size", &cs::MultifrontalQR::block_size)
+        .def_property_readonly("num_fronts", &cs::MultifrontalQR::num_fronts);
+
+    py::class_<cs::LevelSchedule>(m, "LevelSchedule")
+        .def_property_readonly("level_ptr", [](py::object self) {
+            const auto& S = self.cast<const cs::LevelSchedule&>();
+            return vector_view(S.level_ptr, self);
+        })
+        .def_property_readonly("nodes", [](py::object self) {
+            const auto& S = self.cast<const cs::LevelSchedule&>();
+            return vector_view(S.nodes, self);
+        })
+        .def_property_readonly("nlevels", &cs::LevelSchedule::nlevels)
+        .def_readonly("forward", &cs::LevelSchedule::forward);
+
+    py::class_<cs::SymbolicLU>(m, "SymbolicLU")
+        .def_property_readonly("q", [](py::object self) {
+            const auto& S = self.cast<const cs::SymbolicLU&>();
+            return vector_view(S.q, self);
+        })
+        .def_readonly("lnz", &cs::SymbolicLU::lnz)
+        .def_readonly("unz", &cs::SymbolicLU::unz);
+
+    // Bind the LUResult struct
+    py::class_<cs::LUResult>(m, "LUResult")
+        .def_property_readonly("L", [](py::object self) {
+            const auto& lu = self.cast<const cs::LUResult&>();
+            return csc_matrix_to_scipy_csc(lu.L, self);
+        })
+        .def_property_readonly("U", [](py::object self) {
+            const auto& lu = self.cast<const cs::LUResult&>();
+            return csc_matrix_to_scipy_csc(lu.U, self);
+        })
+        .def_property_readonly("p_inv", [](py::object self) {
+            const auto& lu = self.cast<const cs::LUResult&>();
+            return vector_view(lu.p_inv, self);
+        })
+        .def_property_readonly("q", [](py::object self) {
+            const auto& lu = self.cast<const cs::LUResult&>();
+            return vector_view(lu.q, self);
+        });
+
+    // Bind the performance counters as a context manager:
+    //     with csparse.Stats() as stats:
+    //         L = csparse.chol(A)
+    // The counters are installed on the calling thread only, so they do not
+    // count the `*_async` calls, which run on the threads of an executor.
+    py::class_<cs::Stats>(m, "Stats",
+        "Performance counters of the calls made on this thread within a "
+        "``with`` block. Calls made by other threads, including the "
+        "``*_async`` functions, are not counted."
+    )
+        .def(py::init<>())
+        .def_readonly("flops", &cs::Stats::flops)
+        .def_readonly("reallocs", &cs::Stats::reallocs)
+        .def_readonly("peak_bytes", &cs::Stats::peak_bytes)
+        .def_readonly("times", &cs::Stats::times)
+        .def_readonly("calls", &cs::Stats::calls)
+        .def("reset", &cs::Stats::reset)
+        .def("__enter__", [](py::object self) {
+            stats_stack.push_back(cs::set_stats(&self.cast<cs::Stats&>()));
+            return self;
+        })
+        .def("__exit__", [](cs::Stats& self, py::args) {
+            cs::set_stats(stats_stack.back());
+            stats_stack.pop_back();
         })
-        .def_property_readonly("beta", [](const cs::QRResult& qr) {
-            return vector_to_numpy(qr.beta);
+        .def("__repr__", [](const cs::Stats& self) {
+            return "<Stats flops=" + std::to_string(self.flops)
+                + ", reallocs=" + std::to_string(self.reallocs)
+                + ", peak_bytes=" + std::to_string(self.peak_bytes) + ">";
+        });
+
+    // Bind the scratch pool as a context manager:
+    //     with csparse.Workspace() as ws:
+    //         for A in matrices:
+    //             L = csparse.chol(A, S)
+    // Like the counters, the pool is installed on the calling thread only.
+    py::class_<cs::Workspace>(m, "Workspace",
+        "A pool of scratch arrays used by the calls made on this thread within "
+        "a ``with`` block. Calls made by other threads, including the "
+        "``*_async`` functions, use the default pools of their threads."
+    )
+        .def(py::init<>())
+        // The counters are read by the owning thread only, since the kernels
+        // update them without the GIL
+        .def_property_readonly("bytes_in_use", [](const cs::Workspace& ws) {
+            return check_owner(ws).bytes_in_use();
+        })
+        .def_property_readonly("peak_bytes", [](const cs::Workspace& ws) {
+            return check_owner(ws).peak_bytes();
+        })
+        .def_property_readonly("reserved_bytes", [](const cs::Workspace& ws) {
+            return check_owner(ws).reserved_bytes();
+        })
+        .def_property_readonly("leases", [](const cs::Workspace& ws) {
+            return check_owner(ws).leases();
         })
-        .def_property_readonly("R", [&m](const cs::QRResult& qr) {
-            return csc_matrix_to_scipy_csc(qr.R, m);
+        .def_property_readonly("allocations", [](const cs::Workspace& ws) {
+            return check_owner(ws).allocations();
+        })
+        .def("reset_peak", &cs::Workspace::reset_peak)
+        .def("release", &cs::Workspace::release)
+        .def("__enter__", [](py::object self) {
+            auto& ws = self.cast<cs::Workspace&>();
+            ws.claim();  // raises if installed on another thread
+            workspace_stack.push_back(cs::set_workspace(&ws));
+            return self;
+        })
+        .def("__exit__", [](cs::Workspace& self, py::args) {
+            cs::set_workspace(workspace_stack.back());
+            workspace_stack.pop_back();
+            self.unclaim();
+        })
+        .def("__repr__", [](const cs::Workspace& self) {
+            const auto& ws = check_owner(self);
+            return "<Workspace peak_bytes=" + std::to_string(ws.peak_bytes())
+                + ", reserved_bytes=" + std::to_string(ws.reserved_bytes())
+                + ", allocations=" + std::to_string(ws.allocations()) + ">";
+        });
+
+    // Bind the batched factors
+    py::class_<cs::CholBatch>(m, "CholBatch")
+        .def_property_readonly("L", [](py::object self) {
+            const auto& F = self.cast<const cs::CholBatch&>();
+            return csc_matrix_to_scipy_csc(F.L, self);
+        })
+        .def_property_readonly("p_inv", [](py::object self) {
+            const auto& F = self.cast<const cs::CholBatch&>();
+            return vector_view(F.p_inv, self);
+        })
+        .def_property_readonly("values", [](py::object self) {
+            const auto& F = self.cast<const cs::CholBatch&>();
+            return vector_view(F.values, self);
+        })
+        .def_readonly("batch", &cs::CholBatch::batch)
+        .def("factor", &cs::CholBatch::factor, py::arg("b"), release_gil());
+
+    // Bind the frozen assembly pattern
+    py::class_<cs::AssemblyPattern>(m, "AssemblyPattern")
+        // A copy, since the slots index into the arrays of the matrix
+        .def_property_readonly("A",
+            [](const cs::AssemblyPattern& P) { return P.A; }
+        )
+        .def_property_readonly("slots", [](py::object self) {
+            const auto& P = self.cast<const cs::AssemblyPattern&>();
+            return vector_view(P.slots, self);
+        })
+        .def_property_readonly("color_ptr", [](py::object self) {
+            const auto& P = self.cast<const cs::AssemblyPattern&>();
+            return vector_view(P.color_ptr, self);
+        })
+        .def_property_readonly("color_elems", [](py::object self) {
+            const auto& P = self.cast<const cs::AssemblyPattern&>();
+            return vector_view(P.color_elems, self);
+        })
+        .def_property_readonly("num_elements", &cs::AssemblyPattern::num_elements)
+        .def_property_readonly("num_colors", &cs::AssemblyPattern::num_colors)
+        .def("zero", &cs::AssemblyPattern::zero)
+        // Keeps the GIL, since it modifies the values of the pattern
+        .def("add", &cs::AssemblyPattern::add, py::arg("values"), py::arg("threads")=0)
+        .def("add_element",
+            [](cs::AssemblyPattern& P, cs::csint e, const std::vector<double>& Ke) {
+                P.add_element(e, Ke);
+            },
+            py::arg("e"),
+            py::arg("Ke")
+        );
+
+    // Bind the iterative solver types
+    py::class_<cs::Preconditioner>(m, "Preconditioner")
+        .def("__call__", [](const cs::Preconditioner& M, const std::vector<double>& r) {
+            std::vector<double> z(r.size());
+            {
+                py::gil_scoped_release release;
+                M(r, z);
+            }
+            return vector_to_numpy(std::move(z));
+        },
+        py::arg("r"));
+
+    py::class_<cs::IterativeResult>(m, "IterativeResult")
+        .def_property_readonly("x", [](py::object self) {
+            const auto& res = self.cast<const cs::IterativeResult&>();
+            return vector_view(res.x, self);
         })
-        .def_property_readonly("p_inv", [](const cs::QRResult& qr) {
-            return vector_to_numpy(qr.p_inv);
+        .def_readonly("iterations", &cs::IterativeResult::iterations)
+        .def_readonly("residual", &cs::IterativeResult::residual)
+        .def_readonly("converged", &cs::IterativeResult::converged)
+        .def_property_readonly("history", [](py::object self) {
+            const auto& res = self.cast<const cs::IterativeResult&>();
+            return vector_view(res.history, self);
         })
-        .def_property_readonly("q", [](const cs::QRResult& qr) {
-            return vector_to_numpy(qr.q);
+        .def("__repr__", [](const cs::IterativeResult& self) {
+            return "<IterativeResult iterations=" + std::to_string(self.iterations)
+                + ", residual=" + std::to_string(self.residual)
+                + ", converged=" + (self.converged ? "True" : "False") + ">";
         });
 
+    // Bind the factor file cache
+    py::class_<cs::FactorKey>(m, "FactorKey")
+        .def_readonly("pattern_hash", &cs::FactorKey::pattern_hash)
+        .def_readonly("values_hash", &cs::FactorKey::values_hash)
+        .def_readonly("M", &cs::FactorKey::M)
+        .def_readonly("N", &cs::FactorKey::N)
+        .def_readonly("nnz", &cs::FactorKey::nnz)
+        .def("__eq__", [](const cs::FactorKey& a, const cs::FactorKey& b) { return a == b; });
+
+    py::class_<cs::CachedChol>(m, "CachedChol")
+        .def_readonly("S", &cs::CachedChol::S)
+        .def_readonly("L", &cs::CachedChol::L)
+        .def_readonly("has_factor", &cs::CachedChol::has_factor);
+
+    py::class_<cs::CachedQR>(m, "CachedQR")
+        .def_readonly("S", &cs::CachedQR::S)
+        .def_readonly("res", &cs::CachedQR::res)
+        .def_readonly("has_factor", &cs::CachedQR::has_factor);
+
+    py::class_<cs::QRBatch>(m, "QRBatch")
+        .def_property_readonly("V_values", [](py::object self) {
+            const auto& F = self.cast<const cs::QRBatch&>();
+            return vector_view(F.V_values, self);
+        })
+        .def_property_readonly("R_values", [](py::object self) {
+            const auto& F = self.cast<const cs::QRBatch&>();
+            return vector_view(F.R_values, self);
+        })
+        .def_property_readonly("beta", [](py::object self) {
+            const auto& F = self.cast<const cs::QRBatch&>();
+            return vector_view(F.beta, self);
+        })
+        .def_readonly("batch", &cs::QRBatch::batch)
+        .def("factor", &cs::QRBatch::factor, py::arg("b"), release_gil());
+
     //--------------------------------------------------------------------------
     //        COOMatrix class
     //--------------------------------------------------------------------------
@@ -191,16 +1000,16 @@ PYBIND11_MODULE(csparse, m) {
             }
         )
         //
-        .def("compress", &cs::COOMatrix::compress)
-        .def("tocsc", &cs::COOMatrix::tocsc)
-        .def("to_dense_vector", &cs::COOMatrix::to_dense_vector, py::arg("order")='F')
-        .def("toarray", &matrix_to_ndarray<cs::COOMatrix>, py::arg("order")='C')
+        .def("compress", &cs::COOMatrix::compress, py::arg("threads")=0, release_gil())
+        .def("tocsc", &cs::COOMatrix::tocsc, py::arg("threads")=0, release_gil())
+        .def("to_dense_vector", &cs::COOMatrix::to_dense_vector, py::arg("order")='F', release_gil())
+        .def("toarray", &matrix_to_ndarray<cs::COOMatrix>, py::arg("order")='C', borrow_args())
         //
-        .def("transpose", &cs::COOMatrix::transpose)
+        .def("transpose", &cs::COOMatrix::transpose, release_gil())
         .def_property_readonly("T", &cs::COOMatrix::T)
         //
-        .def("dot", &cs::COOMatrix::dot)
-        .def("__mul__", &cs::COOMatrix::dot)
+        .def("dot", &cs::COOMatrix::dot, release_gil())
+        .def("__mul__", &cs::COOMatrix::dot, release_gil())
         //
         .def("__repr__", [](const cs::COOMatrix& A) {
             return A.to_string(false);  // don't print all elements
@@ -215,6 +1024,28 @@ PYBIND11_MODULE(csparse, m) {
     //--------------------------------------------------------------------------
     py::class_<cs::CSCMatrix>(m, "CSCMatrix")
         .def(py::init<>())
+        // NumPy arrays are copied once in bulk, and the copies are adopted by
+        // the matrix. Registered first so that arrays do not fall through to
+        // the element-wise std::vector conversion.
+        .def(py::init(
+            [](
+                const py::array_t<double, py::array::c_style | py::array::forcecast>& data,
+                const py::array_t<cs::csint, py::array::c_style | py::array::forcecast>& indices,
+                const py::array_t<cs::csint, py::array::c_style | py::array::forcecast>& indptr,
+                const cs::Shape& shape
+            ) {
+                return cs::CSCMatrix(
+                    numpy_to_vector(data),
+                    numpy_to_vector(indices),
+                    numpy_to_vector(indptr),
+                    shape
+                );
+            }),
+            py::arg("data"),
+            py::arg("indices"),
+            py::arg("indptr"),
+            py::arg("shape")
+        )
         .def(py::init<
             const std::vector<double>&,
             const std::vector<cs::csint>&,
@@ -242,127 +1073,461 @@ PYBIND11_MODULE(csparse, m) {
             }
         )
         //
-        .def_property_readonly("indptr", &cs::CSCMatrix::indptr)
-        .def_property_readonly("indices", &cs::CSCMatrix::indices)
-        .def_property_readonly("data", &cs::CSCMatrix::data)
+        .def_property_readonly("indptr", [](py::object self) {
+            const auto& A = self.cast<const cs::CSCMatrix&>();
+            return vector_view(A.indptr(), borrow(&A, self));
+        })
+        .def_property_readonly("indices", [](py::object self) {
+            const auto& A = self.cast<const cs::CSCMatrix&>();
+            return vector_view(A.indices(), borrow(&A, self));
+        })
+        .def_property_readonly("data", [](py::object self) {
+            const auto& A = self.cast<const cs::CSCMatrix&>();
+            return vector_view(A.data(), borrow(&A, self));
+        })
         //
-        .def("to_canonical", &cs::CSCMatrix::to_canonical)
+        // The mutators keep the GIL, so that no view is created meanwhile
+        .def("to_canonical",
+            [](cs::CSCMatrix& A) -> cs::CSCMatrix& {
+                check_not_borrowed(&A);
+                return A.to_canonical();
+            }
+        )
         .def_property_readonly("has_sorted_indices", &cs::CSCMatrix::has_sorted_indices)
         .def_property_readonly("has_canonical_format", &cs::CSCMatrix::has_canonical_format)
         .def_property_readonly("is_symmetric", &cs::CSCMatrix::is_symmetric)
         //
         .def("__call__", py::overload_cast<cs::csint, cs::csint>(&cs::CSCMatrix::operator(), py::const_))
         .def("__getitem__",
-            [](cs::CSCMatrix& A, py::tuple t) {
+            [](const cs::CSCMatrix& A, py::tuple t) {
                 cs::csint i = t[0].cast<cs::csint>();
                 cs::csint j = t[1].cast<cs::csint>();
                 return A(i, j);
             }
         )
         //
-        .def("assign", py::overload_cast
-                        <cs::csint, cs::csint, double>(&cs::CSCMatrix::assign))
-        .def("assign", py::overload_cast<
-                        const std::vector<cs::csint>&,
-                        const std::vector<cs::csint>&,
-                        const std::vector<double>&>(&cs::CSCMatrix::assign))
-        .def("assign", py::overload_cast<
-                        const std::vector<cs::csint>&,
-                        const std::vector<cs::csint>&,
-                        const cs::CSCMatrix&>(&cs::CSCMatrix::assign))
+        .def("assign",
+            [](cs::CSCMatrix& A, cs::csint i, cs::csint j, double v) -> cs::CSCMatrix& {
+                check_not_borrowed(&A);
+                return A.assign(i, j, v);
+            }
+        )
+        .def("assign",
+            [](
+                cs::CSCMatrix& A,
+                const std::vector<cs::csint>& i,
+                const std::vector<cs::csint>& j,
+                const std::vector<double>& v
+            ) -> cs::CSCMatrix& {
+                check_not_borrowed(&A);
+                return A.assign(i, j, v);
+            }
+        )
+        .def("assign",
+            [](
+                cs::CSCMatrix& A,
+                const std::vector<cs::csint>& i,
+                const std::vector<cs::csint>& j,
+                const cs::CSCMatrix& C
+            ) -> cs::CSCMatrix& {
+                check_not_borrowed(&A);
+                return A.assign(i, j, C);
+            }
+        )
         .def("__setitem__",
             [](cs::CSCMatrix& A, py::tuple t, double v) {
                 cs::csint i = t[0].cast<cs::csint>();
                 cs::csint j = t[1].cast<cs::csint>();
+                check_not_borrowed(&A);
                 A.assign(i, j, v);
             }
         )
         //
-        .def("tocoo", &cs::CSCMatrix::tocoo)
-        .def("to_dense_vector", &cs::CSCMatrix::to_dense_vector, py::arg("order")='F')
-        .def("toarray", &matrix_to_ndarray<cs::CSCMatrix>, py::arg("order")='C')
+        .def("tocoo", &cs::CSCMatrix::tocoo, release_gil())
+        .def("to_dense_vector",
+            [](const cs::CSCMatrix& A, const char order) {
+                return vector_to_numpy(without_gil([&] { return A.to_dense_vector(order); }));
+            },
+            py::arg("order")='F',
+            borrow_args()
+        )
+        .def("toarray", &matrix_to_ndarray<cs::CSCMatrix>, py::arg("order")='C', borrow_args())
+        .def("toscipy",
+            [](py::object self) {
+                const auto& A = self.cast<const cs::CSCMatrix&>();
+                return csc_matrix_to_scipy_csc(A, borrow(&A, self));
+            }
+        )
         //
-        .def("transpose", &cs::CSCMatrix::transpose, py::arg("values")=true)
+        .def("transpose", &cs::CSCMatrix::transpose, py::arg("values")=true, release_gil())
         .def_property_readonly("T", &cs::CSCMatrix::T)
         //
         .def("band", py::overload_cast<cs::csint, cs::csint>
                         (&cs::CSCMatrix::band, py::const_))
         //
-        .def("gaxpy", &cs::CSCMatrix::gaxpy)
-        .def("gaxpy_row", &cs::CSCMatrix::gaxpy_row)
-        .def("gaxpy_col", &cs::CSCMatrix::gaxpy_col)
-        .def("gaxpy_block", &cs::CSCMatrix::gaxpy_block)
-        .def("gatxpy", &cs::CSCMatrix::gatxpy)
-        .def("gatxpy_row", &cs::CSCMatrix::gatxpy_row)
-        .def("gatxpy_col", &cs::CSCMatrix::gatxpy_col)
-        .def("gatxpy_block", &cs::CSCMatrix::gatxpy_block)
-        .def("sym_gaxpy", &cs::CSCMatrix::sym_gaxpy)
+        .def("gaxpy",
+            [](
+                const cs::CSCMatrix& A,
+                const std::vector<double>& x,
+                const std::vector<double>& y,
+                int threads
+            ) {
+                return vector_to_numpy(without_gil([&] { return A.gaxpy(x, y, threads); }));
+            },
+            py::arg("x"),
+            py::arg("y"),
+            py::arg("threads")=0,
+            borrow_args()
+        )
+        .def("gaxpy_row", &cs::CSCMatrix::gaxpy_row, release_gil())
+        .def("gaxpy_col", &cs::CSCMatrix::gaxpy_col, release_gil())
+        .def("gaxpy_block", &cs::CSCMatrix::gaxpy_block, release_gil())
+        .def("gatxpy",
+            [](
+                const cs::CSCMatrix& A,
+                const std::vector<double>& x,
+                const std::vector<double>& y,
+                int threads
+            ) {
+                return vector_to_numpy(without_gil([&] { return A.gatxpy(x, y, threads); }));
+            },
+            py::arg("x"),
+            py::arg("y"),
+            py::arg("threads")=0,
+            borrow_args()
+        )
+        .def("gatxpy_row", &cs::CSCMatrix::gatxpy_row, release_gil())
+        .def("gatxpy_col", &cs::CSCMatrix::gatxpy_col, release_gil())
+        .def("gatxpy_block", &cs::CSCMatrix::gatxpy_block, release_gil())
+        .def("gaxpy_simd", &cs::CSCMatrix::gaxpy_simd, release_gil())
+        .def("gatxpy_simd", &cs::CSCMatrix::gatxpy_simd, release_gil())
+        .def("sym_gaxpy",
+            [](
+                const cs::CSCMatrix& A,
+                const std::vector<double>& x,
+                const std::vector<double>& y,
+                int threads
+            ) {
+                return vector_to_numpy(without_gil([&] { return A.sym_gaxpy(x, y, threads); }));
+            },
+            py::arg("x"),
+            py::arg("y"),
+            py::arg("threads")=0,
+            borrow_args()
+        )
+        //
+        .def("scale", &cs::CSCMatrix::scale, release_gil())
+        //
+        .def("dot", py::overload_cast<const double>(&cs::CSCMatrix::dot, py::const_), release_gil())
+        .def("dot", py::overload_cast<const std::vector<double>&>(&cs::CSCMatrix::dot, py::const_), release_gil())
+        .def("dot", py::overload_cast<const cs::CSCMatrix&>(&cs::CSCMatrix::dot, py::const_), release_gil())
+        .def("dot_2x",
+            [](
+                const cs::CSCMatrix& A,
+                const cs::CSCMatrix& B,
+                int threads,
+                const std::string& accumulator
+            ) {
+                return A.dot_2x(B, threads, string_to_accumulator(accumulator));
+            },
+            py::arg("B"),
+            py::arg("threads")=0,
+            py::arg("accumulator")="Auto",
+            release_gil()
+        )
+        .def("__matmul__", py::overload_cast<const double>(&cs::CSCMatrix::dot, py::const_), release_gil())
+        .def("__matmul__", py::overload_cast<const std::vector<double>&>(&cs::CSCMatrix::dot, py::const_), release_gil())
+        .def("__matmul__", py::overload_cast<const cs::CSCMatrix&>(&cs::CSCMatrix::dot, py::const_), release_gil())
         //
-        .def("scale", &cs::CSCMatrix::scale)
+        .def("add", &cs::CSCMatrix::add, release_gil())
+        .def("__add__", &cs::CSCMatrix::add, release_gil())
         //
-        .def("dot", py::overload_cast<const double>(&cs::CSCMatrix::dot, py::const_))
-        .def("dot", py::overload_cast<const std::vector<double>&>(&cs::CSCMatrix::dot, py::const_))
-        .def("dot", py::overload_cast<const cs::CSCMatrix&>(&cs::CSCMatrix::dot, py::const_))
-        .def("__matmul__", py::overload_cast<const double>(&cs::CSCMatrix::dot, py::const_))
-        .def("__matmul__", py::overload_cast<const std::vector<double>&>(&cs::CSCMatrix::dot, py::const_))
-        .def("__matmul__", py::overload_cast<const cs::CSCMatrix&>(&cs::CSCMatrix::dot, py::const_))
+        .def("permute", &cs::CSCMatrix::permute, release_gil())
+        .def("symperm", &cs::CSCMatrix::symperm, release_gil())
+        .def("permute_transpose", &cs::CSCMatrix::permute_transpose, release_gil())
+        .def("permute_rows", &cs::CSCMatrix::permute_rows, release_gil())
+        .def("permute_cols", &cs::CSCMatrix::permute_cols, release_gil())
         //
-        .def("add", &cs::CSCMatrix::add)
-        .def("__add__", &cs::CSCMatrix::add)
+        .def("norm", &cs::CSCMatrix::norm, release_gil())
+        .def("fronorm", &cs::CSCMatrix::fronorm, release_gil())
         //
-        .def("permute", &cs::CSCMatrix::permute)
-        .def("symperm", &cs::CSCMatrix::symperm)
-        .def("permute_transpose", &cs::CSCMatrix::permute_transpose)
-        .def("permute_rows", &cs::CSCMatrix::permute_rows)
-        .def("permute_cols", &cs::CSCMatrix::permute_cols)
+        .def("slice", &cs::CSCMatrix::slice, release_gil())
+        .def("index", &cs::CSCMatrix::index, release_gil())
+        .def("add_empty_top", &cs::CSCMatrix::add_empty_top)
+        .def("add_empty_bottom", &cs::CSCMatrix::add_empty_bottom)
+        .def("add_empty_left", &cs::CSCMatrix::add_empty_left)
+        .def("add_empty_right", &cs::CSCMatrix::add_empty_right)
+        //
+        .def("sum_rows", &cs::CSCMatrix::sum_rows, release_gil())
+        .def("sum_cols", &cs::CSCMatrix::sum_cols, release_gil())
+        //
+        .def("tocsr", &cs::CSCMatrix::tocsr, release_gil())
+        .def("build_csr", [](const cs::CSCMatrix& A) { A.csr(); }, release_gil())
+        .def("clear_csr",
+            [](cs::CSCMatrix& A) {
+                check_not_borrowed(&A);
+                A.clear_csr();
+            }
+        )
+        .def_property_readonly("has_csr", &cs::CSCMatrix::has_csr)
+        //
+        .def("__repr__", [](const cs::CSCMatrix& A) {
+            return A.to_string(false);  // don't print all elements
+        })
+        .def("__str__", &cs::CSCMatrix::to_string,
+            py::arg("verbose")=true,
+            py::arg("threshold")=1000
+        );
+
+    //--------------------------------------------------------------------------
+    //        CSRMatrix class
+    //--------------------------------------------------------------------------
+    py::class_<cs::CSRMatrix>(m, "CSRMatrix")
+        .def(py::init<>())
+        .def(py::init<
+            const std::vector<double>&,
+            const std::vector<cs::csint>&,
+            const std::vector<cs::csint>&,
+            const cs::Shape&>(),
+            py::arg("data"),
+            py::arg("indices"),
+            py::arg("indptr"),
+            py::arg("shape")
+        )
+        .def(py::init<const cs::CSCMatrix&>())
         //
-        .def("norm", &cs::CSCMatrix::norm)
-        .def("fronorm", &cs::CSCMatrix::fronorm)
+        .def_property_readonly("nnz", &cs::CSRMatrix::nnz)
+        .def_property_readonly("shape",
+            [](const cs::CSRMatrix& A) {
+                cs::Shape s = A.shape();
+                return std::make_tuple(s[0], s[1]);
+            }
+        )
+        .def_property_readonly("indptr", [](py::object self) {
+            return vector_view(self.cast<const cs::CSRMatrix&>().indptr(), self);
+        })
+        .def_property_readonly("indices", [](py::object self) {
+            return vector_view(self.cast<const cs::CSRMatrix&>().indices(), self);
+        })
+        .def_property_readonly("data", [](py::object self) {
+            return vector_view(self.cast<const cs::CSRMatrix&>().data(), self);
+        })
+        .def("__call__", &cs::CSRMatrix::operator())
         //
-        .def("slice", &cs::CSCMatrix::slice)
-        .def("index", &cs::CSCMatrix::index)
-        .def("add_empty_top", &cs::CSCMatrix::add_empty_top)
-        .def("add_empty_bottom", &cs::CSCMatrix::add_empty_bottom)
-        .def("add_empty_left", &cs::CSCMatrix::add_empty_left)
-        .def("add_empty_right", &cs::CSCMatrix::add_empty_right)
+        .def("tocsc", &cs::CSRMatrix::tocsc, release_gil())
+        .def("to_dense_vector", &cs::CSRMatrix::to_dense_vector, py::arg("order")='F', release_gil())
+        .def("toarray", &matrix_to_ndarray<cs::CSRMatrix>, py::arg("order")='C', borrow_args())
+        .def("toscipy",
+            [](py::object self) {
+                const auto& A = self.cast<const cs::CSRMatrix&>();
+                auto [M, N] = A.shape();
+                py::module_ sparse = py::module_::import("scipy.sparse");
+                return sparse.attr("csr_array")(
+                    py::make_tuple(
+                        vector_view(A.data(), self),
+                        vector_view(A.indices(), self),
+                        vector_view(A.indptr(), self)
+                    ),
+                    py::arg("shape")=py::make_tuple(M, N)
+                );
+            }
+        )
         //
-        .def("sum_rows", &cs::CSCMatrix::sum_rows)
-        .def("sum_cols", &cs::CSCMatrix::sum_cols)
+        .def("gaxpy",
+            [](
+                const cs::CSRMatrix& A,
+                const std::vector<double>& x,
+                const std::vector<double>& y,
+                int threads
+            ) {
+                return vector_to_numpy(without_gil([&] { return A.gaxpy(x, y, threads); }));
+            },
+            py::arg("x"),
+            py::arg("y"),
+            py::arg("threads")=0,
+            borrow_args()
+        )
+        .def("gatxpy",
+            [](
+                const cs::CSRMatrix& A,
+                const std::vector<double>& x,
+                const std::vector<double>& y,
+                int threads
+            ) {
+                return vector_to_numpy(without_gil([&] { return A.gatxpy(x, y, threads); }));
+            },
+            py::arg("x"),
+            py::arg("y"),
+            py::arg("threads")=0,
+            borrow_args()
+        )
+        .def("dot",
+            [](const cs::CSRMatrix& A, const std::vector<double>& x) {
+                return vector_to_numpy(without_gil([&] { return A.dot(x); }));
+            },
+            borrow_args()
+        )
+        .def("__matmul__",
+            [](const cs::CSRMatrix& A, const std::vector<double>& x) {
+                return vector_to_numpy(without_gil([&] { return A.dot(x); }));
+            },
+            borrow_args()
+        )
+        .def("gaxpy_row", &cs::CSRMatrix::gaxpy_row, release_gil())
+        .def("gatxpy_row", &cs::CSRMatrix::gatxpy_row, release_gil())
         //
-        .def("__repr__", [](const cs::CSCMatrix& A) {
-            return A.to_string(false);  // don't print all elements
-        })
-        .def("__str__", &cs::CSCMatrix::to_string,
-            py::arg("verbose")=true,
-            py::arg("threshold")=1000
-        );
+        .def("sum_rows", &cs::CSRMatrix::sum_rows, release_gil())
+        .def("sum_cols", &cs::CSRMatrix::sum_cols, release_gil())
+        .def("slice", &cs::CSRMatrix::slice, release_gil())
+        .def("index", &cs::CSRMatrix::index, release_gil());
 
     //--------------------------------------------------------------------------
     //        Utility Functions
     //--------------------------------------------------------------------------
     m.def("inv_permute", &cs::inv_permute);
 
+    m.def("get_num_threads", &cs::get_num_threads);
+    m.def("set_num_threads", &cs::set_num_threads, py::arg("nthreads"));
+
+    //--------------------------------------------------------------------------
+    //        File I/O
+    //--------------------------------------------------------------------------
+    m.def("read_matrix_market", &cs::read_matrix_market,
+        py::arg("filename"),
+        py::arg("threads")=0,
+        release_gil()
+    );
+    m.def("write_matrix_market", &cs::write_matrix_market,
+        py::arg("filename"),
+        py::arg("A"),
+        py::arg("threads")=0,
+        release_gil()
+    );
+    m.def("read_binary", &cs::read_binary, py::arg("filename"), release_gil());
+    m.def("write_binary", &cs::write_binary,
+        py::arg("filename"),
+        py::arg("A"),
+        release_gil()
+    );
+
+    m.def("factor_key", &cs::factor_key, py::arg("A"), release_gil());
+    m.def("read_factor_key", &cs::read_factor_key, py::arg("filename"), release_gil());
+    m.def("write_chol_cache",
+        py::overload_cast<
+            const std::string&,
+            const cs::CSCMatrix&,
+            const cs::SymbolicChol&
+        >(&cs::write_chol_cache),
+        py::arg("filename"),
+        py::arg("A"),
+        py::arg("S"),
+        release_gil()
+    );
+    m.def("write_chol_cache",
+        py::overload_cast<
+            const std::string&,
+            const cs::CSCMatrix&,
+            const cs::SymbolicChol&,
+            const cs::CSCMatrix&
+        >(&cs::write_chol_cache),
+        py::arg("filename"),
+        py::arg("A"),
+        py::arg("S"),
+        py::arg("L"),
+        release_gil()
+    );
+    m.def("read_chol_cache", &cs::read_chol_cache,
+        py::arg("filename"),
+        py::arg("A"),
+        release_gil()
+    );
+    m.def("write_qr_cache",
+        py::overload_cast<
+            const std::string&,
+            const cs::CSCMatrix&,
+            const cs::SymbolicQR&
+        >(&cs::write_qr_cache),
+        py::arg("filename"),
+        py::arg("A"),
+        py::arg("S"),
+        release_gil()
+    );
+    m.def("write_qr_cache",
+        py::overload_cast<
+            const std::string&,
+            const cs::CSCMatrix&,
+            const cs::SymbolicQR&,
+            const cs::QRResult&
+        >(&cs::write_qr_cache),
+        py::arg("filename"),
+        py::arg("A"),
+        py::arg("S"),
+        py::arg("res"),
+        release_gil()
+    );
+    m.def("read_qr_cache", &cs::read_qr_cache,
+        py::arg("filename"),
+        py::arg("A"),
+        release_gil()
+    );
+
+    //--------------------------------------------------------------------------
+    //        Fill-Reducing Orderings
+    //--------------------------------------------------------------------------
+    m.def("amd",
+        [] (const cs::CSCMatrix& A, const std::string& order="APlusAT") {
+            return cs::amd(A, string_to_amdorder(order));
+        },
+        py::arg("A"),
+        py::arg("order")="APlusAT",
+        release_gil()
+    );
+
+    m.def("nested_dissection",
+        [] (
+            const cs::CSCMatrix& A,
+            const std::string& graph="APlusAT",
+            cs::csint leaf_size=256
+        ) {
+            return cs::nested_dissection(A, string_to_amdorder(graph), leaf_size);
+        },
+        py::arg("A"),
+        py::arg("graph")="APlusAT",
+        py::arg("leaf_size")=256,
+        release_gil()
+    );
+
+    m.def("vertex_separator", &cs::vertex_separator,
+        py::arg("C"),
+        py::arg("seed")=0,
+        release_gil()
+    );
+
     //--------------------------------------------------------------------------
     //        Decomposition Functions
     //--------------------------------------------------------------------------
     // ---------- Cholesky decomposition
-    m.def("etree", &cs::etree, py::arg("A"), py::arg("ata")=false);
-    m.def("post", &cs::post);
+    m.def("etree", &cs::etree, py::arg("A"), py::arg("ata")=false, release_gil());
+    m.def("post", &cs::post, release_gil());
+    m.def("etree_height", &cs::etree_height, py::arg("parent"), release_gil());
 
     m.def("chol",
         [] (
             const cs::CSCMatrix& A,
             const std::string& order="Natural",
-            bool use_postorder=false
+            bool use_postorder=false,
+            int threads=0
         ) {
             cs::AMDOrder order_enum = string_to_amdorder(order);
             cs::SymbolicChol S = cs::schol(A, order_enum, use_postorder);
             double drop_tol = 0.0;  // do not drop entries
-            return cs::chol(A, S, drop_tol);
+            return cs::chol(A, S, drop_tol, threads);
         },
         py::arg("A"),
         py::arg("order")="Natural",
-        py::arg("use_postorder")=false
+        py::arg("use_postorder")=false,
+        py::arg("threads")=0,
+        release_gil()
     );
 
     m.def("symbolic_cholesky",
@@ -381,7 +1546,8 @@ PYBIND11_MODULE(csparse, m) {
         },
         py::arg("A"),
         py::arg("order")="Natural",
-        py::arg("use_postorder")=false
+        py::arg("use_postorder")=false,
+        release_gil()
     );
 
     m.def("leftchol",
@@ -397,7 +1563,8 @@ PYBIND11_MODULE(csparse, m) {
         },
         py::arg("A"),
         py::arg("order")="Natural",
-        py::arg("use_postorder")=false
+        py::arg("use_postorder")=false,
+        release_gil()
     );
 
     m.def("rechol",
@@ -413,7 +1580,106 @@ PYBIND11_MODULE(csparse, m) {
         },
         py::arg("A"),
         py::arg("order")="Natural",
-        py::arg("use_postorder")=false
+        py::arg("use_postorder")=false,
+        release_gil()
+    );
+
+    // ---------- Cholesky with a precomputed symbolic analysis
+    m.def("schol",
+        [] (
+            const cs::CSCMatrix& A,
+            const std::string& order="Natural",
+            bool use_postorder=false
+        ) {
+            return cs::schol(A, string_to_amdorder(order), use_postorder);
+        },
+        py::arg("A"),
+        py::arg("order")="Natural",
+        py::arg("use_postorder")=false,
+        release_gil()
+    );
+
+    m.def("chol",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicChol& S, int threads=0) {
+            check_symbolic(A, S);
+            double drop_tol = 0.0;  // do not drop entries
+            return cs::chol(A, S, drop_tol, threads);
+        },
+        py::arg("A"),
+        py::arg("S"),
+        py::arg("threads")=0,
+        release_gil()
+    );
+
+    m.def("symbolic_cholesky",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicChol& S) {
+            check_symbolic(A, S);
+            return cs::symbolic_cholesky(A, S);
+        },
+        py::arg("A"),
+        py::arg("S"),
+        release_gil()
+    );
+
+    m.def("leftchol",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicChol& S) {
+            check_symbolic(A, S);
+            cs::CSCMatrix L = cs::symbolic_cholesky(A, S);
+            return cs::leftchol(A, S, L);
+        },
+        py::arg("A"),
+        py::arg("S"),
+        release_gil()
+    );
+
+    // Refactor in place, reusing the pattern of L from symbolic_cholesky. L
+    // is guarded, since the GIL is released while it is modified, and A and S
+    // are in use meanwhile.
+    m.def("leftchol",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicChol& S, cs::CSCMatrix& L)
+            -> cs::CSCMatrix&
+        {
+            UseGuard use({&A, &S});
+            MutationGuard guard(&L);
+            without_gil([&] {
+                check_symbolic(A, S);
+                cs::leftchol(A, S, L);
+            });
+            return L;
+        },
+        py::arg("A"),
+        py::arg("S"),
+        py::arg("L"),
+        py::return_value_policy::reference
+    );
+
+    m.def("rechol",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicChol& S) {
+            check_symbolic(A, S);
+            cs::CSCMatrix L = cs::symbolic_cholesky(A, S);
+            return cs::rechol(A, S, L);
+        },
+        py::arg("A"),
+        py::arg("S"),
+        release_gil()
+    );
+
+    m.def("rechol",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicChol& S, cs::CSCMatrix& L)
+            -> cs::CSCMatrix&
+        {
+            UseGuard use({&A, &S});
+            MutationGuard guard(&L);
+            without_gil([&] {
+                check_symbolic(A, S);
+                cs::rechol(A, S, L);
+            });
+            return L;
+        },
+        py::arg("A"),
+        py::arg("S"),
+        py::arg("L"),
+        py::return_value_policy::reference
     );
 
     // ---------- QR decomposition
@@ -430,16 +1696,482 @@ PYBIND11_MODULE(csparse, m) {
         },
         py::arg("A"),
         py::arg("order")="Natural",
-        py::arg("use_postorder")=false
+        py::arg("use_postorder")=false,
+        release_gil()
+    );
+
+    // ---------- QR with a precomputed symbolic analysis
+    m.def("sqr",
+        [] (
+            const cs::CSCMatrix& A,
+            const std::string& order="Natural",
+            bool use_postorder=false
+        ) {
+            return cs::sqr(A, string_to_amdorder(order), use_postorder);
+        },
+        py::arg("A"),
+        py::arg("order")="Natural",
+        py::arg("use_postorder")=false,
+        release_gil()
+    );
+
+    m.def("qr",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicQR& S) {
+            check_symbolic(A, S);
+            return cs::qr(A, S);
+        },
+        py::arg("A"),
+        py::arg("S"),
+        release_gil()
+    );
+
+    m.def("symbolic_qr",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicQR& S) {
+            check_symbolic(A, S);
+            return cs::symbolic_qr(A, S);
+        },
+        py::arg("A"),
+        py::arg("S"),
+        release_gil()
+    );
+
+    m.def("reqr",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicQR& S) {
+            check_symbolic(A, S);
+            cs::QRResult res = cs::symbolic_qr(A, S);
+            cs::reqr(A, S, res);
+            return res;
+        },
+        py::arg("A"),
+        py::arg("S"),
+        release_gil()
+    );
+
+    // Refactor in place, reusing the patterns of V and R from symbolic_qr.
+    // res is guarded, since the GIL is released while it is modified, and A
+    // and S are in use meanwhile.
+    m.def("reqr",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicQR& S, cs::QRResult& res)
+            -> cs::QRResult&
+        {
+            UseGuard use({&A, &S});
+            MutationGuard guard(&res);
+            without_gil([&] {
+                check_symbolic(A, S);
+                cs::reqr(A, S, res);
+            });
+            return res;
+        },
+        py::arg("A"),
+        py::arg("S"),
+        py::arg("res"),
+        py::return_value_policy::reference
+    );
+
+    // ---------- Multifrontal QR decomposition
+    m.def("qr_multifrontal",
+        [] (
+            const cs::CSCMatrix& A,
+            const std::string& order="ATA",
+            cs::csint block_size=32
+        ) {
+            cs::SymbolicQR S = cs::sqr(A, string_to_amdorder(order));
+            return cs::qr_multifrontal(A, S, block_size);
+        },
+        py::arg("A"),
+        py::arg("order")="ATA",
+        py::arg("block_size")=32,
+        release_gil()
+    );
+
+    m.def("qr_multifrontal",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicQR& S, cs::csint block_size=32) {
+            check_symbolic(A, S);
+            return cs::qr_multifrontal(A, S, block_size);
+        },
+        py::arg("A"),
+        py::arg("S"),
+        py::arg("block_size")=32,
+        release_gil()
+    );
+
+    // ---------- LU decomposition
+    m.def("slu",
+        [] (const cs::CSCMatrix& A, const std::string& order="Natural") {
+            return cs::slu(A, string_to_amdorder(order));
+        },
+        py::arg("A"),
+        py::arg("order")="Natural",
+        release_gil()
+    );
+
+    m.def("lu",
+        [] (
+            const cs::CSCMatrix& A,
+            const std::string& order="Natural",
+            double tol=1.0
+        ) {
+            cs::SymbolicLU S = cs::slu(A, string_to_amdorder(order));
+            return cs::lu(A, S, tol);
+        },
+        py::arg("A"),
+        py::arg("order")="Natural",
+        py::arg("tol")=1.0,
+        release_gil()
+    );
+
+    m.def("lu",
+        [] (const cs::CSCMatrix& A, const cs::SymbolicLU& S, double tol=1.0) {
+            check_symbolic(A, S);
+            return cs::lu(A, S, tol);
+        },
+        py::arg("A"),
+        py::arg("S"),
+        py::arg("tol")=1.0,
+        release_gil()
+    );
+
+    // ---------- Assembly into a frozen pattern
+    m.def("assembly_pattern",
+        py::overload_cast<const cs::COOMatrix&>(&cs::assembly_pattern),
+        py::arg("T"),
+        release_gil()
+    );
+    m.def("assembly_pattern",
+        py::overload_cast<
+            cs::csint,
+            const std::vector<cs::csint>&,
+            const std::vector<cs::csint>&
+        >(&cs::assembly_pattern),
+        py::arg("N"),
+        py::arg("elem_ptr"),
+        py::arg("elem_nodes"),
+        release_gil()
+    );
+
+    // ---------- Batches of matrices with the same pattern
+    m.def("chol_batch",
+        [] (
+            const cs::CSCMatrix& A,
+            const cs::SymbolicChol& S,
+            const std::vector<double>& values,
+            const std::string& layout="Strided",
+            int threads=0
+        ) {
+            check_symbolic(A, S);
+            return cs::chol_batch(A, S, values, string_to_batchlayout(layout), threads);
+        },
+        py::arg("A"),
+        py::arg("S"),
+        py::arg("values"),
+        py::arg("layout")="Strided",
+        py::arg("threads")=0,
+        release_gil()
+    );
+    m.def("chol_solve_batch",
+        [] (const cs::CholBatch& F, const std::vector<double>& B, int threads=0) {
+            return vector_to_numpy(without_gil([&] { return cs::chol_solve_batch(F, B, threads); }));
+        },
+        py::arg("F"),
+        py::arg("B"),
+        py::arg("threads")=0,
+        borrow_args()
+    );
+    m.def("qr_batch",
+        [] (
+            const cs::CSCMatrix& A,
+            const cs::SymbolicQR& S,
+            const std::vector<double>& values,
+            const std::string& layout="Strided",
+            int threads=0
+        ) {
+            check_symbolic(A, S);
+            return cs::qr_batch(A, S, values, string_to_batchlayout(layout), threads);
+        },
+        py::arg("A"),
+        py::arg("S"),
+        py::arg("values"),
+        py::arg("layout")="Strided",
+        py::arg("threads")=0,
+        release_gil()
+    );
+    m.def("qr_solve_batch",
+        [] (const cs::QRBatch& F, const std::vector<double>& B, int threads=0) {
+            return vector_to_numpy(without_gil([&] { return cs::qr_solve_batch(F, B, threads); }));
+        },
+        py::arg("F"),
+        py::arg("B"),
+        py::arg("threads")=0,
+        borrow_args()
     );
 
     //--------------------------------------------------------------------------
     //      Solve functions
     //--------------------------------------------------------------------------
-    m.def("lsolve", &cs::lsolve);
-    m.def("usolve", &cs::usolve);
-    m.def("lsolve_opt", &cs::lsolve_opt);
-    m.def("usolve_opt", &cs::usolve_opt);
+    m.def("lsolve",
+        [](const cs::CSCMatrix& L, const std::vector<double>& b) {
+            return vector_to_numpy(without_gil([&] { return cs::lsolve(L, b); }));
+        },
+        borrow_args()
+    );
+    m.def("usolve",
+        [](const cs::CSCMatrix& U, const std::vector<double>& b) {
+            return vector_to_numpy(without_gil([&] { return cs::usolve(U, b); }));
+        },
+        borrow_args()
+    );
+    m.def("lsolve_opt",
+        [](const cs::CSCMatrix& L, const std::vector<double>& b) {
+            return vector_to_numpy(without_gil([&] { return cs::lsolve_opt(L, b); }));
+        },
+        borrow_args()
+    );
+    m.def("usolve_opt",
+        [](const cs::CSCMatrix& U, const std::vector<double>& b) {
+            return vector_to_numpy(without_gil([&] { return cs::usolve_opt(U, b); }));
+        },
+        borrow_args()
+    );
+
+    // ---------- Multiple right-hand sides, as 2D arrays
+    using BlockArray = py::array_t<double, py::array::f_style | py::array::forcecast>;
+
+    m.def("lsolve_block",
+        [](const cs::CSCMatrix& L, const BlockArray& B) {
+            return solve_numpy_block(B, L.shape()[1], [&](const auto& b) {
+                return cs::lsolve_block(L, b);
+            });
+        },
+        py::arg("L"),
+        py::arg("B"),
+        borrow_args()
+    );
+    m.def("ltsolve_block",
+        [](const cs::CSCMatrix& L, const BlockArray& B) {
+            return solve_numpy_block(B, L.shape()[1], [&](const auto& b) {
+                return cs::ltsolve_block(L, b);
+            });
+        },
+        py::arg("L"),
+        py::arg("B"),
+        borrow_args()
+    );
+    m.def("usolve_block",
+        [](const cs::CSCMatrix& U, const BlockArray& B) {
+            return solve_numpy_block(B, U.shape()[1], [&](const auto& b) {
+                return cs::usolve_block(U, b);
+            });
+        },
+        py::arg("U"),
+        py::arg("B"),
+        borrow_args()
+    );
+    m.def("utsolve_block",
+        [](const cs::CSCMatrix& U, const BlockArray& B) {
+            return solve_numpy_block(B, U.shape()[1], [&](const auto& b) {
+                return cs::utsolve_block(U, b);
+            });
+        },
+        py::arg("U"),
+        py::arg("B"),
+        borrow_args()
+    );
+    m.def("chol_solve_block",
+        [](
+            const cs::CSCMatrix& L,
+            const cs::SymbolicChol& S,
+            const BlockArray& B
+        ) {
+            return solve_numpy_block(B, L.shape()[1], [&](const auto& b) {
+                return cs::chol_solve_block(L, S, b);
+            });
+        },
+        py::arg("L"),
+        py::arg("S"),
+        py::arg("B"),
+        borrow_args()
+    );
+
+    m.def("level_schedule", &cs::level_schedule,
+        py::arg("A"),
+        py::arg("lower")=true,
+        py::arg("trans")=false,
+        release_gil()
+    );
+    m.def("level_solve",
+        [](
+            const cs::LevelSchedule& S,
+            const std::vector<double>& b,
+            int threads=0
+        ) {
+            return vector_to_numpy(without_gil([&] { return cs::level_solve(S, b, threads); }));
+        },
+        py::arg("S"),
+        py::arg("b"),
+        py::arg("threads")=0,
+        borrow_args()
+    );
+    m.def("lusolve",
+        [](
+            const cs::CSCMatrix& A,
+            const std::vector<double>& b,
+            const std::string& order="ATANoDenseRows",
+            double tol=1.0
+        ) {
+            cs::AMDOrder order_enum = string_to_amdorder(order);
+            return vector_to_numpy(without_gil([&] {
+                return cs::lusolve(A, b, order_enum, tol);
+            }));
+        },
+        py::arg("A"),
+        py::arg("b"),
+        py::arg("order")="ATANoDenseRows",
+        py::arg("tol")=1.0,
+        borrow_args()
+    );
+    m.def("lusolve",
+        [](const cs::LUResult& res, const std::vector<double>& b) {
+            return vector_to_numpy(without_gil([&] { return cs::lusolve(res, b); }));
+        },
+        py::arg("res"),
+        py::arg("b"),
+        borrow_args()
+    );
+
+    // ---------- Multifrontal QR solves on dense blocks
+    m.def("apply_qt",
+        [](const cs::MultifrontalQR& F, const BlockArray& B) {
+            return solve_numpy_block(B, F.M, [&](const auto& b) {
+                return cs::apply_qt(F, b);
+            }, F.m2);
+        },
+        py::arg("F"),
+        py::arg("B"),
+        borrow_args()
+    );
+    m.def("apply_q",
+        [](const cs::MultifrontalQR& F, const BlockArray& Y) {
+            return solve_numpy_block(Y, F.m2, [&](const auto& y) {
+                return cs::apply_q(F, y);
+            }, F.M);
+        },
+        py::arg("F"),
+        py::arg("Y"),
+        borrow_args()
+    );
+    m.def("qrsolve",
+        [](const cs::MultifrontalQR& F, const BlockArray& B) {
+            return solve_numpy_block(B, F.M, [&](const auto& b) {
+                return cs::qrsolve(F, b);
+            }, F.N);
+        },
+        py::arg("F"),
+        py::arg("B"),
+        borrow_args()
+    );
+    m.def("qrsolve",
+        [](
+            const cs::CSCMatrix& A,
+            const BlockArray& B,
+            const std::string& order="ATA"
+        ) {
+            cs::AMDOrder order_enum = string_to_amdorder(order);
+            auto [M, N] = A.shape();
+            return solve_numpy_block(B, M, [&](const auto& b) {
+                return cs::qrsolve(A, b, order_enum);
+            }, N);
+        },
+        py::arg("A"),
+        py::arg("B"),
+        py::arg("order")="ATA",
+        borrow_args()
+    );
+
+    //--------------------------------------------------------------------------
+    //      Iterative solvers
+    //--------------------------------------------------------------------------
+    m.def("ichol",
+        [](const cs::CSCMatrix& A, const std::string& method="NoFill", double drop_tol=0.0) {
+            return cs::ichol(A, string_to_icholmethod(method), drop_tol);
+        },
+        py::arg("A"),
+        py::arg("method")="NoFill",
+        py::arg("drop_tol")=0.0,
+        release_gil()
+    );
+    m.def("jacobi_preconditioner", &cs::jacobi_preconditioner, py::arg("A"), release_gil());
+    m.def("ichol_preconditioner", &cs::ichol_preconditioner, py::arg("L"), release_gil());
+
+    // An omitted preconditioner is the identity
+    auto precond = [](const cs::Preconditioner *M) {
+        return M ? *M : cs::Preconditioner{};
+    };
+
+    m.def("pcg",
+        [precond](
+            const cs::CSCMatrix& A,
+            const std::vector<double>& b,
+            const cs::Preconditioner *M,
+            double tol,
+            cs::csint max_iter,
+            const std::vector<double>& x0,
+            int threads
+        ) {
+            return cs::pcg(A, b, precond(M), tol, max_iter, x0, threads);
+        },
+        py::arg("A"),
+        py::arg("b"),
+        py::arg("M")=py::none(),
+        py::arg("tol")=1e-8,
+        py::arg("max_iter")=0,
+        py::arg("x0")=std::vector<double>{},
+        py::arg("threads")=0,
+        release_gil()
+    );
+    m.def("minres",
+        [precond](
+            const cs::CSCMatrix& A,
+            const std::vector<double>& b,
+            const cs::Preconditioner *M,
+            double tol,
+            cs::csint max_iter,
+            const std::vector<double>& x0,
+            int threads
+        ) {
+            return cs::minres(A, b, precond(M), tol, max_iter, x0, threads);
+        },
+        py::arg("A"),
+        py::arg("b"),
+        py::arg("M")=py::none(),
+        py::arg("tol")=1e-8,
+        py::arg("max_iter")=0,
+        py::arg("x0")=std::vector<double>{},
+        py::arg("threads")=0,
+        release_gil()
+    );
+    m.def("gmres",
+        [precond](
+            const cs::CSCMatrix& A,
+            const std::vector<double>& b,
+            const cs::Preconditioner *M,
+            double tol,
+            cs::csint max_iter,
+            cs::csint restart,
+            const std::vector<double>& x0,
+            int threads
+        ) {
+            return cs::gmres(A, b, precond(M), tol, max_iter, restart, x0, threads);
+        },
+        py::arg("A"),
+        py::arg("b"),
+        py::arg("M")=py::none(),
+        py::arg("tol")=1e-8,
+        py::arg("max_iter")=0,
+        py::arg("restart")=30,
+        py::arg("x0")=std::vector<double>{},
+        py::arg("threads")=0,
+        release_gil()
+    );
 }
 
 /*==============================================================================
@@ -8,13 +8,22 @@
  *
  *============================================================================*/
 
-#include <numeric>  // accumulate
-#include <ranges>   // views::reverse
+#include <algorithm>  // sort, fill, copy_n, min, max
+#include <cassert>
+#include <numeric>    // accumulate
+#include <ranges>     // views::reverse
+#include <stdexcept>
 #include <vector>
 
+#include "amd.h"
 #include "cholesky.h"  // etree, post
+#include "io.h"        // pattern_hash
+#include "nd.h"
 #include "qr.h"
+#include "solve.h"  // usolve_block
+#include "stats.h"
 #include "utils.h"
+#include "workspace.h"
 
 namespace cs {
 
@@ -24,8 +33,16 @@ inline auto sign(double x) { return std::copysign(1.0, x); }
 
 Householder house(std::span<const double> x)
 {
-    double beta, s, sigma = 0.0;
+    double beta, s;
     std::vector<double> v(x.begin(), x.end());  // copy x into v
+    house_inplace(v, beta, s);
+    return {v, beta, s};
+}
+
+
+void house_inplace(std::span<double> v, double& beta, double& s)
+{
+    double sigma = 0.0;
 
     // sigma is the sum of squares of all elements *except* the first
     for (csint i = 1; i < v.size(); i++) {
@@ -74,8 +91,6 @@ Householder house(std::span<const double> x)
         //     vi /= v0;
         // }
     }
-
-    return {v, beta, s};
 }
 
 
@@ -87,6 +102,18 @@ std::vector<double> happly(
 )
 {
     std::vector<double> Hx(x);  // copy x into Hx
+    happly_inplace(V, j, beta, Hx);
+    return Hx;
+}
+
+
+void happly_inplace(
+    const CSCMatrix& V,
+    csint j,
+    double beta,
+    std::span<double> x
+)
+{
     double tau = 0.0;
 
     // tau = v^T x
@@ -96,12 +123,10 @@ std::vector<double> happly(
 
     tau *= beta;  // tau = beta * v^T x
 
-    // Hx = x - v*tau
+    // x -= v*tau
     for (csint p = V.p_[j]; p < V.p_[j+1]; p++) {
-        Hx[V.i_[p]] -= V.v_[p] * tau;
+        x[V.i_[p]] -= V.v_[p] * tau;
     }
-
-    return Hx;
 }
 
 
@@ -130,7 +155,7 @@ void vcount(const CSCMatrix& A, SymbolicQR& S)
                        tail(N, -1),  // the last row index in each column
                        nque(N);      // the number of rows in each column
 
-    S.p_inv.assign(std::max(M, N), -1);  // initialize permutation vector
+    S.p_inv.assign(M + N, -1);  // room for the fictitious rows
 
     // Initialize the linked lists for each row with their leftmost index
     for (csint i = M-1; i >= 0; i--) {  // scan rows in reverse order
@@ -175,11 +200,15 @@ void vcount(const CSCMatrix& A, SymbolicQR& S)
             S.p_inv[i] = k++;
         }
     }
+
+    S.p_inv.resize(S.m2);
 }
 
 
 SymbolicQR sqr(const CSCMatrix& A, AMDOrder order, bool use_postorder)
 {
+    PhaseTimer timer("sqr");
+
     auto [M, N] = A.shape();
     SymbolicQR S;             // allocate result
     std::vector<csint> q(N);  // column permutation vector
@@ -187,12 +216,14 @@ SymbolicQR sqr(const CSCMatrix& A, AMDOrder order, bool use_postorder)
     if (order == AMDOrder::Natural) {
         std::iota(q.begin(), q.end(), 0);  // identity permutation
     } else {
-        // TODO implement amd order (see Chapter 7)
-        // q = amd(order, A);  // P = amd(A + A.T()) or natural
-        throw std::runtime_error("Ordering method not implemented!");
+        PhaseTimer amd_timer("sqr.amd");
+        q = (order == AMDOrder::NestedDissection)
+            ? nested_dissection(A, AMDOrder::ATA)  // Q = nd(A.T() * A)
+            : amd(A, order);                       // Q = amd(A.T() * A)
     }
 
     // Find pattern of Cholesky factor of A.T @ A
+    PhaseTimer etree_timer("sqr.etree");
     bool values = false,  // don't copy values
          CTC = true;      // do take the etree/counts of A^T A
 
@@ -209,19 +240,47 @@ SymbolicQR sqr(const CSCMatrix& A, AMDOrder order, bool use_postorder)
     }
 
     S.q = q;  // store the column permutation
+    S.pattern_hash = pattern_hash(A);
+
+    etree_timer.stop();
+    PhaseTimer counts_timer("sqr.counts");
 
     // column counts of the Cholesky factor of C^T C
     std::vector<csint> cp = counts(C, S.parent, postorder, CTC);
     S.rnz = std::accumulate(cp.begin(), cp.end(), 0);
 
-    S.leftmost = find_leftmost(A);
+    S.leftmost = find_leftmost(C);  // leftmost of the permuted matrix
     vcount(C, S);  // compute p_inv, vnz, m2
     assert(S.vnz >= 0 && S.rnz >= 0);  // overflow guard
 
+    record_memory(memory_bytes(C) + memory_bytes(S.q) + memory_bytes(S.p_inv)
+                  + memory_bytes(S.parent) + memory_bytes(S.leftmost));
+
     return S;
 }
 
 
+// Count the flops of a Householder QR factorization with factors V and R. Each
+// off-diagonal R(i, k) applies the reflection V(:, i) to column k, with a dot
+// product and an axpy, and each column k computes the reflection V(:, k).
+static double qr_flops(const CSCMatrix& V, const CSCMatrix& R)
+{
+    const auto& Vp = V.indptr();
+    const auto& Rp = R.indptr();
+    const auto& Ri = R.indices();
+
+    double flops = 0;
+    for (csint k = 0; k < R.shape()[1]; k++) {
+        for (csint p = Rp[k]; p < Rp[k+1] - 1; p++) {
+            csint i = Ri[p];
+            flops += 4.0 * (Vp[i+1] - Vp[i]);
+        }
+        flops += 3.0 * (Vp[k+1] - Vp[k]);
+    }
+    return flops;
+}
+
+
 // Exercise 5.1
 QRResult symbolic_qr(const CSCMatrix& A, const SymbolicQR& S)
 {
@@ -294,6 +353,8 @@ QRResult symbolic_qr(const CSCMatrix& A, const SymbolicQR& S)
 
 QRResult qr(const CSCMatrix& A, const SymbolicQR& S)
 {
+    PhaseTimer timer("qr");
+
     csint M = S.m2;  // If M < N, m2 = N
     csint N = A.N_;
 
@@ -302,12 +363,12 @@ QRResult qr(const CSCMatrix& A, const SymbolicQR& S)
     CSCMatrix R({M, N}, S.rnz);   // R factor
     std::vector<double> beta(N);  // scaling factors
 
-    // Allocate workspaces
-    std::vector<double> x(M);      // dense vector
-    std::vector<csint>  w(M, -1),  // workspace for pattern of V[:, k]
-                        s, t;      // stacks for pattern of R[:, k]
-    s.reserve(N);
-    t.reserve(N);
+    // Borrow workspaces. Each column leaves x all zero again.
+    Workspace& ws = get_workspace();
+    auto x = ws.zeros<double>(M);    // dense vector
+    auto w = ws.fill<csint>(M, -1);  // workspace for pattern of V[:, k]
+    auto s = ws.reserve<csint>(N),   // stacks for pattern of R[:, k]
+         t = ws.reserve<csint>(N);
 
     // Compute V and R
     csint vnz = 0,
@@ -320,22 +381,22 @@ QRResult qr(const CSCMatrix& A, const SymbolicQR& S)
         w[k] = k;         // add V(k, k) to pattern of V
         V.i_[vnz++] = k;  // V(k, k) is non-zero
 
-        t.clear();
+        t->clear();
         csint col = S.q[k];  // permuted column of A
 
         // find R[:, k] pattern
         for (csint p = A.p_[col]; p < A.p_[col+1]; p++) {
             csint i = S.leftmost[A.i_[p]];  // i = min(find(A(i, q)))
 
-            s.clear();
+            s->clear();
             while (w[i] != k) {  // traverse up to k
-                s.push_back(i);
+                s->push_back(i);
                 w[i] = k;
                 i = S.parent[i];
             }
 
             // Push path onto "output" stack
-            std::copy(s.rbegin(), s.rend(), std::back_inserter(t));
+            std::copy(s->rbegin(), s->rend(), std::back_inserter(*t));
 
             i = S.p_inv[A.i_[p]];     // i = permuted row of A(:, col)
             x[i] = A.v_[p];           // x(i) = A(:, col)
@@ -347,14 +408,14 @@ QRResult qr(const CSCMatrix& A, const SymbolicQR& S)
         }
 
         // for each i in pattern of R[:, k] (R(i, k) is non-zero)
-        for (csint i : t | std::views::reverse) {
-            x = happly(V, i, beta[i], x);  // apply (V(i), Beta(i)) to x
+        for (csint i : *t | std::views::reverse) {
+            happly_inplace(V, i, beta[i], *x);  // apply (V(i), Beta(i)) to x
             R.i_[rnz] = i;                 // R(i, k) = x(i)
             R.v_[rnz++] = x[i];
             x[i] = 0;
             if (S.parent[i] == k) {
                 // Scatter the non-zero pattern without changing the values
-                vnz = V.scatter(i, 0, w, x, k, V, vnz, false, false);
+                vnz = V.scatter(i, 0, *w, *x, k, V, vnz, false, false);
             }
         }
 
@@ -375,6 +436,13 @@ QRResult qr(const CSCMatrix& A, const SymbolicQR& S)
     R.p_[N] = rnz;  // finalize R
     V.p_[N] = vnz;  // finalize V
 
+    if (Stats *stats = get_stats()) {
+        stats->flops += qr_flops(V, R);
+        record_memory(memory_bytes(V) + memory_bytes(R) + memory_bytes(beta)
+                      + memory_bytes(*x) + memory_bytes(*w)
+                      + memory_bytes(*s) + memory_bytes(*t));
+    }
+
     // Copy the permutation to the result
     std::vector<csint> p_inv = S.p_inv;
 
@@ -407,6 +475,10 @@ void reqr(const CSCMatrix& A, const SymbolicQR& S, QRResult& res)
     assert(!V.indices().empty());
     assert(!R.indices().empty());
 
+    PhaseTimer timer("reqr");
+    V.invalidate_csr_();
+    R.invalidate_csr_();
+
     beta = std::vector<double>(N);  // scaling factors
 
     // Allocate workspaces
@@ -425,7 +497,7 @@ void reqr(const CSCMatrix& A, const SymbolicQR& S, QRResult& res)
         // for each i in pattern of R[:, k] (R(i, k) is non-zero)
         for (csint p = R.p_[k]; p < R.p_[k+1] - 1; p++) {
             csint i = R.i_[p];             // R(i, k)
-            x = happly(V, i, beta[i], x);  // apply (V(i), Beta(i)) to x
+            happly_inplace(V, i, beta[i], x);  // apply (V(i), Beta(i)) to x
             R.v_[p] = x[i];                // R(i, k) = x(i)
             x[i] = 0;
         }
@@ -443,6 +515,593 @@ void reqr(const CSCMatrix& A, const SymbolicQR& S, QRResult& res)
         beta[k] = h.beta;
         R.v_[R.p_[k+1] - 1] = h.s;  // R(k, k) = -sign(x[0]) * norm(x)
     }
+
+    if (Stats *stats = get_stats()) {
+        stats->flops += qr_flops(V, R);
+        record_memory(memory_bytes(V) + memory_bytes(R) + memory_bytes(beta)
+                      + memory_bytes(x));
+    }
+}
+
+
+/*------------------------------------------------------------------------------
+ *         Multifrontal QR
+ *----------------------------------------------------------------------------*/
+/** Apply a block reflector \f$ I - V T V^T \f$ to the columns of a dense matrix.
+ *
+ * @param V  the `m x b` unit lower trapezoidal reflections, with leading
+ *        dimension `ldv`
+ * @param T  the `b x b` upper triangular factor, with leading dimension `b`
+ * @param m, b  the size of `V`
+ * @param[in,out] C  the `m x n` matrix, with leading dimension `ldc`. On
+ *        output, \f$ (I - V T^T V^T) C \f$ if `trans`, or
+ *        \f$ (I - V T V^T) C \f$ otherwise.
+ * @param w  a workspace of size at least `b`
+ */
+static void apply_block_reflector(
+    const double *V,
+    csint ldv,
+    const double *T,
+    csint m,
+    csint b,
+    double *C,
+    csint ldc,
+    csint n,
+    bool trans,
+    std::vector<double>& w
+)
+{
+    for (csint c = 0; c < n; c++) {
+        double *y = C + c * ldc;
+
+        // w = V^T y, where V(0:j, j) == 0
+        for (csint j = 0; j < b; j++) {
+            const double *v = V + j * ldv;
+            double d = 0.0;
+            for (csint i = j; i < m; i++) {
+                d += v[i] * y[i];
+            }
+            w[j] = d;
+        }
+
+        // w = T^T w or w = T w, in place
+        if (trans) {
+            for (csint i = b - 1; i >= 0; i--) {
+                double t = 0.0;
+                for (csint j = 0; j <= i; j++) {
+                    t += T[j + i * b] * w[j];
+                }
+                w[i] = t;
+            }
+        } else {
+            for (csint i = 0; i < b; i++) {
+                double t = 0.0;
+                for (csint j = i; j < b; j++) {
+                    t += T[i + j * b] * w[j];
+                }
+                w[i] = t;
+            }
+        }
+
+        // y -= V w
+        for (csint j = 0; j < b; j++) {
+            const double *v = V + j * ldv;
+            double wj = w[j];
+            for (csint i = j; i < m; i++) {
+                y[i] -= v[i] * wj;
+            }
+        }
+    }
+}
+
+
+/** Compute the dense QR factorization of a front with blocked reflections.
+ *
+ * Each panel of `nb` columns is factored one column at a time, and its T
+ * factor is formed as in LAPACK DLARFT. The block reflector of the panel is
+ * then applied to the trailing columns.
+ *
+ * @param[in,out] Fr  the `m x n` front, in column-major order. On output, the
+ *        upper trapezoidal factor, with zeros below the diagonal.
+ * @param m, n  the size of the front
+ * @param nb  the number of reflections in each panel
+ * @param[out] H  the `m x min(m, n)` reflections, initialized to zero
+ * @param[out] T  the T factor of each panel, the panel starting at column `k`
+ *        is stored at `T + k * nb`
+ * @param tau, w  workspaces of size at least `nb`
+ */
+static void factor_front(
+    double *Fr,
+    csint m,
+    csint n,
+    csint nb,
+    double *H,
+    double *T,
+    std::vector<double>& tau,
+    std::vector<double>& w
+)
+{
+    csint h = std::min(m, n);
+
+    for (csint k0 = 0; k0 < h; k0 += nb) {
+        csint b = std::min(nb, h - k0);
+
+        // Factor the panel
+        for (csint j = k0; j < k0 + b; j++) {
+            double *x = Fr + j * m;
+            std::span<double> v(x + j, m - j);
+
+            double beta, s;
+            house_inplace(v, beta, s);
+
+            std::copy(v.begin(), v.end(), H + j * m + j);  // H(j:m, j) = v
+            std::fill(v.begin(), v.end(), 0.0);
+            x[j] = s;  // R(j, j)
+            tau[j - k0] = beta;
+
+            const double *hj = H + j * m;
+            for (csint c = j + 1; c < k0 + b; c++) {
+                double *y = Fr + c * m;
+                double d = 0.0;
+                for (csint i = j; i < m; i++) {
+                    d += hj[i] * y[i];
+                }
+                d *= beta;
+                for (csint i = j; i < m; i++) {
+                    y[i] -= hj[i] * d;
+                }
+            }
+        }
+
+        // Form T, such that H_k0 ... H_(k0+b-1) = I - V T V^T
+        const double *V = H + k0 * m + k0;
+        double *Tp = T + k0 * nb;
+
+        for (csint i = 0; i < b; i++) {
+            const double *vi = V + i * m;
+
+            // w = V(:, 0:i)^T v_i, where v_i is zero above row i
+            for (csint j = 0; j < i; j++) {
+                const double *vj = V + j * m;
+                double d = 0.0;
+                for (csint r = i; r < m - k0; r++) {
+                    d += vj[r] * vi[r];
+                }
+                w[j] = d;
+            }
+
+            // T(0:i, i) = -tau_i T(0:i, 0:i) w
+            for (csint r = 0; r < i; r++) {
+                double t = 0.0;
+                for (csint c = r; c < i; c++) {
+                    t += Tp[r + c * b] * w[c];
+                }
+                Tp[r + i * b] = -tau[i] * t;
+            }
+
+            Tp[i + i * b] = tau[i];
+        }
+
+        // Apply the block reflector to the trailing columns
+        apply_block_reflector(
+            V, m, Tp, m - k0, b,
+            Fr + (k0 + b) * m + k0, m, n - k0 - b,
+            true, w
+        );
+    }
+}
+
+
+MultifrontalQR qr_multifrontal(
+    const CSCMatrix& A,
+    const SymbolicQR& S,
+    csint block_size
+)
+{
+    PhaseTimer timer("qr_multifrontal");
+
+    auto [M, N] = A.shape();
+
+    if (M < N) {
+        throw std::runtime_error("Multifrontal QR requires M >= N.");
+    }
+
+    if (block_size < 1) {
+        throw std::runtime_error("Block size must be positive.");
+    }
+
+    // The rows of C = A(:, q) are the columns of C^T
+    CSCMatrix CT = A.permute_cols(S.q).transpose();
+    const auto& Tp = CT.indptr();
+    const auto& Ti = CT.indices();
+    const auto& Tx = CT.data();
+
+    MultifrontalQR F;
+    F.M = M;
+    F.N = N;
+    F.m2 = M;
+    F.block_size = block_size;
+    F.q = S.q;
+
+    // Fundamental supernodes: a column joins its only child
+    std::vector<csint> nchild(N, 0), col_front(N);
+    for (csint j = 0; j < N; j++) {
+        if (S.parent[j] >= 0) {
+            nchild[S.parent[j]]++;
+        }
+    }
+
+    for (csint j = 0; j < N; j++) {
+        if (j == 0 || S.parent[j-1] != j || nchild[j] != 1) {
+            F.super.push_back(j);
+        }
+        col_front[j] = static_cast<csint>(F.super.size()) - 1;
+    }
+    F.super.push_back(N);
+
+    csint nf = F.num_fronts();
+
+    // Linked lists of the children of each front, and of its rows of A
+    std::vector<csint> head(nf, -1), next(nf, -1),
+                       row_head(nf, -1), row_next(M, -1);
+
+    for (csint f = nf - 1; f >= 0; f--) {
+        csint p = S.parent[F.super[f+1] - 1];
+        if (p >= 0) {
+            next[f] = head[col_front[p]];
+            head[col_front[p]] = f;
+        }
+    }
+
+    for (csint i = M - 1; i >= 0; i--) {
+        csint k = S.leftmost[i];
+        if (k >= 0) {  // empty rows are not in any front
+            row_next[i] = row_head[col_front[k]];
+            row_head[col_front[k]] = i;
+        }
+    }
+
+    // The contribution block of each front, until it is assembled
+    struct ContributionBlock {
+        std::vector<csint> cols, slots;
+        std::vector<double> values;  // slots x cols, in column-major order
+    };
+
+    std::vector<ContributionBlock> cb(nf);
+
+    std::vector<csint> loc(N, -1),  // local column of each column in the front
+                       cols,        // columns of the front
+                       piv_slot(N); // the slot of each row of R
+    std::vector<double> Fr,  // the dense front
+                        tau(block_size), w(block_size);
+
+    std::vector<csint> Rk, Rj;  // triplets of R, in order of increasing rows
+    std::vector<double> Rx;
+
+    F.front_ptr.push_back(0);
+    F.H_ptr.push_back(0);
+    F.T_ptr.push_back(0);
+
+    double flops = 0;
+    std::size_t max_front = 0;
+
+    for (csint f = 0; f < nf; f++) {
+        csint k1 = F.super[f],
+              k2 = F.super[f+1],
+              npiv = k2 - k1;
+
+        // Pattern of the front: the pivots, then the other columns in order
+        cols.clear();
+        for (csint k = k1; k < k2; k++) {
+            loc[k] = k - k1;
+            cols.push_back(k);
+        }
+
+        csint m = 0;
+        for (csint c = head[f]; c != -1; c = next[c]) {
+            for (const auto& j : cb[c].cols) {
+                if (loc[j] < 0) {
+                    loc[j] = 0;
+                    cols.push_back(j);
+                }
+            }
+            m += static_cast<csint>(cb[c].slots.size());
+        }
+
+        for (csint i = row_head[f]; i != -1; i = row_next[i]) {
+            for (csint p = Tp[i]; p < Tp[i+1]; p++) {
+                if (loc[Ti[p]] < 0) {
+                    loc[Ti[p]] = 0;
+                    cols.push_back(Ti[p]);
+                }
+            }
+            m++;
+        }
+
+        std::sort(cols.begin() + npiv, cols.end());
+        csint n = static_cast<csint>(cols.size());
+        for (csint c = npiv; c < n; c++) {
+            loc[cols[c]] = c;
+        }
+
+        csint nfict = std::max<csint>(npiv - m, 0);  // fictitious rows
+        m += nfict;
+
+        // Assemble the contribution blocks of the children, then the rows of A
+        Fr.assign(m * n, 0.0);
+        csint r = 0;
+
+        for (csint c = head[f]; c != -1; c = next[c]) {
+            ContributionBlock& B = cb[c];
+            csint mc = static_cast<csint>(B.slots.size());
+            for (csint jj = 0; jj < static_cast<csint>(B.cols.size()); jj++) {
+                double *x = Fr.data() + loc[B.cols[jj]] * m + r;
+                std::copy_n(B.values.data() + jj * mc, mc, x);
+            }
+            F.front_rows.insert(F.front_rows.end(), B.slots.begin(), B.slots.end());
+            r += mc;
+            B = {};  // free the block
+        }
+
+        for (csint i = row_head[f]; i != -1; i = row_next[i]) {
+            for (csint p = Tp[i]; p < Tp[i+1]; p++) {
+                Fr[loc[Ti[p]] * m + r] += Tx[p];
+            }
+            F.front_rows.push_back(i);
+            r++;
+        }
+
+        for (csint i = 0; i < nfict; i++) {
+            F.front_rows.push_back(F.m2++);
+        }
+
+        // Factor the front
+        csint h = std::min(m, n);
+        csint H_off = F.H_ptr.back(),
+              T_off = F.T_ptr.back();
+
+        F.H.resize(H_off + m * h, 0.0);
+        F.T.resize(T_off + h * block_size, 0.0);
+        F.H_ptr.push_back(H_off + m * h);
+        F.T_ptr.push_back(T_off + h * block_size);
+
+        factor_front(Fr.data(), m, n, block_size, F.H.data() + H_off,
+                     F.T.data() + T_off, tau, w);
+
+        for (csint j = 0; j < h; j++) {
+            flops += 3.0 * (m - j) + 4.0 * (m - j) * (n - j - 1);
+        }
+        max_front = std::max(max_front, Fr.size());
+
+        // The pivot rows are rows of R
+        const csint *slots = F.front_rows.data() + F.front_ptr.back();
+
+        for (csint i = 0; i < npiv; i++) {
+            piv_slot[k1 + i] = slots[i];
+            for (csint j = i; j < n; j++) {
+                Rk.push_back(k1 + i);
+                Rj.push_back(cols[j]);
+                Rx.push_back(Fr[i + j * m]);
+            }
+        }
+
+        // The other rows of the upper trapezoid are the contribution block
+        if (h > npiv && S.parent[k2 - 1] >= 0) {
+            ContributionBlock& B = cb[f];
+            csint mc = h - npiv;
+            B.cols.assign(cols.begin() + npiv, cols.end());
+            B.slots.assign(slots + npiv, slots + h);
+            B.values.resize(mc * (n - npiv));
+            for (csint j = npiv; j < n; j++) {
+                std::copy_n(Fr.data() + j * m + npiv, mc,
+                            B.values.data() + (j - npiv) * mc);
+            }
+        }
+
+        F.front_ptr.push_back(static_cast<csint>(F.front_rows.size()));
+
+        for (const auto& j : cols) {
+            loc[j] = -1;
+        }
+    }
+
+    // R is N x N, sorted by construction, with the diagonal last in each column
+    std::vector<csint> count(N, 0);
+    for (const auto& j : Rj) {
+        count[j]++;
+    }
+
+    std::vector<csint> Rp = cumsum(count);
+    std::vector<csint> pos(Rp.begin(), Rp.end() - 1);
+    std::vector<csint> Ri(Rk.size());
+    std::vector<double> Rv(Rk.size());
+
+    for (std::size_t p = 0; p < Rk.size(); p++) {
+        csint q = pos[Rj[p]]++;
+        Ri[q] = Rk[p];
+        Rv[q] = Rx[p];
+    }
+
+    F.R = CSCMatrix(std::move(Rv), std::move(Ri), std::move(Rp), {N, N});
+
+    // The rows of R, followed by the remaining slots in order
+    std::vector<char> is_pivot(F.m2, 0);
+    F.rows = piv_slot;
+    for (const auto& i : piv_slot) {
+        is_pivot[i] = 1;
+    }
+    for (csint i = 0; i < F.m2; i++) {
+        if (!is_pivot[i]) {
+            F.rows.push_back(i);
+        }
+    }
+
+    if (Stats *stats = get_stats()) {
+        stats->flops += flops;
+        record_memory(memory_bytes(F.R) + memory_bytes(F.H) + memory_bytes(F.T)
+                      + memory_bytes(F.front_rows) + memory_bytes(CT)
+                      + max_front * sizeof(double));
+    }
+
+    return F;
+}
+
+
+/** Apply the reflections of each front to a dense block in the order of the
+ * slots.
+ *
+ * @param F  the multifrontal factorization
+ * @param[in,out] Y  the dense `m2 x K` block, in column-major order
+ * @param K  the number of columns of `Y`
+ * @param trans  if true, apply \f$ Q^T \f$, otherwise apply \f$ Q \f$
+ */
+static void apply_fronts(
+    const MultifrontalQR& F,
+    std::vector<double>& Y,
+    csint K,
+    bool trans
+)
+{
+    csint nf = F.num_fronts(),
+          nb = F.block_size,
+          m2 = F.m2;
+
+    std::vector<double> W, w(nb);
+
+    for (csint s = 0; s < nf; s++) {
+        // Q^T = ... H_2^T H_1^T applies the fronts in order, Q in reverse
+        csint f = trans ? s : nf - 1 - s;
+        csint r0 = F.front_ptr[f],
+              m = F.front_ptr[f+1] - r0;
+
+        if (m == 0) {
+            continue;
+        }
+
+        csint h = (F.H_ptr[f+1] - F.H_ptr[f]) / m;
+        const csint *slots = F.front_rows.data() + r0;
+        const double *H = F.H.data() + F.H_ptr[f];
+        const double *T = F.T.data() + F.T_ptr[f];
+
+        W.resize(m * K);
+        for (csint c = 0; c < K; c++) {
+            for (csint i = 0; i < m; i++) {
+                W[i + c * m] = Y[slots[i] + c * m2];
+            }
+        }
+
+        csint np = (h + nb - 1) / nb;  // number of panels
+        for (csint t = 0; t < np; t++) {
+            csint k0 = (trans ? t : np - 1 - t) * nb;
+            csint b = std::min(nb, h - k0);
+            apply_block_reflector(
+                H + k0 * m + k0, m, T + k0 * nb, m - k0, b,
+                W.data() + k0, m, K,
+                trans, w
+            );
+        }
+
+        for (csint c = 0; c < K; c++) {
+            for (csint i = 0; i < m; i++) {
+                Y[slots[i] + c * m2] = W[i + c * m];
+            }
+        }
+    }
+}
+
+
+std::vector<double> apply_qt(const MultifrontalQR& F, const std::vector<double>& B)
+{
+    csint M = F.M,
+          m2 = F.m2;
+
+    assert(M == 0 ? B.empty() : B.size() % M == 0);
+    csint K = (M == 0) ? 0 : B.size() / M;
+
+    // Copy B into the slots, with zeros in the fictitious rows
+    std::vector<double> Y(m2 * K, 0.0);
+    for (csint c = 0; c < K; c++) {
+        std::copy_n(B.begin() + c * M, M, Y.begin() + c * m2);
+    }
+
+    apply_fronts(F, Y, K, true);
+
+    // Order the slots by the rows of Q^T A
+    std::vector<double> Z(m2 * K);
+    for (csint c = 0; c < K; c++) {
+        for (csint r = 0; r < m2; r++) {
+            Z[r + c * m2] = Y[F.rows[r] + c * m2];
+        }
+    }
+
+    return Z;
+}
+
+
+std::vector<double> apply_q(const MultifrontalQR& F, const std::vector<double>& Y)
+{
+    csint M = F.M,
+          m2 = F.m2;
+
+    assert(m2 == 0 ? Y.empty() : Y.size() % m2 == 0);
+    csint K = (m2 == 0) ? 0 : Y.size() / m2;
+
+    std::vector<double> Z(m2 * K);
+    for (csint c = 0; c < K; c++) {
+        for (csint r = 0; r < m2; r++) {
+            Z[F.rows[r] + c * m2] = Y[r + c * m2];
+        }
+    }
+
+    apply_fronts(F, Z, K, false);
+
+    // Drop the fictitious rows
+    std::vector<double> B(M * K);
+    for (csint c = 0; c < K; c++) {
+        std::copy_n(Z.begin() + c * m2, M, B.begin() + c * M);
+    }
+
+    return B;
+}
+
+
+std::vector<double> qrsolve(const MultifrontalQR& F, const std::vector<double>& B)
+{
+    csint N = F.N,
+          m2 = F.m2;
+
+    std::vector<double> Y = apply_qt(F, B);  // Y = Q^T B
+    csint K = (m2 == 0) ? 0 : Y.size() / m2;
+
+    // X = R \ Y(0:N, :)
+    std::vector<double> Yn(N * K);
+    for (csint c = 0; c < K; c++) {
+        std::copy_n(Y.begin() + c * m2, N, Yn.begin() + c * N);
+    }
+
+    std::vector<double> Xq = usolve_block(F.R, Yn);
+
+    // X(q, :) = Xq
+    std::vector<double> X(N * K);
+    for (csint c = 0; c < K; c++) {
+        for (csint k = 0; k < N; k++) {
+            X[F.q[k] + c * N] = Xq[k + c * N];
+        }
+    }
+
+    return X;
+}
+
+
+std::vector<double> qrsolve(
+    const CSCMatrix& A,
+    const std::vector<double>& b,
+    AMDOrder order
+)
+{
+    SymbolicQR S = sqr(A, order);
+    MultifrontalQR F = qr_multifrontal(A, S);
+    return qrsolve(F, b);
 }
 
 
@@ -7,12 +7,21 @@
  *
  *============================================================================*/
 
+#include <algorithm>  // std::reverse, std::lower_bound, std::sort
+#include <barrier>
 #include <cassert>
 #include <ranges>  // for std::views::reverse
+#include <stdexcept>
 
+#include "cholesky.h"  // SupernodalChol
+#include "parallel.h"
+#include "simd.h"
 #include "solve.h"
 #include "csc.h"
+#include "csr.h"
+#include "stats.h"
 #include "utils.h"
+#include "workspace.h"
 
 namespace cs {
 
@@ -169,6 +178,11 @@ std::vector<double> lsolve_rows(const CSCMatrix& L, const std::vector<double>& b
     assert(L.M_ == L.N_);
     assert(L.M_ == b.size());
 
+    // Solve by rows if the mirror exists, without searching the columns
+    if (const CSRMatrix *R = L.cached_csr_()) {
+        return lsolve_rows(*R, b);
+    }
+
     // First (backward) pass to find diagonal entries
     // p_diags is a vector of pointers to the diagonal entries
     std::vector<csint> p_diags = find_lower_diagonals(L);
@@ -280,6 +294,11 @@ std::vector<double> usolve_rows(const CSCMatrix& U, const std::vector<double>& b
     assert(U.M_ == U.N_);
     assert(U.M_ == b.size());
 
+    // Solve by rows if the mirror exists, without searching the columns
+    if (const CSRMatrix *R = U.cached_csr_()) {
+        return usolve_rows(*R, b);
+    }
+
     // First (backward) pass to find diagonal entries
     // p_diags is a vector of pointers to the diagonal entries
     std::vector<csint> p_diags = find_upper_diagonals(U);
@@ -467,21 +486,60 @@ SparseSolution spsolve(
     const CSCMatrix& A, 
     const CSCMatrix& B,
     csint k,
-    bool lo
+    bool lo,
+    const std::vector<csint>& p_inv
 )
 {
-    // Populate xi with the non-zero indices of x
-    std::vector<csint> xi = reach(A, B, k);
+    PhaseTimer timer("spsolve");
+
+    auto marked = get_workspace().zeros<bool>(A.N_);  // returned unmarked
+    std::vector<csint> xi;
     std::vector<double> x(A.N_);  // dense output vector
 
-    // scatter B(:, k) into x
+    spsolve(A, B, k, *marked, xi, x, lo, p_inv);
+
+    if (Stats *stats = get_stats()) {
+        // One division and an axpy with the off-diagonal of each column
+        for (const auto& j : xi) {
+            csint J = p_inv.empty() ? j : p_inv[j];
+            if (J >= 0) {
+                stats->flops += 2.0 * (A.p_[J+1] - A.p_[J]) - 1;
+            }
+        }
+    }
+
+    record_memory(memory_bytes(xi) + memory_bytes(x));
+
+    return {xi, x};
+}
+
+
+std::vector<csint>& spsolve(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    csint k,
+    std::vector<bool>& marked,
+    std::vector<csint>& xi,
+    std::vector<double>& x,
+    bool lo,
+    const std::vector<csint>& p_inv
+)
+{
+    // Populate xi with the non-zero indices of x
+    reach(A, B, k, marked, xi, p_inv);
+
+    // clear x in the pattern, then scatter B(:, k) into x
+    for (const auto& j : xi) {
+        x[j] = 0;
+    }
+
     for (csint p = B.p_[k]; p < B.p_[k+1]; p++) {
         x[B.i_[p]] = B.v_[p];
     }
 
     // Solve Lx = b_k or Ux = b_k
-    for (auto& j : xi) {  // x(j) is nonzero
-        csint J = j;  // j maps to col J of G (TODO p_inv arg for LU)
+    for (const auto& j : xi) {  // x(j) is nonzero
+        csint J = p_inv.empty() ? j : p_inv[j];  // j maps to col J of G
         if (J < 0) {
             continue;                                // x(j) is not in the pattern of G
         }
@@ -493,26 +551,52 @@ SparseSolution spsolve(
         }
     }
 
-    return {xi, x};
+    return xi;
 }
 
 
-std::vector<csint> reach(const CSCMatrix& A, const CSCMatrix& B, csint k)
+std::vector<csint> reach(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    csint k,
+    const std::vector<csint>& p_inv
+)
 {
-    // TODO p_inv argument (ignore for now, used in LU decomoposition)
-    std::vector<bool> marked(A.N_, false);
+    auto marked = get_workspace().zeros<bool>(A.N_);  // returned unmarked
     std::vector<csint> xi;  // do not initialize for dfs call!
     xi.reserve(A.N_);
 
+    return reach(A, B, k, *marked, xi, p_inv);
+}
+
+
+std::vector<csint>& reach(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    csint k,
+    std::vector<bool>& marked,
+    std::vector<csint>& xi,
+    const std::vector<csint>& p_inv
+)
+{
+    xi.clear();
+
     for (csint p = B.p_[k]; p < B.p_[k+1]; p++) {
         csint j = B.i_[p];  // consider nonzero B(j, k)
         if (!marked[j]) {
-            xi = dfs(A, j, marked, xi);
+            dfs(A, j, marked, xi, p_inv);
         }
     }
 
+    // Restore the workspace for the next call
+    for (const auto& j : xi) {
+        marked[j] = false;
+    }
+
     // xi is returned from dfs in reverse order, since it is a stack
-    return std::vector<csint>(xi.rbegin(), xi.rend());
+    std::reverse(xi.begin(), xi.end());
+
+    return xi;
 }
 
 
@@ -520,12 +604,18 @@ std::vector<csint>& dfs(
     const CSCMatrix& A, 
     csint j,
     std::vector<bool>& marked,
-    std::vector<csint>& xi
+    std::vector<csint>& xi,
+    const std::vector<csint>& p_inv
 )
 {
-    std::vector<csint> rstack, pstack;  // recursion and pause stacks
-    rstack.reserve(A.N_);
-    pstack.reserve(A.N_);
+    // NOTE the stacks are not reserved, since dfs is called many times
+    // for each column in reach, and the depth is typically small. The pooled
+    // stacks keep their capacity from previous calls.
+    Workspace& ws = get_workspace();
+    auto rstack_buf = ws.reserve<csint>(0),  // recursion and pause stacks
+         pstack_buf = ws.reserve<csint>(0);
+    std::vector<csint>& rstack = *rstack_buf;
+    std::vector<csint>& pstack = *pstack_buf;
 
     rstack.push_back(j);       // initialize the recursion stack
 
@@ -533,7 +623,7 @@ std::vector<csint>& dfs(
 
     while (!rstack.empty()) {
         j = rstack.back();  // get j from the top of the recursion stack
-        csint jnew = j;  // j maps to col jnew of G (NOTE ignore p_inv for now)
+        csint jnew = p_inv.empty() ? j : p_inv[j];  // j maps to col jnew of G
 
         if (!marked[j]) {
             marked[j] = true;  // mark node j as visited
@@ -565,6 +655,216 @@ std::vector<csint>& dfs(
 }
 
 
+void SpsolveWorkspace::resize(csint N)
+{
+    if (static_cast<csint>(mark.size()) < N) {
+        mark.resize(N, stamp);  // stamp is not yet the current generation
+        x.resize(N, 0.0);
+        xi.reserve(N);
+        rstack.reserve(N);
+        pstack.reserve(N);
+    }
+}
+
+
+std::vector<csint>& spsolve(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    csint k,
+    SpsolveWorkspace& ws,
+    bool lo,
+    const std::vector<csint>& p_inv
+)
+{
+    // Populate ws.xi with the non-zero indices of x
+    reach(A, B, k, ws, p_inv);
+
+    std::vector<double>& x = ws.x;
+
+    // clear x in the pattern, then scatter B(:, k) into x
+    for (const auto& j : ws.xi) {
+        x[j] = 0;
+    }
+
+    for (csint p = B.p_[k]; p < B.p_[k+1]; p++) {
+        x[B.i_[p]] = B.v_[p];
+    }
+
+    // Solve Lx = b_k or Ux = b_k
+    for (const auto& j : ws.xi) {
+        csint J = p_inv.empty() ? j : p_inv[j];
+        if (J < 0) {
+            continue;
+        }
+        x[j] /= A.v_[lo ? A.p_[J] : A.p_[J+1] - 1];
+        csint p = lo ? A.p_[J] + 1 : A.p_[J];
+        csint q = lo ? A.p_[J+1]   : A.p_[J+1] - 1;
+        for (; p < q; p++) {
+            x[A.i_[p]] -= A.v_[p] * x[j];
+        }
+    }
+
+    return ws.xi;
+}
+
+
+CSCMatrix spsolve_block(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    bool lo,
+    const std::vector<csint>& p_inv,
+    int threads
+)
+{
+    PhaseTimer timer("spsolve_block");
+
+    assert(A.M_ == B.M_);
+
+    csint M = A.M_,
+          K = B.N_;
+
+    // Each entry of B reaches at least the entries of its column of A
+    csint work = B.p_[K] * (1 + A.nnz() / std::max<csint>(A.N_, 1));
+    int nthreads = static_cast<int>(
+        std::min<csint>(resolve_num_threads(threads, work), std::max<csint>(K, 1))
+    );
+    std::vector<csint> bounds = partition_nnz(B.p_, nthreads);
+
+    // Each thread solves a contiguous block of columns into its own buffers
+    std::vector<std::vector<csint>> Xi(nthreads);
+    std::vector<std::vector<double>> Xv(nthreads);
+    std::vector<csint> count(K, 0);
+    std::vector<double> flops(nthreads, 0.0);
+
+    parallel_for(nthreads, [&](int t) {
+        SpsolveWorkspace ws;
+        ws.resize(M);
+
+        for (csint k = bounds[t]; k < bounds[t+1]; k++) {
+            std::vector<csint>& xi = spsolve(A, B, k, ws, lo, p_inv);
+
+            for (const auto& j : xi) {
+                csint J = p_inv.empty() ? j : p_inv[j];
+                if (J >= 0) {
+                    flops[t] += 2.0 * (A.p_[J+1] - A.p_[J]) - 1;
+                }
+            }
+
+            std::sort(xi.begin(), xi.end());
+
+            for (const auto& i : xi) {
+                Xi[t].push_back(i);
+                Xv[t].push_back(ws.x[i]);
+            }
+
+            count[k] = static_cast<csint>(xi.size());
+        }
+    });
+
+    // Gather the blocks of columns into the result
+    std::vector<csint> Xp = cumsum(count);
+    csint nnz = Xp[K];
+
+    std::vector<csint> indices(nnz);
+    std::vector<double> data(nnz);
+
+    parallel_for(nthreads, [&](int t) {
+        std::copy(Xi[t].begin(), Xi[t].end(), indices.begin() + Xp[bounds[t]]);
+        std::copy(Xv[t].begin(), Xv[t].end(), data.begin() + Xp[bounds[t]]);
+    });
+
+    CSCMatrix X(std::move(data), std::move(indices), std::move(Xp), {M, K});
+    X.has_sorted_indices_ = true;
+    X.has_canonical_format_ = true;
+
+    if (Stats *stats = get_stats()) {
+        for (const auto& f : flops) {
+            stats->flops += f;
+        }
+        // The per-thread buffers, and the marks, stacks, and values of each workspace
+        record_memory(
+            2 * memory_bytes(X)
+            + nthreads * M * (4 * sizeof(csint) + sizeof(double))
+        );
+    }
+
+    return X;
+}
+
+
+std::vector<csint>& reach(
+    const CSCMatrix& A,
+    const CSCMatrix& B,
+    csint k,
+    SpsolveWorkspace& ws,
+    const std::vector<csint>& p_inv
+)
+{
+    ws.resize(A.M_);
+    ws.stamp++;  // a new generation, so all nodes are unmarked
+    ws.xi.clear();
+
+    for (csint p = B.p_[k]; p < B.p_[k+1]; p++) {
+        csint j = B.i_[p];
+        if (ws.mark[j] != ws.stamp) {
+            dfs(A, j, ws, p_inv);
+        }
+    }
+
+    // xi is returned from dfs in reverse order, since it is a stack
+    std::reverse(ws.xi.begin(), ws.xi.end());
+
+    return ws.xi;
+}
+
+
+std::vector<csint>& dfs(
+    const CSCMatrix& A,
+    csint j,
+    SpsolveWorkspace& ws,
+    const std::vector<csint>& p_inv
+)
+{
+    std::vector<csint>& rstack = ws.rstack;
+    std::vector<csint>& pstack = ws.pstack;
+    rstack.clear();
+    pstack.clear();
+
+    rstack.push_back(j);
+
+    while (!rstack.empty()) {
+        j = rstack.back();
+        csint jnew = p_inv.empty() ? j : p_inv[j];
+
+        if (ws.mark[j] != ws.stamp) {
+            ws.mark[j] = ws.stamp;
+            pstack.push_back((jnew < 0) ? 0 : A.p_[jnew]);
+        }
+
+        bool done = true;
+        csint q = (jnew < 0) ? 0 : A.p_[jnew+1];
+
+        for (csint p = pstack.back(); p < q; p++) {
+            csint i = A.i_[p];
+            if (ws.mark[i] != ws.stamp) {
+                pstack.back() = p;
+                rstack.push_back(i);
+                done = false;
+                break;
+            }
+        }
+
+        if (done) {
+            pstack.pop_back();
+            rstack.pop_back();
+            ws.xi.push_back(j);
+        }
+    }
+
+    return ws.xi;
+}
+
+
 // Exercise 4.3
 SparseSolution chol_lsolve(
     const CSCMatrix& L,
@@ -646,6 +946,64 @@ SparseSolution chol_ltsolve(
 }
 
 
+std::vector<double> lsolve_super(const SupernodalChol& L, const std::vector<double>& b)
+{
+    assert(L.super.back() == static_cast<csint>(b.size()));
+
+    std::vector<double> x = b;
+    const csint ns = L.super.size() - 1;
+
+    for (csint s = 0; s < ns; s++) {
+        const csint f = L.super[s],
+                    ncols = L.super[s+1] - f,
+                    nrows = L.rp[s+1] - L.rp[s];
+        const csint *rows = L.ri.data() + L.rp[s];
+        const double *X = L.x.data() + L.xp[s];
+
+        for (csint k = 0; k < ncols; k++) {
+            const double *Xk = X + k * nrows;
+            double& x_val = x[f + k];
+            x_val /= Xk[k];
+            if (x_val != 0) {
+                for (csint r = k + 1; r < nrows; r++) {
+                    x[rows[r]] -= Xk[r] * x_val;
+                }
+            }
+        }
+    }
+
+    return x;
+}
+
+
+std::vector<double> ltsolve_super(const SupernodalChol& L, const std::vector<double>& b)
+{
+    assert(L.super.back() == static_cast<csint>(b.size()));
+
+    std::vector<double> x = b;
+    const csint ns = L.super.size() - 1;
+
+    for (csint s = ns - 1; s >= 0; s--) {
+        const csint f = L.super[s],
+                    ncols = L.super[s+1] - f,
+                    nrows = L.rp[s+1] - L.rp[s];
+        const csint *rows = L.ri.data() + L.rp[s];
+        const double *X = L.x.data() + L.xp[s];
+
+        for (csint k = ncols - 1; k >= 0; k--) {
+            const double *Xk = X + k * nrows;
+            double x_val = x[f + k];
+            for (csint r = k + 1; r < nrows; r++) {
+                x_val -= Xk[r] * x[rows[r]];
+            }
+            x[f + k] = x_val / Xk[k];
+        }
+    }
+
+    return x;
+}
+
+
 std::vector<csint> topological_order(
     const CSCMatrix& b,
     const std::vector<csint>& parent,
@@ -689,6 +1047,377 @@ std::vector<csint> topological_order(
 }
 
 
+/*------------------------------------------------------------------------------
+ *      Multiple Right-Hand Sides
+ *----------------------------------------------------------------------------*/
+static_assert(RHS_TILE % simd::width == 0);
+
+
+// y -= a * x, for one row of a tile
+static inline void tile_axpy(double a, const double *x, double *y)
+{
+    const simd::vec va = simd::set1(-a);
+    for (csint c = 0; c < RHS_TILE; c += simd::width) {
+        simd::store(y + c, simd::fmadd(va, simd::load(x + c), simd::load(y + c)));
+    }
+}
+
+
+// y /= a, for one row of a tile
+static inline void tile_div(double a, double *y)
+{
+    for (csint c = 0; c < RHS_TILE; c++) {
+        y[c] /= a;
+    }
+}
+
+
+// Solve L W = W, where W is a row-major tile (see lsolve)
+static void tile_lsolve(const CSCMatrix& L, double *W)
+{
+    const auto& Lp = L.indptr();
+    const auto& Li = L.indices();
+    const auto& Lx = L.data();
+
+    for (csint j = 0; j < static_cast<csint>(Lp.size()) - 1; j++) {
+        double *wj = W + j * RHS_TILE;
+        tile_div(Lx[Lp[j]], wj);
+        for (csint p = Lp[j] + 1; p < Lp[j+1]; p++) {
+            tile_axpy(Lx[p], wj, W + Li[p] * RHS_TILE);
+        }
+    }
+}
+
+
+// Solve L^T W = W, where W is a row-major tile (see ltsolve)
+static void tile_ltsolve(const CSCMatrix& L, double *W)
+{
+    const auto& Lp = L.indptr();
+    const auto& Li = L.indices();
+    const auto& Lx = L.data();
+
+    for (csint j = static_cast<csint>(Lp.size()) - 2; j >= 0; j--) {
+        double *wj = W + j * RHS_TILE;
+        for (csint p = Lp[j] + 1; p < Lp[j+1]; p++) {
+            tile_axpy(Lx[p], W + Li[p] * RHS_TILE, wj);
+        }
+        tile_div(Lx[Lp[j]], wj);
+    }
+}
+
+
+// Solve U W = W, where W is a row-major tile (see usolve)
+static void tile_usolve(const CSCMatrix& U, double *W)
+{
+    const auto& Up = U.indptr();
+    const auto& Ui = U.indices();
+    const auto& Ux = U.data();
+
+    for (csint j = static_cast<csint>(Up.size()) - 2; j >= 0; j--) {
+        double *wj = W + j * RHS_TILE;
+        tile_div(Ux[Up[j+1] - 1], wj);  // diagonal entry
+        for (csint p = Up[j]; p < Up[j+1] - 1; p++) {
+            tile_axpy(Ux[p], wj, W + Ui[p] * RHS_TILE);
+        }
+    }
+}
+
+
+// Solve U^T W = W, where W is a row-major tile (see utsolve)
+static void tile_utsolve(const CSCMatrix& U, double *W)
+{
+    const auto& Up = U.indptr();
+    const auto& Ui = U.indices();
+    const auto& Ux = U.data();
+
+    for (csint j = 0; j < static_cast<csint>(Up.size()) - 1; j++) {
+        double *wj = W + j * RHS_TILE;
+        for (csint p = Up[j]; p < Up[j+1] - 1; p++) {
+            tile_axpy(Ux[p], W + Ui[p] * RHS_TILE, wj);
+        }
+        tile_div(Ux[Up[j+1] - 1], wj);  // diagonal entry
+    }
+}
+
+
+/** Apply a solve to each tile of `RHS_TILE` columns of `B`.
+ *
+ * Row `i` of each tile of `B` is copied into row `p_inv[i]` of a row-major
+ * workspace `W` of size `N x RHS_TILE`, and copied back out of the same row
+ * after the solve. A partial last tile is padded with zeros.
+ *
+ * @param B  a dense `N x K` matrix in column-major order
+ * @param N  the number of rows of `B`
+ * @param p_inv  the row permutation, or empty for the identity
+ * @param solve  the solve to apply to the workspace, `solve(W)`
+ *
+ * @return X  the dense `N x K` solution, in column-major order
+ */
+template <typename F>
+static std::vector<double> solve_tiles(
+    const std::vector<double>& B,
+    csint N,
+    const std::vector<csint>& p_inv,
+    F solve
+)
+{
+    assert(N == 0 ? B.empty() : B.size() % N == 0);
+
+    csint K = (N == 0) ? 0 : B.size() / N;
+
+    std::vector<double> X(B.size());
+    std::vector<double> W(N * RHS_TILE);
+
+    auto row = [&](csint i) { return p_inv.empty() ? i : p_inv[i]; };
+
+    for (csint k = 0; k < K; k += RHS_TILE) {
+        csint nb = std::min(RHS_TILE, K - k);
+
+        if (nb < RHS_TILE) {
+            std::fill(W.begin(), W.end(), 0.0);
+        }
+
+        for (csint c = 0; c < nb; c++) {
+            const double *b = B.data() + (k + c) * N;
+            for (csint i = 0; i < N; i++) {
+                W[row(i) * RHS_TILE + c] = b[i];
+            }
+        }
+
+        solve(W.data());
+
+        for (csint c = 0; c < nb; c++) {
+            double *x = X.data() + (k + c) * N;
+            for (csint i = 0; i < N; i++) {
+                x[i] = W[row(i) * RHS_TILE + c];
+            }
+        }
+    }
+
+    return X;
+}
+
+
+std::vector<double> lsolve_block(const CSCMatrix& L, const std::vector<double>& B)
+{
+    auto [M, N] = L.shape();
+    assert(M == N);
+    return solve_tiles(B, N, {}, [&](double *W) { tile_lsolve(L, W); });
+}
+
+
+std::vector<double> ltsolve_block(const CSCMatrix& L, const std::vector<double>& B)
+{
+    auto [M, N] = L.shape();
+    assert(M == N);
+    return solve_tiles(B, N, {}, [&](double *W) { tile_ltsolve(L, W); });
+}
+
+
+std::vector<double> usolve_block(const CSCMatrix& U, const std::vector<double>& B)
+{
+    auto [M, N] = U.shape();
+    assert(M == N);
+    return solve_tiles(B, N, {}, [&](double *W) { tile_usolve(U, W); });
+}
+
+
+std::vector<double> utsolve_block(const CSCMatrix& U, const std::vector<double>& B)
+{
+    auto [M, N] = U.shape();
+    assert(M == N);
+    return solve_tiles(B, N, {}, [&](double *W) { tile_utsolve(U, W); });
+}
+
+
+std::vector<double> chol_solve_block(
+    const CSCMatrix& L,
+    const SymbolicChol& S,
+    const std::vector<double>& B
+)
+{
+    auto [M, N] = L.shape();
+    assert(M == N);
+    return solve_tiles(B, N, S.p_inv, [&](double *W) {
+        tile_lsolve(L, W);   // W = L \ P B
+        tile_ltsolve(L, W);  // W = L^T \ W
+    });
+}
+
+
+/*------------------------------------------------------------------------------
+ *      Level-Scheduled Triangular Solves
+ *----------------------------------------------------------------------------*/
+// Minimum non-zeros per thread to split a level, since the threads must
+// synchronize after every level that is split.
+static constexpr csint MIN_LEVEL_NNZ_PER_THREAD = 256;
+
+
+LevelSchedule level_schedule(const CSCMatrix& A, bool lower, bool trans)
+{
+    assert(A.M_ == A.N_);
+    csint N = A.N_;
+
+    LevelSchedule S;
+    S.G = trans ? A : A.transpose();  // column j of G is row j of the system
+    S.forward = (lower != trans);     // x[j] depends on x[i] for i < j
+
+    const CSCMatrix& G = S.G;
+
+    // Compute the level of each unknown from the levels it depends upon
+    std::vector<csint> level(N);
+    csint nlevels = 0;
+
+    for (csint k = 0; k < N; k++) {
+        csint j = S.forward ? k : N - 1 - k;
+        csint lvl = 0;
+        bool has_diag = false;
+
+        for (csint p = G.p_[j]; p < G.p_[j+1]; p++) {
+            csint i = G.i_[p];
+            if (i == j) {
+                has_diag = true;
+            } else if ((i < j) == S.forward) {
+                lvl = std::max(lvl, level[i] + 1);
+            } else if (lower) {
+                throw std::runtime_error("Matrix is not lower triangular!");
+            } else {
+                throw std::runtime_error("Matrix is not upper triangular!");
+            }
+        }
+
+        if (!has_diag) {
+            throw std::runtime_error("Matrix is missing a diagonal entry!");
+        }
+
+        level[j] = lvl;
+        nlevels = std::max(nlevels, lvl + 1);
+    }
+
+    // Sort the unknowns by level
+    std::vector<csint> w(nlevels);
+    for (const auto& lvl : level) {
+        w[lvl]++;
+    }
+
+    S.level_ptr = cumsum(w);
+    std::copy(S.level_ptr.begin(), S.level_ptr.end() - 1, w.begin());
+    S.nodes.resize(N);
+
+    for (csint k = 0; k < N; k++) {
+        csint j = S.forward ? k : N - 1 - k;
+        S.nodes[w[level[j]]++] = j;
+    }
+
+    // Count the work to balance each level among the threads
+    S.work_ptr.resize(N + 1);
+    S.work_ptr[0] = 0;
+    for (csint k = 0; k < N; k++) {
+        csint j = S.nodes[k];
+        S.work_ptr[k+1] = S.work_ptr[k] + G.p_[j+1] - G.p_[j];
+    }
+
+    return S;
+}
+
+
+std::vector<double> level_solve(
+    const LevelSchedule& S,
+    const std::vector<double>& b,
+    int threads
+)
+{
+    const CSCMatrix& G = S.G;
+    assert(G.M_ == static_cast<csint>(b.size()));
+
+    std::vector<double> x = b;
+
+    // Compute x[j] from the unknowns that it depends upon, which are final
+    auto solve_node = [&](csint j) {
+        double d = 0.0;
+        double xj = x[j];
+        for (csint p = G.p_[j]; p < G.p_[j+1]; p++) {
+            csint i = G.i_[p];
+            if (i == j) {
+                d = G.v_[p];
+            } else {
+                xj -= G.v_[p] * x[i];
+            }
+        }
+        x[j] = xj / d;
+    };
+
+    int nthreads = resolve_num_threads(threads, G.nnz());
+
+    if (nthreads == 1) {
+        for (const auto& j : S.nodes) {
+            solve_node(j);
+        }
+        return x;
+    }
+
+    csint nlevels = S.nlevels();
+
+    auto is_wide = [&](csint k) {
+        csint start = S.level_ptr[k],
+              end = S.level_ptr[k+1];
+        return (end - start >= nthreads)
+            && (S.work_ptr[end] - S.work_ptr[start]
+                >= nthreads * MIN_LEVEL_NNZ_PER_THREAD);
+    };
+
+    std::barrier sync(nthreads);
+
+    parallel_for(nthreads, [&](int t) {
+        csint k = 0;
+        while (k < nlevels) {
+            if (is_wide(k)) {
+                // Split the level among the threads by number of non-zeros
+                const csint* work = S.work_ptr.data();
+                csint start = S.level_ptr[k],
+                      end = S.level_ptr[k+1],
+                      work_lo = work[start],
+                      work_hi = work[end];
+
+                auto bound = [&](int s) {
+                    if (s == nthreads) {
+                        return end;
+                    }
+                    csint target = work_lo + (work_hi - work_lo) * s / nthreads;
+                    return static_cast<csint>(
+                        std::lower_bound(work + start, work + end, target) - work
+                    );
+                };
+
+                for (csint n = bound(t); n < bound(t + 1); n++) {
+                    solve_node(S.nodes[n]);
+                }
+
+                k++;
+            } else {
+                // Solve the run of narrow levels on a single thread
+                csint end = k + 1;
+                while (end < nlevels && !is_wide(end)) {
+                    end++;
+                }
+
+                if (t == 0) {
+                    for (csint n = S.level_ptr[k]; n < S.level_ptr[end]; n++) {
+                        solve_node(S.nodes[n]);
+                    }
+                }
+
+                k = end;
+            }
+
+            sync.arrive_and_wait();
+        }
+    });
+
+    return x;
+}
+
+
 }  // namespace cs
 
 /*==============================================================================
@@ -0,0 +1,53 @@
+/*==============================================================================
+ *     File: stats.cpp
+ *  Created: 2025-03-21 10:02
+ *   Author: Bernie Roesler
+ *
+ *  Description: Implements the optional performance counters.
+ *
+ *============================================================================*/
+
+#include <algorithm>  // std::max
+
+#include "csc.h"
+#include "stats.h"
+
+namespace cs {
+
+thread_local Stats *detail::current_stats = nullptr;
+
+
+void Stats::reset()
+{
+    *this = Stats();
+}
+
+
+Stats* set_stats(Stats *stats)
+{
+    Stats *prev = detail::current_stats;
+    detail::current_stats = stats;
+    return prev;
+}
+
+
+void record_memory(std::size_t bytes)
+{
+    if (Stats *stats = get_stats()) {
+        stats->peak_bytes = std::max(stats->peak_bytes, bytes);
+    }
+}
+
+
+std::size_t memory_bytes(const CSCMatrix& A)
+{
+    return memory_bytes(A.data())
+         + memory_bytes(A.indices())
+         + memory_bytes(A.indptr());
+}
+
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/
@@ -13,6 +13,9 @@
 #include <catch2/matchers/catch_matchers_all.hpp>
 
 #include <algorithm>  // reverse
+#include <atomic>
+#include <barrier>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
 #include <map>
@@ -20,6 +23,7 @@
 #include <random>
 #include <string>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 #include "csparse.h"
@@ -201,6 +205,17 @@ auto compare_matrices(
 // }
 
 
+/** Check that a vector is a permutation of 0..N-1. */
+bool is_permutation(const std::vector<csint>& p, csint N)
+{
+    std::vector<csint> sorted_p = p;
+    std::sort(sorted_p.begin(), sorted_p.end());
+    std::vector<csint> expect(N);
+    std::iota(expect.begin(), expect.end(), 0);
+    return sorted_p == expect;
+}
+
+
 /** Return a boolean vector comparing each individual element.
  *
  * @param vec   a vector of doubles
@@ -294,6 +309,18 @@ TEST_CASE("Test cumsum", "[vector]")
     std::vector<csint> expect = {0, 1, 2, 3, 4};
     REQUIRE(c == expect);
     REQUIRE(&a != &c);
+
+    SECTION("Parallel cumsum") {
+        std::vector<csint> w(3 * MIN_NNZ_PER_THREAD + 17);
+        std::iota(w.begin(), w.end(), -100);
+
+        std::vector<csint> expect = cumsum(w, 1);
+
+        for (int threads : {2, 3, 4}) {
+            CAPTURE(threads);
+            CHECK(cumsum(w, threads) == expect);
+        }
+    }
 }
 
 
@@ -523,6 +550,23 @@ TEST_CASE("Test CSCMatrix", "[CSCMatrix]")
         REQUIRE(C.data() == data_expect);
     }
 
+    SECTION("Construct by moving arrays") {
+        std::vector<double> data = C.data();
+        std::vector<csint> indices = C.indices();
+        std::vector<csint> indptr = C.indptr();
+        const double *data_ptr = data.data();
+        const csint *indices_ptr = indices.data();
+
+        CSCMatrix D(std::move(data), std::move(indices), std::move(indptr), C.shape());
+
+        // The storage is adopted, not copied
+        CHECK(D.data().data() == data_ptr);
+        CHECK(D.indices().data() == indices_ptr);
+        CHECK(D.indptr() == C.indptr());
+        CHECK(D.indices() == C.indices());
+        REQUIRE(D.data() == C.data());
+    }
+
     SECTION ("Test CSCMatrix printing") {
         std::stringstream s;
 
@@ -821,6 +865,52 @@ TEST_CASE("Test canonical format", "[CSCMatrix][COOMatrix]")
             }
         }
     }
+
+    SECTION("Test fused pipeline matches separate passes") {
+        CSCMatrix B = A.compress().to_canonical();
+        REQUIRE(C.indptr() == B.indptr());
+        REQUIRE(C.indices() == B.indices());
+        REQUIRE(C.data() == B.data());
+    }
+
+    SECTION("Test parallel compression") {
+        // Large matrix with many duplicates and explicit zeros
+        csint M = 600, N = 300;
+        COOMatrix R = COOMatrix::random(M, N, 0.2, 565656);
+        COOMatrix D = COOMatrix::random(M, N, 0.2, 787878);
+
+        std::vector<csint> rows = R.row(), cols = R.column();
+        std::vector<double> vals = R.data();
+        rows.insert(rows.end(), D.row().begin(), D.row().end());
+        cols.insert(cols.end(), D.column().begin(), D.column().end());
+        vals.insert(vals.end(), D.data().begin(), D.data().end());
+        for (csint k = 0; k < 100; k++) {
+            vals[k * 7] = 0.0;
+        }
+
+        COOMatrix A(vals, rows, cols, {M, N});
+        REQUIRE(A.nnz() >= 4 * MIN_NNZ_PER_THREAD);
+
+        CSCMatrix serial = A.compress(1);
+        CSCMatrix expect = A.compress(1).to_canonical();
+
+        for (int threads : {2, 4}) {
+            CAPTURE(threads);
+
+            // Column order of entries is independent of the threads
+            CSCMatrix Cp = A.compress(threads);
+            CHECK(Cp.indptr() == serial.indptr());
+            CHECK(Cp.indices() == serial.indices());
+            CHECK(Cp.data() == serial.data());
+
+            // The fused pipeline is bitwise identical to the separate passes
+            CSCMatrix Ct = A.tocsc(threads);
+            CHECK(Ct.has_canonical_format());
+            CHECK(Ct.indptr() == expect.indptr());
+            CHECK(Ct.indices() == expect.indices());
+            CHECK(Ct.data() == expect.data());
+        }
+    }
 }
 
 
@@ -1050,6 +1140,231 @@ TEST_CASE("Matrix-(dense) matrix multiply + addition.")
 }
 
 
+TEST_CASE("Multithreaded matrix-vector multiply", "[math][parallel]")
+{
+    csint M = 900,
+          N = 1000;
+    CSCMatrix A = COOMatrix::random(M, N, 0.1, 56).tocsc();
+    CSCMatrix S = (A.slice(0, M, 0, M) + A.slice(0, M, 0, M).T()).band(0, M);
+
+    std::vector<double> x(N), y(M), xs(M);
+    std::iota(x.begin(), x.end(), 1);
+    std::iota(y.begin(), y.end(), -10);
+    std::iota(xs.begin(), xs.end(), 2);
+
+    std::vector<double> expect_Axpy = A.gaxpy(x, y, 1);
+    std::vector<double> expect_ATxpy = A.T().gaxpy(y, x, 1);
+    std::vector<double> expect_Sxpy = S.sym_gaxpy(xs, y, 1);
+
+    SECTION("Partition columns by non-zeros") {
+        int nparts = 4;
+        std::vector<csint> bounds = partition_nnz(A.indptr(), nparts);
+        REQUIRE(static_cast<int>(bounds.size()) == nparts + 1);
+        CHECK(bounds.front() == 0);
+        CHECK(bounds.back() == N);
+        CHECK(std::is_sorted(bounds.begin(), bounds.end()));
+
+        // Each part has about nnz / nparts non-zeros (within one column)
+        csint max_col = 0;
+        for (csint j = 0; j < N; j++) {
+            max_col = std::max(max_col, A.indptr()[j+1] - A.indptr()[j]);
+        }
+        for (int t = 0; t < nparts; t++) {
+            csint part_nnz = A.indptr()[bounds[t+1]] - A.indptr()[bounds[t]];
+            CHECK(std::abs(part_nnz - A.nnz() / nparts) <= max_col);
+        }
+    }
+
+    SECTION("Explicit thread count") {
+        int threads = GENERATE(2, 3, 8);
+        CAPTURE(threads);
+
+        CHECK_THAT(is_close(A.gaxpy(x, y, threads), expect_Axpy, 1e-10), AllTrue());
+        CHECK_THAT(is_close(A.gatxpy(y, x, threads), expect_ATxpy, 1e-10), AllTrue());
+        CHECK_THAT(is_close(S.sym_gaxpy(xs, y, threads), expect_Sxpy, 1e-10), AllTrue());
+    }
+
+    SECTION("Default thread count") {
+        REQUIRE(get_num_threads() == 1);
+        set_num_threads(4);
+        CHECK(get_num_threads() == 4);
+        CHECK(resolve_num_threads(0, A.nnz()) == 4);
+        CHECK(resolve_num_threads(0, 10) == 1);  // too little work
+
+        CHECK_THAT(is_close(A.gaxpy(x, y), expect_Axpy, 1e-10), AllTrue());
+        CHECK_THAT(is_close(A.gatxpy(y, x), expect_ATxpy, 1e-10), AllTrue());
+        CHECK_THAT(is_close(S.sym_gaxpy(xs, y), expect_Sxpy, 1e-10), AllTrue());
+
+        set_num_threads(1);
+    }
+
+    SECTION("Persistent worker threads") {
+        int nthreads = 4;
+        std::vector<std::thread::id> first(nthreads), second(nthreads);
+
+        parallel_for(nthreads, [&](int t) { first[t] = std::this_thread::get_id(); });
+        parallel_for(nthreads, [&](int t) { second[t] = std::this_thread::get_id(); });
+
+        // The caller runs f(0), and the workers are reused by the next call
+        CHECK(first[0] == std::this_thread::get_id());
+        CHECK(second[0] == first[0]);
+        for (int t = 1; t < nthreads; t++) {
+            CHECK(std::count(first.begin(), first.end(), first[t]) == 1);
+            CHECK(std::find(first.begin(), first.end(), second[t]) != first.end());
+        }
+    }
+
+    SECTION("Nested and synchronized workers") {
+        int nthreads = 3;
+        std::vector<int> count(nthreads * nthreads, 0);
+
+        // Every index runs concurrently, so the threads can wait on a barrier
+        parallel_for(nthreads, [&](int t) {
+            std::barrier sync(nthreads);
+            parallel_for(nthreads, [&](int s) {
+                sync.arrive_and_wait();
+                count[t * nthreads + s]++;
+            });
+        });
+
+        CHECK(count == std::vector<int>(nthreads * nthreads, 1));
+    }
+
+    SECTION("Exception in a worker") {
+        std::atomic<int> done = 0;
+        CHECK_THROWS_AS(
+            parallel_for(4, [&](int t) {
+                if (t == 2) {
+                    throw std::runtime_error("worker failed");
+                }
+                done++;
+            }),
+            std::runtime_error
+        );
+        CHECK(done == 3);  // the other threads finish before the rethrow
+    }
+}
+
+
+TEST_CASE("SIMD matrix multiply with multiple right-hand sides", "[math][simd]")
+{
+    csint M = 90,
+          N = 100;
+    CSCMatrix A = COOMatrix::random(M, N, 0.2, 56).tocsc();
+
+    // Cover full tiles, partial tiles, and the scalar remainder
+    csint K = GENERATE(1, 3, 8, 13, 32, 64, 67);
+    CAPTURE(K, simd::width, simd::isa);
+
+    std::vector<double> X(N * K), Y(M * K), XT(M * K), YT(N * K);
+    std::iota(X.begin(), X.end(), -100);
+    std::iota(Y.begin(), Y.end(), 1);
+    std::iota(XT.begin(), XT.end(), 7);
+    std::iota(YT.begin(), YT.end(), -3);
+
+    CHECK_THAT(is_close(A.gaxpy_simd(X, Y), A.gaxpy_row(X, Y), 1e-10), AllTrue());
+    CHECK_THAT(is_close(A.gatxpy_simd(XT, YT), A.gatxpy_row(XT, YT), 1e-10), AllTrue());
+}
+
+
+TEST_CASE("Compact index and value types", "[math][compact]")
+{
+    csint M = 300,
+          N = 200;
+    const CSCMatrix A = COOMatrix::random(M, N, 0.3, 56).tocsc();
+
+    std::vector<double> x(N), y(M);
+    std::iota(x.begin(), x.end(), 1);
+    std::iota(y.begin(), y.end(), -10);
+
+    SECTION("32-bit indices") {
+        const CSCMatrix32 C(A);
+
+        CHECK(C.shape() == A.shape());
+        CHECK(C.nnz() == A.nnz());
+        CHECK(sizeof(C.indices()[0]) == 4);
+        CHECK(C.indptr() == A.indptr());
+
+        const CSCMatrix B = C.tocsc();
+        CHECK(B.indptr() == A.indptr());
+        CHECK(B.indices() == A.indices());
+        CHECK(B.data() == A.data());
+
+        // Same operations in the same order give identical results
+        CHECK(C.gaxpy(x, y) == A.gaxpy(x, y));
+        CHECK(C.gatxpy(y, x) == A.gatxpy(y, x));
+
+        int threads = GENERATE(1, 3);
+        CHECK_THAT(is_close(C.gaxpy(x, y, threads), A.gaxpy(x, y), 1e-10), AllTrue());
+        CHECK(C.gatxpy(y, x, threads) == A.gatxpy(y, x));
+    }
+
+    SECTION("Single precision") {
+        const CSCMatrix32F C(A);
+
+        std::vector<float> xf(x.begin(), x.end()),
+                           yf(y.begin(), y.end());
+
+        std::vector<float> zf = C.gaxpy(xf, yf);
+        std::vector<double> z = A.gaxpy(x, y);
+        for (csint i = 0; i < M; i++) {
+            CHECK_THAT(zf[i], WithinAbs(z[i], 1e-5 * (1.0 + std::abs(z[i]))));
+        }
+    }
+
+    SECTION("Complex values") {
+        const CSCMatrix32Z C(A);
+
+        // A (x + i y[:N]) = A x + i A y[:N]
+        std::vector<double> xi(y.begin(), y.begin() + N);
+        std::vector<std::complex<double>> xz(N), zero(M);
+        for (csint j = 0; j < N; j++) {
+            xz[j] = {x[j], xi[j]};
+        }
+
+        std::vector<std::complex<double>> z = C.gaxpy(xz, zero);
+        std::vector<double> re = A.gaxpy(x, std::vector<double>(M)),
+                            im = A.gaxpy(xi, std::vector<double>(M));
+
+        for (csint i = 0; i < M; i++) {
+            CHECK(z[i].real() == re[i]);
+            CHECK(z[i].imag() == im[i]);
+        }
+    }
+
+    SECTION("Triangular solves") {
+        const CSCMatrix L = COOMatrix(
+            std::vector<double> {1, 2, 3, 4, 5, 6},
+            std::vector<csint>  {0, 1, 1, 2, 2, 2},
+            std::vector<csint>  {0, 0, 1, 0, 1, 2}
+        ).tocsc();
+        const CSCMatrix U = L.T();
+
+        const std::vector<double> b = {1, 5, 15};
+        const CSCMatrix32 L32(L), U32(U);
+
+        CHECK(lsolve(L32, b) == lsolve(L, b));
+        CHECK(ltsolve(L32, b) == ltsolve(L, b));
+        CHECK(usolve(U32, b) == usolve(U, b));
+        CHECK(utsolve(U32, b) == utsolve(U, b));
+
+        // 64-bit indices with complex values
+        const CompactCSC<std::int64_t, std::complex<double>> Lz(L);
+        std::vector<std::complex<double>> bz = {{1, 2}, {5, 10}, {15, 30}};
+        std::vector<std::complex<double>> xz = lsolve(Lz, bz);
+        for (csint i = 0; i < 3; i++) {
+            CHECK(std::abs(xz[i] - std::complex<double>(1, 2)) < tol);
+        }
+    }
+
+    SECTION("Index overflow") {
+        const CSCMatrix B(Shape {csint(1) << 32, 2});
+        CHECK_THROWS(CSCMatrix32(B));
+        CHECK_NOTHROW(CompactCSC<std::int64_t, double>(B));
+    }
+}
+
+
 TEST_CASE("Matrix-matrix multiply.", "[math]")
 {
     SECTION("Test square matrices") {
@@ -1143,6 +1458,56 @@ TEST_CASE("Matrix-matrix multiply.", "[math]")
             }
         }
     }
+
+    SECTION("Test parallel two-phase multiply") {
+        CSCMatrix A = COOMatrix::random(400, 300, 0.1, 565656).tocsc();
+        CSCMatrix B = COOMatrix::random(300, 500, 0.1, 787878).tocsc();
+
+        // Serial dense accumulator is the reference
+        CSCMatrix expect = A.dot_2x(B, 1, SpGEMMAccumulator::Dense);
+
+        // Exact allocation
+        CHECK(expect.nzmax() == expect.nnz());
+        CHECK(expect.nnz() == expect.indptr().back());
+
+        // Same result as dense multiplication
+        CSCMatrix C_canon = CSCMatrix(expect).to_canonical();
+        std::vector<double> Ad = A.to_dense_vector('C');
+        std::vector<double> Bd = B.to_dense_vector('C');
+        std::vector<double> Cd = C_canon.to_dense_vector('C');
+        for (csint i = 0; i < 400; i += 37) {
+            for (csint j = 0; j < 500; j += 41) {
+                double c = 0.0;
+                for (csint k = 0; k < 300; k++) {
+                    c += Ad[i * 300 + k] * Bd[k * 500 + j];
+                }
+                CHECK_THAT(Cd[i * 500 + j], WithinAbs(c, 1e-12));
+            }
+        }
+
+        // Identical entries for any accumulator and number of threads
+        for (auto acc : {SpGEMMAccumulator::Dense, SpGEMMAccumulator::Hash,
+                         SpGEMMAccumulator::Auto}) {
+            for (int threads : {1, 2, 4}) {
+                CAPTURE(acc, threads);
+                CSCMatrix C = A.dot_2x(B, threads, acc);
+                CHECK(C.indptr() == expect.indptr());
+                CHECK(C.indices() == expect.indices());
+                CHECK(C.data() == expect.data());
+            }
+        }
+
+        // Short, wide product that uses the hash accumulator
+        CSCMatrix Bs = COOMatrix::random(300, 2000, 0.002, 121212).tocsc();
+        CSCMatrix Cs = A.dot_2x(Bs, 1, SpGEMMAccumulator::Dense);
+        CSCMatrix Ch = A.dot_2x(Bs, 2, SpGEMMAccumulator::Hash);
+        CHECK(Ch.indices() == Cs.indices());
+        CHECK(Ch.data() == Cs.data());
+
+        // The operator uses the same kernel
+        CSCMatrix C_op = A * B;
+        CHECK(C_op.data() == expect.data());
+    }
 }
 
 
@@ -1956,6 +2321,204 @@ TEST_CASE("Test triangular solve with dense RHS")
 }
 
 
+TEST_CASE("Level-scheduled triangular solve", "[solve][parallel]")
+{
+    SECTION("Small matrix") {
+        const CSCMatrix L = COOMatrix(
+            std::vector<double> {1, 2, 3, 4, 5, 6},
+            std::vector<csint>  {0, 1, 1, 2, 2, 2},
+            std::vector<csint>  {0, 0, 1, 0, 1, 2}
+        ).tocsc();
+
+        const CSCMatrix U = L.T();
+
+        const std::vector<double> expect = {1, 1, 1};
+        const std::vector<double> b_fwd = {1, 5, 15};  // row sums of L
+        const std::vector<double> b_bwd = {7, 8, 6};   // col sums of L
+
+        // Each unknown depends on the one before it
+        LevelSchedule S = level_schedule(L);
+        CHECK(S.nlevels() == 3);
+        CHECK(S.forward);
+        CHECK(S.nodes == std::vector<csint> {0, 1, 2});
+
+        CHECK_THAT(is_close(level_solve(S, b_fwd), expect, tol), AllTrue());
+        CHECK_THAT(
+            is_close(level_solve(level_schedule(L, true, true), b_bwd), expect, tol),
+            AllTrue()
+        );
+        CHECK_THAT(
+            is_close(level_solve(level_schedule(U, false), b_bwd), expect, tol),
+            AllTrue()
+        );
+        CHECK_THAT(
+            is_close(level_solve(level_schedule(U, false, true), b_fwd), expect, tol),
+            AllTrue()
+        );
+    }
+
+    SECTION("Independent unknowns share a level") {
+        // L = I + e_3 e_0^T, so x[3] depends on x[0] only
+        const CSCMatrix L = COOMatrix(
+            std::vector<double> {2, 1, 2, 2, 2},
+            std::vector<csint>  {0, 3, 1, 2, 3},
+            std::vector<csint>  {0, 0, 1, 2, 3}
+        ).tocsc();
+
+        LevelSchedule S = level_schedule(L);
+        CHECK(S.nlevels() == 2);
+        CHECK(S.level_ptr == std::vector<csint> {0, 3, 4});
+        CHECK(S.nodes == std::vector<csint> {0, 1, 2, 3});
+
+        // Backward solve with L^T: x[0] depends on x[3]
+        LevelSchedule St = level_schedule(L, true, true);
+        CHECK_FALSE(St.forward);
+        CHECK(St.nlevels() == 2);
+        CHECK(St.level_ptr == std::vector<csint> {0, 3, 4});
+        CHECK(St.nodes == std::vector<csint> {3, 2, 1, 0});
+    }
+
+    SECTION("Invalid matrices") {
+        const CSCMatrix A = COOMatrix(
+            std::vector<double> {1, 2, 3},
+            std::vector<csint>  {0, 1, 0},
+            std::vector<csint>  {0, 1, 1}
+        ).tocsc();
+
+        CHECK_NOTHROW(level_schedule(A, false));
+        CHECK_THROWS(level_schedule(A, true));   // not lower triangular
+
+        // Missing the diagonal entry A(0, 0)
+        const CSCMatrix B = COOMatrix(
+            std::vector<double> {1, 2},
+            std::vector<csint>  {1, 1},
+            std::vector<csint>  {0, 1},
+            Shape {2, 2}
+        ).tocsc();
+
+        CHECK_THROWS(level_schedule(B));
+    }
+
+    SECTION("Large random matrix") {
+        csint N = 4000;
+
+        std::vector<double> d(N, 10.0);
+        std::vector<csint> idx(N);
+        std::iota(idx.begin(), idx.end(), 0);
+
+        // Sort so that the diagonal is the first entry for lsolve
+        const CSCMatrix L = (
+            COOMatrix::random(N, N, 0.0025, 565656).tocsc().band(-N, -1)
+            + COOMatrix(d, idx, idx).tocsc()
+        ).sort();
+        const CSCMatrix U = L.T();
+
+        std::vector<double> b(N);
+        std::iota(b.begin(), b.end(), 1);
+
+        bool lower = GENERATE(true, false);
+        bool trans = GENERATE(true, false);
+        CAPTURE(lower, trans);
+
+        std::vector<double> expect;
+        if (lower) {
+            expect = trans ? ltsolve(L, b) : lsolve(L, b);
+        } else {
+            expect = trans ? utsolve(U, b) : usolve(U, b);
+        }
+
+        LevelSchedule S = level_schedule(lower ? L : U, lower, trans);
+        REQUIRE(is_permutation(S.nodes, N));
+        CHECK(S.nlevels() > 1);
+        CHECK(S.nlevels() < N);
+
+        const std::vector<double> x = level_solve(S, b, 1);
+        CHECK_THAT(is_close(x, expect, 1e-10), AllTrue());
+
+        // Results are identical for any number of threads
+        int threads = GENERATE(2, 3, 4);
+        CAPTURE(threads);
+        CHECK(level_solve(S, b, threads) == x);
+    }
+}
+
+
+TEST_CASE("Triangular solve with multiple right-hand sides", "[solve]")
+{
+    SECTION("Small matrix") {
+        const CSCMatrix L = COOMatrix(
+            std::vector<double> {1, 2, 3, 4, 5, 6},
+            std::vector<csint>  {0, 1, 1, 2, 2, 2},
+            std::vector<csint>  {0, 0, 1, 0, 1, 2}
+        ).tocsc();
+
+        const CSCMatrix U = L.T();
+
+        // Columns of ones, twos, and threes, in column-major order
+        const std::vector<double> expect = {1, 1, 1, 2, 2, 2, 3, 3, 3};
+        const std::vector<double> B_fwd = {1, 5, 15, 2, 10, 30, 3, 15, 45};
+        const std::vector<double> B_bwd = {7, 8, 6, 14, 16, 12, 21, 24, 18};
+
+        CHECK_THAT(is_close(lsolve_block(L, B_fwd), expect, tol), AllTrue());
+        CHECK_THAT(is_close(ltsolve_block(L, B_bwd), expect, tol), AllTrue());
+        CHECK_THAT(is_close(usolve_block(U, B_bwd), expect, tol), AllTrue());
+        CHECK_THAT(is_close(utsolve_block(U, B_fwd), expect, tol), AllTrue());
+    }
+
+    csint N = 500;
+    csint K = 2 * RHS_TILE + 5;  // includes a partial tile
+
+    std::vector<double> d(N, 10.0);
+    std::vector<csint> idx(N);
+    std::iota(idx.begin(), idx.end(), 0);
+
+    const CSCMatrix L = (
+        COOMatrix::random(N, N, 0.01, 565656).tocsc().band(-N, -1)
+        + COOMatrix(d, idx, idx).tocsc()
+    ).sort();
+    const CSCMatrix U = L.T();
+
+    std::vector<double> B(N * K);
+    std::iota(B.begin(), B.end(), 1);
+
+    // Solve each column separately
+    using Solver = std::vector<double> (*)(const CSCMatrix&, const std::vector<double>&);
+    auto solve_cols = [&](Solver solve, const CSCMatrix& A) {
+        std::vector<double> X;
+        for (csint k = 0; k < K; k++) {
+            std::vector<double> b(B.begin() + k * N, B.begin() + (k + 1) * N);
+            std::vector<double> x = solve(A, b);
+            X.insert(X.end(), x.begin(), x.end());
+        }
+        return X;
+    };
+
+    SECTION("Large random matrix") {
+        CHECK_THAT(is_close(lsolve_block(L, B), solve_cols(lsolve, L), 1e-10), AllTrue());
+        CHECK_THAT(is_close(ltsolve_block(L, B), solve_cols(ltsolve, L), 1e-10), AllTrue());
+        CHECK_THAT(is_close(usolve_block(U, B), solve_cols(usolve, U), 1e-10), AllTrue());
+        CHECK_THAT(is_close(utsolve_block(U, B), solve_cols(utsolve, U), 1e-10), AllTrue());
+    }
+
+    SECTION("Cholesky solve") {
+        const CSCMatrix A = L * U;  // symmetric positive definite
+
+        AMDOrder order = GENERATE(AMDOrder::Natural, AMDOrder::APlusAT);
+        CAPTURE(order);
+
+        SymbolicChol S = schol(A, order);
+        CSCMatrix Lc = chol(A, S);
+
+        std::vector<double> X = chol_solve_block(Lc, S, B);
+        REQUIRE(X.size() == B.size());
+
+        // A X == B
+        std::vector<double> AX = A.gaxpy_col(X, std::vector<double>(N * K, 0.0));
+        CHECK_THAT(is_close(AX, B, 1e-8), AllTrue());
+    }
+}
+
+
 TEST_CASE("Reachability and DFS")
 {
     csint N = 14;  // size of L
@@ -2458,6 +3021,47 @@ TEST_CASE("Cholesky decomposition")
         compare_matrices(LLT, expect_A);
     }
 
+    SECTION("Supernodal Cholesky") {
+        bool use_postorder = GENERATE(false, true);
+        AMDOrder order = GENERATE(AMDOrder::Natural, AMDOrder::APlusAT);
+        CAPTURE(use_postorder, order);
+
+        SymbolicChol S = schol(A, order, use_postorder);
+
+        // Supernodes partition the columns
+        std::vector<csint> super = find_supernodes(S.parent, S.cp);
+        CHECK(super.front() == 0);
+        CHECK(super.back() == N);
+        CHECK(std::is_sorted(super.begin(), super.end()));
+
+        // Symbolic structure matches the column counts
+        SupernodalChol Ls = symbolic_super(A, S);
+        CSCMatrix L_sym = symbolic_cholesky(A, S);
+        CSCMatrix Ls_csc = super_to_csc(Ls);
+        CHECK(Ls_csc.indptr() == L_sym.indptr());
+        CHECK(Ls_csc.indices() == L_sym.indices());
+
+        // Numeric factorization matches the up-looking factorization
+        SupernodalChol Lsuper = chol_super(A, S);
+        CSCMatrix L = chol(A, S);
+        compare_matrices(super_to_csc(Lsuper), L, true, 1e-13);
+
+        // Refactor in place
+        rechol_super(A, S, Ls);
+        compare_matrices(super_to_csc(Ls), L, true, 1e-13);
+
+        // Solve A x = b with the supernodal factor
+        std::vector<double> expect(N);
+        std::iota(expect.begin(), expect.end(), 1);
+        std::vector<double> b = A * expect;
+
+        std::vector<double> y = lsolve_super(Lsuper, pvec(inv_permute(S.p_inv), b));
+        CHECK_THAT(is_close(y, lsolve(L, pvec(inv_permute(S.p_inv), b)), 1e-13), AllTrue());
+
+        std::vector<double> x = ipvec(inv_permute(S.p_inv), ltsolve_super(Lsuper, y));
+        CHECK_THAT(is_close(x, expect, 1e-12), AllTrue());
+    }
+
     SECTION("Exercise 4.1: etree and counts from ereach") {
         std::vector<csint> expect_parent = etree(A);
         std::vector<csint> expect_rowcounts = chol_rowcounts(A);
@@ -2587,6 +3191,93 @@ TEST_CASE("Cholesky decomposition")
 
         REQUIRE((LLT - A).fronorm() / A.fronorm() < drop_tol);
     }
+
+    SECTION("Cached pattern of the symmetric permutation") {
+        SymbolicChol S = schol(A, AMDOrder::APlusAT);
+
+        // The analyzed pattern uses the cached map
+        {
+            SymPermView V(A, S);
+            CHECK(&V.C == &S.C);
+            CHECK(&V.map == &S.C_map);
+        }
+
+        // Move A(5, 0) to A(1, 0), which keeps the number of entries
+        std::vector<csint> rows2 = rows;
+        rows2[0] = 1;
+        CSCMatrix T2 = COOMatrix(vals, rows2, cols).tocsc();
+        CSCMatrix A2 = T2 + T2.T().band(1, N);
+        REQUIRE(A2.nnz() == A.nnz());
+
+        SymPermView V2(A2, S);
+        CHECK(&V2.C != &S.C);
+
+        std::vector<csint> expect_map;
+        CSCMatrix expect_C = A2.symperm_map(S.p_inv, expect_map);
+        CHECK(V2.C.indptr() == expect_C.indptr());
+        CHECK(V2.C.indices() == expect_C.indices());
+        CHECK(V2.map == expect_map);
+
+        // The factor of A2 is computed from its own pattern
+        SymbolicChol S2 = schol(A2, AMDOrder::APlusAT);
+        S2.C = S.C;
+        S2.C_map = S.C_map;  // a stale cache of the pattern of A
+        CSCMatrix L2 = chol(A2, S2);
+        CSCMatrix LLT = (L2 * L2.T()).droptol().to_canonical();
+        compare_matrices(LLT, A2.permute(S2.p_inv, inv_permute(S2.p_inv)).to_canonical());
+    }
+}
+
+
+TEST_CASE("Tree-scheduled parallel Cholesky", "[cholesky][parallel]")
+{
+    // 2D Laplacian on an n x n grid
+    csint n = 60,
+          N = n * n;
+
+    COOMatrix T({N, N});
+    for (csint i = 0; i < n; i++) {
+        for (csint j = 0; j < n; j++) {
+            csint k = i * n + j;
+            T.assign(k, k, 4.0);
+            if (i > 0) { T.assign(k, k - n, -1.0); }
+            if (i < n - 1) { T.assign(k, k + n, -1.0); }
+            if (j > 0) { T.assign(k, k - 1, -1.0); }
+            if (j < n - 1) { T.assign(k, k + 1, -1.0); }
+        }
+    }
+
+    const CSCMatrix A = T.tocsc();
+
+    AMDOrder order = GENERATE(AMDOrder::Natural, AMDOrder::APlusAT);
+    CAPTURE(order);
+
+    SymbolicChol S = schol(A, order);
+    const CSCMatrix expect = chol(A, S, 0.0, 1);
+
+    SECTION("Same factor for any number of threads") {
+        int threads = GENERATE(2, 3, 8);
+        CAPTURE(threads);
+
+        const CSCMatrix L = chol(A, S, 0.0, threads);
+
+        CHECK(L.indptr() == expect.indptr());
+        CHECK(L.indices() == expect.indices());
+        CHECK(L.data() == expect.data());
+    }
+
+    SECTION("Default thread count") {
+        set_num_threads(4);
+        const CSCMatrix L = chol(A, S);
+        set_num_threads(1);
+
+        CHECK(L.indices() == expect.indices());
+        CHECK(L.data() == expect.data());
+    }
+
+    SECTION("Not positive definite") {
+        CHECK_THROWS(chol(-1.0 * A, S, 0.0, 4));
+    }
 }
 
 
@@ -2706,6 +3397,29 @@ TEST_CASE("Householder Reflection")
 
         REQUIRE_THAT(is_close(Hx, expect, tol), AllTrue());
     }
+
+    SECTION("In-place application with sparse v") {
+        // Embed x = [3, 4] in rows 1 and 3 of a longer vector
+        std::vector<double> x = {7, 3, 8, 4, 9};
+        std::vector<double> expect = {7, -5, 8, 0, 9};
+
+        Householder H = house(std::vector<double> {3, 4});
+
+        // Column 1 of V holds the Householder vector, column 0 is a decoy
+        CSCMatrix V = COOMatrix(
+            {1, H.v[0], H.v[1]},
+            {0, 1, 3},
+            {0, 1, 1}
+        ).tocsc();
+
+        std::vector<double> Hx = happly(V, 1, H.beta, x);
+        REQUIRE_THAT(is_close(Hx, expect, tol), AllTrue());
+
+        // The in-place version gives the same result and only touches the
+        // pattern of V(:, 1)
+        happly_inplace(V, 1, H.beta, x);
+        REQUIRE_THAT(is_close(x, expect, tol), AllTrue());
+    }
 }
 
 
@@ -3083,5 +3797,2109 @@ TEST_CASE("QR factorization of an underdetermined matrix M < N", "[under]")
 
 
 
+TEST_CASE("LU decomposition", "[lu]")
+{
+    // Check that P A Q = L U, with the expected triangular structure
+    auto check_lu = [](const CSCMatrix& A, const LUResult& res) {
+        auto [M, N] = A.shape();
+        const CSCMatrix& L = res.L;
+        const CSCMatrix& U = res.U;
+
+        CHECK(is_permutation(inv_permute(res.p_inv), M));
+        CHECK(is_permutation(res.q, N));
+
+        for (csint j = 0; j < N; j++) {
+            // L is unit lower triangular, with the diagonal first
+            REQUIRE(L.indices()[L.indptr()[j]] == j);
+            CHECK(L.data()[L.indptr()[j]] == 1.0);
+            for (csint p = L.indptr()[j]; p < L.indptr()[j+1]; p++) {
+                CHECK(L.indices()[p] >= j);
+            }
+            // U is upper triangular, with the diagonal last
+            REQUIRE(U.indices()[U.indptr()[j+1] - 1] == j);
+            for (csint p = U.indptr()[j]; p < U.indptr()[j+1]; p++) {
+                CHECK(U.indices()[p] <= j);
+            }
+        }
+
+        CSCMatrix LU = (L * U).droptol(1e-14).to_canonical();
+        CSCMatrix PAQ = A.permute(res.p_inv, res.q).droptol(1e-14).to_canonical();
+        compare_matrices(LU, PAQ, true, 1e-12);
+    };
+
+    CSCMatrix A = davis_example_qr();
+    auto [M, N] = A.shape();
+
+    std::vector<double> expect_x(N);
+    std::iota(expect_x.begin(), expect_x.end(), 1);
+    std::vector<double> b = A * expect_x;
+
+    SECTION("Natural ordering") {
+        SymbolicLU S = slu(A);
+        std::vector<csint> expect_q(N);
+        std::iota(expect_q.begin(), expect_q.end(), 0);
+        CHECK(S.q == expect_q);
+
+        LUResult res = lu(A, S);
+        check_lu(A, res);
+    }
+
+    SECTION("Fill-reducing orderings") {
+        for (const auto& order : {AMDOrder::APlusAT, AMDOrder::ATANoDenseRows,
+                                  AMDOrder::ATA}) {
+            CAPTURE(order);
+            SymbolicLU S = slu(A, order);
+            CHECK(S.q == amd(A, order));
+
+            LUResult res = lu(A, S);
+            check_lu(A, res);
+
+            std::vector<double> x = lusolve(A, b, order);
+            CHECK_THAT(is_close(x, expect_x, 1e-12), AllTrue());
+        }
+    }
+
+    SECTION("Partial pivoting") {
+        // The diagonal is zero, so rows must be exchanged
+        CSCMatrix P = COOMatrix(
+            std::vector<double> {1, 2, 3, 4},
+            std::vector<csint>  {1, 0, 2, 2},
+            std::vector<csint>  {0, 1, 1, 2}
+        ).tocsc();
+
+        for (double tol : {0.0, 0.1, 1.0}) {
+            CAPTURE(tol);
+            LUResult res = lu(P, slu(P), tol);
+            check_lu(P, res);
+            // Column 0 pivots on row 1, so column 1 takes the larger row 2
+            CHECK(res.p_inv == std::vector<csint> {2, 0, 1});
+        }
+
+        // Threshold pivoting prefers the diagonal
+        CSCMatrix D = COOMatrix(
+            std::vector<double> {1, 2, 2, 1},
+            std::vector<csint>  {0, 1, 0, 1},
+            std::vector<csint>  {0, 0, 1, 1}
+        ).tocsc();
+
+        CHECK(lu(D, slu(D), 1.0).p_inv == std::vector<csint> {1, 0});
+        CHECK(lu(D, slu(D), 0.1).p_inv == std::vector<csint> {0, 1});
+    }
+
+    SECTION("Reuse the symbolic analysis") {
+        SymbolicLU S = slu(A, AMDOrder::ATANoDenseRows);
+        LUResult res = lu(A, S);
+
+        CHECK_THAT(is_close(lusolve(res, b), expect_x, 1e-12), AllTrue());
+
+        // Same pattern, different values
+        CSCMatrix A2 = A.dot(2.0);
+        LUResult res2 = lu(A2, S);
+        std::vector<double> x2 = lusolve(res2, b);
+        CHECK_THAT(is_close(x2 * 2.0, expect_x, 1e-12), AllTrue());
+    }
+
+    SECTION("Larger random matrix") {
+        csint N = 200;
+        COOMatrix C = COOMatrix::random(N, N, 0.02, 565656);
+        for (csint i = 0; i < N; i++) {
+            C.assign(i, (i + 1) % N, 1.0);  // make it structurally non-singular
+        }
+        CSCMatrix R = C.tocsc();
+
+        // Small initial guess, so the factors must grow
+        SymbolicLU S = slu(R, AMDOrder::ATANoDenseRows);
+        S.lnz = S.unz = 1;
+
+        LUResult res = lu(R, S);
+        check_lu(R, res);
+
+        std::vector<double> x(N, 1.0);
+        std::vector<double> bR = R * x;
+        CHECK_THAT(is_close(lusolve(res, bR), x, 1e-10), AllTrue());
+    }
+
+    SECTION("Singular matrix") {
+        CSCMatrix Z = COOMatrix(
+            std::vector<double> {1, 2, 2, 4},
+            std::vector<csint>  {0, 1, 0, 1},
+            std::vector<csint>  {0, 0, 1, 1}
+        ).tocsc();
+
+        CHECK_THROWS_AS(lu(Z, slu(Z)), std::runtime_error);
+
+        // Structurally singular
+        CSCMatrix E = COOMatrix(
+            std::vector<double> {1, 1},
+            std::vector<csint>  {0, 1},
+            std::vector<csint>  {0, 0},
+            Shape {2, 2}
+        ).tocsc();
+
+        CHECK_THROWS_AS(lu(E, slu(E)), std::runtime_error);
+    }
+}
+
+
+TEST_CASE("Approximate Minimum Degree ordering", "[amd]")
+{
+    SECTION("Natural ordering") {
+        CSCMatrix A = davis_example_qr();
+        std::vector<csint> expect(A.shape()[1]);
+        std::iota(expect.begin(), expect.end(), 0);
+        REQUIRE(amd(A, AMDOrder::Natural) == expect);
+    }
+
+    SECTION("Arrow matrix") {
+        // Dense first row and column, with a diagonal. Natural ordering fills
+        // in the entire lower triangle, whereas the dense node should be
+        // ordered last, which results in no fill-in.
+        csint N = 20;
+        COOMatrix C({N, N});
+        for (csint i = 0; i < N; i++) {
+            C.assign(i, i, N);
+            if (i > 0) {
+                C.assign(i, 0, 1.0);
+                C.assign(0, i, 1.0);
+            }
+        }
+        CSCMatrix A = C.tocsc();
+
+        SymbolicChol S_nat = schol(A, AMDOrder::Natural);
+        SymbolicChol S_amd = schol(A, AMDOrder::APlusAT);
+
+        CHECK(S_nat.lnz == N * (N + 1) / 2);
+        CHECK(S_amd.lnz == 2 * N - 1);
+
+        std::vector<csint> p = amd(A, AMDOrder::APlusAT);
+        CHECK(is_permutation(p, N));
+        CHECK(p.back() == 0);  // dense node is last
+
+        // Check the numeric factorization
+        CSCMatrix L = chol(A, S_amd);
+        CSCMatrix LLT = (L * L.T()).droptol().to_canonical();
+        CSCMatrix expect_A = A.permute(S_amd.p_inv, inv_permute(S_amd.p_inv));
+        compare_matrices(LLT, expect_A, true, 1e-12);
+    }
+
+    SECTION("2D Laplacian") {
+        // 5-point stencil on a k x k grid
+        csint k = 10;
+        csint N = k * k;
+        COOMatrix C({N, N});
+        for (csint i = 0; i < k; i++) {
+            for (csint j = 0; j < k; j++) {
+                csint s = i * k + j;
+                C.assign(s, s, 4.0);
+                if (i > 0)     { C.assign(s, s - k, -1.0); }
+                if (i < k - 1) { C.assign(s, s + k, -1.0); }
+                if (j > 0)     { C.assign(s, s - 1, -1.0); }
+                if (j < k - 1) { C.assign(s, s + 1, -1.0); }
+            }
+        }
+        CSCMatrix A = C.tocsc();
+
+        SymbolicChol S_nat = schol(A, AMDOrder::Natural);
+        SymbolicChol S_amd = schol(A, AMDOrder::APlusAT);
+
+        CHECK(is_permutation(inv_permute(S_amd.p_inv), N));
+        CHECK(S_amd.lnz < S_nat.lnz);
+
+        CSCMatrix L = chol(A, S_amd);
+        CHECK(L.nnz() == S_amd.lnz);
+        CSCMatrix LLT = (L * L.T()).droptol().to_canonical();
+        CSCMatrix expect_A = A.permute(S_amd.p_inv, inv_permute(S_amd.p_inv));
+        compare_matrices(LLT, expect_A, true, 1e-12);
+
+        // Postordering does not change the fill-in
+        SymbolicChol S_post = schol(A, AMDOrder::APlusAT, true);
+        CHECK(S_post.lnz == S_amd.lnz);
+
+        // The supernodal factorization has non-trivial supernodes
+        std::vector<csint> super = find_supernodes(S_post.parent, S_post.cp);
+        CHECK(static_cast<csint>(super.size()) - 1 < N);
+        CSCMatrix Lsuper = super_to_csc(chol_super(A, S_post));
+        compare_matrices(Lsuper, chol(A, S_post), true, 1e-12);
+    }
+
+    SECTION("QR orderings") {
+        CSCMatrix A = davis_example_qr();
+        auto [M, N] = A.shape();
+
+        SymbolicQR S_nat = sqr(A, AMDOrder::Natural);
+
+        for (const auto& order : {AMDOrder::ATANoDenseRows, AMDOrder::ATA}) {
+            CAPTURE(order);
+            std::vector<csint> q = amd(A, order);
+            CHECK(is_permutation(q, N));
+
+            SymbolicQR S = sqr(A, order);
+            CHECK(S.q == q);
+            CHECK(S.rnz <= S_nat.rnz);
+
+            // R^T R = (AQ)^T (AQ)
+            QRResult res = qr(A, S);
+            CSCMatrix AQ = A.permute_cols(S.q);
+            CSCMatrix RTR = (res.R.T() * res.R).droptol(1e-12).to_canonical();
+            CSCMatrix ATA = (AQ.T() * AQ).droptol(1e-12).to_canonical();
+            compare_matrices(RTR, ATA, true, 1e-12);
+        }
+    }
+}
+
+
+TEST_CASE("Matrix Market and binary file I/O", "[io]")
+{
+    namespace fs = std::filesystem;
+    fs::path tmp_dir = fs::temp_directory_path();
+
+    CSCMatrix A = davis_example_qr();
+
+    SECTION("Matrix Market round trip") {
+        std::string filename = (tmp_dir / "csparse_test_io.mtx").string();
+
+        write_matrix_market(filename, A);
+
+        // Keep the explicit zero, which tocsc() would drop
+        CSCMatrix B = read_matrix_market(filename).compress();
+
+        CHECK(B.shape() == A.shape());
+        CHECK(B.nnz() == A.nnz());
+        compare_matrices(B, A);
+
+        fs::remove(filename);
+    }
+
+    SECTION("Matrix Market symmetric pattern") {
+        std::string filename = (tmp_dir / "csparse_test_sym.mtx").string();
+
+        std::ofstream fp(filename);
+        fp << "%%MatrixMarket matrix coordinate pattern symmetric\n"
+           << "% a comment line\n"
+           << "\n"
+           << "3 3 4\n"
+           << "1 1\n"
+           << "2 1\n"
+           << "3 2\n"
+           << "3 3\n";
+        fp.close();
+
+        CSCMatrix B = read_matrix_market(filename).tocsc();
+
+        std::vector<double> expect = {
+            1, 1, 0,
+            1, 0, 1,
+            0, 1, 1
+        };
+
+        CHECK(B.shape() == Shape {3, 3});
+        CHECK(B.nnz() == 6);
+        CHECK(B.is_symmetric());
+        CHECK(B.to_dense_vector('C') == expect);
+
+        fs::remove(filename);
+    }
+
+    SECTION("Matrix Market skew-symmetric") {
+        std::string filename = (tmp_dir / "csparse_test_skew.mtx").string();
+
+        std::ofstream fp(filename);
+        fp << "%%MatrixMarket matrix coordinate real skew-symmetric\n"
+           << "2 2 1\n"
+           << "2 1 3.5\n";
+        fp.close();
+
+        CSCMatrix B = read_matrix_market(filename).tocsc();
+
+        CHECK(B(1, 0) == 3.5);
+        CHECK(B(0, 1) == -3.5);
+
+        fs::remove(filename);
+    }
+
+    SECTION("Matrix Market in parallel") {
+        std::string filename = (tmp_dir / "csparse_test_par.mtx").string();
+
+        CSCMatrix R = COOMatrix::random(400, 400, 0.5, 565656).tocsc();
+        REQUIRE(R.nnz() >= 4 * MIN_NNZ_PER_THREAD);
+
+        write_matrix_market(filename, R, 4);
+
+        COOMatrix serial = read_matrix_market(filename, 1);
+        COOMatrix parallel = read_matrix_market(filename, 4);
+
+        // The entries are in file order, independent of the number of threads
+        CHECK(parallel.row() == serial.row());
+        CHECK(parallel.column() == serial.column());
+        CHECK(parallel.data() == serial.data());
+
+        // Values are written with enough digits to be read back exactly
+        CSCMatrix B = parallel.tocsc();
+        CHECK(B.indptr() == R.indptr());
+        CHECK(B.indices() == R.indices());
+        CHECK(B.data() == R.data());
+
+        fs::remove(filename);
+    }
+
+    SECTION("Matrix Market errors") {
+        std::string filename = (tmp_dir / "csparse_test_bad.mtx").string();
+
+        std::ofstream fp(filename);
+        fp << "%%MatrixMarket matrix coordinate real general\n"
+           << "2 2 2\n"
+           << "1 1 1.0\n"
+           << "3 1 1.0\n";  // out of bounds
+        fp.close();
+
+        CHECK_THROWS_AS(read_matrix_market(filename), std::runtime_error);
+
+        fp.open(filename);
+        fp << "%%MatrixMarket matrix array real general\n"
+           << "2 2\n";
+        fp.close();
+
+        CHECK_THROWS_AS(read_matrix_market(filename), std::runtime_error);
+
+        fp.open(filename);
+        fp << "%%MatrixMarket matrix coordinate real general\n"
+           << "2 2 3\n"
+           << "1 1 1.0\n";  // too few entries
+        fp.close();
+
+        CHECK_THROWS_AS(read_matrix_market(filename), std::runtime_error);
+
+        fs::remove(filename);
+
+        CHECK_THROWS_AS(read_matrix_market(filename), std::runtime_error);
+    }
+
+    SECTION("Binary round trip") {
+        std::string filename = (tmp_dir / "csparse_test_io.csc").string();
+
+        write_binary(filename, A);
+        CHECK(fs::file_size(filename) ==
+              sizeof(BinaryHeader) + (A.shape()[1] + 1 + 2 * A.nnz()) * 8);
+
+        CSCMatrix B = read_binary(filename);
+
+        CHECK(B.shape() == A.shape());
+        CHECK(B.indptr() == A.indptr());
+        CHECK(B.indices() == A.indices());
+        CHECK(B.data() == A.data());
+
+        fs::remove(filename);
+    }
+
+    SECTION("Binary errors") {
+        std::string filename = (tmp_dir / "csparse_test_bad.csc").string();
+
+        // A Matrix Market file is not a binary file
+        write_matrix_market(filename, A);
+        CHECK_THROWS_AS(read_binary(filename), std::runtime_error);
+
+        // Truncated file
+        write_binary(filename, A);
+        fs::resize_file(filename, fs::file_size(filename) - 8);
+        CHECK_THROWS_AS(read_binary(filename), std::runtime_error);
+
+        // Overwrite one index of a valid file
+        auto corrupt = [&](std::size_t offset, csint value) {
+            write_binary(filename, A);
+            std::fstream fp(filename, std::ios::in | std::ios::out | std::ios::binary);
+            fp.seekp(sizeof(BinaryHeader) + offset * sizeof(csint));
+            fp.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        };
+
+        auto [M, N] = A.shape();
+        csint nnz = A.nnz();
+
+        SECTION("Decreasing column pointers") {
+            corrupt(1, A.indptr()[2] + 1);  // indptr[1] > indptr[2]
+            CHECK_THROWS_AS(read_binary(filename), std::runtime_error);
+        }
+
+        SECTION("Row index out of range") {
+            corrupt(N + 1 + nnz / 2, M);
+            CHECK_THROWS_AS(read_binary(filename), std::runtime_error);
+        }
+
+        SECTION("Negative row index") {
+            corrupt(N + 1, -1);
+            CHECK_THROWS_AS(read_binary(filename), std::runtime_error);
+        }
+
+        fs::remove(filename);
+    }
+}
+
+
+
+TEST_CASE("Performance counters", "[stats]")
+{
+    // 2D Laplacian on an n x n grid
+    csint n = 10,
+          N = n * n;
+
+    COOMatrix T({N, N});
+    for (csint i = 0; i < n; i++) {
+        for (csint j = 0; j < n; j++) {
+            csint k = i * n + j;
+            T.assign(k, k, 4.0);
+            if (i > 0) { T.assign(k, k - n, -1.0); }
+            if (i < n - 1) { T.assign(k, k + n, -1.0); }
+            if (j > 0) { T.assign(k, k - 1, -1.0); }
+            if (j < n - 1) { T.assign(k, k + 1, -1.0); }
+        }
+    }
+
+    const CSCMatrix A = T.tocsc();
+
+    Stats stats;
+
+    SECTION("Disabled by default") {
+        REQUIRE(get_stats() == nullptr);
+        SymbolicChol S = schol(A, AMDOrder::APlusAT);
+        chol(A, S);
+        CHECK(stats.flops == 0);
+        CHECK(stats.times.empty());
+    }
+
+    SECTION("Scope installs and restores") {
+        {
+            StatsScope scope(stats);
+            CHECK(get_stats() == &stats);
+
+            Stats inner;
+            {
+                StatsScope inner_scope(inner);
+                CHECK(get_stats() == &inner);
+            }
+            CHECK(get_stats() == &stats);
+        }
+        CHECK(get_stats() == nullptr);
+    }
+
+    SECTION("Cholesky") {
+        SymbolicChol S;
+        CSCMatrix L;
+        {
+            StatsScope scope(stats);
+            S = schol(A, AMDOrder::APlusAT);
+            L = chol(A, S);
+        }
+
+        double expect_flops = 0;
+        for (csint k = 0; k < N; k++) {
+            double count = S.cp[k+1] - S.cp[k];
+            expect_flops += count * count;
+        }
+
+        CHECK(stats.flops == expect_flops);
+        CHECK(stats.calls["schol"] == 1);
+        CHECK(stats.calls["schol.amd"] == 1);
+        CHECK(stats.calls["chol"] == 1);
+        CHECK(stats.times["chol"] >= 0);
+        CHECK(stats.peak_bytes >= static_cast<std::size_t>(S.lnz) * 16);
+
+        // The parallel factorization counts the same flops
+        Stats parallel_stats;
+        {
+            StatsScope scope(parallel_stats);
+            chol(A, S, 0.0, 4);
+            leftchol(A, S, L);
+        }
+        CHECK(parallel_stats.flops == 2 * expect_flops);
+        CHECK(parallel_stats.calls["leftchol"] == 1);
+
+        stats.reset();
+        CHECK(stats.flops == 0);
+        CHECK(stats.peak_bytes == 0);
+        CHECK(stats.calls.empty());
+    }
+
+    SECTION("QR") {
+        StatsScope scope(stats);
+        SymbolicQR S = sqr(A, AMDOrder::ATA);
+        QRResult res = qr(A, S);
+
+        CHECK(stats.calls["sqr"] == 1);
+        CHECK(stats.calls["qr"] == 1);
+        CHECK(stats.flops > 0);
+
+        double qr_flops = stats.flops;
+        reqr(A, S, res);
+        CHECK(stats.flops == 2 * qr_flops);
+    }
+
+    SECTION("LU") {
+        StatsScope scope(stats);
+        LUResult res = lu(A, slu(A, AMDOrder::APlusAT));
+
+        CHECK(stats.calls["slu"] == 1);
+        CHECK(stats.calls["lu"] == 1);
+        CHECK(stats.calls.count("spsolve") == 0);  // the solves are part of lu
+        CHECK(stats.reallocs >= 2);                // L and U are trimmed
+
+        // Each off-diagonal U(i, k) is an axpy with L(:, i), and each L(:, k)
+        // is divided by its pivot
+        const auto& Lp = res.L.indptr();
+        const auto& Up = res.U.indptr();
+        const auto& Ui = res.U.indices();
+
+        double expect_flops = 0;
+        for (csint k = 0; k < N; k++) {
+            for (csint p = Up[k]; p < Up[k+1] - 1; p++) {
+                csint i = Ui[p];
+                expect_flops += 2.0 * (Lp[i+1] - Lp[i] - 1);
+            }
+            expect_flops += Lp[k+1] - Lp[k] - 1;
+        }
+
+        CHECK(stats.flops == expect_flops);
+        CHECK(stats.peak_bytes >= memory_bytes(res.L) + memory_bytes(res.U));
+    }
+}
+
+
+
+TEST_CASE("Batched factorizations", "[batch]")
+{
+    // 2D Laplacian on an n x n grid
+    csint n = 8,
+          N = n * n;
+
+    COOMatrix T({N, N});
+    for (csint i = 0; i < n; i++) {
+        for (csint j = 0; j < n; j++) {
+            csint k = i * n + j;
+            T.assign(k, k, 4.0);
+            if (i > 0) { T.assign(k, k - n, -1.0); }
+            if (i < n - 1) { T.assign(k, k + n, -1.0); }
+            if (j > 0) { T.assign(k, k - 1, -1.0); }
+            if (j < n - 1) { T.assign(k, k + 1, -1.0); }
+        }
+    }
+
+    const CSCMatrix A = T.tocsc();
+
+    // A batch of matrices with the pattern of A, and values that differ
+    csint batch = 2 * BATCH_LANES + 3;  // include a partial group
+
+    auto make_batch = [&](const CSCMatrix& P) {
+        std::vector<CSCMatrix> As;
+        for (csint b = 0; b < batch; b++) {
+            std::vector<double> v = P.data();
+            for (csint j = 0; j < P.shape()[1]; j++) {
+                for (csint p = P.indptr()[j]; p < P.indptr()[j+1]; p++) {
+                    csint i = P.indices()[p];
+                    v[p] *= (i == j) ? 1.0 + 0.5 * b : 1.0 + 0.01 * b * ((i + j) % 5);
+                }
+            }
+            As.emplace_back(v, P.indices(), P.indptr(), P.shape());
+        }
+        return As;
+    };
+
+    // The values of each matrix, in the given layout
+    auto pack = [&](const std::vector<std::vector<double>>& xs, BatchLayout layout) {
+        csint size = xs[0].size();
+        std::vector<double> packed(size * batch);
+        for (csint b = 0; b < batch; b++) {
+            for (csint p = 0; p < size; p++) {
+                csint idx = (layout == BatchLayout::Strided) ? b * size + p : p * batch + b;
+                packed[idx] = xs[b][p];
+            }
+        }
+        return packed;
+    };
+
+    auto unpack = [&](const std::vector<double>& packed, csint b, BatchLayout layout) {
+        csint size = packed.size() / batch;
+        std::vector<double> x(size);
+        for (csint p = 0; p < size; p++) {
+            csint idx = (layout == BatchLayout::Strided) ? b * size + p : p * batch + b;
+            x[p] = packed[idx];
+        }
+        return x;
+    };
+
+    BatchLayout layout = GENERATE(BatchLayout::Strided, BatchLayout::Interleaved);
+    int threads = GENERATE(1, 3);
+    CAPTURE(layout, threads);
+
+    SECTION("Cholesky") {
+        const std::vector<CSCMatrix> As = make_batch(A);
+        SymbolicChol S = schol(A, AMDOrder::APlusAT);
+
+        std::vector<std::vector<double>> vals, bs, xs;
+        for (const auto& Ab : As) {
+            std::vector<double> x(N);
+            std::iota(x.begin(), x.end(), 1);
+            vals.push_back(Ab.data());
+            bs.push_back(Ab * x);
+            xs.push_back(x);
+        }
+
+        CholBatch F = chol_batch(A, S, pack(vals, layout), layout, threads);
+        REQUIRE(F.batch == batch);
+
+        std::vector<double> X = chol_solve_batch(F, pack(bs, layout), threads);
+
+        for (csint b = 0; b < batch; b++) {
+            CAPTURE(b);
+            CSCMatrix expect = chol(As[b], S);
+            CSCMatrix L = F.factor(b);
+            REQUIRE(L.indptr() == expect.indptr());
+            REQUIRE(L.indices() == expect.indices());
+            CHECK_THAT(is_close(L.data(), expect.data(), 1e-10), AllTrue());
+
+            CHECK_THAT(is_close(unpack(X, b, layout), xs[b], 1e-10), AllTrue());
+        }
+    }
+
+    SECTION("QR") {
+        // Drop columns to make an overdetermined system
+        const CSCMatrix Ar = A.slice(0, N, 0, N - n);
+        const std::vector<CSCMatrix> As = make_batch(Ar);
+        SymbolicQR S = sqr(Ar, AMDOrder::ATA);
+
+        std::vector<std::vector<double>> vals, bs, xs;
+        for (const auto& Ab : As) {
+            std::vector<double> x(N - n);
+            std::iota(x.begin(), x.end(), 1);
+            vals.push_back(Ab.data());
+            bs.push_back(Ab * x);
+            xs.push_back(x);
+        }
+
+        QRBatch F = qr_batch(Ar, S, pack(vals, layout), layout, threads);
+        REQUIRE(F.batch == batch);
+
+        std::vector<double> X = qr_solve_batch(F, pack(bs, layout), threads);
+
+        for (csint b = 0; b < batch; b++) {
+            CAPTURE(b);
+            QRResult expect = qr(As[b], S);
+            QRResult res = F.factor(b);
+            REQUIRE(res.V.indptr() == expect.V.indptr());
+            REQUIRE(res.R.indices() == expect.R.indices());
+            CHECK_THAT(is_close(res.V.data(), expect.V.data(), 1e-10), AllTrue());
+            CHECK_THAT(is_close(res.R.data(), expect.R.data(), 1e-10), AllTrue());
+            CHECK_THAT(is_close(res.beta, expect.beta, 1e-10), AllTrue());
+
+            CHECK_THAT(is_close(unpack(X, b, layout), xs[b], 1e-10), AllTrue());
+        }
+    }
+
+    SECTION("Errors") {
+        SymbolicChol S = schol(A);
+
+        // Values are not a multiple of nnz
+        std::vector<double> values(A.nnz() * 2 + 1, 1.0);
+        CHECK_THROWS_AS(chol_batch(A, S, values, layout, threads), std::runtime_error);
+
+        // One matrix is not positive definite
+        std::vector<std::vector<double>> vals(batch, A.data());
+        for (auto& v : vals[batch - 1]) {
+            v = -v;
+        }
+        CHECK_THROWS_AS(chol_batch(A, S, pack(vals, layout), layout, threads),
+                        std::runtime_error);
+
+        // Underdetermined QR
+        const CSCMatrix At = A.slice(0, N - n, 0, N);
+        CHECK_THROWS_AS(qr_batch(At, sqr(At), std::vector<double>(At.nnz(), 1.0)),
+                        std::runtime_error);
+    }
+}
+
+
+
+TEST_CASE("Iterative solvers", "[iterative]")
+{
+    // 2D Laplacian on an n x n grid
+    csint n = 20,
+          N = n * n;
+
+    auto laplacian = [&](double shift, double convection) {
+        COOMatrix T({N, N});
+        for (csint i = 0; i < n; i++) {
+            for (csint j = 0; j < n; j++) {
+                csint k = i * n + j;
+                T.assign(k, k, 4.0 + shift);
+                if (i > 0) { T.assign(k, k - n, -1.0); }
+                if (i < n - 1) { T.assign(k, k + n, -1.0); }
+                if (j > 0) { T.assign(k, k - 1, -1.0 - convection); }
+                if (j < n - 1) { T.assign(k, k + 1, -1.0 + convection); }
+            }
+        }
+        return T.tocsc();
+    };
+
+    const CSCMatrix A = laplacian(0.0, 0.0);
+
+    std::vector<double> x_true(N);
+    for (csint k = 0; k < N; k++) {
+        x_true[k] = 1.0 + static_cast<double>(k % 7) / 7;
+    }
+
+    const std::vector<double> b = A * x_true;
+    double tol = 1e-10;
+
+    SECTION("Incomplete Cholesky, no fill-in") {
+        CSCMatrix L = ichol(A, ICholMethod::NoFill);
+
+        // Same pattern as the lower triangle of A
+        CSCMatrix Al = A.band(-N, 0);
+        REQUIRE(L.indptr() == Al.indptr());
+        REQUIRE(L.indices() == Al.indices());
+
+        // L L^T matches A on the pattern of A
+        const CSCMatrix LLT = (L * L.T()).to_canonical();
+        for (csint j = 0; j < N; j++) {
+            for (csint p = A.indptr()[j]; p < A.indptr()[j+1]; p++) {
+                csint i = A.indices()[p];
+                CHECK_THAT(LLT(i, j), WithinAbs(A(i, j), 1e-12));
+            }
+        }
+
+        // A tridiagonal matrix has no fill-in, so IC(0) is exact
+        const CSCMatrix At = A.band(-1, 1);
+        CSCMatrix Lt = ichol(At, ICholMethod::NoFill);
+        CSCMatrix Lc = chol(At, schol(At, AMDOrder::Natural));
+        CHECK_THAT(is_close(Lt.data(), Lc.data(), 1e-12), AllTrue());
+
+        // Not positive definite
+        CHECK_THROWS_AS(ichol(-1.0 * A, ICholMethod::NoFill), std::runtime_error);
+    }
+
+    SECTION("PCG") {
+        IterativeResult none = pcg(A, b, {}, tol);
+        IterativeResult jac = pcg(A, b, jacobi_preconditioner(A), tol);
+        IterativeResult ic0 = pcg(
+            A, b, ichol_preconditioner(ichol(A, ICholMethod::NoFill)), tol
+        );
+
+        for (const auto& res : {none, jac, ic0}) {
+            CHECK(res.converged);
+            CHECK(res.residual <= 1e-9);
+            CHECK(res.history.size() == static_cast<std::size_t>(res.iterations));
+            CHECK(res.history.back() <= tol);
+            CHECK_THAT(is_close(res.x, x_true, 1e-8), AllTrue());
+        }
+
+        CHECK(ic0.iterations < none.iterations);
+    }
+
+    SECTION("MINRES") {
+        IterativeResult res = minres(A, b, {}, tol);
+        CHECK(res.converged);
+        CHECK_THAT(is_close(res.x, x_true, 1e-8), AllTrue());
+
+        res = minres(A, b, jacobi_preconditioner(A), tol);
+        CHECK(res.converged);
+        CHECK_THAT(is_close(res.x, x_true, 1e-8), AllTrue());
+
+        // Symmetric indefinite
+        const CSCMatrix As = laplacian(-3.0, 0.0);
+        const std::vector<double> bs = As * x_true;
+        res = minres(As, bs, {}, tol, 4 * N);
+        CHECK(res.converged);
+        CHECK(res.residual <= 1e-8);
+        CHECK_THAT(is_close(res.x, x_true, 1e-6), AllTrue());
+    }
+
+    SECTION("GMRES") {
+        // Nonsymmetric
+        const CSCMatrix An = laplacian(0.0, 0.4);
+        const std::vector<double> bn = An * x_true;
+
+        IterativeResult res = gmres(An, bn, {}, tol, 10 * N, 30);
+        CHECK(res.converged);
+        CHECK(res.residual <= tol);
+        CHECK_THAT(is_close(res.x, x_true, 1e-8), AllTrue());
+
+        IterativeResult jac = gmres(An, bn, jacobi_preconditioner(An), tol, 10 * N, 30);
+        CHECK(jac.converged);
+        CHECK_THAT(is_close(jac.x, x_true, 1e-8), AllTrue());
+
+        // Without restarts, GMRES converges in at most N iterations
+        res = gmres(An, bn, {}, tol, N, N);
+        CHECK(res.converged);
+        CHECK(res.iterations <= N);
+    }
+
+    SECTION("Multithreaded products") {
+        // A grid large enough for 4 threads of MIN_NNZ_PER_THREAD
+        csint m = 130,
+              K = m * m;
+        COOMatrix T({K, K});
+        for (csint i = 0; i < m; i++) {
+            for (csint j = 0; j < m; j++) {
+                csint k = i * m + j;
+                T.assign(k, k, 6.0);  // well conditioned
+                if (i > 0) { T.assign(k, k - m, -1.0); }
+                if (i < m - 1) { T.assign(k, k + m, -1.0); }
+                if (j > 0) { T.assign(k, k - 1, -1.2); }
+                if (j < m - 1) { T.assign(k, k + 1, -0.8); }
+            }
+        }
+        const CSCMatrix An = T.tocsc();
+        const CSCMatrix As = (An + An.T()).to_canonical();
+        REQUIRE(resolve_num_threads(4, As.nnz()) == 4);
+
+        std::vector<double> xs(K);
+        for (csint k = 0; k < K; k++) {
+            xs[k] = 1.0 + static_cast<double>(k % 7) / 7;
+        }
+        const std::vector<double> bs = As * xs,
+                                  bn = An * xs;
+
+        for (int threads : {1, 2, 4}) {
+            IterativeResult res = pcg(As, bs, {}, tol, 0, {}, threads);
+            CHECK(res.converged);
+            CHECK_THAT(is_close(res.x, xs, 1e-8), AllTrue());
+
+            res = minres(As, bs, {}, tol, 0, {}, threads);
+            CHECK(res.converged);
+            CHECK_THAT(is_close(res.x, xs, 1e-8), AllTrue());
+
+            res = gmres(An, bn, {}, tol, 0, 30, {}, threads);
+            CHECK(res.converged);
+            CHECK_THAT(is_close(res.x, xs, 1e-8), AllTrue());
+        }
+    }
+
+    SECTION("Initial guess and iteration limit") {
+        // Starting at the solution takes no iterations
+        IterativeResult res = pcg(A, b, {}, tol, 0, x_true);
+        CHECK(res.converged);
+        CHECK(res.iterations == 0);
+
+        res = minres(A, b, {}, tol, 0, x_true);
+        CHECK(res.converged);
+        CHECK(res.iterations == 0);
+
+        res = gmres(A, b, {}, tol, 0, 30, x_true);
+        CHECK(res.converged);
+        CHECK(res.iterations == 0);
+
+        // Too few iterations
+        res = pcg(A, b, {}, tol, 3);
+        CHECK_FALSE(res.converged);
+        CHECK(res.iterations == 3);
+        CHECK(res.residual > tol);
+
+        // Zero RHS
+        res = pcg(A, std::vector<double>(N, 0.0));
+        CHECK(res.converged);
+        CHECK(res.x == std::vector<double>(N, 0.0));
+    }
+
+    SECTION("Errors") {
+        CHECK_THROWS_AS(pcg(A, std::vector<double>(N + 1, 1.0)), std::runtime_error);
+        CHECK_THROWS_AS(minres(A, b, {}, tol, 0, std::vector<double>(N - 1)),
+                        std::runtime_error);
+        CHECK_THROWS_AS(gmres(A.slice(0, N - 1, 0, N), b), std::runtime_error);
+        CHECK_THROWS_AS(pcg(-1.0 * A, b), std::runtime_error);
+    }
+}
+
+
+
+TEST_CASE("Assembly into a frozen pattern", "[assembly]")
+{
+    // Bilinear quadrilaterals on an n x n grid of elements, large enough for
+    // the threaded assembly
+    csint n = 40,
+          nn = n + 1,
+          N = nn * nn;
+
+    std::vector<csint> elem_ptr = {0}, elem_nodes;
+    for (csint i = 0; i < n; i++) {
+        for (csint j = 0; j < n; j++) {
+            csint k = i * nn + j;
+            elem_nodes.insert(elem_nodes.end(), {k, k + 1, k + nn + 1, k + nn});
+            elem_ptr.push_back(elem_nodes.size());
+        }
+    }
+
+    csint ne = n * n;
+
+    // Element stiffness matrix, scaled differently for each element
+    const std::vector<double> K0 = {
+         4, -1, -2, -1,
+        -1,  4, -1, -2,
+        -2, -1,  4, -1,
+        -1, -2, -1,  4
+    };
+
+    auto kernel = [&](csint e, std::span<double> Ke) {
+        for (std::size_t k = 0; k < Ke.size(); k++) {
+            Ke[k] += (1.0 + 0.1 * e) * K0[k] / 6;
+        }
+    };
+
+    // Expected matrix, from the COO format
+    COOMatrix T({N, N});
+    std::vector<double> values;
+    for (csint e = 0; e < ne; e++) {
+        std::vector<double> Ke(16, 0.0);
+        kernel(e, Ke);
+        for (csint b = 0; b < 4; b++) {
+            for (csint a = 0; a < 4; a++) {
+                csint i = elem_nodes[elem_ptr[e] + a],
+                      j = elem_nodes[elem_ptr[e] + b];
+                T.assign(i, j, Ke[a + b * 4]);
+                values.push_back(Ke[a + b * 4]);
+            }
+        }
+    }
+
+    const CSCMatrix expect = T.tocsc().to_canonical();
+
+    AssemblyPattern P = assembly_pattern(N, elem_ptr, elem_nodes);
+
+    REQUIRE(P.num_elements() == ne);
+    REQUIRE(P.A.has_canonical_format());
+    REQUIRE(P.A.indptr() == expect.indptr());
+    REQUIRE(P.A.indices() == expect.indices());
+    CHECK(P.A.data() == std::vector<double>(expect.nnz(), 0.0));
+    CHECK(P.slots.size() == values.size());
+
+    SECTION("Coloring") {
+        // 2 x 2 colors for a structured grid of quadrilaterals
+        CHECK(P.num_colors() == 4);
+        REQUIRE(P.color_ptr.back() == ne);
+        CHECK(is_permutation(P.color_elems, ne));
+
+        // No two elements of a color share a node
+        csint shared = 0;
+        for (csint c = 0; c < P.num_colors(); c++) {
+            std::vector<bool> used(N, false);
+            for (csint q = P.color_ptr[c]; q < P.color_ptr[c+1]; q++) {
+                csint e = P.color_elems[q];
+                for (csint r = elem_ptr[e]; r < elem_ptr[e+1]; r++) {
+                    shared += used[elem_nodes[r]];
+                    used[elem_nodes[r]] = true;
+                }
+            }
+        }
+        CHECK(shared == 0);
+    }
+
+    SECTION("Element by element") {
+        for (csint e = 0; e < ne; e++) {
+            std::vector<double> Ke(16, 0.0);
+            kernel(e, Ke);
+            P.add_element(e, Ke);
+        }
+        CHECK_THAT(is_close(P.A.data(), expect.data(), 1e-13), AllTrue());
+
+        // Zero and reassemble, keeping the pattern
+        P.zero();
+        CHECK(P.A.data() == std::vector<double>(expect.nnz(), 0.0));
+        CHECK(P.A.nnz() == expect.nnz());
+    }
+
+    SECTION("All contributions") {
+        for (int threads : {1, 4}) {
+            CAPTURE(threads);
+            P.zero();
+            P.add(values, threads);
+            CHECK_THAT(is_close(P.A.data(), expect.data(), 1e-13), AllTrue());
+        }
+    }
+
+    SECTION("Colored kernel") {
+        for (int threads : {1, 4}) {
+            CAPTURE(threads);
+            P.zero();
+            P.assemble(kernel, threads);
+            CHECK_THAT(is_close(P.A.data(), expect.data(), 1e-13), AllTrue());
+        }
+
+        // Exceptions from the kernel are rethrown
+        auto bad = [&](csint e, std::span<double> Ke) {
+            if (e == ne / 2) {
+                throw std::runtime_error("bad element");
+            }
+            kernel(e, Ke);
+        };
+        CHECK_THROWS_AS(P.assemble(bad, 4), std::runtime_error);
+    }
+
+    SECTION("From a COO matrix") {
+        AssemblyPattern Q = assembly_pattern(T);
+        CHECK(Q.num_elements() == 0);
+        REQUIRE(Q.A.indices() == expect.indices());
+        CHECK_THAT(is_close(Q.A.data(), expect.data(), 1e-13), AllTrue());
+
+        // Reassemble with new values
+        std::vector<double> twice = values;
+        for (auto& v : twice) {
+            v *= 2;
+        }
+        Q.zero();
+        Q.add(twice);
+        CHECK_THAT(is_close(Q.A.data(), (2.0 * expect).data(), 1e-13), AllTrue());
+
+        CHECK_THROWS_AS(Q.assemble(kernel), std::runtime_error);
+        CHECK_THROWS_AS(Q.add_element(0, K0), std::runtime_error);
+    }
+
+    SECTION("Errors") {
+        CHECK_THROWS_AS(P.add(std::vector<double>(3, 1.0)), std::runtime_error);
+        CHECK_THROWS_AS(P.add_element(0, std::vector<double>(9, 1.0)), std::runtime_error);
+        CHECK_THROWS_AS(P.add_element(ne, K0), std::runtime_error);
+
+        // Inconsistent offsets and nodes out of range
+        CHECK_THROWS_AS(assembly_pattern(N, {0, 4}, {0, 1, 2}), std::runtime_error);
+        CHECK_THROWS_AS(assembly_pattern(N, {0, 3, 2}, {0, 1, 2}), std::runtime_error);
+        CHECK_THROWS_AS(assembly_pattern(3, {0, 2}, {0, 3}), std::runtime_error);
+    }
+}
+
+
+
+TEST_CASE("Upper triangular symmetric storage", "[sym]")
+{
+    // 2D Laplacian on an n x n grid
+    csint n = 10,
+          N = n * n;
+
+    COOMatrix T({N, N});
+    for (csint i = 0; i < n; i++) {
+        for (csint j = 0; j < n; j++) {
+            csint k = i * n + j;
+            T.assign(k, k, 4.0 + 0.01 * k);
+            if (i > 0) { T.assign(k, k - n, -1.0); }
+            if (i < n - 1) { T.assign(k, k + n, -1.0); }
+            if (j > 0) { T.assign(k, k - 1, -1.0); }
+            if (j < n - 1) { T.assign(k, k + 1, -1.0); }
+        }
+    }
+
+    const CSCMatrix A = T.tocsc();
+    const CSCMatrix Au = A.band(0, N);  // only the upper triangle
+
+    AMDOrder order = GENERATE(AMDOrder::Natural, AMDOrder::APlusAT);
+    CAPTURE(order);
+
+    SymbolicChol S = schol(A, order);
+    SymbolicChol Su = schol(Au, order);
+
+    const CSCMatrix expect = chol(A, S);
+
+    SECTION("Symbolic analysis") {
+        CHECK(etree(Au) == etree(A));
+        CHECK(Su.p_inv == S.p_inv);
+        CHECK(Su.parent == S.parent);
+        CHECK(Su.cp == S.cp);
+
+        // The cached pattern only holds the upper triangle
+        CHECK(S.C.nnz() == Au.nnz());
+        CHECK(Su.C.indices() == S.C.indices());
+        CHECK(S.anz == A.nnz());
+        CHECK(Su.anz == Au.nnz());
+    }
+
+    SECTION("Numeric factorizations") {
+        CSCMatrix L = chol(Au, Su);
+        CHECK(L.indices() == expect.indices());
+        CHECK_THAT(is_close(L.data(), expect.data(), 1e-14), AllTrue());
+
+        L = chol(Au, Su, 0.0, 4);
+        CHECK_THAT(is_close(L.data(), expect.data(), 1e-14), AllTrue());
+
+        CSCMatrix Ll = symbolic_cholesky(Au, Su);
+        leftchol(Au, Su, Ll);
+        CHECK_THAT(is_close(Ll.data(), expect.data(), 1e-14), AllTrue());
+
+        CSCMatrix Lr = symbolic_cholesky(Au, Su);
+        rechol(Au, Su, Lr);
+        CHECK_THAT(is_close(Lr.data(), expect.data(), 1e-14), AllTrue());
+
+        SupernodalChol Ls = symbolic_super(Au, Su);
+        rechol_super(Au, Su, Ls);
+        CHECK_THAT(is_close(super_to_csc(Ls).data(), expect.data(), 1e-12), AllTrue());
+
+        CSCMatrix Li = ichol(Au, ICholMethod::NoFill);
+        CHECK_THAT(is_close(Li.data(), ichol(A, ICholMethod::NoFill).data(), 1e-14),
+                   AllTrue());
+    }
+
+    SECTION("Matrix-vector multiply") {
+        std::vector<double> x(N), y(N, 1.0);
+        std::iota(x.begin(), x.end(), 1);
+        CHECK_THAT(is_close(Au.sym_gaxpy(x, y), A.gaxpy(x, y), 1e-12), AllTrue());
+    }
+
+    SECTION("Without the cached map") {
+        // The analysis of another pattern computes the map locally
+        CSCMatrix L = chol(Au, S);
+        CHECK_THAT(is_close(L.data(), expect.data(), 1e-14), AllTrue());
+
+        SymbolicChol S2 = S;
+        S2.C = CSCMatrix();
+        S2.C_map.clear();
+        S2.anz = 0;
+
+        L = chol(A, S2);
+        CHECK(L.data() == expect.data());
+
+        CSCMatrix Ll = symbolic_cholesky(A, S2);
+        leftchol(A, S2, Ll);
+        CHECK_THAT(is_close(Ll.data(), expect.data(), 1e-14), AllTrue());
+    }
+}
+
+
+TEST_CASE("Linear combinations and in-place products", "[math]")
+{
+    csint M = 60,
+          N = 50;
+    CSCMatrix A = COOMatrix::random(M, N, 0.1, 11).tocsc(),
+              B = COOMatrix::random(M, N, 0.1, 12).tocsc(),
+              C = COOMatrix::random(M, N, 0.1, 13).tocsc();
+
+    SECTION("Lazy evaluation") {
+        CSCMatrix expect = add_scaled(add_scaled(A, B, 2.0, 1.0), C, 1.0, -0.5);
+
+        LinearCombination L = LinearCombination(A, 2.0) + B - LinearCombination(C, 0.5);
+        CHECK(L.num_terms() == 3);
+        CHECK(L.shape() == A.shape());
+
+        CSCMatrix E = L;
+        CHECK(E.nnz() <= A.nnz() + B.nnz() + C.nnz());
+        CHECK_THAT(is_close(E.to_dense_vector(), expect.to_dense_vector(), 1e-14), AllTrue());
+
+        // Scaling an expression scales every term
+        CSCMatrix F = -1.0 * (LinearCombination(A, 2.0) + (B - 0.5 * C));
+        CHECK_THAT(is_close(F.to_dense_vector(), (-1.0 * expect).to_dense_vector(), 1e-14),
+                   AllTrue());
+
+        // Cancelling terms leave explicit zeros in the pattern
+        CSCMatrix Z = LinearCombination(A) - A;
+        CHECK(Z.nnz() == A.nnz());
+        CHECK_THAT(is_close(Z.data(), std::vector<double>(A.nnz()), 1e-15), AllTrue());
+    }
+
+    SECTION("Operators on matrices are eager") {
+        CSCMatrix S = A + B,
+                  D = A - B,
+                  T = 2.0 * A;
+        CHECK_THAT(is_close(S.to_dense_vector(), add_scaled(A, B, 1.0, 1.0).to_dense_vector(), 1e-14),
+                   AllTrue());
+        CHECK_THAT(is_close(D.to_dense_vector(), add_scaled(A, B, 1.0, -1.0).to_dense_vector(), 1e-14),
+                   AllTrue());
+        CHECK_THAT(is_close(T.data(), A.data() * 2.0, 1e-14), AllTrue());
+    }
+
+    SECTION("Shape mismatch") {
+        CSCMatrix At = A.T();
+        CHECK_THROWS_AS(A + At, std::invalid_argument);
+        CHECK_THROWS_AS(A - At, std::invalid_argument);
+        CHECK_THROWS_AS(LinearCombination(A) + At, std::invalid_argument);
+        CHECK_THROWS_AS(add_scaled(A, At, 1.0, 2.0), std::invalid_argument);
+    }
+
+    SECTION("Temporaries are owned by the expression") {
+        LinearCombination L = LinearCombination(A.T().T()) + LinearCombination(B.T().T(), 3.0);
+        CHECK(L.num_terms() == 2);
+
+        CSCMatrix E = L;  // the transposes are still alive
+        CHECK_THAT(is_close(E.to_dense_vector(), add_scaled(A, B, 1.0, 3.0).to_dense_vector(), 1e-14),
+                   AllTrue());
+    }
+
+    SECTION("In-place products") {
+        std::vector<double> x(N), xt(M), y(M, 1.0), yt(N, -1.0);
+        std::iota(x.begin(), x.end(), 1);
+        std::iota(xt.begin(), xt.end(), -3);
+
+        std::vector<double> expect_y = A.gaxpy(x, y),
+                            expect_yt = A.T().gaxpy(xt, yt);
+
+        A.gaxpy(std::span<const double>(x), std::span<double>(y));
+        CHECK_THAT(is_close(y, expect_y, 1e-12), AllTrue());
+
+        A.gatxpy(std::span<const double>(xt), std::span<double>(yt));
+        CHECK_THAT(is_close(yt, expect_yt, 1e-12), AllTrue());
+
+        std::vector<double> z(M, 99.0);  // overwritten
+        A.dot(std::span<const double>(x), std::span<double>(z));
+        CHECK_THAT(is_close(z, A * x, 1e-12), AllTrue());
+
+        CSCMatrix S = (A.slice(0, N, 0, N) + A.slice(0, N, 0, N).T());
+        std::vector<double> ys(N, 2.0);
+        std::vector<double> expect_ys = S.gaxpy(x, ys);
+        S.band(0, N).sym_gaxpy(std::span<const double>(x), std::span<double>(ys));
+        CHECK_THAT(is_close(ys, expect_ys, 1e-12), AllTrue());
+    }
+
+    SECTION("In-place scaling") {
+        std::vector<double> r(M), c(N);
+        std::iota(r.begin(), r.end(), 1);
+        std::iota(c.begin(), c.end(), 2);
+
+        CSCMatrix expect = A.scale(r, c);
+        CSCMatrix As = A;
+        As.scale_inplace(r, c);
+        CHECK(As.data() == expect.data());
+    }
+}
+
+
+TEST_CASE("CSR matrix and the cached CSR mirror", "[csr]")
+{
+    csint M = 40,
+          N = 30;
+    CSCMatrix A = COOMatrix::random(M, N, 0.2, 23).tocsc().to_canonical();
+    const CSCMatrix A0 = A;  // never has a mirror
+
+    SECTION("Conversion") {
+        CSRMatrix R(A);
+        CHECK(R.shape() == A.shape());
+        CHECK(R.nnz() == A.nnz());
+        CHECK(R.has_canonical_format());
+        CHECK(R(3, 7) == A0(3, 7));
+        CHECK(R.to_dense_vector('F') == A.to_dense_vector('F'));
+        CHECK(R.to_dense_vector('C') == A.to_dense_vector('C'));
+        compare_matrices(R.tocsc(), A);
+
+        // The arrays of the rows are the arrays of the transpose
+        CSRMatrix R2(R.data(), R.indices(), R.indptr(), R.shape());
+        CHECK(R2.to_dense_vector() == A.to_dense_vector());
+    }
+
+    SECTION("The mirror is shared by copies and discarded on modification") {
+        CHECK_FALSE(A.has_csr());
+        const CSRMatrix& R = A.csr();
+        CHECK(A.has_csr());
+        CHECK(&A.csr() == &R);  // built once
+
+        CSCMatrix B = A;
+        CHECK(B.has_csr());
+        CHECK(&B.csr() == &R);
+
+        B.assign(0, 0, 99.0);
+        CHECK_FALSE(B.has_csr());
+        CHECK(B.csr()(0, 0) == 99.0);
+        CHECK(A.has_csr());
+        CHECK(A.csr()(0, 0) == A0(0, 0));
+
+        B.to_canonical();
+        CHECK_FALSE(B.has_csr());
+
+        A.clear_csr();
+        CHECK_FALSE(A.has_csr());
+    }
+
+    SECTION("Row-oriented operations use the mirror") {
+        A.csr();
+        REQUIRE(A.has_csr());
+
+        compare_matrices(A.T(), A0.T());
+        CHECK(A.sum_rows() == A0.sum_rows());
+        compare_matrices(A.slice(5, 9, 0, N), A0.slice(5, 9, 0, N));
+        compare_matrices(A.slice(2, 30, 3, 4), A0.slice(2, 30, 3, 4));
+
+        std::vector<csint> rows = {7, 2, 2, 39, 0},
+                           cols = {29, 1, 4, 4, 10, 0, 17};
+        compare_matrices(A.index(rows, cols), A0.index(rows, cols));
+
+        CSRMatrix R = A.tocsr();
+        CHECK(R.sum_cols() == A0.sum_cols());
+    }
+
+    SECTION("Products") {
+        const CSRMatrix& R = A.csr();
+        csint K = 3;
+
+        std::vector<double> x(N), xt(M), y(M, 1.0), yt(N, 2.0);
+        std::iota(x.begin(), x.end(), 1);
+        std::iota(xt.begin(), xt.end(), -5);
+
+        CHECK_THAT(is_close(R.gaxpy(x, y), A.gaxpy(x, y), 1e-12), AllTrue());
+        CHECK_THAT(is_close(R.gatxpy(xt, yt), A.gatxpy(xt, yt), 1e-12), AllTrue());
+        CHECK_THAT(is_close(R.dot(x), A * x, 1e-12), AllTrue());
+
+        std::vector<double> X(N * K), Y(M * K, 1.0), XT(M * K), YT(N * K, -1.0);
+        std::iota(X.begin(), X.end(), 0);
+        std::iota(XT.begin(), XT.end(), 3);
+
+        CHECK_THAT(is_close(R.gaxpy_row(X, Y), A.gaxpy_row(X, Y), 1e-10), AllTrue());
+        CHECK_THAT(is_close(R.gatxpy_row(XT, YT), A.gatxpy_row(XT, YT), 1e-10),
+                   AllTrue());
+    }
+
+    SECTION("Row-permuted triangular solves") {
+        csint n = 50;
+        std::vector<double> d(n, 10.0);
+        std::vector<csint> idx(n);
+        std::iota(idx.begin(), idx.end(), 0);
+
+        CSCMatrix L = (
+            COOMatrix::random(n, n, 0.1, 77).tocsc().band(-n, -1)
+            + COOMatrix(d, idx, idx).tocsc()
+        ).to_canonical();
+        CSCMatrix U = L.T();
+
+        std::vector<csint> p(n);
+        for (csint k = 0; k < n; k++) {
+            p[k] = (7 * k + 3) % n;
+        }
+        REQUIRE(is_permutation(p, n));
+
+        CSCMatrix PL = L.permute_rows(inv_permute(p)),
+                  PU = U.permute_rows(inv_permute(p));
+
+        std::vector<double> b(n);
+        std::iota(b.begin(), b.end(), 1);
+
+        std::vector<double> expect_l = lsolve_rows(PL, b),
+                            expect_u = usolve_rows(PU, b);
+
+        PL.csr();
+        PU.csr();
+        CHECK_THAT(is_close(lsolve_rows(PL, b), expect_l, 1e-12), AllTrue());
+        CHECK_THAT(is_close(usolve_rows(PU, b), expect_u, 1e-12), AllTrue());
+
+        CHECK_THROWS(lsolve_rows(PU.csr(), b));
+        CHECK_THROWS(usolve_rows(PL.csr(), b));
+    }
+}
+
+
+TEST_CASE("Rank-k Cholesky update and downdate", "[cholesky]")
+{
+    // Define the test matrix A (See Davis, Figure 4.2, p 39)
+    csint N = 11;
+    std::vector<csint> rows = {5, 6, 2, 7, 9, 10, 5, 9, 7, 10, 8, 9, 10, 9, 10, 10};
+    std::vector<csint> cols = {0, 0, 1, 1, 2,  2, 3, 3, 4,  4, 5, 5,  6, 7,  7,  9};
+    std::vector<double> vals(rows.size(), 1);
+
+    for (csint i = 0; i < N; i++) {
+        rows.push_back(i);
+        cols.push_back(i);
+        vals.push_back(10.0 + i);
+    }
+
+    CSCMatrix T = COOMatrix(vals, rows, cols).tocsc();
+    CSCMatrix A = (T + T.T().band(1, N)).to_canonical();
+
+    SymbolicChol S = schol(A, AMDOrder::Natural);
+    const CSCMatrix L = chol(A, S);
+
+    // Each update column has the pattern of a column of L
+    std::vector<csint> Lcols = {1, 3, 6};
+    csint K = Lcols.size();
+    std::default_random_engine rng(56);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+
+    COOMatrix c({N, K});
+    for (csint k = 0; k < K; k++) {
+        for (csint p = L.indptr()[Lcols[k]]; p < L.indptr()[Lcols[k] + 1]; p++) {
+            c.assign(L.indices()[p], k, unif(rng));
+        }
+    }
+
+    CSCMatrix C = c.tocsc();
+    std::vector<double> A_up = (A + C * C.T()).to_dense_vector();
+
+    SECTION("Update matches the rank-1 updates") {
+        CSCMatrix L_k = L;
+        chol_updown(L_k, true, C, S.parent);
+
+        CSCMatrix L_1 = L;
+        for (csint k = 0; k < K; k++) {
+            chol_update(L_1, true, C.slice(0, N, k, k + 1), S.parent);
+        }
+
+        CHECK(L_k.nnz() == L.nnz());
+        CHECK_THAT(is_close(L_k.data(), L_1.data(), 1e-14), AllTrue());
+        CHECK_THAT(is_close((L_k * L_k.T()).to_dense_vector(), A_up, 1e-12), AllTrue());
+    }
+
+    SECTION("Downdate restores the factor") {
+        UpdownWorkspace ws;
+        CSCMatrix L_k = L;
+
+        chol_updown(L_k, true, C, S.parent, ws);
+        CHECK(std::all_of(ws.W.begin(), ws.W.end(), [](double w) { return w == 0.0; }));
+
+        chol_updown(L_k, false, C, S.parent, ws);  // reuse the workspace
+        CHECK_THAT(is_close(L_k.data(), L.data(), 1e-12), AllTrue());
+    }
+
+    SECTION("Downdate of a non-positive definite matrix") {
+        CSCMatrix L_k = L;
+        CHECK_THROWS(chol_updown(L_k, false, 10.0 * C, S.parent));
+    }
+}
+
+
+TEST_CASE("Sparse block triangular solve", "[spsolve]")
+{
+    csint N = 1000,
+          K = 200;
+
+    // A well-conditioned random lower triangular matrix
+    COOMatrix T = COOMatrix::random(N, N, 0.005, 31);
+    for (csint i = 0; i < N; i++) {
+        T.assign(i, i, 10.0);
+    }
+
+    const CSCMatrix L = T.tocsc().band(-N, 0).to_canonical();
+    const CSCMatrix U = L.T();
+    const CSCMatrix B = COOMatrix::random(N, K, 0.02, 32).tocsc().to_canonical();
+
+    // The dense solution of each column, from the single-column solver
+    auto expect_dense = [&](const CSCMatrix& A, bool lo) {
+        std::vector<double> X(N * K);
+        for (csint k = 0; k < K; k++) {
+            auto [xi, x] = spsolve(A, B, k, lo);
+            std::copy(x.begin(), x.end(), X.begin() + k * N);
+        }
+        return X;
+    };
+
+    SECTION("Workspace solves match the allocating version") {
+        SpsolveWorkspace ws;
+        for (csint k = 0; k < K; k += 17) {
+            auto [xi, x] = spsolve(L, B, k);
+            std::vector<csint>& ws_xi = spsolve(L, B, k, ws);
+            REQUIRE(ws_xi == xi);
+            for (const auto& i : xi) {
+                CHECK(ws.x[i] == x[i]);
+            }
+        }
+    }
+
+    SECTION("Lower and upper triangular") {
+        for (bool lo : {true, false}) {
+            const CSCMatrix& A = lo ? L : U;
+            CSCMatrix X = spsolve_block(A, B, lo, {}, 1);
+
+            CHECK(X.shape() == Shape {N, K});
+            CHECK(X.has_canonical_format());
+            CHECK(X.to_dense_vector() == expect_dense(A, lo));
+        }
+    }
+
+    SECTION("Threads give the same result") {
+        CSCMatrix X1 = spsolve_block(L, B, true, {}, 1);
+        CSCMatrix X4 = spsolve_block(L, B, true, {}, 4);
+
+        CHECK(X4.indptr() == X1.indptr());
+        CHECK(X4.indices() == X1.indices());
+        CHECK(X4.data() == X1.data());
+    }
+}
+
+
+TEST_CASE("Factor file cache", "[io]")
+{
+    namespace fs = std::filesystem;
+    std::string filename = (fs::temp_directory_path() / "csparse_test_factor.bin").string();
+
+    SECTION("Cholesky") {
+        // Define the test matrix A (See Davis, Figure 4.2, p 39)
+        csint N = 11;
+        std::vector<csint> rows = {5, 6, 2, 7, 9, 10, 5, 9, 7, 10, 8, 9, 10, 9, 10, 10};
+        std::vector<csint> cols = {0, 0, 1, 1, 2,  2, 3, 3, 4,  4, 5, 5,  6, 7,  7,  9};
+        std::vector<double> vals(rows.size(), 1);
+
+        for (csint i = 0; i < N; i++) {
+            rows.push_back(i);
+            cols.push_back(i);
+            vals.push_back(10.0 + i);
+        }
+
+        CSCMatrix T = COOMatrix(vals, rows, cols).tocsc();
+        CSCMatrix A = (T + T.T().band(1, N)).to_canonical();
+
+        SymbolicChol S = schol(A, AMDOrder::APlusAT);
+        CSCMatrix L = chol(A, S);
+
+        write_chol_cache(filename, A, S, L);
+        CHECK(read_factor_key(filename) == factor_key(A));
+
+        CachedChol C = read_chol_cache(filename, A);
+        REQUIRE(C.has_factor);
+        CHECK(C.S.p_inv == S.p_inv);
+        CHECK(C.S.parent == S.parent);
+        CHECK(C.S.cp == S.cp);
+        CHECK(C.S.lnz == S.lnz);
+        CHECK(C.S.C_map == S.C_map);
+        CHECK(S.pattern_hash == pattern_hash(A));
+        CHECK(C.S.pattern_hash == S.pattern_hash);
+        CHECK(C.L.has_canonical_format());
+        CHECK(C.L.indptr() == L.indptr());
+        CHECK(C.L.indices() == L.indices());
+        CHECK(C.L.data() == L.data());
+
+        // New values reuse the analysis, but not the factor
+        CSCMatrix A2 = (2.0 * A);
+        CHECK(factor_key(A2).pattern_hash == factor_key(A).pattern_hash);
+        CHECK(factor_key(A2).values_hash != factor_key(A).values_hash);
+
+        CachedChol C2 = read_chol_cache(filename, A2);
+        CHECK_FALSE(C2.has_factor);
+        CSCMatrix L2 = chol(A2, C2.S);
+        CHECK_THAT(is_close(L2.data(), (std::sqrt(2.0) * L).data(), 1e-14), AllTrue());
+
+        // A different pattern cannot use the analysis
+        CSCMatrix A3 = A;
+        A3.assign(0, 1, 1.0);
+        A3.assign(1, 0, 1.0);
+        CHECK_THROWS_AS(read_chol_cache(filename, A3.to_canonical()), std::runtime_error);
+
+        // An analysis without the factor
+        write_chol_cache(filename, A, S);
+        CHECK_FALSE(read_chol_cache(filename, A).has_factor);
+    }
+
+    SECTION("QR") {
+        CSCMatrix A = davis_example_qr();
+        SymbolicQR S = sqr(A, AMDOrder::ATA);
+        QRResult res = qr(A, S);
+
+        write_qr_cache(filename, A, S, res);
+
+        CachedQR C = read_qr_cache(filename, A);
+        REQUIRE(C.has_factor);
+        CHECK(C.S.q == S.q);
+        CHECK(C.S.leftmost == S.leftmost);
+        CHECK(C.S.vnz == S.vnz);
+        CHECK(C.S.rnz == S.rnz);
+        CHECK(S.pattern_hash == pattern_hash(A));
+        CHECK(C.S.pattern_hash == S.pattern_hash);
+        CHECK(C.res.V.data() == res.V.data());
+        CHECK(C.res.beta == res.beta);
+        CHECK(C.res.R.indices() == res.R.indices());
+        CHECK(C.res.R.data() == res.R.data());
+        CHECK(C.res.p_inv == res.p_inv);
+        CHECK(C.res.q == res.q);
+
+        // A Cholesky reader does not accept a QR file
+        CHECK_THROWS_AS(read_chol_cache(filename, A), std::runtime_error);
+    }
+
+    SECTION("Errors") {
+        CSCMatrix A = davis_example_qr();
+        SymbolicQR S = sqr(A);
+
+        // A binary CSC file is not a factor file
+        write_binary(filename, A);
+        CHECK_THROWS_AS(read_factor_key(filename), std::runtime_error);
+
+        // Truncated file
+        write_qr_cache(filename, A, S, qr(A, S));
+        fs::resize_file(filename, fs::file_size(filename) - 8);
+        CHECK_THROWS_AS(read_qr_cache(filename, A), std::runtime_error);
+
+        // Overwrite one entry of the first array (p_inv) of a valid file
+        auto corrupt = [&](std::size_t offset, csint value) {
+            write_qr_cache(filename, A, S, qr(A, S));
+            std::fstream fp(filename, std::ios::in | std::ios::out | std::ios::binary);
+            fp.seekp(sizeof(FactorHeader) + (1 + offset) * sizeof(csint));
+            fp.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        };
+
+        csint N = A.shape()[1];
+
+        corrupt(0, S.p_inv[1]);  // not a permutation
+        CHECK_THROWS_AS(read_qr_cache(filename, A), std::runtime_error);
+
+        corrupt(0, -1);
+        CHECK_THROWS_AS(read_qr_cache(filename, A), std::runtime_error);
+
+        // p_inv, q, then parent
+        corrupt((1 + S.p_inv.size()) + (1 + N), N);
+        CHECK_THROWS_AS(read_qr_cache(filename, A), std::runtime_error);
+
+        // Flip one bit of a saved analysis
+        auto flip = [&](std::size_t offset) {
+            std::fstream fp(filename, std::ios::in | std::ios::out | std::ios::binary);
+            char c;
+            fp.seekg(offset);
+            fp.read(&c, 1);
+            c ^= 0x10;
+            fp.seekp(offset);
+            fp.write(&c, 1);
+        };
+
+        write_qr_cache(filename, A, S);
+        REQUIRE_NOTHROW(read_qr_cache(filename, A));
+        flip(fs::file_size(filename) - 2 * sizeof(csint));  // in vnz
+        CHECK_THROWS_AS(read_qr_cache(filename, A), std::runtime_error);
+
+        // A well-formed file of an analysis that does not fit A
+        SymbolicQR S_bad = S;
+        S_bad.rnz--;
+        write_qr_cache(filename, A, S_bad);
+        CHECK_THROWS_AS(read_qr_cache(filename, A), std::runtime_error);
+
+        S_bad = S;
+        S_bad.parent[N-1] = 0;  // a parent before its child
+        write_qr_cache(filename, A, S_bad);
+        CHECK_THROWS_AS(read_qr_cache(filename, A), std::runtime_error);
+
+        CSCMatrix As = (A + A.T());
+        SymbolicChol Sc = schol(As, AMDOrder::APlusAT);
+
+        write_chol_cache(filename, As, Sc);
+        REQUIRE_NOTHROW(read_chol_cache(filename, As));
+        flip(sizeof(FactorHeader) + sizeof(csint));  // in p_inv
+        CHECK_THROWS_AS(read_chol_cache(filename, As), std::runtime_error);
+
+        SymbolicChol Sc_bad = Sc;
+        Sc_bad.cp[1]--;  // column counts that do not fit the tree
+        write_chol_cache(filename, As, Sc_bad);
+        CHECK_THROWS_AS(read_chol_cache(filename, As), std::runtime_error);
+
+        Sc_bad = Sc;
+        Sc_bad.parent[N-1] = 0;
+        write_chol_cache(filename, As, Sc_bad);
+        CHECK_THROWS_AS(read_chol_cache(filename, As), std::runtime_error);
+
+        // Without the cached pattern of C, the counts are checked against A
+        Sc_bad = Sc;
+        Sc_bad.C = CSCMatrix();
+        Sc_bad.C_map.clear();
+        write_chol_cache(filename, As, Sc_bad);
+        CHECK_NOTHROW(read_chol_cache(filename, As));
+        Sc_bad.cp[1]--;
+        write_chol_cache(filename, As, Sc_bad);
+        CHECK_THROWS_AS(read_chol_cache(filename, As), std::runtime_error);
+
+        // An empty matrix has a key
+        CHECK(factor_key(CSCMatrix()).nnz == 0);
+    }
+
+    fs::remove(filename);
+}
+
+
+TEST_CASE("Multifrontal QR", "[qr]")
+{
+    CSCMatrix A = davis_example_qr();
+    auto [M, N] = A.shape();
+
+    AMDOrder order = GENERATE(AMDOrder::Natural, AMDOrder::ATA);
+    csint block_size = GENERATE(1, 2, 32);
+    CAPTURE(order, block_size);
+
+    SymbolicQR S = sqr(A, order);
+    MultifrontalQR F = qr_multifrontal(A, S, block_size);
+
+    REQUIRE(F.R.shape() == Shape {N, N});
+    CHECK(F.m2 == M);
+    CHECK(F.num_fronts() <= N);
+
+    // The rows of Q^T A(:, q) are a permutation of the slots
+    std::vector<csint> rows = F.rows;
+    std::sort(rows.begin(), rows.end());
+    std::vector<csint> expect_rows(M);
+    std::iota(expect_rows.begin(), expect_rows.end(), 0);
+    CHECK(rows == expect_rows);
+
+    SECTION("R matches the column-by-column QR, up to signs") {
+        QRResult res = qr(A, S);
+        std::vector<double> expect_R = res.R.slice(0, N, 0, N).to_dense_vector();
+        std::vector<double> R = F.R.to_dense_vector();
+
+        for (auto& x : expect_R) { x = std::fabs(x); }
+        for (auto& x : R) { x = std::fabs(x); }
+
+        CHECK_THAT(is_close(R, expect_R, 1e-12), AllTrue());
+    }
+
+    SECTION("Apply Q^T and Q") {
+        // Q^T A(:, q) = [R; 0]
+        std::vector<double> Y = apply_qt(F, A.permute_cols(S.q).to_dense_vector());
+        std::vector<double> expect_Y = F.R.to_dense_vector();
+        REQUIRE(Y.size() == expect_Y.size());
+        CHECK_THAT(is_close(Y, expect_Y, 1e-12), AllTrue());
+
+        // Q Q^T B = B
+        csint K = 3;
+        std::vector<double> B(M * K);
+        std::iota(B.begin(), B.end(), 1.0);
+
+        CHECK_THAT(is_close(apply_q(F, apply_qt(F, B)), B, 1e-12), AllTrue());
+    }
+}
+
+
+TEST_CASE("Least-squares solve with multifrontal QR", "[qr]")
+{
+    // Overdetermined, with an empty row
+    csint M = 8, N = 5;
+    CSCMatrix A = davis_example_qr().slice(0, M, 0, N);
+    A = vstack(A, CSCMatrix(Shape {1, N}));
+    M++;
+
+    std::vector<double> expect_x(N);
+    std::iota(expect_x.begin(), expect_x.end(), 1.0);
+
+    SECTION("Consistent system") {
+        std::vector<double> b = A * expect_x;
+        std::vector<double> x = qrsolve(A, b);
+        CHECK_THAT(is_close(x, expect_x, 1e-12), AllTrue());
+    }
+
+    SECTION("Least-squares residual is orthogonal to the columns of A") {
+        std::vector<double> b(M, 1.0);
+        std::vector<double> x = qrsolve(A, b, AMDOrder::Natural);
+
+        std::vector<double> r = b - A * x;
+        std::vector<double> ATr = A.T() * r;
+        CHECK_THAT(is_close(ATr, std::vector<double>(N, 0.0), 1e-12), AllTrue());
+    }
+
+    SECTION("Block of right-hand sides") {
+        SymbolicQR S = sqr(A, AMDOrder::ATA);
+        MultifrontalQR F = qr_multifrontal(A, S, 2);
+
+        csint K = 4;
+        std::vector<double> X_true(N * K), B(M * K);
+        for (csint k = 0; k < K; k++) {
+            std::vector<double> x(N);
+            std::iota(x.begin(), x.end(), static_cast<double>(k));
+            std::copy(x.begin(), x.end(), X_true.begin() + k * N);
+            std::vector<double> b = A * x;
+            std::copy(b.begin(), b.end(), B.begin() + k * M);
+        }
+
+        CHECK_THAT(is_close(qrsolve(F, B), X_true, 1e-12), AllTrue());
+    }
+
+    SECTION("Fictitious rows") {
+        // Column 1 is empty, so its front has a row of zeros
+        CSCMatrix B = COOMatrix(
+            std::vector<double> {1.0, 2.0, 1.0, 3.0},
+            std::vector<csint>  {0, 1, 1, 2},
+            std::vector<csint>  {0, 0, 2, 2}
+        ).tocsc();
+
+        SymbolicQR S = sqr(B);
+        MultifrontalQR F = qr_multifrontal(B, S);
+
+        const CSCMatrix& R = F.R;
+        CHECK(F.m2 == 4);
+        CHECK(R(1, 1) == 0.0);
+
+        std::vector<double> b = {1.0, 2.0, 3.0};
+        CHECK_THAT(is_close(apply_q(F, apply_qt(F, b)), b, 1e-14), AllTrue());
+    }
+
+    SECTION("Errors") {
+        CSCMatrix AT = A.T();
+        SymbolicQR S = sqr(AT);
+        CHECK_THROWS_AS(qr_multifrontal(AT, S), std::runtime_error);
+        CHECK_THROWS_AS(qr_multifrontal(A, sqr(A), 0), std::runtime_error);
+    }
+}
+
+
+TEST_CASE("Nested dissection ordering", "[amd][nd]")
+{
+    // 2D Laplacian on an n x n grid
+    csint n = 40,
+          N = n * n;
+
+    COOMatrix T({N, N});
+    for (csint i = 0; i < n; i++) {
+        for (csint j = 0; j < n; j++) {
+            csint k = i * n + j;
+            T.assign(k, k, 4.0);
+            if (i > 0) { T.assign(k, k - n, -1.0); }
+            if (i < n - 1) { T.assign(k, k + n, -1.0); }
+            if (j > 0) { T.assign(k, k - 1, -1.0); }
+            if (j < n - 1) { T.assign(k, k + 1, -1.0); }
+        }
+    }
+
+    const CSCMatrix A = T.tocsc();
+
+    SECTION("Vertex separator") {
+        CSCMatrix C = build_graph(A, AMDOrder::APlusAT);
+        std::vector<csint> part = vertex_separator(C);
+
+        REQUIRE(static_cast<csint>(part.size()) == N);
+
+        csint size[3] = {0, 0, 0};
+        for (const auto& s : part) {
+            REQUIRE((s >= 0 && s <= 2));
+            size[s]++;
+        }
+
+        // The halves are balanced, and the separator is about one grid line
+        CHECK(size[0] > N / 3);
+        CHECK(size[1] > N / 3);
+        CHECK(size[2] <= 2 * n);
+
+        // No edge joins the two halves
+        const auto& Cp = C.indptr();
+        const auto& Ci = C.indices();
+        csint cut = 0;
+        for (csint j = 0; j < N; j++) {
+            for (csint p = Cp[j]; p < Cp[j+1]; p++) {
+                cut += (part[j] + part[Ci[p]] == 1);
+            }
+        }
+        CHECK(cut == 0);
+    }
+
+    SECTION("Cholesky ordering") {
+        csint leaf_size = GENERATE(16, 256);
+        CAPTURE(leaf_size);
+
+        std::vector<csint> p = nested_dissection(A, AMDOrder::APlusAT, leaf_size);
+        CHECK(is_permutation(p, N));
+
+        SymbolicChol S_nat = schol(A, AMDOrder::Natural);
+        SymbolicChol S_amd = schol(A, AMDOrder::APlusAT);
+        SymbolicChol S_nd = schol(A, AMDOrder::NestedDissection);
+
+        CHECK(S_nd.p_inv == inv_permute(nested_dissection(A)));
+        CHECK(S_nd.lnz < S_nat.lnz);
+
+        // The elimination tree is wider, and shorter, than that of AMD
+        CHECK(etree_height(S_nd.parent) < etree_height(S_amd.parent));
+
+        CSCMatrix L = chol(A, S_nd);
+        CHECK(L.nnz() == S_nd.lnz);
+        CSCMatrix LLT = (L * L.T()).droptol().to_canonical();
+        CSCMatrix expect_A = A.permute(S_nd.p_inv, inv_permute(S_nd.p_inv));
+        CHECK_THAT(is_close(LLT.to_dense_vector(), expect_A.to_dense_vector(), 1e-12),
+                   AllTrue());
+    }
+
+    SECTION("QR ordering") {
+        // Overdetermined, so that the graph is that of A^T A
+        CSCMatrix B = vstack(A, A.slice(0, n, 0, N));
+
+        SymbolicQR S = sqr(B, AMDOrder::NestedDissection);
+        CHECK(S.q == nested_dissection(B, AMDOrder::ATA));
+        CHECK(is_permutation(S.q, N));
+
+        std::vector<double> expect_x(N, 1.0);
+        std::vector<double> x = qrsolve(B, B * expect_x, AMDOrder::NestedDissection);
+        CHECK_THAT(is_close(x, expect_x, 1e-10), AllTrue());
+    }
+
+    SECTION("Small graphs are ordered by minimum degree") {
+        CSCMatrix A = davis_example_qr();
+        CHECK(nested_dissection(A) == amd(A, AMDOrder::APlusAT));
+    }
+
+    SECTION("Errors") {
+        CHECK_THROWS_AS(nested_dissection(A, AMDOrder::Natural), std::runtime_error);
+        CHECK_THROWS_AS(nested_dissection(A, AMDOrder::NestedDissection), std::runtime_error);
+    }
+}
+
+
+TEST_CASE("Workspace arena", "[workspace]")
+{
+    Workspace ws;
+
+    SECTION("Buffers are reused") {
+        {
+            auto a = ws.take<csint>(100);
+            REQUIRE(a->size() == 100);
+        }
+        {
+            auto b = ws.take<csint>(50);
+            REQUIRE(b->size() == 50);
+            CHECK(b->capacity() >= 100);
+        }
+
+        CHECK(ws.leases() == 2);
+        CHECK(ws.allocations() == 1);
+        CHECK(ws.reserved_bytes() == 100 * sizeof(csint));
+        CHECK(ws.bytes_in_use() == 0);
+
+        ws.release();
+        CHECK(ws.reserved_bytes() == 0);
+    }
+
+    SECTION("High-water mark") {
+        {
+            auto a = ws.take<csint>(100);
+            auto b = ws.fill<double>(50, 1.0);
+            CHECK(ws.bytes_in_use() == 100 * sizeof(csint) + 50 * sizeof(double));
+
+            auto s = ws.reserve<csint>(0);
+            for (csint k = 0; k < 200; k++) {
+                s->push_back(k);  // the stack grows while in use
+            }
+        }
+
+        CHECK(ws.bytes_in_use() == 0);
+        CHECK(ws.peak_bytes() >= (300 * sizeof(csint) + 50 * sizeof(double)));
+        CHECK(ws.peak_bytes() == ws.reserved_bytes());
+
+        ws.reset_peak();
+        CHECK(ws.peak_bytes() == 0);
+    }
+
+    SECTION("Zeroed buffers") {
+        {
+            auto x = ws.zeros<double>(10);
+            REQUIRE(std::ranges::all_of(*x, [](double v) { return v == 0.0; }));
+            x[3] = 1.0;
+            x[3] = 0.0;  // returned clean
+        }
+        {
+            auto x = ws.zeros<double>(20);  // grows the clean buffer
+            CHECK(ws.allocations() == 2);
+            CHECK(std::ranges::all_of(*x, [](double v) { return v == 0.0; }));
+        }
+
+        // A buffer abandoned by an exception is cleared on its next use
+        try {
+            auto x = ws.zeros<double>(20);
+            x[5] = 1.0;
+            throw std::runtime_error("abandoned");
+        } catch (const std::runtime_error&) {}
+
+        auto x = ws.zeros<double>(20);
+        CHECK(std::ranges::all_of(*x, [](double v) { return v == 0.0; }));
+    }
+
+    SECTION("Thread-local default") {
+        Workspace *main_ws = &get_workspace();
+        Workspace *other_ws = nullptr;
+        std::thread([&]() { other_ws = &get_workspace(); }).join();
+        CHECK(other_ws != main_ws);
+
+        {
+            WorkspaceScope scope(ws);
+            CHECK(&get_workspace() == &ws);
+        }
+
+        CHECK(&get_workspace() == main_ws);
+    }
+
+    SECTION("Owner thread") {
+        WorkspaceScope scope(ws);
+        {
+            WorkspaceScope nested(ws);  // the same thread may nest scopes
+            CHECK(&get_workspace() == &ws);
+        }
+
+        bool elsewhere = false,
+             scope_threw = false,
+             release_threw = false;
+        std::thread([&]() {
+            elsewhere = ws.claimed_elsewhere();
+            try { WorkspaceScope other(ws); } catch (const std::runtime_error&) { scope_threw = true; }
+            try { ws.release(); } catch (const std::runtime_error&) { release_threw = true; }
+        }).join();
+
+        CHECK(elsewhere);
+        CHECK(scope_threw);
+        CHECK(release_threw);
+        CHECK_FALSE(ws.claimed_elsewhere());
+    }
+
+    SECTION("Released claims") {
+        {
+            WorkspaceScope scope(ws);
+        }
+
+        bool threw = false,
+             installed = false;
+        std::thread([&]() {
+            try {
+                WorkspaceScope other(ws);
+                installed = &get_workspace() == &ws;
+            } catch (const std::runtime_error&) {
+                threw = true;
+            }
+        }).join();
+
+        CHECK_FALSE(threw);
+        CHECK(installed);
+    }
+
+    SECTION("Kernels") {
+        // 2D Laplacian on an n x n grid
+        csint n = 20,
+              N = n * n;
+
+        COOMatrix T({N, N});
+        for (csint i = 0; i < n; i++) {
+            for (csint j = 0; j < n; j++) {
+                csint k = i * n + j;
+                T.assign(k, k, 4.0);
+                if (i > 0) { T.assign(k, k - n, -1.0); }
+                if (i < n - 1) { T.assign(k, k + n, -1.0); }
+                if (j > 0) { T.assign(k, k - 1, -1.0); }
+                if (j < n - 1) { T.assign(k, k + 1, -1.0); }
+            }
+        }
+
+        const CSCMatrix A = T.tocsc();
+        const SymbolicChol S = schol(A, AMDOrder::APlusAT);
+        const SymbolicQR Sq = sqr(A, AMDOrder::ATA);
+        const std::vector<csint> parent = etree(A);
+
+        const CSCMatrix L0 = chol(A, S);
+        const QRResult QR0 = qr(A, Sq);
+        const CSCMatrix AA0 = A * A;
+        const std::vector<csint> counts0 = counts(A, parent, post(parent));
+        const std::vector<csint> reach0 = reach(L0, A, N / 2);
+
+        // A column of L keeps the pattern of the update on its etree path
+        const CSCMatrix C = 0.5 * L0.slice(0, N, N / 2, N / 2 + 1);
+
+        auto run_kernels = [&]() {
+            CSCMatrix L = chol(A, S);
+            CHECK(L.data() == L0.data());
+
+            QRResult res = qr(A, Sq);
+            CHECK(res.V.data() == QR0.V.data());
+            CHECK(res.R.data() == QR0.R.data());
+
+            CHECK((A * A).data() == AA0.data());
+            CHECK(etree(A) == parent);
+            CHECK(counts(A, parent, post(parent)) == counts0);
+            CHECK(reach(L0, A, N / 2) == reach0);
+
+            chol_update(L, true, C, S.parent);
+            chol_update(L, false, C, S.parent);
+            CHECK_THAT(is_close(L.data(), L0.data(), 1e-12), AllTrue());
+        };
+
+        WorkspaceScope scope(ws);
+
+        // The first calls fill the pool, and later calls do not allocate
+        run_kernels();
+        run_kernels();
+        csint allocations = ws.allocations();
+        csint leases = ws.leases();
+
+        run_kernels();
+        CHECK(ws.leases() > leases);
+        CHECK(ws.allocations() == allocations);
+        CHECK(ws.bytes_in_use() == 0);
+        CHECK(ws.peak_bytes() >= N * sizeof(double));
+
+        // The kernels returned their accumulators all zero
+        for (csint M : {N, 2 * N}) {
+            auto x = ws.zeros<double>(M);
+            CHECK(std::ranges::all_of(*x, [](double v) { return v == 0.0; }));
+        }
+    }
+}
+
+
 /*==============================================================================
  *============================================================================*/
@@ -13,6 +13,7 @@
 #include <numeric>  // partial_sum
 
 #include "utils.h"
+#include "parallel.h"
 
 namespace cs {
 
@@ -108,12 +109,38 @@ std::vector<csint> inv_permute(const std::vector<csint>& p)
 }
 
 
-std::vector<csint> cumsum(const std::vector<csint>& w)
+std::vector<csint> cumsum(const std::vector<csint>& w, int threads)
 {
-    std::vector<csint> out(w.size() + 1);
+    csint N = w.size();
+    std::vector<csint> out(N + 1);
 
-    // Row pointers are the cumulative sum of the counts, starting with 0
-    std::partial_sum(w.begin(), w.end(), out.begin() + 1);
+    int nthreads = resolve_num_threads(threads, N);
+
+    if (nthreads <= 1) {
+        // Row pointers are the cumulative sum of the counts, starting with 0
+        std::partial_sum(w.begin(), w.end(), out.begin() + 1);
+        return out;
+    }
+
+    // Sum each block, then offset each block by the sum of the previous ones
+    std::vector<csint> block_sum(nthreads + 1, 0);
+
+    parallel_for(nthreads, [&](int t) {
+        csint start = N * t / nthreads;
+        csint end = N * (t + 1) / nthreads;
+        std::partial_sum(w.begin() + start, w.begin() + end, out.begin() + start + 1);
+        block_sum[t+1] = (end > start) ? out[end] : 0;
+    });
+
+    std::partial_sum(block_sum.begin(), block_sum.end(), block_sum.begin());
+
+    parallel_for(nthreads, [&](int t) {
+        csint start = N * t / nthreads;
+        csint end = N * (t + 1) / nthreads;
+        for (csint k = start + 1; k <= end; k++) {
+            out[k] += block_sum[t];
+        }
+    });
 
     return out;
 }
@@ -0,0 +1,102 @@
+/*==============================================================================
+ *     File: workspace.cpp
+ *  Created: 2025-03-31 09:20
+ *   Author: Bernie Roesler
+ *
+ *  Description: Implements the reusable pool of scratch arrays.
+ *
+ *============================================================================*/
+
+#include <stdexcept>
+
+#include "workspace.h"
+
+namespace cs {
+
+thread_local Workspace *detail::current_workspace = nullptr;
+
+
+void Workspace::claim()
+{
+    std::lock_guard<std::mutex> lock(owner_mutex_);
+    std::thread::id self = std::this_thread::get_id();
+
+    if (claims_ > 0 && owner_ != self) {
+        throw std::runtime_error("Workspace is already installed on another thread!");
+    }
+
+    owner_ = self;
+    claims_++;
+}
+
+
+void Workspace::unclaim()
+{
+    std::lock_guard<std::mutex> lock(owner_mutex_);
+    if (claims_ > 0 && owner_ == std::this_thread::get_id() && --claims_ == 0) {
+        owner_ = std::thread::id();
+    }
+}
+
+
+bool Workspace::claimed_elsewhere() const
+{
+    std::lock_guard<std::mutex> lock(owner_mutex_);
+    return claims_ > 0 && owner_ != std::this_thread::get_id();
+}
+
+
+void Workspace::check_owner_() const
+{
+    if (claimed_elsewhere()) {
+        throw std::runtime_error("Workspace is in use by another thread!");
+    }
+}
+
+
+void Workspace::reset_peak()
+{
+    check_owner_();
+    peak_ = in_use_;
+}
+
+
+void Workspace::release()
+{
+    check_owner_();
+
+    auto clear = [this](auto& list) {
+        for (const auto& v : list) {
+            reserved_ -= capacity_bytes_(v);
+        }
+        list.clear();
+        list.shrink_to_fit();
+    };
+
+    std::apply([&](auto&... pools) {
+        (clear(pools.clean), ...);
+        (clear(pools.dirty), ...);
+    }, pools_);
+}
+
+
+Workspace& get_workspace()
+{
+    thread_local Workspace default_workspace;
+    Workspace *ws = detail::current_workspace;
+    return ws ? *ws : default_workspace;
+}
+
+
+Workspace* set_workspace(Workspace *ws)
+{
+    Workspace *prev = detail::current_workspace;
+    detail::current_workspace = ws;
+    return prev;
+}
+
+
+}  // namespace cs
+
+/*==============================================================================
+ *============================================================================*/